@@ -0,0 +1,147 @@
+#include <eosio/chain/abi_plan.hpp>
+#include <eosio/chain/abi_serializer.hpp>
+#include <fc/io/json.hpp>
+
+#include <benchmark.hpp>
+
+// Benchmark converting binary data to JSON with an ABI. "variant" is abi_serializer::binary_to_variant() followed by
+// fc::json::to_string(), "plan" writes the JSON directly with an abi_plan. "compile" is the one time cost of the plan.
+//
+//  transfer - a single eosio.token transfer action
+//  block    - a block of 100 transactions of 10 decoded transfer actions each
+//  nested   - a tree of structs 10 levels deep, every struct holding two children of the level below
+//
+// A single conversion is short, to run a benchmarking session, in the build directory, type
+//    benchmark/benchmark -f abi -r 1000
+
+namespace eosio::benchmark {
+
+using namespace eosio::chain;
+
+namespace {
+
+constexpr uint32_t trxs_per_block     = 100;
+constexpr uint32_t actions_per_trx    = 10;
+constexpr uint32_t nested_depth       = 10;
+
+const char* block_abi = R"=====({
+   "version": "eosio::abi/1.1",
+   "structs": [
+      {"name": "transfer", "base": "", "fields": [
+         {"name": "from", "type": "name"},
+         {"name": "to", "type": "name"},
+         {"name": "quantity", "type": "asset"},
+         {"name": "memo", "type": "string"}
+      ]},
+      {"name": "permission_level", "base": "", "fields": [
+         {"name": "actor", "type": "name"},
+         {"name": "permission", "type": "name"}
+      ]},
+      {"name": "action", "base": "", "fields": [
+         {"name": "account", "type": "name"},
+         {"name": "name", "type": "name"},
+         {"name": "authorization", "type": "permission_level[]"},
+         {"name": "data", "type": "transfer"}
+      ]},
+      {"name": "transaction", "base": "", "fields": [
+         {"name": "expiration", "type": "time_point_sec"},
+         {"name": "ref_block_num", "type": "uint16"},
+         {"name": "ref_block_prefix", "type": "uint32"},
+         {"name": "actions", "type": "action[]"}
+      ]},
+      {"name": "block", "base": "", "fields": [
+         {"name": "timestamp", "type": "block_timestamp_type"},
+         {"name": "producer", "type": "name"},
+         {"name": "transactions", "type": "transaction[]"}
+      ]}
+   ],
+   "actions": [{"name": "transfer", "type": "transfer", "ricardian_contract": ""}]
+})=====";
+
+fc::variant make_transfer(uint32_t i) {
+   return fc::mutable_variant_object()
+      ("from", name(i % 1000 + 1))
+      ("to", "eosio.token")
+      ("quantity", std::to_string(i) + ".0000 SYS")
+      ("memo", "transfer " + std::to_string(i));
+}
+
+fc::variant make_block() {
+   fc::variants trxs;
+   for (uint32_t t = 0; t < trxs_per_block; ++t) {
+      fc::variants actions;
+      for (uint32_t a = 0; a < actions_per_trx; ++a) {
+         actions.emplace_back(fc::mutable_variant_object()
+            ("account", "eosio.token")
+            ("name", "transfer")
+            ("authorization", fc::variants{fc::mutable_variant_object()("actor", name(a + 1))("permission", "active")})
+            ("data", make_transfer(t * actions_per_trx + a)));
+      }
+      trxs.emplace_back(fc::mutable_variant_object()
+         ("expiration", "2023-01-01T00:00:00")
+         ("ref_block_num", t)
+         ("ref_block_prefix", t * 1000)
+         ("actions", std::move(actions)));
+   }
+   return fc::mutable_variant_object()
+      ("timestamp", "2023-01-01T00:00:00.000")
+      ("producer", "eosio")
+      ("transactions", std::move(trxs));
+}
+
+abi_def make_nested_abi() {
+   abi_def abi;
+   abi.version = "eosio::abi/1.1";
+   abi.structs.emplace_back("node0", "", vector<field_def>{{"value", "uint64"}, {"label", "string"}});
+   for (uint32_t level = 1; level <= nested_depth; ++level) {
+      abi.structs.emplace_back("node" + std::to_string(level), "",
+                               vector<field_def>{{"value", "uint64"}, {"label", "string"},
+                                                 {"children", "node" + std::to_string(level - 1) + "[]"}});
+   }
+   return abi;
+}
+
+fc::variant make_node(uint32_t level) {
+   fc::mutable_variant_object node;
+   node("value", uint64_t(level) << 40)("label", "level " + std::to_string(level));
+   if (level > 0)
+      node("children", fc::variants{make_node(level - 1), make_node(level - 1)});
+   return node;
+}
+
+// no deadline and no depth limit, the nested tree can exceed abi_serializer::max_recursion_depth
+const abi_serializer::yield_function_t no_yield;
+
+void benchmark_conversion(const std::string& name, const abi_serializer& abis, const std::string& type, const fc::variant& value) {
+   const bytes bin = abis.variant_to_binary(type, value, no_yield);
+
+   const auto abis_ptr = std::make_shared<const abi_serializer>(abis);
+   abi_plan plan(abis_ptr);
+   EOS_ASSERT(plan.binary_to_json(type, bin, no_yield) == fc::json::to_string(abis.binary_to_variant(type, bin, no_yield), fc::time_point::maximum()),
+              misc_exception, "abi_plan output of ${type} differs", ("type", type));
+
+   size_t len = 0;
+   benchmarking("abi " + name + " variant", [&]() {
+      len += fc::json::to_string(abis.binary_to_variant(type, bin, no_yield), fc::time_point::maximum()).size();
+   });
+   benchmarking("abi " + name + " plan", [&]() {
+      len += plan.binary_to_json(type, bin, no_yield).size();
+   });
+   benchmarking("abi " + name + " compile", [&]() {
+      len += abi_plan(abis_ptr).num_types();
+   });
+}
+
+} // anonymous namespace
+
+void abi_benchmarking() {
+   abi_serializer block_abis(fc::json::from_string(block_abi).as<abi_def>(), no_yield);
+   benchmark_conversion("transfer", block_abis, "transfer", make_transfer(1));
+   benchmark_conversion("block " + std::to_string(trxs_per_block * actions_per_trx) + " actions", block_abis, "block", make_block());
+
+   abi_serializer nested_abis(make_nested_abi(), no_yield);
+   benchmark_conversion("nested " + std::to_string(nested_depth) + " levels", nested_abis,
+                        "node" + std::to_string(nested_depth), make_node(nested_depth));
+}
+
+} // benchmark
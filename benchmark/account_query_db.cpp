@@ -0,0 +1,60 @@
+#include <eosio/chain_plugin/account_query_db.hpp>
+#include <eosio/testing/tester.hpp>
+
+#include <benchmark.hpp>
+
+// Benchmark the startup of the account query DB of enable-account-queries on a chain holding many permissions:
+// "build" recreates it from every permission of the chain state, "load at head" loads the file written on a clean
+// shutdown and "load and merge" loads a file written at an earlier block, as after a crash, merging it with the
+// chain state. "checkpoint" is the serialization and write of the file.
+//
+// To run a benchmarking session, in the build directory, type
+//    benchmark/benchmark -f account_query_db -r 5
+
+namespace eosio::benchmark {
+
+using namespace eosio::chain;
+using namespace eosio::chain::literals;
+using namespace eosio::testing;
+
+namespace {
+
+constexpr uint32_t num_accounts = 5000;
+
+} // anonymous namespace
+
+void account_query_db_benchmarking() {
+   using mvo = fc::mutable_variant_object;
+   using eosio::chain_apis::account_query_db;
+
+   fc::logger::get(DEFAULT_LOGGER).set_log_level(fc::log_level::off);
+
+   // owner, active and one more permission with its own key per account
+   tester chain;
+   for (uint32_t i = 0; i < num_accounts; ++i) {
+      const name account(std::string("user") + char('a' + i / 676 % 26) + char('a' + i / 26 % 26) + char('a' + i % 26));
+      chain.create_account(account);
+      chain.push_action(config::system_account_name, updateauth::get_name(), account, mvo()
+            ("account", account)
+            ("permission", "role"_n)
+            ("parent", "active")
+            ("auth", authority(chain.get_public_key(account, "role"))));
+      if (i % 100 == 99)
+         chain.produce_block();
+   }
+   chain.produce_block();
+
+   fc::temp_directory temp_dir;
+   const auto persist_file = temp_dir.path() / "account_query_db.dat";
+
+   benchmarking("account_query_db build", [&]() { account_query_db db(*chain.control); });
+
+   account_query_db db(*chain.control, persist_file);
+   benchmarking("account_query_db checkpoint", [&]() { db.close(); });
+   benchmarking("account_query_db load at head", [&]() { account_query_db loaded(*chain.control, persist_file); });
+
+   chain.produce_block();
+   benchmarking("account_query_db load and merge", [&]() { account_query_db loaded(*chain.control, persist_file); });
+}
+
+} // namespace eosio::benchmark
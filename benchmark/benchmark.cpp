@@ -15,7 +15,17 @@ std::map<std::string, std::function<void()>> features {
    { "key", key_benchmarking },
    { "hash", hash_benchmarking },
    { "blake2", blake2_benchmarking },
-   { "bls", bls_benchmarking }
+   { "bls", bls_benchmarking },
+   { "state_history", state_history_benchmarking },
+   { "ship_compression", ship_compression_benchmarking },
+   { "ship_deltas", ship_deltas_benchmarking },
+   { "block_log", block_log_benchmarking },
+   { "snapshot", snapshot_benchmarking },
+   { "abi", abi_benchmarking },
+   { "trace_api", trace_api_benchmarking },
+   { "wasm_cache", wasm_cache_benchmarking },
+   { "read_only", read_only_benchmarking },
+   { "account_query_db", account_query_db_benchmarking }
 };
 
 // values to control cout format
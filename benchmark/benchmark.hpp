@@ -21,6 +21,16 @@ void key_benchmarking();
 void hash_benchmarking();
 void blake2_benchmarking();
 void bls_benchmarking();
+void state_history_benchmarking();
+void ship_compression_benchmarking();
+void ship_deltas_benchmarking();
+void block_log_benchmarking();
+void snapshot_benchmarking();
+void abi_benchmarking();
+void trace_api_benchmarking();
+void wasm_cache_benchmarking();
+void read_only_benchmarking();
+void account_query_db_benchmarking();
 
 void benchmarking(const std::string& name, const std::function<void()>& func); 
 
@@ -0,0 +1,66 @@
+#include <eosio/chain/block_log.hpp>
+#include <eosio/chain/transaction.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/io/raw.hpp>
+
+#include <benchmark.hpp>
+
+#include <iostream>
+
+// Benchmark serving irreversible blocks from the block log, the way net_plugin serves blocks to syncing peers.
+// "unpack" reads the block into a signed_block and packs it again for the wire, "serialized" sends the bytes as
+// stored in the block log.
+//
+// To run a benchmarking session, in the build directory, type
+//    benchmark/benchmark -f block_log -r 10
+
+namespace eosio::benchmark {
+
+using namespace eosio::chain;
+
+namespace {
+
+constexpr uint32_t num_blocks     = 1000;
+constexpr uint32_t trxs_per_block = 50;
+
+signed_block_ptr make_block(uint32_t block_num) {
+   auto b = std::make_shared<signed_block>();
+   b->previous._hash[0] = fc::endian_reverse_u32(block_num - 1);
+   for (uint32_t i = 0; i < trxs_per_block; ++i) {
+      signed_transaction trx;
+      trx.actions.emplace_back(vector<permission_level>{{name(block_num), "active"_n}}, "eosio.token"_n, "transfer"_n,
+                               bytes(128, char(i)));
+      trx.expiration = fc::time_point_sec{block_num};
+      trx.ref_block_num = i;
+      b->transactions.emplace_back(packed_transaction(std::move(trx)));
+   }
+   return b;
+}
+
+} // anonymous namespace
+
+void block_log_benchmarking() {
+   fc::temp_directory dir;
+   block_log          log(dir.path());
+
+   log.reset(genesis_state{}, make_block(1));
+   for (uint32_t block_num = 2; block_num <= num_blocks; ++block_num) {
+      auto b = make_block(block_num);
+      log.append(b, b->calculate_id(), fc::raw::pack(*b));
+   }
+
+   uint64_t bytes = 0;
+   auto serve_unpacked = [&]() {
+      for (uint32_t block_num = 1; block_num <= num_blocks; ++block_num)
+         bytes += fc::raw::pack(*log.read_block_by_num(block_num)).size();
+   };
+   auto serve_serialized = [&]() {
+      for (uint32_t block_num = 1; block_num <= num_blocks; ++block_num)
+         bytes += log.read_serialized_block_by_num(block_num).size();
+   };
+
+   benchmarking("block_log unpack " + std::to_string(num_blocks) + " blocks", serve_unpacked);
+   benchmarking("block_log serialized " + std::to_string(num_blocks) + " blocks", serve_serialized);
+}
+
+} // benchmark
@@ -4,7 +4,9 @@
 #include <fc/crypto/sha256.hpp>
 #include <fc/crypto/sha512.hpp>
 #include <fc/crypto/ripemd160.hpp>
+#include <fc/io/raw.hpp>
 #include <fc/utility.hpp>
+#include <eosio/chain/merkle.hpp>
 
 #include <benchmark.hpp>
 
@@ -84,6 +86,31 @@ void hash_benchmarking() {
    };
    benchmarking("keccak256 (" + std::to_string(large_message.length()) + " bytes)", keccak_large_msg);
 
+   // merkle root the way the controller computes action and transaction mroots, compared to hashing one pair of
+   // digests at a time through the encoder
+   auto merkle_pairwise = [](std::deque<eosio::chain::digest_type> ids) {
+      while (ids.size() > 1) {
+         if (ids.size() % 2)
+            ids.push_back(ids.back());
+         for (size_t i = 0; i < ids.size() / 2; ++i)
+            ids[i] = eosio::chain::digest_type::hash(eosio::chain::make_canonical_pair(ids[2 * i], ids[2 * i + 1]));
+         ids.resize(ids.size() / 2);
+      }
+      return ids.front();
+   };
+
+   for (size_t num_leaves : {1000, 10000, 100000}) {
+      std::deque<eosio::chain::digest_type> leaves;
+      for (size_t i = 0; i < num_leaves; ++i)
+         leaves.push_back(fc::sha256::hash(std::to_string(i)));
+
+      benchmarking("merkle (" + std::to_string(num_leaves) + " leaves)", [&]() {
+         eosio::chain::merkle(leaves);
+      });
+      benchmarking("merkle pairwise (" + std::to_string(num_leaves) + " leaves)", [&]() {
+         merkle_pairwise(leaves);
+      });
+   }
 }
 
 } // benchmark
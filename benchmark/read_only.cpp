@@ -0,0 +1,78 @@
+#include <eosio/chain/exec_pri_queue.hpp>
+#include <eosio/producer_plugin/ro_trx_queue.hpp>
+
+#include <benchmark.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Benchmark the queues read-only threads contend on: read-only threads popping the read_only and read_exclusive
+// handlers of the executor, and read-only threads exhausting their transactions together at the end of a read window,
+// then one thread popping them to post them again.
+//
+// To run a benchmarking session, in the build directory, type
+//    benchmark/benchmark -f read_only -r 10
+
+namespace eosio::benchmark {
+
+namespace {
+
+constexpr size_t num_tasks = 100000;
+
+void exec_queue_benchmarking(size_t num_read_threads) {
+   auto run = [&]() {
+      appbase::exec_pri_queue que;
+      que.init_read_threads(num_read_threads);
+      std::atomic<size_t> num_executed = 0;
+      for (size_t i = 0; i < num_tasks; ++i) {
+         const appbase::exec_queue q = i % 2 ? appbase::exec_queue::read_only : appbase::exec_queue::read_exclusive;
+         que.add(i % 3, q, i, [&]() { ++num_executed; });
+      }
+
+      que.enable_locking([]() { return false; }); // read threads exit once all are waiting on an empty queue
+      std::vector<std::thread> threads;
+      for (size_t t = 0; t < num_read_threads; ++t) {
+         threads.emplace_back([&]() {
+            while (que.execute_highest_blocking_locked(appbase::exec_queue::read_only, appbase::exec_queue::read_exclusive))
+               ;
+         });
+      }
+      for (auto& t : threads)
+         t.join();
+      que.disable_locking();
+      que.clear();
+   };
+   benchmarking("exec_pri_queue " + std::to_string(num_read_threads) + " read threads", run);
+}
+
+void ro_trx_queue_benchmarking(size_t num_read_threads) {
+   auto run = [&]() {
+      ro_trx_queue<size_t> que;
+      std::vector<std::thread> threads;
+      for (size_t t = 0; t < num_read_threads; ++t) {
+         threads.emplace_back([&, t]() {
+            for (size_t i = t; i < num_tasks; i += num_read_threads)
+               que.push_back(size_t{i});
+         });
+      }
+      for (auto& t : threads)
+         t.join();
+      size_t v = 0;
+      while (que.pop_front(v))
+         ;
+   };
+   benchmarking("ro_trx_queue " + std::to_string(num_read_threads) + " read threads", run);
+}
+
+} // anonymous namespace
+
+void read_only_benchmarking() {
+   for (size_t num_read_threads : {1, 4, 8, 16, 32}) {
+      exec_queue_benchmarking(num_read_threads);
+      ro_trx_queue_benchmarking(num_read_threads);
+   }
+}
+
+} // namespace eosio::benchmark
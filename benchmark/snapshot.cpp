@@ -0,0 +1,95 @@
+#include <eosio/chain/contract_table_objects.hpp>
+#include <eosio/chain/snapshot.hpp>
+#include <eosio/testing/tester.hpp>
+
+#include <benchmark.hpp>
+
+#include <fstream>
+
+// Benchmark loading a snapshot into an empty state, the way nodeos starts from --snapshot. "istream" reads the
+// sections one after another from a stream, "threaded" maps the snapshot and loads independent sections on the
+// controller thread pool.
+//
+// The snapshot is generated from a chain whose contract tables hold about snapshot_mb MiB of key value rows.
+// Every run loads it once, to run a benchmarking session, in the build directory, type
+//    benchmark/benchmark -f snapshot -r 3
+
+namespace eosio::benchmark {
+
+using namespace eosio::chain;
+using namespace eosio::testing;
+
+namespace {
+
+constexpr uint64_t snapshot_mb    = 2048;
+constexpr uint32_t value_size     = 200;
+constexpr uint32_t rows_per_table = 10000;
+
+void fill_contract_tables(chainbase::database& db) {
+   const uint64_t row_size = value_size + 2 * sizeof(uint64_t);
+   for (uint64_t table = 0, total = 0; total < (snapshot_mb << 20); ++table) {
+      const auto& t = db.create<table_id_object>([&](table_id_object& t) {
+         t.code  = "bench"_n;
+         t.scope = name(table);
+         t.table = "rows"_n;
+         t.payer = "bench"_n;
+         t.count = rows_per_table;
+      });
+      for (uint32_t i = 0; i < rows_per_table; ++i) {
+         db.create<key_value_object>([&](key_value_object& kv) {
+            kv.t_id        = t.id;
+            kv.primary_key = i;
+            kv.payer       = "bench"_n;
+            kv.value.resize_and_fill(value_size, [i](char* data, std::size_t size) { memset(data, char(i), size); });
+         });
+      }
+      total += rows_per_table * row_size;
+   }
+}
+
+} // anonymous namespace
+
+void snapshot_benchmarking() {
+   // keep the controller quiet
+   fc::logger::get(DEFAULT_LOGGER).set_log_level(fc::log_level::off);
+
+   fc::temp_directory dir;
+   auto [cfg, genesis] = tester::default_config(dir);
+   cfg.state_size = snapshot_mb * 3 * 1024 * 1024;
+
+   const auto snapshot_path = dir.path() / "snapshot.bin";
+   chain_id_type chain_id = genesis.compute_chain_id();
+   {
+      tester chain(cfg, genesis);
+      chain.produce_block();
+      chain.control->abort_block();
+      fill_contract_tables(chain.control->mutable_db());
+
+      std::ofstream out(snapshot_path, std::ios::out | std::ios::binary);
+      auto writer = std::make_shared<ostream_snapshot_writer>(out);
+      chain.control->write_snapshot(writer);
+      writer->finalize();
+   }
+   std::cout << "snapshot of " << std::filesystem::file_size(snapshot_path) / (1024 * 1024) << " MiB" << std::endl;
+
+   auto load = [&](const snapshot_reader_ptr& reader) {
+      fc::temp_directory load_dir;
+      auto load_cfg       = cfg;
+      load_cfg.blocks_dir = load_dir.path() / config::default_blocks_dir_name;
+      load_cfg.state_dir  = load_dir.path() / config::default_state_dir_name;
+
+      controller control(load_cfg, make_protocol_feature_set(), chain_id);
+      control.add_indices();
+      control.startup([]() {}, []() { return false; }, reader);
+   };
+
+   benchmarking("snapshot load istream", [&]() {
+      std::ifstream in(snapshot_path, std::ios::in | std::ios::binary);
+      load(std::make_shared<istream_snapshot_reader>(in));
+   });
+   benchmarking("snapshot load threaded", [&]() {
+      load(std::make_shared<threaded_snapshot_reader>(snapshot_path));
+   });
+}
+
+} // benchmark
@@ -0,0 +1,286 @@
+#include <eosio/state_history/compression.hpp>
+#include <eosio/state_history/create_deltas.hpp>
+#include <eosio/state_history/log.hpp>
+#include <eosio/state_history/trace_converter.hpp>
+#include <eosio/testing/tester.hpp>
+#include <fc/filesystem.hpp>
+
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/device/null.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include <benchmark.hpp>
+#include <test_contracts.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+
+// Benchmark concurrent readers of a state history log, the way SHiP sessions stream entries to their clients.
+// Every session reads the whole log; the per-run time staying flat while sessions are added shows aggregate
+// throughput scaling with the session count.
+//
+// To run a benchmarking session, in the build directory, type
+//    benchmark/benchmark -f state_history -r 5
+//
+// ship_compression compares the compression of state history log entries. Trace and delta payloads are produced the
+// way state_history_plugin produces them, by a test chain running token transfers. For every codec and level it
+// prints the compression ratio and compress / decompress throughput over all payloads.
+//    benchmark/benchmark -f ship_compression -r 5
+//
+// ship_deltas measures pack_deltas for a block touching a few hot tables of a chain holding many rows, the cost
+// paid by state_history_plugin for every block. A full snapshot of the same chain is measured for comparison.
+//    benchmark/benchmark -f ship_deltas -r 100
+
+namespace eosio::benchmark {
+
+namespace {
+
+constexpr uint32_t num_entries    = 64;
+constexpr size_t   entry_ints     = 256 * 1024; // 1 MiB per entry
+
+chain::block_id_type block_id_for(uint32_t block_num) {
+   auto id    = fc::sha256::hash(std::to_string(block_num));
+   id._hash[0] = fc::endian_reverse_u32(block_num);
+   return id;
+}
+
+uint64_t read_all_entries(state_history_log& log) {
+   uint64_t total = 0;
+   for (uint32_t block_num = 1; block_num <= num_entries; ++block_num) {
+      decompress_stream result;
+      total += log.get_unpacked_entry(block_num, result);
+      std::visit(chain::overloaded{
+         [](std::vector<char>&) {},
+         [](std::unique_ptr<bio::filtering_istreambuf>& strm) {
+            bio::copy(*strm, bio::null_sink());
+         }}, result.buf);
+   }
+   return total;
+}
+
+using payloads_t = std::vector<std::vector<char>>;
+
+template <typename F>
+std::vector<char> pack_payload(F&& pack_to) {
+   std::vector<char> out;
+   {
+      bio::filtering_ostreambuf buf;
+      buf.push(bio::back_inserter(out));
+      pack_to(buf);
+   }
+   return out;
+}
+
+// payloads of trace_history.log and chain_state_history.log for a chain busy with token transfers
+std::pair<payloads_t, payloads_t> generate_payloads() {
+   using namespace eosio::testing;
+   using namespace eosio::chain::literals;
+   using mvo = fc::mutable_variant_object;
+
+   payloads_t                     traces;
+   payloads_t                     deltas;
+   state_history::trace_converter converter;
+
+   tester chain([&](chain::controller& control) {
+      control.applied_transaction.connect(
+         [&](std::tuple<const chain::transaction_trace_ptr&, const chain::packed_transaction_ptr&> t) {
+            converter.add_transaction(std::get<0>(t), std::get<1>(t));
+         });
+      control.accepted_block.connect([&](const chain::block_signal_params& t) {
+         const auto& [block, id] = t;
+         traces.emplace_back(pack_payload([&](auto& buf) { converter.pack(buf, false, block); }));
+         deltas.emplace_back(pack_payload([&](auto& buf) { state_history::pack_deltas(buf, control.db(), deltas.empty()); }));
+      });
+      control.block_start.connect([&](uint32_t) {
+         converter.cached_traces.clear();
+         converter.onblock_trace.reset();
+      });
+   });
+
+   constexpr uint32_t num_accounts = 100;
+   std::vector<chain::account_name> accounts;
+   for (uint32_t i = 0; i < num_accounts; ++i)
+      accounts.emplace_back(chain::name(std::string("user") + char('a' + i / 26 % 26) + char('a' + i % 26)));
+   chain.create_accounts({"eosio.token"_n});
+   chain.create_accounts(accounts);
+   chain.set_code("eosio.token"_n, test_contracts::eosio_token_wasm());
+   chain.set_abi("eosio.token"_n, test_contracts::eosio_token_abi());
+   chain.produce_block();
+
+   chain.push_action("eosio.token"_n, "create"_n, "eosio.token"_n, mvo()("issuer", "eosio.token")("maximum_supply", "1000000000.0000 CUR"));
+   chain.push_action("eosio.token"_n, "issue"_n, "eosio.token"_n, mvo()("to", "eosio.token")("quantity", "1000000000.0000 CUR")("memo", ""));
+   for (const auto& a : accounts)
+      chain.push_action("eosio.token"_n, "transfer"_n, "eosio.token"_n, mvo()("from", "eosio.token")("to", a)("quantity", "10000.0000 CUR")("memo", "initial balance"));
+   chain.produce_block();
+
+   std::mt19937 rng;
+   for (uint32_t block = 0; block < 100; ++block) {
+      for (uint32_t trx = 0; trx < 50; ++trx) {
+         const auto& from = accounts[rng() % num_accounts];
+         const auto& to   = accounts[rng() % num_accounts];
+         if (from == to)
+            continue;
+         chain.push_action("eosio.token"_n, "transfer"_n, from,
+                           mvo()("from", from)("to", to)("quantity", "0.0001 CUR")("memo", "transfer " + std::to_string(rng())));
+      }
+      chain.produce_block();
+   }
+   chain.close();
+   return {std::move(traces), std::move(deltas)};
+}
+
+uint64_t total_size(const payloads_t& payloads) {
+   uint64_t total = 0;
+   for (const auto& p : payloads)
+      total += p.size();
+   return total;
+}
+
+payloads_t compress_all(const payloads_t& payloads, const state_history::compression_config& config) {
+   payloads_t result;
+   result.reserve(payloads.size());
+   for (const auto& p : payloads) {
+      auto& out = result.emplace_back();
+      bio::filtering_ostream comp;
+      state_history::push_compressor(comp, config);
+      comp.push(bio::back_inserter(out));
+      bio::write(comp, p.data(), p.size());
+      bio::close(comp);
+   }
+   return result;
+}
+
+void decompress_all(const payloads_t& compressed, state_history::compression_type type) {
+   for (const auto& c : compressed) {
+      bio::filtering_istreambuf decomp;
+      state_history::push_decompressor(decomp, type);
+      decomp.push(bio::array_source(c.data(), c.size()));
+      bio::copy(decomp, bio::null_sink());
+   }
+}
+
+void compression_benchmarking(const std::string& kind, const payloads_t& payloads) {
+   const double mib = double(total_size(payloads)) / (1024 * 1024);
+   const std::vector<state_history::compression_config> configs = {
+      {state_history::compression_type::zlib, 1}, {state_history::compression_type::zlib, {}},
+      {state_history::compression_type::zlib, 9}, {state_history::compression_type::zstd, 1},
+      {state_history::compression_type::zstd, {}}, {state_history::compression_type::zstd, 9},
+      {state_history::compression_type::zstd, 19}};
+
+   for (const auto& config : configs) {
+      const std::string codec = std::string(to_string(config.type)) + "-" + (config.level ? std::to_string(*config.level) : "default");
+
+      auto start = std::chrono::steady_clock::now();
+      payloads_t compressed = compress_all(payloads, config);
+      const double compress_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      start = std::chrono::steady_clock::now();
+      decompress_all(compressed, config.type);
+      const double decompress_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      std::cout << std::left << std::setw(20) << (kind + " " + codec) << std::right << std::fixed << std::setprecision(2)
+                << " ratio " << std::setw(6) << mib * 1024 * 1024 / total_size(compressed)
+                << "  compress " << std::setw(8) << mib / compress_sec << " MiB/s"
+                << "  decompress " << std::setw(8) << mib / decompress_sec << " MiB/s" << std::endl;
+
+      benchmarking(kind + " " + codec + " compress", [&]() { compress_all(payloads, config); });
+      benchmarking(kind + " " + codec + " decompress", [&]() { decompress_all(compressed, config.type); });
+   }
+}
+
+} // namespace
+
+void ship_compression_benchmarking() {
+   // prevent logging from interwined with output benchmark results
+   fc::logger::get(DEFAULT_LOGGER).set_log_level(fc::log_level::off);
+
+   auto [traces, deltas] = generate_payloads();
+   std::cout << "payloads: " << traces.size() << " traces " << total_size(traces) << " bytes, "
+             << deltas.size() << " deltas " << total_size(deltas) << " bytes" << std::endl;
+
+   compression_benchmarking("traces", traces);
+   compression_benchmarking("deltas", deltas);
+}
+
+void ship_deltas_benchmarking() {
+   using namespace eosio::testing;
+   using namespace eosio::chain::literals;
+   using mvo = fc::mutable_variant_object;
+
+   fc::logger::get(DEFAULT_LOGGER).set_log_level(fc::log_level::off);
+
+   tester chain;
+   chain.create_accounts({"eosio.token"_n});
+   chain.set_code("eosio.token"_n, test_contracts::eosio_token_wasm());
+   chain.set_abi("eosio.token"_n, test_contracts::eosio_token_abi());
+   chain.produce_block();
+   chain.push_action("eosio.token"_n, "create"_n, "eosio.token"_n, mvo()("issuer", "eosio.token")("maximum_supply", "1000000000.0000 CUR"));
+   chain.push_action("eosio.token"_n, "issue"_n, "eosio.token"_n, mvo()("to", "eosio.token")("quantity", "1000000000.0000 CUR")("memo", ""));
+   chain.produce_block();
+
+   // cold rows: accounts, permissions, resource rows and token balances which the measured block does not touch
+   constexpr uint32_t num_accounts = 1000;
+   std::vector<chain::account_name> accounts;
+   for (uint32_t i = 0; i < num_accounts; ++i) {
+      accounts.emplace_back(chain::name(std::string("user") + char('a' + i / 676 % 26) + char('a' + i / 26 % 26) + char('a' + i % 26)));
+      chain.create_account(accounts.back());
+      chain.push_action("eosio.token"_n, "transfer"_n, "eosio.token"_n, mvo()("from", "eosio.token")("to", accounts.back())("quantity", "10.0000 CUR")("memo", ""));
+      if (i % 100 == 99)
+         chain.produce_block();
+   }
+   chain.produce_block();
+
+   // the pending block only touches the balances of a few hot accounts, its undo session is what pack_deltas packs
+   for (uint32_t trx = 0; trx < 20; ++trx) {
+      const auto& from = accounts[trx % 4];
+      const auto& to   = accounts[(trx + 1) % 4];
+      chain.push_action("eosio.token"_n, "transfer"_n, from,
+                        mvo()("from", from)("to", to)("quantity", "0.0001 CUR")("memo", std::to_string(trx)));
+   }
+
+   const auto& db = chain.control->db();
+   auto pack = [&](bool full_snapshot) {
+      bio::filtering_ostreambuf buf;
+      buf.push(bio::null_sink());
+      state_history::pack_deltas(buf, db, full_snapshot);
+   };
+   benchmarking("ship deltas hot block", [&]() { pack(false); });
+   benchmarking("ship deltas full snapshot", [&]() { pack(true); });
+}
+
+void state_history_benchmarking() {
+   fc::temp_directory log_dir;
+   state_history_log  log("ship_bench", log_dir.path());
+
+   std::mt19937 rng;
+   std::vector<int32_t> data(entry_ints);
+   for (uint32_t block_num = 1; block_num <= num_entries; ++block_num) {
+      // half random, half compressible, roughly the ratio seen for traces
+      std::generate_n(data.begin(), data.size() / 2, std::ref(rng));
+      std::fill(data.begin() + data.size() / 2, data.end(), block_num);
+      state_history_log_header header{.block_id = block_id_for(block_num)};
+      log.pack_and_write_entry(header, block_id_for(block_num - 1), [&](auto&& buf) {
+         bio::write(buf, (const char*)data.data(), data.size() * sizeof(data[0]));
+      });
+   }
+
+   const auto mib_per_session = num_entries * entry_ints * sizeof(int32_t) / (1024 * 1024);
+   for (uint32_t sessions : {1, 2, 4, 8, 16}) {
+      auto read_concurrently = [&]() {
+         std::vector<std::thread> threads;
+         for (uint32_t i = 0; i < sessions; ++i)
+            threads.emplace_back([&]() { read_all_entries(log); });
+         for (auto& t : threads)
+            t.join();
+      };
+      benchmarking("ship read " + std::to_string(sessions) + " sessions x " + std::to_string(mib_per_session) + " MiB",
+                   read_concurrently);
+   }
+}
+
+} // benchmark
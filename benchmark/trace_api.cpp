@@ -0,0 +1,65 @@
+#include <eosio/trace_api/store_provider.hpp>
+#include <fc/filesystem.hpp>
+
+#include <benchmark.hpp>
+
+// Benchmark finding the block of a transaction in the trace_api trx id slices, the lookup behind
+// /v1/trace_api/get_transaction_trace. "scan" reads every trx id entry up to the transaction, "indexed" searches the
+// indices the slice maintenance builds once slices are irreversible. "miss" looks up an unknown transaction, which
+// touches every slice.
+//
+// To run a benchmarking session, in the build directory, type
+//    benchmark/benchmark -f trace_api -r 10
+
+namespace eosio::benchmark {
+
+using namespace eosio::trace_api;
+
+namespace {
+
+constexpr uint32_t slice_width    = 100;
+constexpr uint32_t trxs_per_block = 10;
+
+chain::transaction_id_type trx_id_for(uint32_t block_num, uint32_t i) {
+   return fc::sha256::hash(std::to_string(block_num) + "-" + std::to_string(i));
+}
+
+void benchmark_slices(uint32_t num_slices) {
+   fc::temp_directory dir;
+   store_provider sp(dir.path(), slice_width, std::optional<uint32_t>(), std::optional<uint32_t>(), 0);
+
+   const uint32_t last_block = num_slices * slice_width - 1;
+   for (uint32_t block_num = 1; block_num <= last_block; ++block_num) {
+      block_trxs_entry entry{ .block_num = block_num };
+      for (uint32_t i = 0; i < trxs_per_block; ++i)
+         entry.ids.emplace_back(trx_id_for(block_num, i));
+      sp.append_trx_ids(std::move(entry));
+      sp.append_lib(block_num);
+   }
+
+   const auto target = trx_id_for(last_block, trxs_per_block - 1);
+   const auto unknown = trx_id_for(last_block + 1, 0);
+   auto lookup = [&](const chain::transaction_id_type& id) {
+      return [&sp, &id]() { sp.get_trx_block_number(id, std::optional<uint32_t>()); };
+   };
+
+   const std::string name = "trace_api " + std::to_string(num_slices) + " slices ";
+   benchmarking(name + "scan", lookup(target));
+   benchmarking(name + "scan miss", lookup(unknown));
+
+   // a lib past the last slice makes every slice irreversible
+   slice_directory sd(dir.path(), slice_width, std::optional<uint32_t>(), std::optional<uint32_t>(), 0);
+   sd.run_maintenance_tasks(last_block + slice_width + 1, {});
+
+   benchmarking(name + "indexed", lookup(target));
+   benchmarking(name + "indexed miss", lookup(unknown));
+}
+
+} // anonymous namespace
+
+void trace_api_benchmarking() {
+   for (uint32_t num_slices : {1, 100, 1000})
+      benchmark_slices(num_slices);
+}
+
+} // benchmark
@@ -0,0 +1,121 @@
+#include <eosio/chain/instantiated_module_cache.hpp>
+#include <fc/crypto/sha256.hpp>
+
+#include <benchmark.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <list>
+#include <random>
+#include <unordered_map>
+
+// Benchmark the instantiated module cache of wasm_interface by replaying a trace of contract calls against budgets that
+// hold a fraction of all contracts. Contract sizes are spread between 10KiB and 2MiB, and the instantiation time of a
+// contract is its size scaled by a per contract factor, as the number of functions and imports varies. Calls follow a
+// Zipf distribution over the contracts, generated with a fixed seed so each run replays the same trace. A miss spins
+// for the instantiation time of the contract, so the time of a run is dominated by what the eviction policy costs.
+// "lru" replays the same trace against a cache of the same budget evicting the least recently used contracts, as a
+// baseline for the cost aware policy.
+//
+// To run a benchmarking session, in the build directory, type
+//    benchmark/benchmark -f wasm_cache -r 10
+
+namespace eosio::benchmark {
+
+using namespace eosio::chain;
+
+namespace {
+
+constexpr uint32_t num_contracts = 200;
+constexpr uint32_t num_calls     = 20000;
+constexpr double   zipf_exponent = 1.0;
+
+struct contract {
+   digest_type      code_hash;
+   uint64_t         bytes = 0;
+   fc::microseconds instantiation_time;
+};
+
+struct recorded_trace {
+   std::vector<contract> contracts;
+   std::vector<uint32_t> calls; ///< index into contracts
+   uint64_t              total_bytes = 0;
+};
+
+recorded_trace make_trace() {
+   std::mt19937_64 rng(0x5eed);
+   std::uniform_real_distribution<double> log_size(std::log(10.0 * 1024), std::log(2.0 * 1024 * 1024));
+   std::uniform_real_distribution<double> cost_factor(0.5, 4.0);
+
+   recorded_trace trace;
+   for (uint32_t i = 0; i < num_contracts; ++i) {
+      const auto bytes = static_cast<uint64_t>(std::exp(log_size(rng)));
+      trace.contracts.push_back({ .code_hash = fc::sha256::hash(std::to_string(i)),
+                                  .bytes = bytes,
+                                  .instantiation_time = fc::microseconds(static_cast<int64_t>(bytes / 10000 * cost_factor(rng)) + 1) });
+      trace.total_bytes += bytes;
+   }
+
+   std::vector<double> weights;
+   for (uint32_t i = 0; i < num_contracts; ++i)
+      weights.push_back(1.0 / std::pow(i + 1, zipf_exponent));
+   std::discrete_distribution<uint32_t> pick(weights.begin(), weights.end());
+   for (uint32_t i = 0; i < num_calls; ++i)
+      trace.calls.push_back(pick(rng));
+   return trace;
+}
+
+void instantiate(fc::microseconds t) {
+   const auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(t.count());
+   while (std::chrono::steady_clock::now() < end)
+      ;
+}
+
+void replay(const recorded_trace& trace, uint64_t max_bytes) {
+   instantiated_module_cache<uint32_t> cache(max_bytes);
+   for (uint32_t i : trace.calls) {
+      const contract& c = trace.contracts[i];
+      if (cache.find(c.code_hash, 0, 0))
+         continue;
+      instantiate(c.instantiation_time);
+      cache.insert(c.code_hash, 0, 0, i, c.bytes, c.instantiation_time, true);
+   }
+}
+
+void replay_lru(const recorded_trace& trace, uint64_t max_bytes) {
+   std::list<uint32_t> lru; // most recently used first
+   std::unordered_map<uint32_t, std::list<uint32_t>::iterator> cached;
+   uint64_t bytes = 0;
+   for (uint32_t i : trace.calls) {
+      if (auto it = cached.find(i); it != cached.end()) {
+         lru.splice(lru.begin(), lru, it->second);
+         continue;
+      }
+      const contract& c = trace.contracts[i];
+      instantiate(c.instantiation_time);
+      cached[i] = lru.insert(lru.begin(), i);
+      bytes += c.bytes;
+      while (bytes > max_bytes && lru.size() > 1) {
+         bytes -= trace.contracts[lru.back()].bytes;
+         cached.erase(lru.back());
+         lru.pop_back();
+      }
+   }
+}
+
+} // anonymous namespace
+
+void wasm_cache_benchmarking() {
+   const recorded_trace trace = make_trace();
+   for (uint32_t pct : {10, 25, 50, 100}) {
+      const uint64_t max_bytes = trace.total_bytes * pct / 100;
+      benchmarking("wasm cache " + std::to_string(pct) + "% budget", [&]() {
+         replay(trace, max_bytes);
+      });
+      benchmarking("wasm cache " + std::to_string(pct) + "% budget lru", [&]() {
+         replay_lru(trace, max_bytes);
+      });
+   }
+}
+
+} // benchmark
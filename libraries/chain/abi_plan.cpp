@@ -0,0 +1,435 @@
+#include <eosio/chain/abi_plan.hpp>
+#include <eosio/chain/asset.hpp>
+#include <eosio/chain/exceptions.hpp>
+#include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/io/varint.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <charconv>
+#include <set>
+
+namespace eosio { namespace chain {
+
+   namespace {
+
+   template <typename T>
+   T unpack_value( fc::datastream<const char*>& stream ) {
+      T v;
+      fc::raw::unpack( stream, v );
+      return v;
+   }
+
+   // integers as fc::json writes them from a fc::variant, the ones that do not fit in 32 bits are quoted
+   template <typename T>
+   void append_integer( std::string& out, T v ) {
+      constexpr int64_t max_value = 0xffffffff;
+      bool quote;
+      if constexpr( std::is_signed_v<T> )
+         quote = v > max_value || v < -max_value;
+      else
+         quote = v > static_cast<uint64_t>(max_value);
+
+      char buf[24];
+      auto r = std::to_chars( buf, buf + sizeof(buf), v );
+      if( quote ) out += '"';
+      out.append( buf, r.ptr );
+      if( quote ) out += '"';
+   }
+
+   void append_string( std::string& out, std::string_view s ) {
+      out += '"';
+      out += fc::escape_string( s, {} );
+      out += '"';
+   }
+
+   } // anonymous namespace
+
+   abi_plan::abi_plan( abi_serializer_ptr serializer )
+   : abis(std::move(serializer))
+   {
+      EOS_ASSERT( abis, abi_exception, "abi_plan requires an abi_serializer" );
+      for( const auto& t : abis->built_in_types )
+         compile( t.first );
+      for( const auto& t : abis->typedefs )
+         compile( t.first );
+      for( const auto& s : abis->structs )
+         compile( s.first );
+      for( const auto& v : abis->variants )
+         compile( v.first );
+      for( const auto& a : abis->actions )
+         compile( a.second );
+      for( const auto& t : abis->tables )
+         compile( t.second );
+      for( const auto& r : abis->action_results )
+         compile( r.second );
+   }
+
+   size_t abi_plan::memory_size()const {
+      size_t size = sizeof(*this) + nodes.capacity() * sizeof(node) + fields.capacity() * sizeof(field)
+                    + alternatives.capacity() * sizeof(alternative);
+      for( const auto& n : nodes )
+         size += n.type.capacity();
+      for( const auto& f : fields )
+         size += f.name.capacity() + f.key.capacity();
+      for( const auto& a : alternatives )
+         size += a.tag.capacity();
+      for( const auto& t : types )
+         size += 4 * sizeof(void*) + sizeof(t) + t.first.capacity();
+      return size;
+   }
+
+   std::optional<abi_plan::type_id> abi_plan::find_type( std::string_view type )const {
+      auto itr = types.find( type );
+      if( itr == types.end() )
+         return {};
+      return itr->second;
+   }
+
+   abi_plan::type_id abi_plan::compile( std::string_view type ) {
+      if( auto itr = types.find( type ); itr != types.end() )
+         return itr->second;
+
+      // registered before its members are compiled, so recursive types refer to it
+      const type_id id = nodes.size();
+      nodes.emplace_back().type = type;
+      types.emplace( type, id );
+
+      // resolved the way abi_serializer::_binary_to_variant() resolves it
+      auto rtype = abis->resolve_type( type );
+      auto ftype = abis->fundamental_type( rtype );
+      if( auto btype = abis->built_in_types.find( ftype ); btype != abis->built_in_types.end() ) {
+         static const std::map<std::string_view, builtin_kind> direct = {
+            {"bool", builtin_kind::uint8},   {"uint8", builtin_kind::uint8},         {"uint16", builtin_kind::uint16},
+            {"uint32", builtin_kind::uint32}, {"uint64", builtin_kind::uint64},       {"int8", builtin_kind::int8},
+            {"int16", builtin_kind::int16},   {"int32", builtin_kind::int32},         {"int64", builtin_kind::int64},
+            {"varuint32", builtin_kind::varuint32}, {"varint32", builtin_kind::varint32}, {"name", builtin_kind::name},
+            {"string", builtin_kind::string}, {"asset", builtin_kind::asset}
+         };
+         auto& n       = nodes[id];
+         n.kind        = node_kind::builtin;
+         n.is_array    = abis->is_array( rtype );
+         n.is_optional = abis->is_optional( rtype );
+         n.unpack      = &btype->second.first;
+         if( auto d = direct.find( ftype ); d != direct.end() && !abis->specialized_types.count( ftype ) )
+            n.builtin = d->second;
+         return id;
+      }
+
+      if( abis->is_array( rtype ) || abis->is_optional( rtype ) ) {
+         const bool array = abis->is_array( rtype );
+         const type_id element = compile( ftype );
+         nodes[id].kind    = array ? node_kind::array : node_kind::optional;
+         nodes[id].element = element;
+         return id;
+      }
+
+      if( auto v_itr = abis->variants.find( rtype ); v_itr != abis->variants.end() ) {
+         std::vector<alternative> alts;
+         for( const auto& t : v_itr->second.types )
+            alts.push_back( alternative{ .tag = "[\"" + fc::escape_string( t, {} ) + "\",", .type = compile( t ) } );
+         nodes[id].kind  = node_kind::variant;
+         nodes[id].first = alternatives.size();
+         nodes[id].count = alts.size();
+         std::move( alts.begin(), alts.end(), std::back_inserter( alternatives ) );
+         return id;
+      }
+
+      // a struct repeating a field of its base replaces the value in place, left to the abi_serializer
+      if( auto s_itr = abis->structs.find( rtype ); s_itr != abis->structs.end() && !has_duplicate_fields( s_itr->second ) )
+         return compile_struct( id, s_itr->second );
+
+      return id;
+   }
+
+   abi_plan::type_id abi_plan::compile_struct( type_id id, const struct_def& st ) {
+      type_id base = no_type;
+      if( st.base != type_name() ) {
+         base = compile( abis->resolve_type( st.base ) );
+         if( nodes[base].kind != node_kind::struct_type )
+            return id;
+      }
+
+      std::vector<field> own;
+      for( const auto& f : st.fields ) {
+         const bool extension = boost::algorithm::ends_with( f.type, "$" );
+         auto ftype = abis->resolve_type( extension ? abi_serializer::_remove_bin_extension( f.type ) : f.type );
+         own.push_back( field{ .name = f.name, .key = "\"" + fc::escape_string( f.name, {} ) + "\":",
+                               .type = compile( ftype ), .extension = extension } );
+      }
+      auto& n = nodes[id];
+      n.kind  = node_kind::struct_type;
+      n.base  = base;
+      n.first = fields.size();
+      n.count = own.size();
+      std::move( own.begin(), own.end(), std::back_inserter( fields ) );
+      return id;
+   }
+
+   bool abi_plan::has_duplicate_fields( const struct_def& st )const {
+      std::set<std::string_view> names;
+      for( const struct_def* s = &st; s; ) {
+         for( const auto& f : s->fields ) {
+            if( !names.insert( f.name ).second )
+               return true;
+         }
+         if( s->base == type_name() )
+            break;
+         auto itr = abis->structs.find( abis->resolve_type( s->base ) );
+         s = itr != abis->structs.end() ? &itr->second : nullptr;
+      }
+      return false;
+   }
+
+   void abi_plan::binary_to_json( std::string_view type, fc::datastream<const char*>& stream, std::string& out, const yield_function_t& yield )const {
+      if( auto id = find_type( type ) ) {
+         binary_to_json( *id, stream, out, yield );
+      } else {
+         out += fc::json::to_string( abis->binary_to_variant( type, stream, yield ), fc::time_point::maximum() );
+      }
+   }
+
+   void abi_plan::binary_to_json( type_id type, fc::datastream<const char*>& stream, std::string& out, const yield_function_t& yield )const {
+      EOS_ASSERT( type < nodes.size(), invalid_type_inside_abi, "Unknown type id ${id}", ("id", type) );
+      write( type, stream, out, yield, 1 );
+   }
+
+   std::string abi_plan::binary_to_json( std::string_view type, const bytes& binary, const yield_function_t& yield )const {
+      std::string out;
+      out.reserve( binary.size() * 2 );
+      fc::datastream<const char*> ds( binary.data(), binary.size() );
+      binary_to_json( type, ds, out, yield );
+      return out;
+   }
+
+   fc::variant abi_plan::binary_to_variant( std::string_view type, fc::datastream<const char*>& stream, const yield_function_t& yield )const {
+      if( auto id = find_type( type ) )
+         return to_variant( *id, stream, yield, 1 );
+      return abis->binary_to_variant( type, stream, yield );
+   }
+
+   fc::variant abi_plan::binary_to_variant( std::string_view type, const bytes& binary, const yield_function_t& yield )const {
+      fc::datastream<const char*> ds( binary.data(), binary.size() );
+      return binary_to_variant( type, ds, yield );
+   }
+
+   fc::variant abi_plan::to_variant( type_id id, fc::datastream<const char*>& stream, const yield_function_t& yield, size_t depth )const {
+      const node& n = nodes[id];
+      yield( ++depth );
+      switch( n.kind ) {
+         case node_kind::builtin:
+            // the abi_serializer unpacks every built-in type, including the ones written directly as JSON, this way
+            try {
+               return (*n.unpack)( stream, n.is_array, n.is_optional, yield );
+            } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack ${class} type '${type}'",
+                                      ("class", n.is_array ? "array of built-in" : n.is_optional ? "optional of built-in" : "built-in")
+                                      ("type", impl::limit_size(n.type)) )
+         case node_kind::array: {
+            fc::unsigned_int size;
+            try {
+               fc::raw::unpack( stream, size );
+            } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack size of array '${t}'", ("t", impl::limit_size(n.type)) )
+            fc::variants vars;
+            vars.reserve( std::min<size_t>( size.value, stream.remaining() ) );
+            for( uint32_t i = 0; i < size.value; ++i )
+               vars.emplace_back( to_variant( n.element, stream, yield, depth ) );
+            return fc::variant( std::move( vars ) );
+         }
+         case node_kind::optional: {
+            char flag;
+            try {
+               fc::raw::unpack( stream, flag );
+            } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack presence flag of optional '${t}'", ("t", impl::limit_size(n.type)) )
+            return flag ? to_variant( n.element, stream, yield, depth ) : fc::variant();
+         }
+         case node_kind::variant: {
+            fc::unsigned_int select;
+            try {
+               fc::raw::unpack( stream, select );
+            } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack tag of variant '${t}'", ("t", impl::limit_size(n.type)) )
+            EOS_ASSERT( select.value < n.count, unpack_exception,
+                        "Unpacked invalid tag (${select}) for variant '${t}'", ("select", select.value)("t", impl::limit_size(n.type)) );
+            const auto& alt = alternatives[n.first + select.value];
+            return fc::variants{ fc::variant( nodes[alt.type].type ), to_variant( alt.type, stream, yield, depth ) };
+         }
+         case node_kind::struct_type: {
+            fc::mutable_variant_object mvo;
+            to_variant_fields( n, stream, mvo, yield, depth );
+            EOS_ASSERT( mvo.size() > 0, unpack_exception, "Unable to unpack '${t}' from stream", ("t", impl::limit_size(n.type)) );
+            return fc::variant( std::move( mvo ) );
+         }
+         case node_kind::fallback:
+            return abis->binary_to_variant( n.type, stream, yield );
+      }
+      return {};
+   }
+
+   void abi_plan::to_variant_fields( const node& n, fc::datastream<const char*>& stream, fc::mutable_variant_object& obj,
+                                     const yield_function_t& yield, size_t depth )const {
+      if( n.base != no_type ) {
+         yield( ++depth );
+         to_variant_fields( nodes[n.base], stream, obj, yield, depth );
+      }
+      bool encountered_extension = false;
+      for( uint32_t i = n.first; i < n.first + n.count; ++i ) {
+         const auto& f = fields[i];
+         encountered_extension |= f.extension;
+         if( !stream.remaining() ) {
+            if( f.extension )
+               continue;
+            if( encountered_extension ) {
+               EOS_THROW( abi_exception, "Encountered field '${f}' without binary extension designation while processing struct '${p}'",
+                          ("f", impl::limit_size(f.name))("p", impl::limit_size(n.type)) );
+            }
+            EOS_THROW( unpack_exception, "Stream unexpectedly ended; unable to unpack field '${f}' of struct '${p}'",
+                       ("f", impl::limit_size(f.name))("p", impl::limit_size(n.type)) );
+         }
+         obj( f.name, to_variant( f.type, stream, yield, depth ) );
+      }
+   }
+
+   namespace impl {
+      fc::variant plan_binary_to_variant( const abi_plan& plan, std::string_view type, const bytes& binary,
+                                          const abi_serializer::yield_function_t& yield ) {
+         return plan.binary_to_variant( type, binary, yield );
+      }
+   }
+
+   void abi_plan::write( type_id id, fc::datastream<const char*>& stream, std::string& out, const yield_function_t& yield, size_t depth )const {
+      const node& n = nodes[id];
+      yield( ++depth );
+      switch( n.kind ) {
+         case node_kind::builtin:
+            write_builtin( n, stream, out, yield );
+            return;
+         case node_kind::array: {
+            fc::unsigned_int size;
+            try {
+               fc::raw::unpack( stream, size );
+            } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack size of array '${t}'", ("t", impl::limit_size(n.type)) )
+            out += '[';
+            for( uint32_t i = 0; i < size.value; ++i ) {
+               if( i )
+                  out += ',';
+               write( n.element, stream, out, yield, depth );
+            }
+            out += ']';
+            return;
+         }
+         case node_kind::optional: {
+            char flag;
+            try {
+               fc::raw::unpack( stream, flag );
+            } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack presence flag of optional '${t}'", ("t", impl::limit_size(n.type)) )
+            if( flag )
+               write( n.element, stream, out, yield, depth );
+            else
+               out += "null";
+            return;
+         }
+         case node_kind::variant: {
+            fc::unsigned_int select;
+            try {
+               fc::raw::unpack( stream, select );
+            } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack tag of variant '${t}'", ("t", impl::limit_size(n.type)) )
+            EOS_ASSERT( select.value < n.count, unpack_exception,
+                        "Unpacked invalid tag (${select}) for variant '${t}'", ("select", select.value)("t", impl::limit_size(n.type)) );
+            const auto& alt = alternatives[n.first + select.value];
+            out += alt.tag;
+            write( alt.type, stream, out, yield, depth );
+            out += ']';
+            return;
+         }
+         case node_kind::struct_type: {
+            size_t written = 0;
+            out += '{';
+            write_fields( n, stream, out, yield, depth, written );
+            EOS_ASSERT( written > 0, unpack_exception, "Unable to unpack '${t}' from stream", ("t", impl::limit_size(n.type)) );
+            out += '}';
+            return;
+         }
+         case node_kind::fallback:
+            out += fc::json::to_string( abis->binary_to_variant( n.type, stream, yield ), fc::time_point::maximum() );
+            return;
+      }
+   }
+
+   void abi_plan::write_fields( const node& n, fc::datastream<const char*>& stream, std::string& out, const yield_function_t& yield,
+                                size_t depth, size_t& written )const {
+      if( n.base != no_type ) {
+         yield( ++depth );
+         write_fields( nodes[n.base], stream, out, yield, depth, written );
+      }
+      bool encountered_extension = false;
+      for( uint32_t i = n.first; i < n.first + n.count; ++i ) {
+         const auto& f = fields[i];
+         encountered_extension |= f.extension;
+         if( !stream.remaining() ) {
+            if( f.extension )
+               continue;
+            if( encountered_extension ) {
+               EOS_THROW( abi_exception, "Encountered field '${f}' without binary extension designation while processing struct '${p}'",
+                          ("f", impl::limit_size(f.name))("p", impl::limit_size(n.type)) );
+            }
+            EOS_THROW( unpack_exception, "Stream unexpectedly ended; unable to unpack field '${f}' of struct '${p}'",
+                       ("f", impl::limit_size(f.name))("p", impl::limit_size(n.type)) );
+         }
+         if( written++ )
+            out += ',';
+         out += f.key;
+         write( f.type, stream, out, yield, depth );
+      }
+   }
+
+   void abi_plan::write_builtin( const node& n, fc::datastream<const char*>& stream, std::string& out, const yield_function_t& yield )const {
+      try {
+         if( n.builtin == builtin_kind::other ) {
+            // only this value goes through a fc::variant
+            out += fc::json::to_string( (*n.unpack)( stream, n.is_array, n.is_optional, yield ), fc::time_point::maximum() );
+            return;
+         }
+
+         auto write_value = [&]() {
+            switch( n.builtin ) {
+               case builtin_kind::uint8:     append_integer( out, unpack_value<uint8_t>( stream ) ); break;
+               case builtin_kind::uint16:    append_integer( out, unpack_value<uint16_t>( stream ) ); break;
+               case builtin_kind::uint32:    append_integer( out, unpack_value<uint32_t>( stream ) ); break;
+               case builtin_kind::uint64:    append_integer( out, unpack_value<uint64_t>( stream ) ); break;
+               case builtin_kind::int8:      append_integer( out, unpack_value<int8_t>( stream ) ); break;
+               case builtin_kind::int16:     append_integer( out, unpack_value<int16_t>( stream ) ); break;
+               case builtin_kind::int32:     append_integer( out, unpack_value<int32_t>( stream ) ); break;
+               case builtin_kind::int64:     append_integer( out, unpack_value<int64_t>( stream ) ); break;
+               case builtin_kind::varuint32: append_integer( out, uint64_t(unpack_value<fc::unsigned_int>( stream ).value) ); break;
+               case builtin_kind::varint32:  append_integer( out, int64_t(unpack_value<fc::signed_int>( stream ).value) ); break;
+               case builtin_kind::name:      append_string( out, unpack_value<name>( stream ).to_string() ); break;
+               case builtin_kind::string:    append_string( out, unpack_value<std::string>( stream ) ); break;
+               case builtin_kind::asset:     append_string( out, unpack_value<asset>( stream ).to_string() ); break;
+               case builtin_kind::other:     break;
+            }
+         };
+
+         // arrays and optionals of built-in types are unpacked as a std::vector and a std::optional are
+         if( n.is_array ) {
+            auto size = unpack_value<fc::unsigned_int>( stream );
+            FC_ASSERT( size.value <= MAX_NUM_ARRAY_ELEMENTS );
+            out += '[';
+            for( uint32_t i = 0; i < size.value; ++i ) {
+               if( i )
+                  out += ',';
+               write_value();
+            }
+            out += ']';
+         } else if( n.is_optional ) {
+            if( unpack_value<bool>( stream ) )
+               write_value();
+            else
+               out += "null";
+         } else {
+            write_value();
+         }
+      } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack ${class} type '${type}'",
+                                ("class", n.is_array ? "array of built-in" : n.is_optional ? "optional of built-in" : "built-in")
+                                ("type", impl::limit_size(n.type)) )
+   }
+
+} } // namespace eosio::chain
@@ -84,6 +84,7 @@ namespace eosio { namespace chain {
    void abi_serializer::add_specialized_unpack_pack( const string& name,
                                                      std::pair<abi_serializer::unpack_function, abi_serializer::pack_function> unpack_pack ) {
       built_in_types[name] = std::move( unpack_pack );
+      specialized_types.insert( name );
    }
 
    void abi_serializer::configure_built_in_types() {
@@ -193,6 +194,38 @@ namespace eosio { namespace chain {
       return set_abi(abi, create_yield_function(max_serialization_time));
    }
 
+   size_t abi_serializer::memory_size()const {
+      // a map node holds its value and about four pointers, strings are counted by capacity when not stored inline
+      constexpr size_t node_overhead = 4 * sizeof(void*);
+      auto str_size = [](const string& s) { return s.capacity() > string().capacity() ? s.capacity() + 1 : 0; };
+      size_t size = sizeof(*this);
+      for( const auto& [type, unpack_pack] : built_in_types )
+         size += node_overhead + sizeof(string) + sizeof(unpack_pack) + str_size(type);
+      for( const auto& type : specialized_types )
+         size += node_overhead + sizeof(string) + str_size(type);
+      for( const auto& [new_type, type] : typedefs )
+         size += node_overhead + 2 * sizeof(string) + str_size(new_type) + str_size(type);
+      for( const auto& [type, st] : structs ) {
+         size += node_overhead + sizeof(string) + sizeof(struct_def) + str_size(type) + str_size(st.name) + str_size(st.base);
+         size += st.fields.capacity() * sizeof(field_def);
+         for( const auto& f : st.fields )
+            size += str_size(f.name) + str_size(f.type);
+      }
+      for( const auto* m : { &actions, &tables, &action_results } ) {
+         for( const auto& [n, type] : *m )
+            size += node_overhead + sizeof(name) + sizeof(string) + str_size(type);
+      }
+      for( const auto& [code, msg] : error_messages )
+         size += node_overhead + sizeof(uint64_t) + sizeof(string) + str_size(msg);
+      for( const auto& [type, v] : variants ) {
+         size += node_overhead + sizeof(string) + sizeof(variant_def) + str_size(type) + str_size(v.name);
+         size += v.types.capacity() * sizeof(string);
+         for( const auto& t : v.types )
+            size += str_size(t);
+      }
+      return size;
+   }
+
    bool abi_serializer::is_builtin_type(const std::string_view& type)const {
       return built_in_types.find(type) != built_in_types.end();
    }
@@ -185,6 +185,24 @@ namespace eosio { namespace chain {
          return block;
       }
 
+      template <typename Stream>
+      std::vector<char> read_serialized_block(Stream&& ds, uint64_t block_size, uint32_t expect_block_num) {
+         std::vector<char> buff;
+         buff.resize(block_size);
+         ds.read(buff.data(), buff.size());
+
+         // block number of the previous block is at bytes 14:17, big endian, see block_log_data::block_num_at
+         constexpr size_t blknum_offset = 14;
+         uint32_t         prev_block_num;
+         EOS_ASSERT(buff.size() >= blknum_offset + sizeof(prev_block_num), block_log_exception,
+                    "Invalid size ${s} of block ${n} in block log", ("s", buff.size())("n", expect_block_num));
+         memcpy(&prev_block_num, buff.data() + blknum_offset, sizeof(prev_block_num));
+         EOS_ASSERT(fc::endian_reverse_u32(prev_block_num) + 1 == expect_block_num, block_log_exception,
+                    "Wrong block was read from block log.");
+
+         return buff;
+      }
+
       template <typename Stream>
       signed_block_header read_block_header(Stream&& ds, uint32_t expect_block_num) {
          signed_block_header bh;
@@ -485,6 +503,7 @@ namespace eosio { namespace chain {
          virtual void     flush()                                                             = 0;
 
          virtual signed_block_ptr                   read_block_by_num(uint32_t block_num)        = 0;
+         virtual std::vector<char>                  read_serialized_block_by_num(uint32_t block_num) = 0;
          virtual std::optional<signed_block_header> read_block_header_by_num(uint32_t block_num) = 0;
 
          virtual uint32_t version() const = 0;
@@ -518,6 +537,7 @@ namespace eosio { namespace chain {
          void flush() final {}
 
          signed_block_ptr read_block_by_num(uint32_t block_num) final { return {}; };
+         std::vector<char> read_serialized_block_by_num(uint32_t block_num) final { return {}; };
          std::optional<signed_block_header> read_block_header_by_num(uint32_t block_num) final { return {}; };
 
          uint32_t         version() const final { return 0; }
@@ -562,6 +582,7 @@ namespace eosio { namespace chain {
          virtual uint32_t         working_block_file_first_block_num() { return preamble.first_block_num; }
          virtual void             post_append(uint64_t pos) {}
          virtual signed_block_ptr retry_read_block_by_num(uint32_t block_num) { return {}; }
+         virtual std::vector<char> retry_read_serialized_block_by_num(uint32_t block_num) { return {}; }
          virtual std::optional<signed_block_header> retry_read_block_header_by_num(uint32_t block_num) { return {}; }
 
          void append(const signed_block_ptr& b, const block_id_type& id,
@@ -615,6 +636,28 @@ namespace eosio { namespace chain {
             FC_LOG_AND_RETHROW()
          }
 
+         std::vector<char> read_serialized_block_by_num(uint32_t block_num) final {
+            try {
+               uint64_t pos = get_block_pos(block_num);
+               if (pos != block_log::npos) {
+                  // a block entry is the packed block followed by its position
+                  uint64_t end_pos;
+                  if (block_num < block_header::num_from_id(head->id)) {
+                     end_pos = get_block_pos(block_num + 1);
+                  } else {
+                     block_file.seek_end(preamble.is_currently_pruned() ? -sizeof(uint32_t) : 0);
+                     end_pos = block_file.tellp();
+                  }
+                  EOS_ASSERT(end_pos >= pos + sizeof(uint64_t), block_log_exception,
+                             "Invalid position of block ${n} in block log", ("n", block_num));
+                  block_file.seek(pos);
+                  return read_serialized_block(block_file, end_pos - pos - sizeof(uint64_t), block_num);
+               }
+               return retry_read_serialized_block_by_num(block_num);
+            }
+            FC_LOG_AND_RETHROW()
+         }
+
          std::optional<signed_block_header> read_block_header_by_num(uint32_t block_num) final {
             try {
                uint64_t pos = get_block_pos(block_num);
@@ -1032,6 +1075,19 @@ namespace eosio { namespace chain {
             return {};
          }
 
+         std::vector<char> retry_read_serialized_block_by_num(uint32_t block_num) final {
+            auto pos = catalog.get_block_position(block_num);
+            if (!pos)
+               return {};
+            // get_block_position() opened the retained log containing block_num
+            const uint32_t n = block_num - catalog.log_data.first_block_num();
+            const uint64_t end_pos = n + 1 < catalog.log_index.num_blocks() ? catalog.log_index.nth_block_position(n + 1)
+                                                                            : catalog.log_data.end_of_block_position();
+            EOS_ASSERT(end_pos >= *pos + sizeof(uint64_t), block_log_exception,
+                       "Invalid position of block ${n} in retained block log", ("n", block_num));
+            return read_serialized_block(catalog.log_data.ro_stream_at(*pos), end_pos - *pos - sizeof(uint64_t), block_num);
+         }
+
          std::optional<signed_block_header> retry_read_block_header_by_num(uint32_t block_num) final {
             auto ds = catalog.ro_stream_for_block(block_num);
             if (ds)
@@ -1230,6 +1286,11 @@ namespace eosio { namespace chain {
       return my->read_block_by_num(block_num);
    }
 
+   std::vector<char> block_log::read_serialized_block_by_num(uint32_t block_num) const {
+      std::lock_guard g(my->mtx);
+      return my->read_serialized_block_by_num(block_num);
+   }
+
    std::optional<signed_block_header> block_log::read_block_header_by_num(uint32_t block_num) const {
       std::lock_guard g(my->mtx);
       return my->read_block_header_by_num(block_num);
@@ -22,6 +22,7 @@
 #include <eosio/chain/authorization_manager.hpp>
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/subjective_billing.hpp>
+#include <eosio/chain/signature_recovery_cache.hpp>
 #include <eosio/chain/chain_snapshot.hpp>
 #include <eosio/chain/thread_utils.hpp>
 #include <eosio/chain/platform_timer.hpp>
@@ -35,8 +36,10 @@
 #include <fc/variant_object.hpp>
 #include <bls12-381/bls12-381.hpp>
 
+#include <condition_variable>
 #include <new>
 #include <shared_mutex>
+#include <thread>
 #include <utility>
 
 namespace eosio { namespace chain {
@@ -112,6 +115,113 @@ class maybe_session {
       std::optional<database::session>     _session;
 };
 
+/**
+ * Emplaces the key value rows of the contract tables on its own thread, in the order they were decoded, while the
+ * thread reading the contract_tables section goes on decoding and creating the rows of the other indices.
+ */
+class key_value_row_loader {
+public:
+   using rows_t = std::vector<std::pair<table_id_object::id_type, snapshot_key_value_object>>;
+
+   static constexpr size_t batch_size  = 4096;
+   static constexpr size_t max_batches = 16;
+
+   explicit key_value_row_loader(chainbase::database& db)
+   : _db(db)
+   , _thread([this]() { run(); })
+   {
+      _batch.reserve(batch_size);
+   }
+
+   ~key_value_row_loader() {
+      if (_thread.joinable()) {
+         // reading the section failed, drop what is left
+         {
+            std::lock_guard g(_mtx);
+            _batches.clear();
+            _done = true;
+            _cv.notify_all();
+         }
+         _thread.join();
+      }
+   }
+
+   void add(table_id_object::id_type t_id, snapshot_key_value_object&& row) {
+      _batch.emplace_back(t_id, std::move(row));
+      if (_batch.size() == batch_size) {
+         std::unique_lock g(_mtx);
+         _cv.wait(g, [this]() { return _batches.size() < max_batches || _except; });
+         rethrow_if_failed();
+         _batches.emplace_back(std::move(_batch));
+         _cv.notify_all();
+         _batch = rows_t();
+         _batch.reserve(batch_size);
+      }
+   }
+
+   // waits for all rows to be emplaced
+   void finish() {
+      finish_batches();
+      _thread.join();
+      std::lock_guard g(_mtx);
+      rethrow_if_failed();
+   }
+
+private:
+   void finish_batches() {
+      std::lock_guard g(_mtx);
+      if (_done)
+         return;
+      if (!_batch.empty())
+         _batches.emplace_back(std::move(_batch));
+      _done = true;
+      _cv.notify_all();
+   }
+
+   void rethrow_if_failed() {
+      if (_except)
+         std::rethrow_exception(std::exchange(_except, nullptr));
+   }
+
+   void run() {
+      fc::set_thread_name("snapshot-kv");
+      try {
+         while (true) {
+            rows_t rows;
+            {
+               std::unique_lock g(_mtx);
+               _cv.wait(g, [this]() { return !_batches.empty() || _done; });
+               if (_batches.empty())
+                  return;
+               rows = std::move(_batches.front());
+               _batches.pop_front();
+               _cv.notify_all();
+            }
+            for (auto& [t_id, row] : rows) {
+               _db.create<key_value_object>([&](key_value_object& kv) {
+                  kv.t_id = t_id;
+                  detail::snapshot_row_traits<key_value_object>::from_snapshot_row(std::move(row), kv, _db);
+               });
+            }
+         }
+      } catch (...) {
+         std::lock_guard g(_mtx);
+         _except = std::current_exception();
+         _batches.clear();
+         _cv.notify_all();
+      }
+   }
+
+   chainbase::database&    _db;
+   rows_t                  _batch;
+   std::mutex              _mtx;
+   std::condition_variable _cv;
+   std::deque<rows_t>      _batches;
+   bool                    _done = false;
+   std::exception_ptr      _except;
+   std::thread             _thread; // last, started once everything else is constructed
+};
+
 struct building_block {
    building_block( const block_header_state_legacy& prev,
                    block_timestamp_type when,
@@ -254,8 +364,10 @@ struct controller_impl {
    uint32_t                        snapshot_head_block = 0;
    struct chain; // chain is a namespace so use an embedded type for the named_thread_pool tag
    named_thread_pool<chain>        thread_pool;
+   signature_recovery_cache        sig_recovery_cache; // thread-safe, used by thread_pool threads
    deep_mind_handler*              deep_mind_logger = nullptr;
    bool                            okay_to_print_integrity_hash_on_stop = false;
+   static constexpr uint64_t       integrity_hash_contract_rows = 100'000; ///< contract table rows per part of the version 2 integrity hash
    std::atomic<bool>               writing_snapshot = false;
 
    thread_local static platform_timer timer; // a copy for main thread and each read-only thread
@@ -321,7 +433,9 @@ struct controller_impl {
     chain_id( chain_id ),
     read_mode( cfg.read_mode ),
     thread_pool(),
-    wasmif( conf.wasm_runtime, conf.eosvmoc_tierup, db, conf.state_dir, conf.eosvmoc_config, !conf.profile_accounts.empty() )
+    sig_recovery_cache( cfg.signature_recovery_cache_size ),
+    wasmif( conf.wasm_runtime, conf.eosvmoc_tierup, db, conf.state_dir, conf.eosvmoc_config, !conf.profile_accounts.empty(),
+            conf.wasm_instantiation_cache_size )
    {
       fork_db.open( [this]( block_timestamp_type timestamp,
                             const flat_set<digest_type>& cur_features,
@@ -509,6 +623,48 @@ struct controller_impl {
       initialize_database(genesis);
    }
 
+   // maximum number of irreversible blocks read and prepared ahead of the block being applied during replay
+   static constexpr uint32_t replay_prefetch_blocks = 64;
+
+   // a block read from the block log and prepared on the thread pool ahead of its apply during replay
+   struct replay_block {
+      signed_block_ptr                      block;
+      std::vector<transaction_metadata_ptr> trx_metas; // in the order of the packed transactions of block
+      fc::microseconds                      read_time;
+      fc::microseconds                      unpack_time;
+      fc::microseconds                      recover_time;
+   };
+
+   // thread-safe, block is empty if block_num is not in the block log
+   replay_block read_replay_block( uint32_t block_num, bool recover_keys ) const {
+      replay_block r;
+      auto start = fc::time_point::now();
+      std::vector<char> packed = blog.read_serialized_block_by_num( block_num );
+      auto read_end = fc::time_point::now();
+      r.read_time = read_end - start;
+      if( packed.empty() )
+         return r;
+
+      auto b = std::make_shared<signed_block>();
+      fc::datastream<const char*> ds( packed.data(), packed.size() );
+      fc::raw::unpack( ds, *b );
+      auto unpack_end = fc::time_point::now();
+      r.unpack_time = unpack_end - read_end;
+
+      r.trx_metas.reserve( b->transactions.size() );
+      for( const auto& receipt : b->transactions ) {
+         if( std::holds_alternative<packed_transaction>(receipt.trx) ) {
+            packed_transaction_ptr ptrx( b, &std::get<packed_transaction>(receipt.trx) ); // alias signed_block_ptr
+            r.trx_metas.emplace_back( recover_keys
+               ? transaction_metadata::recover_keys( std::move(ptrx), chain_id, fc::microseconds::maximum(), transaction_metadata::trx_type::input )
+               : transaction_metadata::create_no_recover_keys( std::move(ptrx), transaction_metadata::trx_type::input ) );
+         }
+      }
+      r.recover_time = fc::time_point::now() - unpack_end;
+      r.block = std::move( b );
+      return r;
+   }
+
    void replay(std::function<bool()> check_shutdown) {
       auto blog_head = blog.head();
       if( !fork_db.root() ) {
@@ -526,18 +682,63 @@ struct controller_impl {
       if( blog_head && start_block_num <= blog_head->block_num() ) {
          ilog( "existing block log, attempting to replay from ${s} to ${n} blocks",
                ("s", start_block_num)("n", blog_head->block_num()) );
+         // Blocks are read, unpacked and their transaction metadata created, including key recovery when all
+         // checks are forced, on the thread pool up to replay_prefetch_blocks ahead of the block being applied.
+         const bool recover_keys = conf.force_all_checks;
+         const uint32_t last_block_num = blog_head->block_num();
+         uint32_t next_read_block_num = start_block_num;
+         std::deque<std::future<replay_block>> prefetched;
+         auto prefetch = [&]() {
+            while( prefetched.size() < replay_prefetch_blocks && next_read_block_num <= last_block_num ) {
+               prefetched.emplace_back( post_async_task( thread_pool.get_executor(), [this, block_num=next_read_block_num++, recover_keys]() {
+                  return read_replay_block( block_num, recover_keys );
+               } ) );
+            }
+         };
+         // blocks still being prepared reference this controller
+         auto wait_prefetched = fc::make_scoped_exit([&prefetched]() {
+            for( auto& f : prefetched ) {
+               if( f.valid() ) f.wait();
+            }
+         });
+
+         fc::microseconds read_time, unpack_time, recover_time, wait_time, apply_time;
          try {
-            while( auto next = blog.read_block_by_num( head->block_num + 1 ) ) {
-               replay_push_block( next, controller::block_status::irreversible );
+            prefetch();
+            while( !prefetched.empty() ) {
+               auto wait_start = fc::time_point::now();
+               replay_block next = prefetched.front().get();
+               prefetched.pop_front();
+               auto apply_start = fc::time_point::now();
+               wait_time += apply_start - wait_start;
+               if( !next.block ) break;
+               prefetch();
+
+               read_time += next.read_time;
+               unpack_time += next.unpack_time;
+               recover_time += next.recover_time;
+
+               size_t next_trx = 0;
+               auto trx_lookup = [&trx_metas=next.trx_metas, &next_trx]( const transaction_id_type& id ) -> transaction_metadata_ptr {
+                  if( next_trx < trx_metas.size() && trx_metas[next_trx]->id() == id )
+                     return trx_metas[next_trx++];
+                  return {};
+               };
+               replay_push_block( next.block, controller::block_status::irreversible, trx_lookup );
+               apply_time += fc::time_point::now() - apply_start;
                if( check_shutdown() ) break;
-               if( next->block_num() % 500 == 0 ) {
-                  ilog( "${n} of ${head}", ("n", next->block_num())("head", blog_head->block_num()) );
+               if( next.block->block_num() % 500 == 0 ) {
+                  ilog( "${n} of ${head}", ("n", next.block->block_num())("head", blog_head->block_num()) );
                }
             }
          } catch(  const database_guard_exception& e ) {
             except_ptr = std::current_exception();
          }
          ilog( "${n} irreversible blocks replayed", ("n", 1 + head->block_num - start_block_num) );
+         ilog( "replay stages, on thread pool: read ${r} ms, unpack ${u} ms, create transaction metadata ${k} ms; "
+               "on main thread: apply ${a} ms, waiting for prefetched blocks ${w} ms",
+               ("r", read_time.count()/1000)("u", unpack_time.count()/1000)("k", recover_time.count()/1000)
+               ("a", apply_time.count()/1000)("w", wait_time.count()/1000) );
 
          auto pending_head = fork_db.pending_head();
          if( pending_head ) {
@@ -741,9 +942,14 @@ struct controller_impl {
       }
 
       if( conf.integrity_hash_on_start )
-         ilog( "chain database started with hash: ${hash}", ("hash", calculate_integrity_hash()) );
+         ilog( "chain database started with hash: ${hash}", ("hash", calculate_integrity_hash( conf.integrity_hash_version )) );
       okay_to_print_integrity_hash_on_stop = true;
 
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+      // code objects are available now, compile hot contracts missing from the code cache while replaying
+      wasmif.eos_vm_oc_preload();
+#endif
+
       replay( check_shutdown ); // replay any irreversible and reversible blocks ahead of current head
 
       if( check_shutdown() ) return;
@@ -773,8 +979,14 @@ struct controller_impl {
       thread_pool.stop();
       pending.reset();
       //only log this not just if configured to, but also if initialization made it to the point we'd log the startup too
-      if(okay_to_print_integrity_hash_on_stop && conf.integrity_hash_on_stop)
-         ilog( "chain database stopped with hash: ${hash}", ("hash", calculate_integrity_hash()) );
+      if(okay_to_print_integrity_hash_on_stop && conf.integrity_hash_on_stop) {
+         // version 2 is calculated on the thread pool, restart it now that the pending block is gone
+         if( conf.integrity_hash_version > 1 )
+            thread_pool.start( conf.thread_pool_size, []( const fc::exception& e ) {
+               elog( "Exception in chain thread pool, calculating integrity hash: ${e}", ("e", e.to_detail_string()) );
+            } );
+         ilog( "chain database stopped with hash: ${hash}", ("hash", calculate_integrity_hash( conf.integrity_hash_version )) );
+      }
    }
 
    void add_indices() {
@@ -795,9 +1007,12 @@ struct controller_impl {
                   */
    }
 
-   void add_contract_tables_to_snapshot( const snapshot_writer_ptr& snapshot ) const {
-      snapshot->write_section("contract_tables", [this]( auto& section ) {
-         index_utils<table_id_multi_index>::walk(db, [this, &section]( const table_id_object& table_row ){
+   // the tables with an id in [first, last)
+   void add_contract_tables_to_snapshot( const snapshot_writer_ptr& snapshot,
+                                         table_id_object::id_type first = table_id_object::id_type(0),
+                                         table_id_object::id_type last = table_id_object::id_type(std::numeric_limits<int64_t>::max()) ) const {
+      snapshot->write_section("contract_tables", [this, first, last]( auto& section ) {
+         index_utils<table_id_multi_index>::walk_range<by_id>(db, first, last, [this, &section]( const table_id_object& table_row ){
             // add a row for the table
             section.add_row(table_row, db);
 
@@ -821,8 +1036,12 @@ struct controller_impl {
       });
    }
 
-   void read_contract_tables_from_snapshot( const snapshot_reader_ptr& snapshot ) {
-      snapshot->read_section("contract_tables", [this]( auto& section ) {
+   void read_contract_tables_from_snapshot( const snapshot_reader_ptr& snapshot, bool concurrent = false ) {
+      std::optional<key_value_row_loader> key_value_loader;
+      if (concurrent)
+         key_value_loader.emplace(db);
+
+      snapshot->read_section("contract_tables", [this, &key_value_loader]( auto& section ) {
          bool more = !section.empty();
          while (more) {
             // read the row for the table
@@ -833,12 +1052,24 @@ struct controller_impl {
             });
 
             // read the size and data rows for each type of table
-            contract_database_index_set::walk_indices([this, &section, &t_id, &more](auto utils) {
+            contract_database_index_set::walk_indices([this, &section, &t_id, &more, &key_value_loader](auto utils) {
                using utils_t = decltype(utils);
+               using value_t = typename utils_t::index_t::value_type;
 
                unsigned_int size;
                more = section.read_row(size, db);
 
+               if constexpr (std::is_same_v<value_t, key_value_object>) {
+                  if (key_value_loader) {
+                     for (size_t idx = 0; idx < size.value; idx++) {
+                        snapshot_key_value_object row;
+                        more = section.read_row(row);
+                        key_value_loader->add(t_id, std::move(row));
+                     }
+                     return;
+                  }
+               }
+
                for (size_t idx = 0; idx < size.value; idx++) {
                   utils_t::create(db, [this, &section, &more, &t_id](auto& row) {
                      row.t_id = t_id;
@@ -848,22 +1079,31 @@ struct controller_impl {
             });
          }
       });
-   }
 
-   void add_to_snapshot( const snapshot_writer_ptr& snapshot ) {
-      // clear in case the previous call to clear did not finish in time of deadline
-      clear_expired_input_transactions( fc::time_point::maximum() );
+      if (key_value_loader)
+         key_value_loader->finish();
+   }
 
-      snapshot->write_section<chain_snapshot_header>([this]( auto &section ){
-         section.add_row(chain_snapshot_header(), db);
-      });
+   /**
+    * Calls add with every part of the snapshot, in snapshot order. A part is a callable writing one or more sections
+    * into the snapshot_writer it is given. Parts only read the state, they can be written concurrently into separate
+    * writers. When max_contract_rows is not 0 the contract tables are split in parts of about that many rows.
+    */
+   template<typename F>
+   void for_each_snapshot_part( F&& add, uint64_t max_contract_rows = 0 ) const {
+      add([this]( const snapshot_writer_ptr& snapshot ) {
+         snapshot->write_section<chain_snapshot_header>([this]( auto &section ){
+            section.add_row(chain_snapshot_header(), db);
+         });
 
-      snapshot->write_section("eosio::chain::block_state", [this]( auto &section ){
-         section.template add_row<block_header_state_legacy>(*head, db);
+         snapshot->write_section("eosio::chain::block_state", [this]( auto &section ){
+            section.template add_row<block_header_state_legacy>(*head, db);
+         });
       });
 
-      controller_index_set::walk_indices([this, &snapshot]( auto utils ){
-         using value_t = typename decltype(utils)::index_t::value_type;
+      controller_index_set::walk_indices([this, &add]( auto utils ){
+         using utils_t = decltype(utils);
+         using value_t = typename utils_t::index_t::value_type;
 
          // skip the table_id_object as its inlined with contract tables section
          if (std::is_same<value_t, table_id_object>::value) {
@@ -875,17 +1115,43 @@ struct controller_impl {
             return;
          }
 
-         snapshot->write_section<value_t>([this]( auto& section ){
-            decltype(utils)::walk(db, [this, &section]( const auto &row ) {
-               section.add_row(row, db);
+         add([this]( const snapshot_writer_ptr& snapshot ) {
+            snapshot->write_section<value_t>([this]( auto& section ){
+               utils_t::walk(db, [this, &section]( const auto &row ) {
+                  section.add_row(row, db);
+               });
             });
          });
       });
 
-      add_contract_tables_to_snapshot(snapshot);
+      if (max_contract_rows == 0) {
+         add([this]( const snapshot_writer_ptr& snapshot ) { add_contract_tables_to_snapshot(snapshot); });
+      } else {
+         // table_id_object::count is the number of rows of the table in all its indices
+         table_id_object::id_type first(0);
+         uint64_t rows = 0;
+         index_utils<table_id_multi_index>::walk(db, [this, &add, &first, &rows, max_contract_rows]( const table_id_object& table_row ) {
+            if (rows >= max_contract_rows) {
+               add([this, first, last = table_row.id]( const snapshot_writer_ptr& snapshot ) {
+                  add_contract_tables_to_snapshot(snapshot, first, last);
+               });
+               first = table_row.id;
+               rows = 0;
+            }
+            rows += table_row.count + 1;
+         });
+         add([this, first]( const snapshot_writer_ptr& snapshot ) { add_contract_tables_to_snapshot(snapshot, first); });
+      }
 
-      authorization.add_to_snapshot(snapshot);
-      resource_limits.add_to_snapshot(snapshot);
+      add([this]( const snapshot_writer_ptr& snapshot ) { authorization.add_to_snapshot(snapshot); });
+      add([this]( const snapshot_writer_ptr& snapshot ) { resource_limits.add_to_snapshot(snapshot); });
+   }
+
+   void add_to_snapshot( const snapshot_writer_ptr& snapshot ) {
+      // clear in case the previous call to clear did not finish in time of deadline
+      clear_expired_input_transactions( fc::time_point::maximum() );
+
+      for_each_snapshot_part([&snapshot]( auto&& part ) { part(snapshot); });
    }
 
    static std::optional<genesis_state> extract_legacy_genesis_state( snapshot_reader& snapshot, uint32_t version ) {
@@ -937,8 +1203,25 @@ struct controller_impl {
          static_cast<block_header_state_legacy&>(*head) = head_header_state;
       }
 
-      controller_index_set::walk_indices([this, &snapshot, &header]( auto utils ){
-         using value_t = typename decltype(utils)::index_t::value_type;
+      // Every section below fills its own indices. When the reader can be cloned, they are loaded concurrently on
+      // the thread pool, each with its own reader.
+      const bool concurrent = !!snapshot->clone();
+      std::vector<std::future<void>> loads;
+      auto wait_for_loads = fc::make_scoped_exit([&loads]() {
+         for (auto& f : loads)
+            f.wait();
+      });
+      auto load = [&](auto&& f) {
+         if (concurrent) {
+            loads.emplace_back(post_async_task(thread_pool.get_executor(), [f, reader = snapshot->clone()]() { f(reader); }));
+         } else {
+            f(snapshot);
+         }
+      };
+
+      controller_index_set::walk_indices([this, &load, &header]( auto utils ){
+         using utils_t = decltype(utils);
+         using value_t = typename utils_t::index_t::value_type;
 
          // skip the table_id_object as its inlined with contract tables section
          if (std::is_same<value_t, table_id_object>::value) {
@@ -950,69 +1233,76 @@ struct controller_impl {
             return;
          }
 
-         // special case for in-place upgrade of global_property_object
-         if (std::is_same<value_t, global_property_object>::value) {
-            using v2 = legacy::snapshot_global_property_object_v2;
-            using v3 = legacy::snapshot_global_property_object_v3;
-            using v4 = legacy::snapshot_global_property_object_v4;
-
-            if (std::clamp(header.version, v2::minimum_version, v2::maximum_version) == header.version ) {
-               std::optional<genesis_state> genesis = extract_legacy_genesis_state(*snapshot, header.version);
-               EOS_ASSERT( genesis, snapshot_exception,
-                           "Snapshot indicates chain_snapshot_header version 2, but does not contain a genesis_state. "
-                           "It must be corrupted.");
-               snapshot->read_section<global_property_object>([&db=this->db,gs_chain_id=genesis->compute_chain_id()]( auto &section ) {
-                  v2 legacy_global_properties;
-                  section.read_row(legacy_global_properties, db);
-
-                  db.create<global_property_object>([&legacy_global_properties,&gs_chain_id](auto& gpo ){
-                     gpo.initalize_from(legacy_global_properties, gs_chain_id, kv_database_config{},
-                                       genesis_state::default_initial_wasm_configuration);
+         load([this, &header](const snapshot_reader_ptr& snapshot) {
+            // special case for in-place upgrade of global_property_object
+            if (std::is_same<value_t, global_property_object>::value) {
+               using v2 = legacy::snapshot_global_property_object_v2;
+               using v3 = legacy::snapshot_global_property_object_v3;
+               using v4 = legacy::snapshot_global_property_object_v4;
+
+               if (std::clamp(header.version, v2::minimum_version, v2::maximum_version) == header.version ) {
+                  std::optional<genesis_state> genesis = extract_legacy_genesis_state(*snapshot, header.version);
+                  EOS_ASSERT( genesis, snapshot_exception,
+                              "Snapshot indicates chain_snapshot_header version 2, but does not contain a genesis_state. "
+                              "It must be corrupted.");
+                  snapshot->read_section<global_property_object>([&db=this->db,gs_chain_id=genesis->compute_chain_id()]( auto &section ) {
+                     v2 legacy_global_properties;
+                     section.read_row(legacy_global_properties, db);
+
+                     db.create<global_property_object>([&legacy_global_properties,&gs_chain_id](auto& gpo ){
+                        gpo.initalize_from(legacy_global_properties, gs_chain_id, kv_database_config{},
+                                          genesis_state::default_initial_wasm_configuration);
+                     });
                   });
-               });
-               return; // early out to avoid default processing
-            }
+                  return; // early out to avoid default processing
+               }
 
-            if (std::clamp(header.version, v3::minimum_version, v3::maximum_version) == header.version ) {
-               snapshot->read_section<global_property_object>([&db=this->db]( auto &section ) {
-                  v3 legacy_global_properties;
-                  section.read_row(legacy_global_properties, db);
+               if (std::clamp(header.version, v3::minimum_version, v3::maximum_version) == header.version ) {
+                  snapshot->read_section<global_property_object>([&db=this->db]( auto &section ) {
+                     v3 legacy_global_properties;
+                     section.read_row(legacy_global_properties, db);
 
-                  db.create<global_property_object>([&legacy_global_properties](auto& gpo ){
-                     gpo.initalize_from(legacy_global_properties, kv_database_config{},
-                                        genesis_state::default_initial_wasm_configuration);
+                     db.create<global_property_object>([&legacy_global_properties](auto& gpo ){
+                        gpo.initalize_from(legacy_global_properties, kv_database_config{},
+                                           genesis_state::default_initial_wasm_configuration);
+                     });
                   });
-               });
-               return; // early out to avoid default processing
-            }
+                  return; // early out to avoid default processing
+               }
 
-            if (std::clamp(header.version, v4::minimum_version, v4::maximum_version) == header.version) {
-               snapshot->read_section<global_property_object>([&db = this->db](auto& section) {
-                  v4 legacy_global_properties;
-                  section.read_row(legacy_global_properties, db);
+               if (std::clamp(header.version, v4::minimum_version, v4::maximum_version) == header.version) {
+                  snapshot->read_section<global_property_object>([&db = this->db](auto& section) {
+                     v4 legacy_global_properties;
+                     section.read_row(legacy_global_properties, db);
 
-                  db.create<global_property_object>([&legacy_global_properties](auto& gpo) {
-                     gpo.initalize_from(legacy_global_properties);
+                     db.create<global_property_object>([&legacy_global_properties](auto& gpo) {
+                        gpo.initalize_from(legacy_global_properties);
+                     });
                   });
-               });
-               return; // early out to avoid default processing
+                  return; // early out to avoid default processing
+               }
             }
-         }
 
-         snapshot->read_section<value_t>([this]( auto& section ) {
-            bool more = !section.empty();
-            while(more) {
-               decltype(utils)::create(db, [this, &section, &more]( auto &row ) {
-                  more = section.read_row(row, db);
-               });
-            }
+            snapshot->read_section<value_t>([this]( auto& section ) {
+               bool more = !section.empty();
+               while(more) {
+                  utils_t::create(db, [this, &section, &more]( auto &row ) {
+                     more = section.read_row(row, db);
+                  });
+               }
+            });
          });
       });
 
-      read_contract_tables_from_snapshot(snapshot);
+      load([this, concurrent](const snapshot_reader_ptr& snapshot) { read_contract_tables_from_snapshot(snapshot, concurrent); });
+      load([this](const snapshot_reader_ptr& snapshot) { authorization.read_from_snapshot(snapshot); });
+      load([this](const snapshot_reader_ptr& snapshot) { resource_limits.read_from_snapshot(snapshot); });
 
-      authorization.read_from_snapshot(snapshot);
-      resource_limits.read_from_snapshot(snapshot);
+      wait_for_loads.cancel();
+      for (auto& f : loads)
+         f.wait();
+      for (auto& f : loads)
+         f.get();
 
       db.set_revision( head->block_num );
       db.create<database_header_object>([](const auto& header){
@@ -1026,13 +1316,46 @@ struct controller_impl {
       );
    }
 
-   fc::sha256 calculate_integrity_hash() {
-      fc::sha256::encoder enc;
-      auto hash_writer = std::make_shared<integrity_hash_snapshot_writer>(enc);
-      add_to_snapshot(hash_writer);
-      hash_writer->finalize();
+   fc::sha256 calculate_integrity_hash( uint32_t version ) {
+      EOS_ASSERT( version == 1 || version == 2, misc_exception, "Unknown integrity hash version ${v}", ("v", version) );
+
+      if (version == 1) {
+         fc::sha256::encoder enc;
+         auto hash_writer = std::make_shared<integrity_hash_snapshot_writer>(enc);
+         add_to_snapshot(hash_writer);
+         hash_writer->finalize();
+
+         return enc.result();
+      }
+
+      // clear in case the previous call to clear did not finish in time of deadline
+      clear_expired_input_transactions( fc::time_point::maximum() );
 
-      return enc.result();
+      // every part hashes its sections on the thread pool, the state is not modified until they are all done
+      std::vector<std::future<std::vector<fc::sha256>>> parts;
+      auto wait_for_parts = fc::make_scoped_exit([&parts]() {
+         for (auto& f : parts)
+            f.wait();
+      });
+      for_each_snapshot_part([this, &parts]( auto&& part ) {
+         parts.emplace_back( post_async_task( thread_pool.get_executor(), [part]() {
+            auto hash_writer = std::make_shared<section_hash_snapshot_writer>();
+            part(hash_writer);
+            hash_writer->finalize();
+            return hash_writer->section_hashes();
+         }) );
+      }, integrity_hash_contract_rows);
+
+      wait_for_parts.cancel();
+      for (auto& f : parts)
+         f.wait();
+
+      deque<digest_type> hashes;
+      for (auto& f : parts) {
+         for (auto& h : f.get())
+            hashes.emplace_back(h);
+      }
+      return merkle( std::move(hashes) );
    }
 
    void create_native_account( const fc::time_point& initial_timestamp, account_name name, const authority& owner, const authority& active, bool is_privileged = false ) {
@@ -2098,7 +2421,8 @@ struct controller_impl {
                   } else {
                      packed_transaction_ptr ptrx( b, &pt ); // alias signed_block_ptr
                      auto fut = transaction_metadata::start_recover_keys(
-                           std::move( ptrx ), thread_pool.get_executor(), chain_id, fc::microseconds::maximum(), transaction_metadata::trx_type::input  );
+                           std::move( ptrx ), thread_pool.get_executor(), chain_id, fc::microseconds::maximum(), transaction_metadata::trx_type::input,
+                           UINT32_MAX, &sig_recovery_cache );
                      trx_metas.emplace_back( transaction_metadata_ptr{}, std::move( fut ) );
                   }
                }
@@ -2275,7 +2599,8 @@ struct controller_impl {
       } FC_LOG_AND_RETHROW( )
    }
 
-   void replay_push_block( const signed_block_ptr& b, controller::block_status s ) {
+   void replay_push_block( const signed_block_ptr& b, controller::block_status s,
+                           const trx_meta_cache_lookup& trx_lookup = trx_meta_cache_lookup{} ) {
       self.validate_db_available_size();
 
       EOS_ASSERT(!pending, block_validate_exception, "it is not valid to push a block when there is a pending block");
@@ -2312,7 +2637,7 @@ struct controller_impl {
 
          controller::block_report br;
          if( s == controller::block_status::irreversible ) {
-            apply_block( br, bsp, s, trx_meta_cache_lookup{} );
+            apply_block( br, bsp, s, trx_lookup );
 
             // On replay, log_irreversible is not called and so no irreversible_block signal is emitted.
             // So emit it explicitly here.
@@ -2988,6 +3313,10 @@ boost::asio::io_context& controller::get_thread_pool() {
    return my->thread_pool.get_executor();
 }
 
+signature_recovery_cache& controller::get_signature_recovery_cache() {
+   return my->sig_recovery_cache;
+}
+
 std::future<block_state_legacy_ptr> controller::create_block_state_future( const block_id_type& id, const signed_block_ptr& b ) {
    return my->create_block_state_future( id, b );
 }
@@ -3198,6 +3527,15 @@ signed_block_ptr controller::fetch_block_by_number( uint32_t block_num )const  {
    return my->blog.read_block_by_num(block_num);
 } FC_CAPTURE_AND_RETHROW( (block_num) ) }
 
+std::vector<char> controller::fetch_serialized_block_by_number( uint32_t block_num )const  { try {
+   auto blk_state = fetch_block_state_by_number( block_num );
+   if( blk_state ) {
+      return fc::raw::pack(*blk_state->block);
+   }
+
+   return my->blog.read_serialized_block_by_num(block_num);
+} FC_CAPTURE_AND_RETHROW( (block_num) ) }
+
 std::optional<signed_block_header> controller::fetch_block_header_by_number( uint32_t block_num )const  { try {
    auto blk_state = fetch_block_state_by_number( block_num );
    if( blk_state ) {
@@ -3234,10 +3572,14 @@ block_id_type controller::get_block_id_for_num( uint32_t block_num )const { try
    return id;
 } FC_CAPTURE_AND_RETHROW( (block_num) ) }
 
-fc::sha256 controller::calculate_integrity_hash() { try {
-   return my->calculate_integrity_hash();
+fc::sha256 controller::calculate_integrity_hash( uint32_t version ) { try {
+   return my->calculate_integrity_hash( version );
 } FC_LOG_AND_RETHROW() }
 
+fc::sha256 controller::calculate_integrity_hash() {
+   return calculate_integrity_hash( my->conf.integrity_hash_version );
+}
+
 void controller::write_snapshot( const snapshot_writer_ptr& snapshot ) {
    EOS_ASSERT( !my->pending, block_validate_exception, "cannot take a consistent snapshot with a pending block" );
    my->writing_snapshot.store(true, std::memory_order_release);
@@ -3408,6 +3750,10 @@ validation_mode controller::get_validation_mode()const {
    return my->conf.block_validation_mode;
 }
 
+uint32_t controller::get_integrity_hash_version()const {
+   return my->conf.integrity_hash_version;
+}
+
 uint32_t controller::get_terminate_at_block()const {
    return my->conf.terminate_at_block;
 }
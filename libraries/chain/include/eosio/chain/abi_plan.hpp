@@ -0,0 +1,106 @@
+#pragma once
+#include <eosio/chain/abi_serializer.hpp>
+
+namespace eosio::chain {
+
+/**
+ *  An ABI compiled into a flat plan for converting binary data to JSON.
+ *
+ *  Every type of the ABI, and every type used by its structs, variants, actions, tables and action results, is
+ *  resolved once into a node referring to other nodes by id, so converting a value does no lookup by type name.
+ *  binary_to_json() writes the JSON directly from the binary data without building a fc::variant tree, the result is
+ *  the same as fc::json::to_string() of abi_serializer::binary_to_variant() for the same data. binary_to_variant()
+ *  returns the same fc::variant as abi_serializer::binary_to_variant(), for callers that need one.
+ *
+ *  A plan is immutable once compiled and can be used from several threads. It shares ownership of the abi_serializer
+ *  it was compiled from, so it stays valid when that serializer is evicted from a cache.
+ */
+class abi_plan {
+public:
+   using type_id          = uint32_t;
+   using yield_function_t = abi_serializer::yield_function_t;
+
+   explicit abi_plan( abi_serializer_ptr abis );
+
+   const abi_serializer_ptr& get_serializer()const { return abis; }
+
+   /// @return id of type if it was compiled into the plan
+   std::optional<type_id> find_type( std::string_view type )const;
+
+   /// Appends the JSON of a value of type to out. A type that is not in the plan is converted by the abi_serializer.
+   void binary_to_json( std::string_view type, fc::datastream<const char*>& stream, std::string& out, const yield_function_t& yield )const;
+   void binary_to_json( type_id type, fc::datastream<const char*>& stream, std::string& out, const yield_function_t& yield )const;
+   std::string binary_to_json( std::string_view type, const bytes& binary, const yield_function_t& yield )const;
+
+   /// Same result as abi_serializer::binary_to_variant(), errors are reported without the path into the value
+   fc::variant binary_to_variant( std::string_view type, fc::datastream<const char*>& stream, const yield_function_t& yield )const;
+   fc::variant binary_to_variant( std::string_view type, const bytes& binary, const yield_function_t& yield )const;
+
+   size_t num_types()const { return nodes.size(); }
+
+   /// @return estimate of the memory used by the plan, not including its abi_serializer
+   size_t memory_size()const;
+
+private:
+   enum class node_kind : uint8_t {
+      builtin,
+      array,
+      optional,
+      struct_type,
+      variant,
+      fallback    ///< converted by the abi_serializer, for the few ABIs a plan can not express
+   };
+
+   /// built-in types written directly, all others are unpacked to a fc::variant by their abi_serializer function
+   enum class builtin_kind : uint8_t {
+      uint8, uint16, uint32, uint64, int8, int16, int32, int64, varuint32, varint32, name, string, asset, other
+   };
+
+   static constexpr type_id no_type = std::numeric_limits<type_id>::max();
+
+   struct node {
+      node_kind                              kind        = node_kind::fallback;
+      builtin_kind                           builtin     = builtin_kind::other;
+      bool                                   is_array    = false; ///< of a built-in type
+      bool                                   is_optional = false; ///< of a built-in type
+      type_id                                element     = no_type; ///< of an array or optional
+      type_id                                base        = no_type; ///< of a struct
+      uint32_t                               first       = 0; ///< first field of a struct or alternative of a variant
+      uint32_t                               count       = 0;
+      const abi_serializer::unpack_function* unpack      = nullptr; ///< builtin_kind::other
+      std::string                            type; ///< as named in the ABI
+   };
+
+   struct field {
+      std::string name;
+      std::string key; ///< "name":
+      type_id     type      = no_type;
+      bool        extension = false;
+   };
+
+   struct alternative {
+      std::string tag; ///< ["type",
+      type_id     type = no_type;
+   };
+
+   type_id compile( std::string_view type );
+   type_id compile_struct( type_id id, const struct_def& st );
+   bool    has_duplicate_fields( const struct_def& st )const;
+
+   void write( type_id id, fc::datastream<const char*>& stream, std::string& out, const yield_function_t& yield, size_t depth )const;
+   void write_fields( const node& n, fc::datastream<const char*>& stream, std::string& out, const yield_function_t& yield,
+                      size_t depth, size_t& written )const;
+   void write_builtin( const node& n, fc::datastream<const char*>& stream, std::string& out, const yield_function_t& yield )const;
+
+   fc::variant to_variant( type_id id, fc::datastream<const char*>& stream, const yield_function_t& yield, size_t depth )const;
+   void        to_variant_fields( const node& n, fc::datastream<const char*>& stream, fc::mutable_variant_object& obj,
+                                  const yield_function_t& yield, size_t depth )const;
+
+   abi_serializer_ptr                          abis;
+   std::vector<node>                           nodes;
+   std::vector<field>                          fields;
+   std::vector<alternative>                    alternatives;
+   std::map<std::string, type_id, std::less<>> types;
+};
+
+} // namespace eosio::chain
@@ -3,6 +3,7 @@
 #include <eosio/chain/trace.hpp>
 #include <eosio/chain/contract_types.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <set>
 #include <utility>
 #include <fc/variant_object.hpp>
 #include <fc/scoped_exit.hpp>
@@ -16,6 +17,8 @@ using std::function;
 using std::pair;
 using namespace fc;
 
+class abi_plan;
+
 namespace impl {
    struct abi_from_variant;
    struct abi_to_variant;
@@ -67,6 +70,9 @@ struct abi_serializer {
 
    std::optional<string>  get_error_message( uint64_t error_code )const;
 
+   /// @return estimate of the memory used by this serializer and the ABI it parsed
+   size_t memory_size()const;
+
    fc::variant binary_to_variant( const std::string_view& type, const bytes& binary, const yield_function_t& yield, bool short_path = false )const;
    fc::variant binary_to_variant( const std::string_view& type, const bytes& binary, const fc::microseconds& max_action_data_serialization_time, bool short_path = false )const;
    fc::variant binary_to_variant( const std::string_view& type, fc::datastream<const char*>& binary, const yield_function_t& yield, bool short_path = false )const;
@@ -148,6 +154,7 @@ private:
    map<name,type_name>                        action_results;
 
    map<type_name, pair<unpack_function, pack_function>, std::less<>> built_in_types;
+   std::set<type_name, std::less<>>                                 specialized_types; ///< built-in types replaced by add_specialized_unpack_pack
    void configure_built_in_types();
 
    fc::variant _binary_to_variant( const std::string_view& type, const bytes& binary, impl::binary_to_variant_context& ctx )const;
@@ -167,10 +174,16 @@ private:
    friend struct impl::abi_from_variant;
    friend struct impl::abi_to_variant;
    friend struct impl::abi_traverse_context_with_path;
+   friend class abi_plan;
 };
 
 namespace impl {
    const static size_t hex_log_max_size = 64;
+
+   /// abi_plan::binary_to_variant(), defined with abi_plan
+   fc::variant plan_binary_to_variant( const abi_plan& plan, std::string_view type, const bytes& binary,
+                                       const abi_serializer::yield_function_t& yield );
+
    struct abi_traverse_context {
       abi_traverse_context( abi_serializer::yield_function_t yield, fc::microseconds max_action_data_serialization )
       : yield(std::move( yield ))
@@ -511,7 +524,15 @@ namespace impl {
                if (!type.empty()) {
                   try {
                      action_data_to_variant_context _ctx(abi, ctx, type);
-                     mvo( "data", abi._binary_to_variant( type, act.data, _ctx ));
+                     const abi_plan* plan = nullptr;
+                     if constexpr( requires { resolver.get_plan( act.account ); } ) {
+                        if( !ctx.is_logging() )
+                           plan = resolver.get_plan( act.account );
+                     }
+                     if( plan )
+                        mvo( "data", plan_binary_to_variant( *plan, type, act.data, _ctx.get_yield_function() ));
+                     else
+                        mvo( "data", abi._binary_to_variant( type, act.data, _ctx ));
                   } catch(...) {
                      // any failure to serialize data, then leave as not serialized
                      set_hex_data(mvo, "data", act.data);
@@ -1002,8 +1023,11 @@ void abi_serializer::from_variant( const fc::variant& v, T& o, const Resolver& r
    impl::abi_from_variant::extract(v, o, resolver, ctx);
 } FC_RETHROW_EXCEPTIONS(error, "Failed to deserialize variant", ("variant",v))
 
-using abi_serializer_cache_t = std::unordered_map<account_name, std::optional<abi_serializer>>;
-using resolver_fn_t = std::function<std::optional<abi_serializer>(const account_name& name)>;
+using abi_serializer_ptr = std::shared_ptr<const abi_serializer>; // shared so parsed ABIs can be cached across requests
+using abi_serializer_cache_t = std::unordered_map<account_name, abi_serializer_ptr>;
+using abi_plan_ptr = std::shared_ptr<const abi_plan>;
+using abi_plan_cache_t = std::unordered_map<account_name, abi_plan_ptr>;
+using resolver_fn_t = std::function<abi_serializer_ptr(const account_name& name)>;
    
 class abi_resolver {
 public:
@@ -1011,6 +1035,12 @@ public:
       abi_serializers(std::move(abi_serializers))
    {}
 
+   /// plans, compiled from the serializers of the same accounts, convert action data in place of the serializers
+   abi_resolver(abi_serializer_cache_t&& abi_serializers, abi_plan_cache_t&& abi_plans) :
+      abi_serializers(std::move(abi_serializers)),
+      abi_plans(std::move(abi_plans))
+   {}
+
    std::optional<std::reference_wrapper<const abi_serializer>> operator()(const account_name& account) const {
       auto it = abi_serializers.find(account);
       if (it != abi_serializers.end() && it->second)
@@ -1018,8 +1048,14 @@ public:
       return {};
    };
 
+   const abi_plan* get_plan(const account_name& account) const {
+      auto it = abi_plans.find(account);
+      return it != abi_plans.end() ? it->second.get() : nullptr;
+   }
+
 private:
    abi_serializer_cache_t abi_serializers;
+   abi_plan_cache_t       abi_plans;
 };
 
 class abi_serializer_cache_builder {
@@ -1096,13 +1132,10 @@ public:
          return {};
       }
       auto serializer = resolver_(account);
-      auto& dest = abi_serializers[account]; // add entry regardless
-      if (serializer) {
-         // we got a serializer, so move it into the cache
-         dest = abi_serializer_cache_t::mapped_type{std::move(*serializer)};
-         return *dest; // and return a reference to it
-      }
-      return {}; 
+      auto& dest = abi_serializers[account] = std::move(serializer); // add entry regardless
+      if (dest)
+         return *dest;
+      return {};
    };
 
 private:
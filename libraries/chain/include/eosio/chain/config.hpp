@@ -116,6 +116,7 @@ const static eosio::chain::wasm_interface::vm_type default_wasm_runtime = eosio:
 #else
 const static eosio::chain::wasm_interface::vm_type default_wasm_runtime = eosio::chain::wasm_interface::vm_type::eos_vm;
 #endif
+const static uint64_t   default_wasm_instantiation_cache_size = 512*1024*1024ll; ///< wasm code bytes of instantiated contracts
 
 const static uint32_t   default_abi_serializer_max_time_us = 15*1000; ///< default deadline for abi serialization methods
 
@@ -7,6 +7,7 @@
 #include <boost/signals2/signal.hpp>
 
 #include <eosio/chain/snapshot.hpp>
+#include <eosio/chain/signature_recovery_cache.hpp>
 #include <eosio/chain/protocol_feature_manager.hpp>
 #include <eosio/chain/webassembly/eos-vm-oc/config.hpp>
 
@@ -75,6 +76,7 @@ namespace eosio { namespace chain {
             uint64_t                 state_size             =  chain::config::default_state_size;
             uint64_t                 state_guard_size       =  chain::config::default_state_guard_size;
             uint32_t                 sig_cpu_bill_pct       =  chain::config::default_sig_cpu_bill_pct;
+            uint64_t                 signature_recovery_cache_size = signature_recovery_cache::default_capacity;
             uint16_t                 thread_pool_size       =  chain::config::default_controller_thread_pool_size;
             bool                     read_only              =  false;
             bool                     force_all_checks       =  false;
@@ -86,8 +88,10 @@ namespace eosio { namespace chain {
             uint32_t                 terminate_at_block     = 0;
             bool                     integrity_hash_on_start= false;
             bool                     integrity_hash_on_stop = false;
+            uint32_t                 integrity_hash_version = 1; ///< version of the integrity hash logged on start and stop, see calculate_integrity_hash()
 
             wasm_interface::vm_type  wasm_runtime = chain::config::default_wasm_runtime;
+            uint64_t                 wasm_instantiation_cache_size = chain::config::default_wasm_instantiation_cache_size;
             eosvmoc::config          eosvmoc_config;
             wasm_interface::vm_oc_enable eosvmoc_tierup     = wasm_interface::vm_oc_enable::oc_auto;
 
@@ -185,6 +189,9 @@ namespace eosio { namespace chain {
 
          boost::asio::io_context& get_thread_pool();
 
+         /// thread-safe cache of the keys recovered from transaction signatures, pass to transaction_metadata::recover_keys
+         signature_recovery_cache& get_signature_recovery_cache();
+
          const chainbase::database& db()const;
 
          const fork_database& fork_db()const;
@@ -245,6 +252,8 @@ namespace eosio { namespace chain {
          signed_block_ptr fetch_block_by_number( uint32_t block_num )const;
          // thread-safe
          signed_block_ptr fetch_block_by_id( const block_id_type& id )const;
+         // thread-safe, fc::raw::pack of the block, read from the block log without unpacking it when irreversible
+         std::vector<char> fetch_serialized_block_by_number( uint32_t block_num )const;
          // thread-safe
          std::optional<signed_block_header> fetch_block_header_by_number( uint32_t block_num )const;
          // thread-safe
@@ -256,7 +265,14 @@ namespace eosio { namespace chain {
          // thread-safe
          block_id_type get_block_id_for_num( uint32_t block_num )const;
 
-         fc::sha256 calculate_integrity_hash();
+         /**
+          * Version 1 hashes all the rows of the state, in snapshot order, with a single encoder.
+          * Version 2 hashes every snapshot section, and ranges of the contract tables, separately on the thread pool
+          * and returns the merkle root of those hashes, in snapshot order.
+          * The two versions are not comparable, nodes must use the same version.
+          */
+         fc::sha256 calculate_integrity_hash( uint32_t version );
+         fc::sha256 calculate_integrity_hash(); ///< of the configured integrity_hash_version
          void write_snapshot( const snapshot_writer_ptr& snapshot );
          // thread-safe
          bool is_writing_snapshot()const;
@@ -307,6 +323,7 @@ namespace eosio { namespace chain {
 
          db_read_mode get_read_mode()const;
          validation_mode get_validation_mode()const;
+         uint32_t get_integrity_hash_version()const;
          uint32_t get_terminate_at_block()const;
 
          void set_subjective_cpu_leeway(fc::microseconds leeway);
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+#include <fc/time.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/composite_key.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+namespace eosio::chain {
+
+struct instantiated_module_cache_stats {
+   uint64_t hits      = 0;
+   uint64_t misses    = 0;
+   uint64_t evictions = 0; ///< entries evicted to stay within the size budget
+   uint64_t entries   = 0;
+   uint64_t bytes     = 0; ///< estimated resident size of all entries
+};
+
+/**
+ * Instantiated wasm modules keyed by code hash, vm type and vm version, bounded by a budget of estimated resident
+ * bytes.
+ *
+ * When over budget the entry with the lowest priority is evicted first (GreedyDual-Size-Frequency). The priority of an
+ * entry is the inflation value at its last use plus its number of uses times its instantiation time per byte, so a
+ * small module that is slow to instantiate and often used is kept over a large one that is quick to instantiate again.
+ * Each eviction raises the inflation value to the priority of the evicted entry, which lets entries not used for a
+ * while age out whatever their cost.
+ *
+ * Independently of the budget, entries of code replaced by setcode are erased once the replacing block is
+ * irreversible, see code_block_num_last_used() and erase_last_used_before().
+ *
+ * Not thread safe, returned entries stay valid until erased.
+ */
+template <typename Module>
+class instantiated_module_cache {
+public:
+   using stats = instantiated_module_cache_stats;
+
+   struct entry {
+      digest_type   code_hash;
+      uint8_t       vm_type             = 0;
+      uint8_t       vm_version          = 0;
+      uint32_t      last_block_num_used = UINT32_MAX; ///< block of the setcode replacing this code
+      Module        module;
+      uint64_t      bytes               = 0;
+      uint64_t      instantiation_us    = 0;
+      uint64_t      uses                = 0;
+      double        priority            = 0;
+   };
+
+   /// @param max_bytes budget of estimated resident bytes, 0 for no limit
+   explicit instantiated_module_cache(uint64_t max_bytes)
+      : max_bytes(max_bytes) {}
+
+   /// @return the entry counting a hit and raising its priority, or nullptr counting a miss
+   const entry* find(const digest_type& code_hash, uint8_t vm_type, uint8_t vm_version) {
+      auto it = index.find(boost::make_tuple(code_hash, vm_type, vm_version));
+      if (it == index.end()) {
+         ++cache_stats.misses;
+         return nullptr;
+      }
+      ++cache_stats.hits;
+      index.modify(it, [&](entry& e) {
+         ++e.uses;
+         e.priority = priority_of(e);
+      });
+      return &*it;
+   }
+
+   /// @return true if cached, does not count as a use
+   bool contains(const digest_type& code_hash, uint8_t vm_type, uint8_t vm_version) const {
+      return index.find(boost::make_tuple(code_hash, vm_type, vm_version)) != index.end();
+   }
+
+   /// Adds a module that was not cached
+   /// @param bytes estimated resident size of the module
+   /// @param evict if true evict other entries until within the budget, otherwise the budget may be exceeded until the
+   ///              next call to evict_to_budget()
+   const entry& insert(const digest_type& code_hash, uint8_t vm_type, uint8_t vm_version, Module module,
+                       uint64_t bytes, fc::microseconds instantiation_time, bool evict) {
+      entry e{ .code_hash = code_hash, .vm_type = vm_type, .vm_version = vm_version, .module = std::move(module),
+               .bytes = bytes, .instantiation_us = static_cast<uint64_t>(std::max<int64_t>(instantiation_time.count(), 0)),
+               .uses = 1 };
+      e.priority = priority_of(e);
+      auto [it, inserted] = index.emplace(std::move(e));
+      assert(inserted);
+      cache_stats.bytes += bytes;
+      if (evict)
+         evict_to_budget(&*it);
+      return *it;
+   }
+
+   /// Evicts the lowest priority entries other than keep until within the budget
+   void evict_to_budget(const entry* keep = nullptr) {
+      if (max_bytes == 0)
+         return;
+      auto& by_prio = index.template get<by_priority>();
+      auto it = by_prio.begin();
+      while (cache_stats.bytes > max_bytes && it != by_prio.end()) {
+         if (&*it == keep) {
+            ++it;
+            continue;
+         }
+         inflation = it->priority;
+         cache_stats.bytes -= it->bytes;
+         ++cache_stats.evictions;
+         it = by_prio.erase(it);
+      }
+   }
+
+   void code_block_num_last_used(const digest_type& code_hash, uint8_t vm_type, uint8_t vm_version, uint32_t block_num) {
+      auto it = index.find(boost::make_tuple(code_hash, vm_type, vm_version));
+      if (it != index.end())
+         index.modify(it, [block_num](entry& e) { e.last_block_num_used = block_num; });
+   }
+
+   /// Erases all entries last used on or before block_num, calling on_erase(const entry&) for each first
+   template <typename F>
+   void erase_last_used_before(uint32_t block_num, F&& on_erase) {
+      auto& by_block = index.template get<by_last_block_num>();
+      const auto last_it = by_block.upper_bound(block_num);
+      for (auto it = by_block.begin(); it != last_it; ++it) {
+         on_erase(*it);
+         cache_stats.bytes -= it->bytes;
+      }
+      by_block.erase(by_block.begin(), last_it);
+   }
+
+   stats get_stats() const {
+      stats s = cache_stats;
+      s.entries = index.size();
+      return s;
+   }
+
+   uint64_t get_max_bytes() const { return max_bytes; }
+
+private:
+   double priority_of(const entry& e) const {
+      return inflation + static_cast<double>(e.uses) * e.instantiation_us / std::max<uint64_t>(e.bytes, 1);
+   }
+
+   struct by_hash;
+   struct by_last_block_num;
+   struct by_priority;
+   using index_type = boost::multi_index_container<
+      entry,
+      boost::multi_index::indexed_by<
+         boost::multi_index::ordered_unique<boost::multi_index::tag<by_hash>,
+            boost::multi_index::composite_key< entry,
+               boost::multi_index::member<entry, digest_type, &entry::code_hash>,
+               boost::multi_index::member<entry, uint8_t,     &entry::vm_type>,
+               boost::multi_index::member<entry, uint8_t,     &entry::vm_version>
+            >
+         >,
+         boost::multi_index::ordered_non_unique<boost::multi_index::tag<by_last_block_num>,
+            boost::multi_index::member<entry, uint32_t, &entry::last_block_num_used>>,
+         boost::multi_index::ordered_non_unique<boost::multi_index::tag<by_priority>,
+            boost::multi_index::member<entry, double, &entry::priority>>
+      >
+   >;
+
+   const uint64_t max_bytes;
+   double         inflation = 0; ///< priority of the last evicted entry
+   stats          cache_stats;
+   index_type     index;
+};
+
+} // namespace eosio::chain
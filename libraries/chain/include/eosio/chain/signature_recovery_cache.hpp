@@ -0,0 +1,70 @@
+#pragma once
+#include <eosio/chain/types.hpp>
+
+#include <memory>
+
+namespace eosio::chain {
+
+namespace detail { struct signature_recovery_cache_impl; }
+
+/**
+ * Cache of public keys recovered from transaction signatures, keyed by signature and signed digest. Owned by the
+ * controller, see controller::get_signature_recovery_cache().
+ *
+ * A transaction is usually recovered when it arrives over p2p or http and again when the block containing it is
+ * validated, possibly on another thread and through a different transaction_metadata. Key recovery of these paths
+ * goes through the controller's cache, so K1, R1 and WebAuthn recovery is done once per signature.
+ *
+ * The signature CPU time billed for a transaction is measured around its key recovery. The time each recovery took is
+ * cached with its key and billed again on every hit, so a transaction is billed the same signature CPU time whether or
+ * not its keys are found in the cache.
+ *
+ * Bounded by number of entries, least recently used entries are evicted first. The cache is split into shards to keep
+ * lock contention low. All methods are thread-safe.
+ */
+class signature_recovery_cache {
+public:
+   static constexpr size_t default_capacity = 100'000;
+
+   struct stats {
+      uint64_t hits      = 0;
+      uint64_t misses    = 0;
+      uint64_t evictions = 0;
+      uint64_t entries   = 0;
+   };
+
+   /**
+    * @param max_entries maximum number of cached keys, 0 disables the cache
+    */
+   explicit signature_recovery_cache( size_t max_entries = default_capacity );
+   ~signature_recovery_cache();
+
+   /**
+    * Set the maximum number of cached keys, removing all entries. 0 disables the cache.
+    */
+   void set_capacity( size_t max_entries );
+
+   /**
+    * @param cached_recovery_time if not null, set to the time the recovery of a key found in the cache took, 0 when
+    *                             the key is recovered by this call
+    * @return the public key signature was created with for digest, recovered or from the cache
+    * @throws if the key can not be recovered, failures are not cached
+    */
+   public_key_type recover( const signature_type& sig, const digest_type& digest,
+                            fc::microseconds* cached_recovery_time = nullptr );
+
+   /**
+    * @return counters since creation and the current number of entries
+    */
+   stats get_stats() const;
+
+   /**
+    * Remove all entries
+    */
+   void clear();
+
+private:
+   std::unique_ptr<detail::signature_recovery_cache_impl> my;
+};
+
+} // namespace eosio::chain
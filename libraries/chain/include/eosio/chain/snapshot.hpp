@@ -3,6 +3,7 @@
 #include <eosio/chain/database_utils.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <fc/variant_object.hpp>
+#include <fc/io/datastream.hpp>
 #include <boost/core/demangle.hpp>
 #include <ostream>
 #include <memory>
@@ -158,6 +159,7 @@ namespace eosio { namespace chain {
    namespace detail {
       struct abstract_snapshot_row_reader {
          virtual void provide(std::istream& in) const = 0;
+         virtual void provide(fc::datastream<const char*>& in) const = 0;
          virtual void provide(const fc::variant&) const = 0;
          virtual std::string row_type_name() const = 0;
       };
@@ -203,6 +205,12 @@ namespace eosio { namespace chain {
             });
          }
 
+         void provide(fc::datastream<const char*>& in) const override {
+            row_validation_helper::apply(data, [&in,this](){
+               fc::raw::unpack(in, data);
+            });
+         }
+
          void provide(const fc::variant& var) const override {
             row_validation_helper::apply(data, [&var,this]() {
                fc::from_variant(var, data);
@@ -277,6 +285,12 @@ namespace eosio { namespace chain {
 
       virtual void return_to_header() = 0;
 
+      /**
+       * A reader of the same snapshot with its own position, sections of independent indices can be read from
+       * different threads through clones. Returns an empty pointer when the reader does not support it.
+       */
+      virtual std::shared_ptr<snapshot_reader> clone() const { return {}; }
+
       virtual ~snapshot_reader(){};
 
       protected:
@@ -374,6 +388,33 @@ namespace eosio { namespace chain {
          uint64_t       cur_row;
    };
 
+   /**
+    * Reads a binary snapshot through a read-only memory mapping of the file. The sections are indexed once when
+    * the reader is constructed, clones share the mapping and the index.
+    */
+   class threaded_snapshot_reader : public snapshot_reader {
+      public:
+         explicit threaded_snapshot_reader(const std::filesystem::path& snapshot_path);
+
+         void validate() const override;
+         void set_section( const string& section_name ) override;
+         bool read_row( detail::abstract_snapshot_row_reader& row_reader ) override;
+         bool empty ( ) override;
+         void clear_section() override;
+         void return_to_header() override;
+         std::shared_ptr<snapshot_reader> clone() const override;
+
+      private:
+         struct mapped_snapshot;
+
+         explicit threaded_snapshot_reader(std::shared_ptr<const mapped_snapshot> snapshot);
+
+         std::shared_ptr<const mapped_snapshot> snapshot;
+         fc::datastream<const char*>            section_data;
+         uint64_t                               num_rows;
+         uint64_t                               cur_row;
+   };
+
    class istream_json_snapshot_reader : public snapshot_reader {
       public:
          explicit istream_json_snapshot_reader(const std::filesystem::path& p);
@@ -406,4 +447,22 @@ namespace eosio { namespace chain {
 
    };
 
+   /**
+    * Hashes every section separately, its name followed by its rows, for the version 2 integrity hash.
+    */
+   class section_hash_snapshot_writer : public snapshot_writer {
+      public:
+         void write_start_section( const std::string& section_name ) override;
+         void write_row( const detail::abstract_snapshot_row_writer& row_writer ) override;
+         void write_end_section( ) override;
+         void finalize();
+
+         /// in the order the sections were written
+         const std::vector<fc::sha256>& section_hashes() const { return hashes; }
+
+      private:
+         std::optional<fc::sha256::encoder>  enc;
+         std::vector<fc::sha256>             hashes;
+   };
+
 }}
@@ -22,6 +22,8 @@
 
 #include <limits>
 
+#include <sys/types.h>
+
 namespace eosio::chain {
 
 namespace bmi = boost::multi_index;
@@ -68,6 +70,13 @@ public:
       std::vector<snapshot_schedule_information> snapshot_requests;
    };
 
+   struct background_snapshot_stats {
+      uint32_t in_progress  = 0;
+      uint64_t rows_written = 0; // rows written so far by the snapshots in progress
+      uint64_t completed    = 0;
+      uint64_t failed       = 0;
+   };
+
    template<typename T>
    using next_function = eosio::chain::next_function<T>;
 
@@ -172,6 +181,28 @@ private:
    uint32_t _snapshot_id = 0;
    uint32_t _inflight_sid = 0;
 
+   // written by a background snapshot process, lives in memory shared with it
+   struct background_snapshot_progress;
+
+   // snapshot being written by a forked process from its copy-on-write view of the state
+   struct background_snapshot {
+      pid_t                                 pid = -1;
+      block_id_type                         head_id;
+      uint32_t                              head_block_num = 0;
+      fc::time_point                        head_block_time;
+      fc::time_point                        start_time;
+      fc::time_point                        last_log_time;
+      fs::path                              temp_path;
+      next_function<snapshot_information>   next;
+      uint32_t                              srid = 0;
+      background_snapshot_progress*         progress = nullptr;
+   };
+
+   bool _background = false;
+   std::vector<background_snapshot> _background_snapshots;
+   uint64_t _background_completed = 0;
+   uint64_t _background_failed = 0;
+
    // path to write the snapshots to
    fs::path _snapshots_dir;
 
@@ -181,8 +212,17 @@ private:
       _snapshot_db << sr;
    };
 
+   void add_pending_snapshot_info(uint32_t srid, const snapshot_information& si);
+
+   void create_background_snapshot(next_function<snapshot_information> next, chain::controller& chain, const std::function<void(void)>& predicate);
+   void finish_background_snapshot(background_snapshot& bs, int status, const chain::controller& chain);
+
 public:
    snapshot_scheduler() = default;
+   ~snapshot_scheduler();
+
+   snapshot_scheduler(const snapshot_scheduler&) = delete;
+   snapshot_scheduler& operator=(const snapshot_scheduler&) = delete;
 
    // snapshot scheduler listener
    void on_start_block(uint32_t height, chain::controller& chain);
@@ -209,6 +249,19 @@ public:
 
    // former producer_plugin snapshot fn
    void create_snapshot(next_function<snapshot_information> next, chain::controller& chain, std::function<void(void)> predicate);
+
+   // write snapshots from a forked process instead of the calling thread, requires a state that is private to
+   // this process (database-map-mode other than mapped) so the child keeps a frozen copy-on-write view of it
+   void set_background(bool background);
+   bool is_background() const { return _background; }
+
+   // reap finished background snapshots, called from on_start_block
+   void poll_background_snapshots(const chain::controller& chain);
+
+   // kill background snapshots in progress and remove their incomplete files
+   void abort_background_snapshots();
+
+   background_snapshot_stats get_background_snapshot_stats() const;
 };
 
 
@@ -219,5 +272,6 @@ FC_REFLECT(eosio::chain::snapshot_scheduler::snapshot_request_information, (bloc
 FC_REFLECT(eosio::chain::snapshot_scheduler::snapshot_request_params, (block_spacing) (start_block_num) (end_block_num) (snapshot_description))
 FC_REFLECT(eosio::chain::snapshot_scheduler::snapshot_request_id_information, (snapshot_request_id))
 FC_REFLECT(eosio::chain::snapshot_scheduler::get_snapshot_requests_result, (snapshot_requests))
+FC_REFLECT(eosio::chain::snapshot_scheduler::background_snapshot_stats, (in_progress) (rows_written) (completed) (failed))
 FC_REFLECT_DERIVED(eosio::chain::snapshot_scheduler::snapshot_schedule_information, (eosio::chain::snapshot_scheduler::snapshot_request_id_information)(eosio::chain::snapshot_scheduler::snapshot_request_information), (pending_snapshots))
 FC_REFLECT_DERIVED(eosio::chain::snapshot_scheduler::snapshot_schedule_result, (eosio::chain::snapshot_scheduler::snapshot_request_id_information)(eosio::chain::snapshot_scheduler::snapshot_request_information), )
@@ -5,6 +5,8 @@
 
 namespace eosio { namespace chain {
 
+   class signature_recovery_cache;
+
    struct deferred_transaction_generation_context : fc::reflect_init {
       static constexpr uint16_t extension_id() { return 0; }
       static constexpr bool     enforce_unique() { return true; }
@@ -86,7 +88,8 @@ namespace eosio { namespace chain {
                                                      fc::time_point deadline,
                                                      const vector<bytes>& cfd,
                                                      flat_set<public_key_type>& recovered_pub_keys,
-                                                     bool allow_duplicate_keys = false) const;
+                                                     bool allow_duplicate_keys = false,
+                                                     signature_recovery_cache* sig_cache = nullptr) const;
 
       uint32_t total_actions()const { return context_free_actions.size() + actions.size(); }
 
@@ -124,7 +127,8 @@ namespace eosio { namespace chain {
       signature_type            sign(const private_key_type& key, const chain_id_type& chain_id)const;
       fc::microseconds          get_signature_keys( const chain_id_type& chain_id, fc::time_point deadline,
                                                     flat_set<public_key_type>& recovered_pub_keys,
-                                                    bool allow_duplicate_keys = false )const;
+                                                    bool allow_duplicate_keys = false,
+                                                    signature_recovery_cache* sig_cache = nullptr )const;
    };
 
    struct packed_transaction : fc::reflect_init {
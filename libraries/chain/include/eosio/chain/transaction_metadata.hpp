@@ -78,17 +78,21 @@ class transaction_metadata {
       bool is_transient() const { return _trx_type == trx_type::read_only || _trx_type == trx_type::dry_run; };
 
       /// Thread safe.
+      /// @param sig_cache cache of recovered keys, usually controller::get_signature_recovery_cache(), null to not cache
       /// @returns transaction_metadata_ptr or exception via future
       static recover_keys_future
       start_recover_keys( packed_transaction_ptr trx, boost::asio::io_context& thread_pool,
                           const chain_id_type& chain_id, fc::microseconds time_limit,
-                          trx_type t, uint32_t max_variable_sig_size = UINT32_MAX );
+                          trx_type t, uint32_t max_variable_sig_size = UINT32_MAX,
+                          signature_recovery_cache* sig_cache = nullptr );
       /// Thread safe.
+      /// @param sig_cache cache of recovered keys, usually controller::get_signature_recovery_cache(), null to not cache
       /// @returns transaction_metadata_ptr or throws
       static transaction_metadata_ptr
       recover_keys( packed_transaction_ptr trx,
                     const chain_id_type& chain_id, fc::microseconds time_limit,
-                    trx_type t, uint32_t max_variable_sig_size = UINT32_MAX );
+                    trx_type t, uint32_t max_variable_sig_size = UINT32_MAX,
+                    signature_recovery_cache* sig_cache = nullptr );
 
       /// @returns constructed transaction_metadata with no key recovery (sig_cpu_usage=0, recovered_pub_keys=empty)
       static transaction_metadata_ptr
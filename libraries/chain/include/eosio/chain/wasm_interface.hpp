@@ -10,7 +10,8 @@ namespace eosio { namespace chain {
    class apply_context;
    class wasm_runtime_interface;
    class controller;
-   namespace eosvmoc { struct config; }
+   namespace eosvmoc { struct config; struct compile_stats; }
+   struct instantiated_module_cache_stats;
 
    struct wasm_exit {
       int32_t code = 0;
@@ -48,7 +49,8 @@ namespace eosio { namespace chain {
 
          inline static bool test_disable_tierup = false; // set by unittests to test tierup failing
 
-         wasm_interface(vm_type vm, vm_oc_enable eosvmoc_tierup, const chainbase::database& d, const std::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, bool profile);
+         wasm_interface(vm_type vm, vm_oc_enable eosvmoc_tierup, const chainbase::database& d, const std::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, bool profile,
+                        uint64_t instantiation_cache_size);
          ~wasm_interface();
 
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
@@ -57,8 +59,17 @@ namespace eosio { namespace chain {
 
          // returns true if EOS VM OC is enabled
          bool is_eos_vm_oc_enabled() const;
+
+         // compile the most recently used code of the previous run that is missing from the EOS VM OC code cache
+         void eos_vm_oc_preload();
 #endif
 
+         // metrics of EOS VM OC tier-up compiles, all 0 when tier-up is not enabled. Call on the main thread
+         eosvmoc::compile_stats get_eos_vm_oc_compile_stats() const;
+
+         // metrics of the cache of instantiated modules
+         instantiated_module_cache_stats get_instantiation_cache_stats() const;
+
          //call before dtor to skip what can be minutes of dtor overhead with some runtimes; can cause leaks
          void indicate_shutting_down();
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <eosio/chain/wasm_interface.hpp>
+#include <eosio/chain/instantiated_module_cache.hpp>
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
 #include <eosio/chain/webassembly/eos-vm-oc.hpp>
 #else
@@ -35,16 +36,6 @@ namespace eosio { namespace chain {
    namespace eosvmoc { struct config; }
 
    struct wasm_interface_impl {
-      struct wasm_cache_entry {
-         digest_type                                          code_hash;
-         uint32_t                                             last_block_num_used;
-         std::unique_ptr<wasm_instantiated_module_interface>  module;
-         uint8_t                                              vm_type = 0;
-         uint8_t                                              vm_version = 0;
-      };
-      struct by_hash;
-      struct by_last_block_num;
-
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
 struct eosvmoc_tier {
    // Called from main thread
@@ -70,8 +61,10 @@ struct eosvmoc_tier {
 #endif
 
       wasm_interface_impl(wasm_interface::vm_type vm, wasm_interface::vm_oc_enable eosvmoc_tierup, const chainbase::database& d,
-                          const std::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, bool profile)
-         : db(d)
+                          const std::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, bool profile,
+                          uint64_t instantiation_cache_size)
+         : wasm_instantiation_cache(instantiation_cache_size)
+         , db(d)
          , wasm_runtime_time(vm)
       {
 #ifdef EOSIO_EOS_VM_RUNTIME_ENABLED
@@ -107,8 +100,7 @@ struct eosvmoc_tier {
          // This method is only called from tests; performance is not critical.
          // No need for an additional check if we should lock or not.
          std::lock_guard g(instantiation_cache_mutex);
-         wasm_cache_index::iterator it = wasm_instantiation_cache.find( boost::make_tuple(code_hash, vm_type, vm_version) );
-         return it != wasm_instantiation_cache.end();
+         return wasm_instantiation_cache.contains(code_hash, vm_type, vm_version);
       }
 
       void code_block_num_last_used(const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version, const uint32_t& block_num) {
@@ -116,11 +108,7 @@ struct eosvmoc_tier {
          // the transaction is not read-only, implying we are
          // in write window. Read-only threads are not running.
          // Safe to update the cache without locking.
-         wasm_cache_index::iterator it = wasm_instantiation_cache.find(boost::make_tuple(code_hash, vm_type, vm_version));
-         if(it != wasm_instantiation_cache.end())
-            wasm_instantiation_cache.modify(it, [block_num](wasm_cache_entry& e) {
-               e.last_block_num_used = block_num;
-            });
+         wasm_instantiation_cache.code_block_num_last_used(code_hash, vm_type, vm_version, block_num);
       }
 
       // reports each code_hash and vm_version that will be erased to callback
@@ -129,13 +117,19 @@ struct eosvmoc_tier {
          // in write window. Read-only threads are not running.
          // Safe to update the cache without locking.
          // Anything last used before or on the LIB can be evicted.
-         const auto first_it = wasm_instantiation_cache.get<by_last_block_num>().begin();
-         const auto last_it  = wasm_instantiation_cache.get<by_last_block_num>().upper_bound(lib);
+         wasm_instantiation_cache.erase_last_used_before(lib, [&](const module_cache::entry& e) {
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
-         if(eosvmoc) for(auto it = first_it; it != last_it; it++)
-            eosvmoc->cc.free_code(it->code_hash, it->vm_version);
+            if(eosvmoc)
+               eosvmoc->cc.free_code(e.code_hash, e.vm_version);
 #endif
-         wasm_instantiation_cache.get<by_last_block_num>().erase(first_it, last_it);
+         });
+         // Catch up on evictions deferred while read-only threads were running.
+         wasm_instantiation_cache.evict_to_budget();
+      }
+
+      instantiated_module_cache_stats get_instantiation_cache_stats() const {
+         std::lock_guard g(instantiation_cache_mutex);
+         return wasm_instantiation_cache.get_stats();
       }
 
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
@@ -168,48 +162,31 @@ struct eosvmoc_tier {
          const uint8_t&       vm_version,
          transaction_context& trx_context )
       {
-         wasm_cache_index::iterator it = wasm_instantiation_cache.find( boost::make_tuple(code_hash, vm_type, vm_version) );
-         if (it != wasm_instantiation_cache.end()) {
+         if (const module_cache::entry* e = wasm_instantiation_cache.find(code_hash, vm_type, vm_version)) {
             // An instantiated module's module should never be null.
-            assert(it->module);
-            return it->module;
+            assert(e->module);
+            return e->module;
          }
 
          const code_object* codeobject = &db.get<code_object,by_code_hash>(boost::make_tuple(code_hash, vm_type, vm_version));
-         it = wasm_instantiation_cache.emplace( wasm_interface_impl::wasm_cache_entry {
-            .code_hash = code_hash,
-            .last_block_num_used = UINT32_MAX,
-            .module = nullptr,
-            .vm_type = vm_type,
-            .vm_version = vm_version
-         } ).first;
          auto timer_pause = fc::make_scoped_exit([&](){
             trx_context.resume_billing_timer();
          });
          trx_context.pause_billing_timer();
-         wasm_instantiation_cache.modify(it, [&](auto& c) {
-            c.module = runtime_interface->instantiate_module(codeobject->code.data(), codeobject->code.size(), code_hash, vm_type, vm_version);
-         });
-         return it->module;
+         const auto start = fc::time_point::now();
+         auto module = runtime_interface->instantiate_module(codeobject->code.data(), codeobject->code.size(), code_hash, vm_type, vm_version);
+         // The resident size of an instantiated module is not known to the runtimes, the budget counts the wasm code size
+         // it grows with.
+         // Only evict in the write window, read-only threads may still be executing modules returned to them.
+         return wasm_instantiation_cache.insert(code_hash, vm_type, vm_version, std::move(module), codeobject->code.size(),
+                                                fc::time_point::now() - start, trx_context.control.is_write_window()).module;
       }
 
       std::unique_ptr<wasm_runtime_interface> runtime_interface;
 
-      typedef boost::multi_index_container<
-         wasm_cache_entry,
-         indexed_by<
-            ordered_unique<tag<by_hash>,
-               composite_key< wasm_cache_entry,
-                  member<wasm_cache_entry, digest_type, &wasm_cache_entry::code_hash>,
-                  member<wasm_cache_entry, uint8_t,     &wasm_cache_entry::vm_type>,
-                  member<wasm_cache_entry, uint8_t,     &wasm_cache_entry::vm_version>
-               >
-            >,
-            ordered_non_unique<tag<by_last_block_num>, member<wasm_cache_entry, uint32_t, &wasm_cache_entry::last_block_num_used>>
-         >
-      > wasm_cache_index;
+      using module_cache = instantiated_module_cache<std::unique_ptr<wasm_instantiated_module_interface>>;
       mutable std::mutex instantiation_cache_mutex;
-      wasm_cache_index wasm_instantiation_cache;
+      module_cache wasm_instantiation_cache;
 
       const chainbase::database& db;
       const wasm_interface::vm_type wasm_runtime_time;
@@ -6,6 +6,7 @@
 #include <eosio/chain/webassembly/eos-vm-oc/ipc_helpers.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/sequenced_index.hpp>
 #include <boost/multi_index/composite_key.hpp>
 #include <boost/multi_index/key_extractors.hpp>
@@ -13,6 +14,8 @@
 #include <boost/interprocess/mem_algo/rbtree_best_fit.hpp>
 #include <boost/asio/local/datagram_protocol.hpp>
 
+#include <fc/io/cfile.hpp>
+#include <fc/time.hpp>
 
 #include <thread>
 
@@ -35,6 +38,86 @@ using allocator_t = bip::rbtree_best_fit<bip::null_mutex_family, bip::offset_ptr
 
 struct config;
 
+// metrics of EOS VM OC tier-up compiles
+struct compile_stats {
+   uint64_t queued      = 0; // compiles waiting for a compile thread
+   uint64_t in_progress = 0; // compiles sent to the compile monitor
+   uint64_t compiled    = 0; // compiles completed since start
+   uint64_t failed      = 0; // compiles that failed or did not fit in the code cache since start
+   uint64_t latency_us  = 0; // sum of the time from the first request of each completed compile until it was available
+};
+
+//compiles waiting for a compile thread. Hottest code first, so a burst of compiles of rarely used code does not delay
+// compiling hot code: eosio.* code, then code requested most often while waiting, then first come first served
+class compile_queue {
+   public:
+      //queues code with the given number of requests, or adds them to code already queued. A high priority request
+      // moves queued code ahead of all code that is not high priority
+      void push(const code_tuple& ct, bool high_priority, uint64_t requests = 1);
+      bool contains(const code_tuple& ct) const;
+      //returns true if the code was queued
+      bool erase(const code_tuple& ct);
+
+      //the hottest code, the queue must not be empty
+      const code_tuple& front() const;
+      void pop_front();
+
+      size_t size() const { return _queue.size(); }
+      bool empty() const { return _queue.empty(); }
+
+   private:
+      struct queued_compile : code_tuple {
+         bool     high_priority = false; //eosio.* accounts
+         uint64_t requests      = 0;     //executions that found the code not compiled yet, how hot the code is
+         uint64_t sequence      = 0;     //first come first served among equally hot code
+      };
+      struct by_code;
+      using queue_t = boost::multi_index_container<
+         queued_compile,
+         indexed_by<
+            ordered_unique<
+               composite_key< queued_compile,
+                  member<queued_compile, bool,     &queued_compile::high_priority>,
+                  member<queued_compile, uint64_t, &queued_compile::requests>,
+                  member<queued_compile, uint64_t, &queued_compile::sequence>
+               >,
+               composite_key_compare< std::greater<bool>, std::greater<uint64_t>, std::less<uint64_t> >
+            >,
+            hashed_unique<tag<by_code>,
+               composite_key< queued_compile,
+                  member<code_tuple, digest_type, &code_tuple::code_id>,
+                  member<code_tuple, uint8_t,     &code_tuple::vm_version>
+               >
+            >
+         >
+      >;
+      queue_t  _queue;
+      uint64_t _next_sequence = 0;
+};
+
+//compile_stats of compiles, each measured from the first request of its code until it is available
+class compile_stats_tracker {
+   public:
+      //code requested that is not queued or compiling yet, later requests of the same code are ignored
+      void requested(const code_tuple& ct, fc::time_point now = fc::time_point::now());
+      void completed(const code_tuple& ct, bool success, fc::time_point now = fc::time_point::now());
+      //code no longer queued or compiling that did not complete
+      void forget(const code_tuple& ct);
+
+      //queued and in_progress are not tracked
+      const compile_stats& stats() const { return _stats; }
+
+   private:
+      std::unordered_map<code_tuple, fc::time_point> _request_times;
+      compile_stats _stats;
+};
+
+//code added to the code cache as recorded in its journal
+struct journaled_code {
+   code_descriptor descriptor;
+   uint64_t        code_size = 0; //allocated size at descriptor.code_begin
+   uint64_t        checksum = 0;  //of the code and initdata, the journal can reach the disk before the code does
+};
 
 class code_cache_base {
    public:
@@ -74,25 +157,32 @@ class code_cache_base {
       std::filesystem::path _cache_file_path;
       int                   _cache_fd;
 
+      //mapping of the whole cache file, the compile monitor writes compiled code through its own mapping
+      char* _code_mapping = nullptr;
+
+      //every change to _cache_index is appended to the journal while running, so the index can be recovered after an
+      // unclean shutdown. It is removed on clean shutdown, when the index is serialized in to the cache itself
+      using journal_record = std::variant<journaled_code, code_tuple>; //added, removed
+      std::filesystem::path _journal_path;
+      fc::cfile             _journal;
+      void write_journal();
+      void append_to_journal(const journal_record& record);
+      void append_to_journal(const code_descriptor& added);
+      journaled_code journal_entry(const code_descriptor& cd) const;
+      //returns the entries described by a journal, most recently added first
+      static std::vector<journaled_code> read_journal(const std::filesystem::path& journal_path);
+
+      //most recently used code of the previous run, at most _eosvmoc_config.preload_count
+      std::vector<code_tuple> _preload_candidates;
+
       io_context _ctx;
       local::datagram_protocol::socket _compile_monitor_write_socket{_ctx};
       local::datagram_protocol::socket _compile_monitor_read_socket{_ctx};
 
       //these are really only useful to the async code cache, but keep them here so free_code can be shared
-      using queued_compilies_t = boost::multi_index_container<
-         code_tuple,
-         indexed_by<
-            sequenced<>,
-            hashed_unique<tag<by_hash>,
-               composite_key< code_tuple,
-                  member<code_tuple, digest_type, &code_tuple::code_id>,
-                  member<code_tuple, uint8_t,     &code_tuple::vm_version>
-               >
-            >
-         >
-      >;
-      queued_compilies_t _queued_compiles;
+      compile_queue _queued_compiles;
       std::unordered_map<code_tuple, bool> _outstanding_compiles_and_poison;
+      compile_stats_tracker _compile_stats;
 
       size_t _free_bytes_eviction_threshold;
       void check_eviction_threshold(size_t free_bytes);
@@ -114,6 +204,13 @@ class code_cache_async : public code_cache_base {
       //otherwise: return nullptr
       const code_descriptor* const get_descriptor_for_code(bool high_priority, const digest_type& code_id, const uint8_t& vm_version, bool is_write_window, get_cd_failure& failure);
 
+      //kick off compiles of the most recently used code of the previous run that is not in the cache, call once the
+      // chain state is loaded
+      void preload();
+
+      //call on the main thread
+      compile_stats get_compile_stats() const;
+
    private:
       std::thread _monitor_reply_thread;
       boost::lockfree::spsc_queue<wasm_compilation_result_message> _result_queue;
@@ -31,6 +31,10 @@ struct config {
 #endif
    std::optional<uint64_t> stack_size_limit {16u*1024u};
    std::optional<size_t>   generated_code_size_limit {16u*1024u*1024u};
+
+   // number of most recently used contracts of the previous run to page in or compile at startup, not used by the
+   // compile monitor
+   uint32_t preload_count = 0;
 };
 
 //work around unexpected std::optional behavior
@@ -11,42 +11,50 @@ namespace eosio { namespace chain {
  * as the node values will imply it
  */
 
+// bit of the first byte of a digest which tells the side it is on, cleared on the left and set on the right
+constexpr uint64_t canonical_right_mask = 0x0000000000000080ULL;
+
 digest_type make_canonical_left(const digest_type& val) {
    digest_type canonical_l = val;
-   canonical_l._hash[0] &= 0xFFFFFFFFFFFFFF7FULL;
+   canonical_l._hash[0] &= ~canonical_right_mask;
    return canonical_l;
 }
 
 digest_type make_canonical_right(const digest_type& val) {
    digest_type canonical_r = val;
-   canonical_r._hash[0] |= 0x0000000000000080ULL;
+   canonical_r._hash[0] |= canonical_right_mask;
    return canonical_r;
 }
 
 bool is_canonical_left(const digest_type& val) {
-   return (val._hash[0] & 0x0000000000000080ULL) == 0;
+   return (val._hash[0] & canonical_right_mask) == 0;
 }
 
 bool is_canonical_right(const digest_type& val) {
-   return (val._hash[0] & 0x0000000000000080ULL) != 0;
+   return (val._hash[0] & canonical_right_mask) != 0;
 }
 
 
 digest_type merkle(deque<digest_type> ids) {
    if( 0 == ids.size() ) { return digest_type(); }
 
-   while( ids.size() > 1 ) {
-      if( ids.size() % 2 )
-         ids.push_back(ids.back());
+   // each level is hashed in one batch, in place, over contiguous memory
+   vector<digest_type> nodes(ids.begin(), ids.end());
+   while( nodes.size() > 1 ) {
+      if( nodes.size() % 2 )
+         nodes.push_back(nodes.back());
 
-      for (size_t i = 0; i < ids.size() / 2; i++) {
-         ids[i] = digest_type::hash(make_canonical_pair(ids[2 * i], ids[(2 * i) + 1]));
+      for (size_t i = 0; i < nodes.size(); i += 2) {
+         // make_canonical_left() and make_canonical_right() in place
+         nodes[i]._hash[0]     &= ~canonical_right_mask;
+         nodes[i + 1]._hash[0] |= canonical_right_mask;
       }
+      digest_type::hash_pairs(nodes.data(), nodes.size() / 2, nodes.data());
 
-      ids.resize(ids.size() / 2);
+      nodes.resize(nodes.size() / 2);
    }
 
-   return ids.front();
+   return nodes.front();
 }
 
 } } // eosio::chain
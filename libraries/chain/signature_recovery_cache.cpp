@@ -0,0 +1,125 @@
+#include <eosio/chain/signature_recovery_cache.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace eosio::chain {
+
+namespace detail {
+
+struct signature_recovery_cache_entry {
+   digest_type      key;
+   public_key_type  pub_key;
+   fc::microseconds recovery_time; // time the recovery took, billed again on every hit
+};
+
+struct signature_recovery_cache_shard {
+   using lru_t = std::list<signature_recovery_cache_entry>; // front is most recently used
+
+   std::mutex                                       mtx;
+   lru_t                                            lru;
+   std::unordered_map<digest_type, lru_t::iterator> index;
+};
+
+struct signature_recovery_cache_impl {
+   static constexpr size_t num_shards = 16;
+
+   std::array<signature_recovery_cache_shard, num_shards> shards;
+   std::atomic<size_t>                                    max_shard_entries = 0;
+   std::atomic<uint64_t>                                  hits      = 0;
+   std::atomic<uint64_t>                                  misses    = 0;
+   std::atomic<uint64_t>                                  evictions = 0;
+
+   // key is a hash of both, the signature alone does not determine the recovered key
+   static digest_type key_for( const signature_type& sig, const digest_type& digest ) {
+      digest_type::encoder enc;
+      fc::raw::pack( enc, digest );
+      fc::raw::pack( enc, sig );
+      return enc.result();
+   }
+
+   signature_recovery_cache_shard& shard_for( const digest_type& key ) {
+      return shards[key._hash[0] % num_shards];
+   }
+};
+
+} // namespace detail
+
+signature_recovery_cache::signature_recovery_cache( size_t max_entries )
+   : my( std::make_unique<detail::signature_recovery_cache_impl>() ) {
+   set_capacity( max_entries );
+}
+
+signature_recovery_cache::~signature_recovery_cache() = default;
+
+void signature_recovery_cache::set_capacity( size_t max_entries ) {
+   // at least one entry per shard unless disabled
+   my->max_shard_entries = max_entries == 0 ? 0 : std::max<size_t>( 1, max_entries / detail::signature_recovery_cache_impl::num_shards );
+   clear();
+}
+
+public_key_type signature_recovery_cache::recover( const signature_type& sig, const digest_type& digest,
+                                                   fc::microseconds* cached_recovery_time ) {
+   auto& c = *my;
+   if( cached_recovery_time )
+      *cached_recovery_time = fc::microseconds();
+   const size_t max_shard_entries = c.max_shard_entries;
+   if( max_shard_entries == 0 )
+      return public_key_type( sig, digest );
+
+   const digest_type key = detail::signature_recovery_cache_impl::key_for( sig, digest );
+   auto& s = c.shard_for( key );
+   {
+      std::lock_guard g( s.mtx );
+      if( auto itr = s.index.find( key ); itr != s.index.end() ) {
+         s.lru.splice( s.lru.begin(), s.lru, itr->second );
+         ++c.hits;
+         if( cached_recovery_time )
+            *cached_recovery_time = itr->second->recovery_time;
+         return itr->second->pub_key;
+      }
+   }
+   ++c.misses;
+
+   // recover without holding the lock, another thread may recover the same signature concurrently
+   const auto start = fc::time_point::now();
+   public_key_type pub_key( sig, digest );
+   const fc::microseconds recovery_time = fc::time_point::now() - start;
+
+   std::lock_guard g( s.mtx );
+   if( s.index.find( key ) == s.index.end() ) {
+      s.lru.push_front( { key, pub_key, recovery_time } );
+      s.index.emplace( key, s.lru.begin() );
+      while( s.index.size() > max_shard_entries ) {
+         s.index.erase( s.lru.back().key );
+         s.lru.pop_back();
+         ++c.evictions;
+      }
+   }
+   return pub_key;
+}
+
+signature_recovery_cache::stats signature_recovery_cache::get_stats() const {
+   auto& c = *my;
+   stats result{ .hits = c.hits, .misses = c.misses, .evictions = c.evictions };
+   for( auto& s : c.shards ) {
+      std::lock_guard g( s.mtx );
+      result.entries += s.index.size();
+   }
+   return result;
+}
+
+void signature_recovery_cache::clear() {
+   for( auto& s : my->shards ) {
+      std::lock_guard g( s.mtx );
+      s.index.clear();
+      s.lru.clear();
+   }
+}
+
+} // namespace eosio::chain
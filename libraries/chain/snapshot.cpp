@@ -5,6 +5,11 @@
 #include <fc/scoped_exit.hpp>
 #include <fc/io/json.hpp>
 
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <unordered_map>
+
 #include <rapidjson/document.h>
 #include <rapidjson/filereadstream.h>
 #include <rapidjson/stringbuffer.h>
@@ -337,6 +342,124 @@ void istream_snapshot_reader::return_to_header() {
    clear_section();
 }
 
+struct threaded_snapshot_reader::mapped_snapshot {
+   struct section {
+      uint64_t    row_count = 0;
+      const char* rows      = nullptr;
+      size_t      size      = 0;
+   };
+
+   boost::interprocess::file_mapping            file;
+   boost::interprocess::mapped_region           region;
+   std::unordered_map<std::string, section>     sections;
+
+   // an empty file can not be mapped
+   static const std::filesystem::path& check_size(const std::filesystem::path& p) {
+      EOS_ASSERT(std::filesystem::file_size(p) >= sizeof(ostream_snapshot_writer::magic_number) + sizeof(current_snapshot_version),
+                 snapshot_exception, "Binary snapshot ${p} is truncated", ("p", p));
+      return p;
+   }
+
+   explicit mapped_snapshot(const std::filesystem::path& p)
+   : file(check_size(p).generic_string().c_str(), boost::interprocess::read_only)
+   , region(file, boost::interprocess::read_only)
+   {
+      region.advise(boost::interprocess::mapped_region::advice_sequential);
+
+      fc::datastream<const char*> ds(static_cast<const char*>(region.get_address()), region.get_size());
+      try {
+         // validate totem
+         auto expected_totem = ostream_snapshot_writer::magic_number;
+         decltype(expected_totem) actual_totem;
+         fc::raw::unpack(ds, actual_totem);
+         EOS_ASSERT(actual_totem == expected_totem, snapshot_exception,
+                    "Binary snapshot has unexpected magic number!");
+
+         // validate version
+         auto expected_version = current_snapshot_version;
+         decltype(expected_version) actual_version;
+         fc::raw::unpack(ds, actual_version);
+         EOS_ASSERT(actual_version == expected_version, snapshot_exception,
+                    "Binary snapshot is an unsuppored version.  Expected : ${expected}, Got: ${actual}",
+                    ("expected", expected_version)("actual", actual_version));
+
+         // index the sections: size, row count, null terminated name and rows
+         while (true) {
+            uint64_t section_size = 0;
+            fc::raw::unpack(ds, section_size);
+            if (section_size == std::numeric_limits<uint64_t>::max())
+               break;
+
+            EOS_ASSERT(section_size <= ds.remaining() && section_size >= sizeof(uint64_t), snapshot_exception,
+                       "Binary snapshot section exceeds the snapshot size");
+            const char* section_end = ds.pos() + section_size;
+
+            section sec;
+            fc::raw::unpack(ds, sec.row_count);
+            std::string name;
+            for (char c = 0; ds.get(c) && c != 0;)
+               name.push_back(c);
+            EOS_ASSERT(ds.pos() <= section_end, snapshot_exception,
+                       "Binary snapshot section name exceeds the section size");
+
+            sec.rows = ds.pos();
+            sec.size = section_end - ds.pos();
+            sections.emplace(std::move(name), sec);
+            ds.skip(sec.size);
+         }
+      } FC_LOG_AND_RETHROW()
+   }
+};
+
+threaded_snapshot_reader::threaded_snapshot_reader(const std::filesystem::path& snapshot_path)
+:threaded_snapshot_reader(std::make_shared<const mapped_snapshot>(snapshot_path))
+{
+}
+
+threaded_snapshot_reader::threaded_snapshot_reader(std::shared_ptr<const mapped_snapshot> snapshot)
+:snapshot(std::move(snapshot))
+,section_data(nullptr, 0)
+,num_rows(0)
+,cur_row(0)
+{
+}
+
+void threaded_snapshot_reader::validate() const {
+   // the header and the section layout are validated when the snapshot is mapped
+}
+
+void threaded_snapshot_reader::set_section( const string& section_name ) {
+   auto itr = snapshot->sections.find(section_name);
+   EOS_ASSERT(itr != snapshot->sections.end(), snapshot_exception, "Binary snapshot has no section named ${n}", ("n", section_name));
+
+   section_data = fc::datastream<const char*>(itr->second.rows, itr->second.size);
+   num_rows = itr->second.row_count;
+   cur_row = 0;
+}
+
+bool threaded_snapshot_reader::read_row( detail::abstract_snapshot_row_reader& row_reader ) {
+   row_reader.provide(section_data);
+   return ++cur_row < num_rows;
+}
+
+bool threaded_snapshot_reader::empty ( ) {
+   return num_rows == 0;
+}
+
+void threaded_snapshot_reader::clear_section() {
+   section_data = fc::datastream<const char*>(nullptr, 0);
+   num_rows = 0;
+   cur_row = 0;
+}
+
+void threaded_snapshot_reader::return_to_header() {
+   clear_section();
+}
+
+std::shared_ptr<snapshot_reader> threaded_snapshot_reader::clone() const {
+   return std::shared_ptr<threaded_snapshot_reader>(new threaded_snapshot_reader(snapshot));
+}
+
 struct istream_json_snapshot_reader_impl {
    uint64_t num_rows;
    uint64_t cur_row;
@@ -444,4 +567,22 @@ void integrity_hash_snapshot_writer::finalize() {
    // no-op for structural details
 }
 
+void section_hash_snapshot_writer::write_start_section( const std::string& section_name ) {
+   enc.emplace();
+   fc::raw::pack(*enc, section_name);
+}
+
+void section_hash_snapshot_writer::write_row( const detail::abstract_snapshot_row_writer& row_writer ) {
+   row_writer.write(*enc);
+}
+
+void section_hash_snapshot_writer::write_end_section( ) {
+   hashes.emplace_back(enc->result());
+   enc.reset();
+}
+
+void section_hash_snapshot_writer::finalize() {
+   // no-op, every section is hashed when it ends
+}
+
 }}
@@ -4,10 +4,128 @@
 #include <eosio/chain/snapshot_scheduler.hpp>
 #include <fc/scoped_exit.hpp>
 
+#include <atomic>
+#include <csignal>
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/prctl.h>
+#endif
+
 namespace eosio::chain {
 
+struct snapshot_scheduler::background_snapshot_progress {
+   std::atomic<uint64_t> rows_written = 0;
+   std::atomic<uint32_t> sections_written = 0;
+   char                  error[512] = {};
+};
+
+namespace {
+
+// counts what has been written so the parent can report progress of a background snapshot
+class progress_snapshot_writer : public ostream_snapshot_writer {
+public:
+   progress_snapshot_writer(std::ostream& snapshot, std::atomic<uint64_t>& rows, std::atomic<uint32_t>& sections)
+       : ostream_snapshot_writer(snapshot), rows(rows), sections(sections) {}
+
+   void write_row(const detail::abstract_snapshot_row_writer& row_writer) override {
+      ostream_snapshot_writer::write_row(row_writer);
+      rows.fetch_add(1, std::memory_order_relaxed);
+   }
+
+   void write_end_section() override {
+      ostream_snapshot_writer::write_end_section();
+      sections.fetch_add(1, std::memory_order_relaxed);
+   }
+
+private:
+   std::atomic<uint64_t>& rows;
+   std::atomic<uint32_t>& sections;
+};
+
+// Output of a background snapshot, created before the fork. It only calls write(2) and lseek(2), which are
+// async-signal-safe, so the child does not go through the locks of stdio or of a file stream.
+class fd_streambuf : public std::streambuf {
+public:
+   explicit fd_streambuf(int fd) : fd(fd) { setp(buffer, buffer + sizeof(buffer)); }
+
+protected:
+   int_type overflow(int_type ch) override {
+      if(!flush_buffer())
+         return traits_type::eof();
+      if(!traits_type::eq_int_type(ch, traits_type::eof())) {
+         *pptr() = traits_type::to_char_type(ch);
+         pbump(1);
+      }
+      return traits_type::not_eof(ch);
+   }
+
+   int sync() override { return flush_buffer() ? 0 : -1; }
+
+   // ostream_snapshot_writer seeks back to fill in the size of each section
+   pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+      if(!(which & std::ios_base::out) || !flush_buffer())
+         return pos_type(off_type(-1));
+      const int whence = dir == std::ios_base::beg ? SEEK_SET : dir == std::ios_base::cur ? SEEK_CUR : SEEK_END;
+      return pos_type(::lseek(fd, off, whence));
+   }
+
+   pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+      return seekoff(off_type(pos), std::ios_base::beg, which);
+   }
+
+private:
+   bool flush_buffer() {
+      for(const char* p = pbase(); p < pptr();) {
+         const ssize_t n = ::write(fd, p, pptr() - p);
+         if(n < 0) {
+            if(errno == EINTR)
+               continue;
+            return false;
+         }
+         p += n;
+      }
+      setp(buffer, buffer + sizeof(buffer));
+      return true;
+   }
+
+   const int fd;
+   char      buffer[64 * 1024];
+};
+
+// closes the fds inherited by a forked child but stdin, stdout, stderr and keep_fd, async-signal-safe
+void close_inherited_fds(int keep_fd, long max_fd) {
+   auto close_fds = [max_fd](unsigned first, unsigned last) {
+      if(first > last)
+         return;
+#if defined(SYS_close_range)
+      if(::syscall(SYS_close_range, first, last, 0u) == 0)
+         return;
+#endif
+      for(long fd = first; fd <= std::min<long>(last, max_fd - 1); ++fd)
+         ::close(fd);
+   };
+   close_fds(3, keep_fd - 1);
+   close_fds(keep_fd + 1, ~0u);
+}
+
+} // anonymous namespace
+
+snapshot_scheduler::~snapshot_scheduler() {
+   abort_background_snapshots();
+}
+
 // snapshot_scheduler_listener
 void snapshot_scheduler::on_start_block(uint32_t height, chain::controller& chain) {
+   poll_background_snapshots(chain);
+
    bool snapshot_executed = false;
 
    auto execute_snapshot_with_log = [this, height, &snapshot_executed, &chain](const auto& req) {
@@ -114,8 +232,12 @@ void snapshot_scheduler::set_snapshots_path(fs::path sn_path) {
 }
 
 void snapshot_scheduler::add_pending_snapshot_info(const snapshot_information& si) {
+   add_pending_snapshot_info(_inflight_sid, si);
+}
+
+void snapshot_scheduler::add_pending_snapshot_info(uint32_t srid, const snapshot_information& si) {
    auto& snapshot_by_id = _snapshot_requests.get<by_snapshot_id>();
-   auto snapshot_req = snapshot_by_id.find(_inflight_sid);
+   auto snapshot_req = snapshot_by_id.find(srid);
    if(snapshot_req != snapshot_by_id.end()) {
       _snapshot_requests.modify(snapshot_req, [&si](auto& p) {
          p.pending_snapshots.emplace_back(si);
@@ -170,6 +292,11 @@ void snapshot_scheduler::create_snapshot(next_function<snapshot_information> nex
       return;
    }
 
+   if(_background) {
+      create_background_snapshot(std::move(next), chain, predicate);
+      return;
+   }
+
    auto write_snapshot = [&](const fs::path& p) -> void {
       if(predicate) predicate();
       fs::create_directory(p.parent_path());
@@ -229,4 +356,211 @@ void snapshot_scheduler::create_snapshot(next_function<snapshot_information> nex
    }
 }
 
+void snapshot_scheduler::set_background(bool background) {
+   _background = background;
+}
+
+void snapshot_scheduler::create_background_snapshot(next_function<snapshot_information> next, chain::controller& chain,
+                                                    const std::function<void(void)>& predicate) {
+   const auto head_id = chain.head_block_id();
+
+   // if a snapshot at this block is still being written or waits to become irreversible, attach this request to it
+   auto chain_next = [&next](next_function<snapshot_information>& prev) {
+      prev = [prev, next](const next_function_variant<snapshot_information>& res) {
+         prev(res);
+         next(res);
+      };
+   };
+   auto in_flight = std::find_if(_background_snapshots.begin(), _background_snapshots.end(),
+                                 [&head_id](const background_snapshot& bs) { return bs.head_id == head_id; });
+   if(in_flight != _background_snapshots.end()) {
+      chain_next(in_flight->next);
+      return;
+   }
+   auto& pending_by_id = _pending_snapshot_index.get<by_id>();
+   auto existing = pending_by_id.find(head_id);
+   if(existing != pending_by_id.end()) {
+      pending_by_id.modify(existing, [&chain_next](auto& entry) { chain_next(entry.next); });
+      return;
+   }
+
+   try {
+      // the pending block has to be gone before the fork, the child snapshots the state as of the head block
+      if(predicate) predicate();
+
+      const auto temp_path = pending_snapshot<snapshot_information>::get_temp_path(head_id, _snapshots_dir);
+      fs::create_directory(temp_path.parent_path());
+
+      void* mem = mmap(nullptr, sizeof(background_snapshot_progress), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+      EOS_ASSERT(mem != MAP_FAILED, snapshot_execution_exception,
+                 "Unable to map background snapshot progress: ${e}", ("e", std::strerror(errno)));
+      auto* progress = new (mem) background_snapshot_progress;
+      auto unmap = fc::make_scoped_exit([mem]() { munmap(mem, sizeof(background_snapshot_progress)); });
+
+      // everything the child needs is set up here, after the fork it only writes the snapshot
+      const int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+      EOS_ASSERT(fd >= 0, snapshot_execution_exception,
+                 "Unable to create background snapshot file ${p}: ${e}", ("p", temp_path.generic_string())("e", std::strerror(errno)));
+      auto close_fd = fc::make_scoped_exit([fd]() { ::close(fd); });
+      auto snap_buf = std::make_unique<fd_streambuf>(fd);
+      std::ostream snap_out(snap_buf.get());
+      auto writer = std::make_shared<progress_snapshot_writer>(snap_out, progress->rows_written, progress->sections_written);
+      const long max_fd = ::sysconf(_SC_OPEN_MAX);
+      const pid_t parent_pid = ::getpid();
+
+      const pid_t pid = fork();
+      EOS_ASSERT(pid >= 0, snapshot_execution_exception,
+                 "Unable to fork background snapshot process: ${e}", ("e", std::strerror(errno)));
+
+      if(pid == 0) {
+         // child: only this thread exists, locks held by the parent's other threads are never released. Besides
+         // controller::write_snapshot, which walks the state without logging, only async-signal-safe calls are made:
+         // no logging and no return into the parent's code. The child only keeps the snapshot fd and stdio.
+#if defined(__linux__)
+         prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+         if(::getppid() != parent_pid) // parent exited before the death signal was set
+            _exit(1);
+         std::signal(SIGINT, SIG_IGN);
+         std::signal(SIGHUP, SIG_IGN);
+         std::signal(SIGPIPE, SIG_IGN);
+         std::signal(SIGTERM, SIG_DFL);
+         close_inherited_fds(fd, max_fd);
+
+         int rc = 0;
+         auto set_error = [&](const char* e) {
+            std::strncpy(progress->error, e, sizeof(progress->error) - 1);
+            rc = 1;
+         };
+         try {
+            chain.write_snapshot(writer);
+            writer->finalize();
+            if(!snap_out.flush())
+               set_error("unable to write snapshot file");
+            else if(::close(fd) != 0)
+               set_error("unable to close snapshot file");
+         } catch(const std::exception& e) { // fc::exception::what() is its name, formatting its log messages allocates
+            set_error(e.what());
+         } catch(...) {
+            set_error("unknown exception");
+         }
+         _exit(rc);
+      }
+
+      unmap.cancel();
+      const auto now = fc::time_point::now();
+      _background_snapshots.push_back(background_snapshot{
+            .pid = pid, .head_id = head_id, .head_block_num = chain.head_block_num(), .head_block_time = chain.head_block_time(),
+            .start_time = now, .last_log_time = now, .temp_path = temp_path, .next = std::move(next), .srid = _inflight_sid,
+            .progress = progress});
+      ilog("Writing snapshot of block ${bn} in background process ${pid}", ("bn", chain.head_block_num())("pid", pid));
+   }
+   CATCH_AND_CALL(next);
+}
+
+void snapshot_scheduler::poll_background_snapshots(const chain::controller& chain) {
+   if(_background_snapshots.empty())
+      return;
+
+   const auto now = fc::time_point::now();
+   std::vector<std::pair<background_snapshot, int>> finished;
+   for(auto it = _background_snapshots.begin(); it != _background_snapshots.end();) {
+      int status = 0;
+      pid_t r = waitpid(it->pid, &status, WNOHANG);
+      if(r == 0) {
+         if(now - it->last_log_time >= fc::seconds(30)) {
+            it->last_log_time = now;
+            ilog("Background snapshot of block ${bn}: ${rows} rows in ${s} sections written in ${t} s",
+                 ("bn", it->head_block_num)("rows", it->progress->rows_written.load())
+                 ("s", it->progress->sections_written.load())("t", (now - it->start_time).to_seconds()));
+         }
+         ++it;
+         continue;
+      }
+      if(r < 0) {
+         // not our child anymore, nothing to reap
+         status = -1;
+         std::strncpy(it->progress->error, std::strerror(errno), sizeof(it->progress->error) - 1);
+      }
+      finished.emplace_back(std::move(*it), status);
+      it = _background_snapshots.erase(it);
+   }
+
+   // callbacks may throw, the finished snapshots are no longer tracked
+   for(auto& [bs, status] : finished)
+      finish_background_snapshot(bs, status, chain);
+}
+
+void snapshot_scheduler::finish_background_snapshot(background_snapshot& bs, int status, const chain::controller& chain) {
+   const bool ok = status >= 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+   std::string error;
+   if(!ok) {
+      if(bs.progress->error[0])
+         error = bs.progress->error;
+      else if(status >= 0 && WIFSIGNALED(status))
+         error = "killed by signal " + std::to_string(WTERMSIG(status));
+      else
+         error = "exited with status " + std::to_string(status >= 0 ? WEXITSTATUS(status) : status);
+   }
+   const uint64_t rows = bs.progress->rows_written.load();
+   munmap(bs.progress, sizeof(background_snapshot_progress));
+   bs.progress = nullptr;
+
+   auto next = std::move(bs.next);
+   try {
+      if(!ok) {
+         ++_background_failed;
+         std::error_code ec;
+         fs::remove(bs.temp_path, ec);
+         EOS_THROW(snapshot_execution_exception, "Background snapshot of block ${bn} failed: ${e}",
+                   ("bn", bs.head_block_num)("e", error));
+      }
+      ++_background_completed;
+      ilog("Background snapshot of block ${bn} written, ${rows} rows in ${t} s",
+           ("bn", bs.head_block_num)("rows", rows)("t", (fc::time_point::now() - bs.start_time).to_seconds()));
+
+      const auto snapshot_path = pending_snapshot<snapshot_information>::get_final_path(bs.head_id, _snapshots_dir);
+      std::error_code ec;
+      if(chain.get_read_mode() == db_read_mode::IRREVERSIBLE) {
+         fs::rename(bs.temp_path, snapshot_path, ec);
+         EOS_ASSERT(!ec, snapshot_finalization_exception,
+                    "Unable to finalize valid snapshot of block number ${bn}: [code: ${ec}] ${message}",
+                    ("bn", bs.head_block_num)("ec", ec.value())("message", ec.message()));
+         next(snapshot_information{bs.head_id, bs.head_block_num, bs.head_block_time, chain_snapshot_header::current_version, snapshot_path.generic_string()});
+         return;
+      }
+
+      // finalized by on_irreversible_block
+      const auto pending_path = pending_snapshot<snapshot_information>::get_pending_path(bs.head_id, _snapshots_dir);
+      fs::rename(bs.temp_path, pending_path, ec);
+      EOS_ASSERT(!ec, snapshot_finalization_exception,
+                 "Unable to promote temp snapshot ${t} to pending ${p} for block number ${bn}: [code: ${ec}] ${message}",
+                 ("t", bs.temp_path.generic_string())("p", pending_path.generic_string())
+                 ("bn", bs.head_block_num)("ec", ec.value())("message", ec.message()));
+      _pending_snapshot_index.emplace(bs.head_id, next, pending_path.generic_string(), snapshot_path.generic_string());
+      add_pending_snapshot_info(bs.srid, snapshot_information{bs.head_id, bs.head_block_num, bs.head_block_time, chain_snapshot_header::current_version, pending_path.generic_string()});
+   }
+   CATCH_AND_CALL(next);
+}
+
+void snapshot_scheduler::abort_background_snapshots() {
+   for(auto& bs : _background_snapshots) {
+      kill(bs.pid, SIGKILL);
+      int status = 0;
+      waitpid(bs.pid, &status, 0);
+      std::error_code ec;
+      fs::remove(bs.temp_path, ec);
+      munmap(bs.progress, sizeof(background_snapshot_progress));
+   }
+   _background_snapshots.clear();
+}
+
+snapshot_scheduler::background_snapshot_stats snapshot_scheduler::get_background_snapshot_stats() const {
+   background_snapshot_stats stats{.in_progress = static_cast<uint32_t>(_background_snapshots.size()),
+                                   .completed = _background_completed, .failed = _background_failed};
+   for(const auto& bs : _background_snapshots)
+      stats.rows_written += bs.progress->rows_written.load(std::memory_order_relaxed);
+   return stats;
+}
+
 }// namespace eosio::chain
@@ -10,6 +10,7 @@
 #include <eosio/chain/config.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/transaction.hpp>
+#include <eosio/chain/signature_recovery_cache.hpp>
 
 namespace eosio { namespace chain {
 
@@ -58,26 +59,30 @@ digest_type transaction::sig_digest( const chain_id_type& chain_id, const vector
 
 fc::microseconds transaction::get_signature_keys( const vector<signature_type>& signatures,
       const chain_id_type& chain_id, fc::time_point deadline, const vector<bytes>& cfd,
-      flat_set<public_key_type>& recovered_pub_keys, bool allow_duplicate_keys)const
+      flat_set<public_key_type>& recovered_pub_keys, bool allow_duplicate_keys, signature_recovery_cache* sig_cache)const
 { try {
    auto start = fc::time_point::now();
    recovered_pub_keys.clear();
+   // recovery time of the keys found in the cache, billed as if they were recovered
+   fc::microseconds cached_time;
 
    if ( !signatures.empty() ) {
       const digest_type digest = sig_digest(chain_id, cfd);
 
       for(const signature_type& sig : signatures) {
-         auto now = fc::time_point::now();
+         auto now = fc::time_point::now() + cached_time;
          EOS_ASSERT( now < deadline, tx_cpu_usage_exceeded, "transaction signature verification executed for too long ${time}us",
                      ("time", now - start)("now", now)("deadline", deadline)("start", start) );
-         auto[ itr, successful_insertion ] = recovered_pub_keys.emplace( sig, digest );
+         fc::microseconds sig_cached_time;
+         auto[ itr, successful_insertion ] = recovered_pub_keys.emplace( sig_cache ? sig_cache->recover( sig, digest, &sig_cached_time ) : public_key_type( sig, digest ) );
+         cached_time += sig_cached_time;
          EOS_ASSERT( allow_duplicate_keys || successful_insertion, tx_duplicate_sig,
                      "transaction includes more than one signature signed using the same key associated with public key: ${key}",
                      ("key", *itr ) );
       }
    }
 
-   return fc::time_point::now() - start;
+   return fc::time_point::now() - start + cached_time;
 } FC_CAPTURE_AND_RETHROW() }
 
 flat_multimap<uint16_t, transaction_extension> transaction::validate_and_extract_extensions()const {
@@ -131,9 +136,9 @@ signature_type signed_transaction::sign(const private_key_type& key, const chain
 fc::microseconds
 signed_transaction::get_signature_keys( const chain_id_type& chain_id, fc::time_point deadline,
                                         flat_set<public_key_type>& recovered_pub_keys,
-                                        bool allow_duplicate_keys)const
+                                        bool allow_duplicate_keys, signature_recovery_cache* sig_cache)const
 {
-   return transaction::get_signature_keys(signatures, chain_id, deadline, context_free_data, recovered_pub_keys, allow_duplicate_keys);
+   return transaction::get_signature_keys(signatures, chain_id, deadline, context_free_data, recovered_pub_keys, allow_duplicate_keys, sig_cache);
 }
 
 uint32_t packed_transaction::get_unprunable_size()const {
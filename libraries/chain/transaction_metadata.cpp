@@ -9,10 +9,11 @@ recover_keys_future transaction_metadata::start_recover_keys( packed_transaction
                                                               const chain_id_type& chain_id,
                                                               fc::microseconds time_limit,
                                                               trx_type t,
-                                                              uint32_t max_variable_sig_size )
+                                                              uint32_t max_variable_sig_size,
+                                                              signature_recovery_cache* sig_cache )
 {
-   return post_async_task( thread_pool, [trx{std::move(trx)}, chain_id, time_limit, t, max_variable_sig_size]() mutable {
-      return recover_keys( std::move(trx), chain_id, time_limit, t, max_variable_sig_size );
+   return post_async_task( thread_pool, [trx{std::move(trx)}, chain_id, time_limit, t, max_variable_sig_size, sig_cache]() mutable {
+      return recover_keys( std::move(trx), chain_id, time_limit, t, max_variable_sig_size, sig_cache );
    });
 }
 
@@ -20,14 +21,15 @@ transaction_metadata_ptr transaction_metadata::recover_keys( packed_transaction_
                                                               const chain_id_type& chain_id,
                                                               fc::microseconds time_limit,
                                                               trx_type t,
-                                                              uint32_t max_variable_sig_size )
+                                                              uint32_t max_variable_sig_size,
+                                                              signature_recovery_cache* sig_cache )
 {
    fc::time_point deadline = time_limit == fc::microseconds::maximum() ?
                              fc::time_point::maximum() : fc::time_point::now() + time_limit;
    check_variable_sig_size( trx, max_variable_sig_size );
    const signed_transaction& trn = trx->get_signed_transaction();
    flat_set<public_key_type> recovered_pub_keys;
-   fc::microseconds cpu_usage = trn.get_signature_keys( chain_id, deadline, recovered_pub_keys );
+   fc::microseconds cpu_usage = trn.get_signature_keys( chain_id, deadline, recovered_pub_keys, false, sig_cache );
    return std::make_shared<transaction_metadata>( private_type(), std::move( trx ), cpu_usage, std::move( recovered_pub_keys ), t );
 }
 
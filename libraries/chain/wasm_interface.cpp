@@ -10,6 +10,7 @@
 #include <eosio/chain/authorization_manager.hpp>
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/wasm_interface_private.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/code_cache.hpp>
 #include <eosio/chain/wasm_eosio_validation.hpp>
 #include <eosio/chain/wasm_eosio_injection.hpp>
 #include <eosio/chain/global_property_object.hpp>
@@ -32,8 +33,9 @@
 
 namespace eosio { namespace chain {
 
-   wasm_interface::wasm_interface(vm_type vm, vm_oc_enable eosvmoc_tierup, const chainbase::database& d, const std::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, bool profile)
-     : eosvmoc_tierup(eosvmoc_tierup), my( new wasm_interface_impl(vm, eosvmoc_tierup, d, data_dir, eosvmoc_config, profile) ) {}
+   wasm_interface::wasm_interface(vm_type vm, vm_oc_enable eosvmoc_tierup, const chainbase::database& d, const std::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, bool profile,
+                                  uint64_t instantiation_cache_size)
+     : eosvmoc_tierup(eosvmoc_tierup), my( new wasm_interface_impl(vm, eosvmoc_tierup, d, data_dir, eosvmoc_config, profile, instantiation_cache_size) ) {}
 
    wasm_interface::~wasm_interface() {}
 
@@ -124,7 +126,24 @@ namespace eosio { namespace chain {
    bool wasm_interface::is_eos_vm_oc_enabled() const {
       return my->is_eos_vm_oc_enabled();
    }
+
+   void wasm_interface::eos_vm_oc_preload() {
+      if (my->eosvmoc)
+         my->eosvmoc->cc.preload();
+   }
+#endif
+
+   eosvmoc::compile_stats wasm_interface::get_eos_vm_oc_compile_stats() const {
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+      if (my->eosvmoc)
+         return my->eosvmoc->cc.get_compile_stats();
 #endif
+      return {};
+   }
+
+   instantiated_module_cache_stats wasm_interface::get_instantiation_cache_stats() const {
+      return my->get_instantiation_cache_stats();
+   }
 
    wasm_instantiated_module_interface::~wasm_instantiated_module_interface() = default;
    wasm_runtime_interface::~wasm_runtime_interface() = default;
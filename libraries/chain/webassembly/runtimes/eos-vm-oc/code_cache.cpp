@@ -8,7 +8,11 @@
 #include <eosio/chain/webassembly/eos-vm-oc/intrinsic.hpp>
 #include <eosio/chain/webassembly/eos-vm-oc/compile_monitor.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <fc/crypto/city.hpp>
 
+#include <list>
+
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/syscall.h>
 #include <sys/mman.h>
@@ -21,6 +25,8 @@
 
 using namespace IR;
 
+FC_REFLECT(eosio::chain::eosvmoc::journaled_code, (descriptor)(code_size)(checksum))
+
 namespace eosio { namespace chain { namespace eosvmoc {
 
 static constexpr size_t header_offset = 512u;
@@ -38,6 +44,79 @@ static constexpr size_t descriptor_ptr_from_file_start = header_offset + offseto
 
 static_assert(sizeof(code_cache_header) <= header_size, "code_cache_header too big");
 
+static constexpr uint64_t journal_id = 0x4c4e524a434f4d56ULL; //"VMOCJRNL" little endian
+static constexpr uint32_t journal_version = 2;
+
+//journal records are framed by their size and checksum, a torn record at the end of the journal is ignored
+struct journal_record_header {
+   uint32_t size;
+   uint64_t checksum;
+} __attribute__ ((packed));
+
+template <typename Record>
+static void write_journal_record(fc::cfile& journal, const Record& record) {
+   const std::vector<char> data = fc::raw::pack(record);
+   const journal_record_header rh{static_cast<uint32_t>(data.size()), fc::city_hash64(data.data(), data.size())};
+   journal.write((const char*)&rh, sizeof(rh));
+   journal.write(data.data(), data.size());
+}
+
+static uint64_t code_checksum(const char* code_mapping, const code_descriptor& cd, uint64_t code_size) {
+   const uint64_t checksums[] = { fc::city_hash64(code_mapping + cd.code_begin, code_size),
+                                  fc::city_hash64(code_mapping + cd.initdata_begin, cd.initdata_size) };
+   return fc::city_hash64((const char*)checksums, sizeof(checksums));
+}
+
+std::vector<journaled_code> code_cache_base::read_journal(const std::filesystem::path& journal_path) {
+   fc::cfile journal;
+   journal.set_file_path(journal_path);
+   journal.open("rb");
+   const size_t journal_size = std::filesystem::file_size(journal_path);
+
+   uint64_t id = 0;
+   uint32_t version = 0;
+   EOS_ASSERT(journal_size >= sizeof(id) + sizeof(version), database_exception, "code cache journal is too short");
+   journal.read((char*)&id, sizeof(id));
+   journal.read((char*)&version, sizeof(version));
+   EOS_ASSERT(id == journal_id && version == journal_version, bad_database_version_exception, "code cache journal not compatible with this version");
+
+   std::list<journaled_code> entries; //most recently added first
+   std::unordered_map<code_tuple, std::list<journaled_code>::iterator> entry_of_code;
+   auto erase = [&](const code_tuple& ct) {
+      if(auto it = entry_of_code.find(ct); it != entry_of_code.end()) {
+         entries.erase(it->second);
+         entry_of_code.erase(it);
+      }
+   };
+   std::vector<char> data;
+   for(size_t pos = journal.tellp(); pos + sizeof(journal_record_header) <= journal_size; pos = journal.tellp()) {
+      journal_record_header rh;
+      journal.read((char*)&rh, sizeof(rh));
+      if(rh.size > journal_size - pos - sizeof(rh))
+         break;
+      data.resize(rh.size);
+      journal.read(data.data(), data.size());
+      if(fc::city_hash64(data.data(), data.size()) != rh.checksum)
+         break;
+
+      fc::datastream<const char*> ds(data.data(), data.size());
+      journal_record record;
+      fc::raw::unpack(ds, record);
+      std::visit(overloaded {
+         [&](journaled_code& jc) {
+            const code_tuple ct{jc.descriptor.code_hash, jc.descriptor.vm_version};
+            erase(ct);
+            entry_of_code[ct] = entries.insert(entries.begin(), std::move(jc));
+         },
+         [&](const code_tuple& ct) {
+            erase(ct);
+         }
+      }, record);
+   }
+
+   return {entries.begin(), entries.end()};
+}
+
 code_cache_async::code_cache_async(const std::filesystem::path& data_dir, const eosvmoc::config& eosvmoc_config, const chainbase::database& db) :
    code_cache_base(data_dir, eosvmoc_config, db),
    _result_queue(eosvmoc_config.threads * 2),
@@ -84,10 +163,13 @@ void code_cache_async::wait_on_compile_monitor_message() {
 std::tuple<size_t, size_t> code_cache_async::consume_compile_thread_queue() {
    size_t bytes_remaining = 0;
    size_t gotsome = _result_queue.consume_all([&](const wasm_compilation_result_message& result) {
+      _compile_stats.completed(result.code, std::holds_alternative<code_descriptor>(result.result));
+
       if(_outstanding_compiles_and_poison[result.code] == false) {
          std::visit(overloaded {
             [&](const code_descriptor& cd) {
                _cache_index.push_front(cd);
+               append_to_journal(cd);
             },
             [&](const compilation_result_unknownfailure&) {
                wlog("code ${c} failed to tier-up with EOS VM OC", ("c", result.code.code_id));
@@ -116,20 +198,23 @@ const code_descriptor* const code_cache_async::get_descriptor_for_code(bool high
       if(count_processed)
          check_eviction_threshold(bytes_remaining);
 
-      while(count_processed && _queued_compiles.size()) {
-         auto nextup = _queued_compiles.begin();
+      //hottest queued code first
+      while(count_processed && !_queued_compiles.empty()) {
+         const code_tuple nextup = _queued_compiles.front();
+         _queued_compiles.pop_front();
 
          //it's not clear this check is required: if apply() was called for code then it existed in the code_index; and then
          // if we got notification of it no longer existing we would have removed it from queued_compiles
-         const code_object* const codeobject = _db.find<code_object,by_code_hash>(boost::make_tuple(nextup->code_id, 0, nextup->vm_version));
+         const code_object* const codeobject = _db.find<code_object,by_code_hash>(boost::make_tuple(nextup.code_id, 0, nextup.vm_version));
          if(codeobject) {
-            _outstanding_compiles_and_poison.emplace(*nextup, false);
+            _outstanding_compiles_and_poison.emplace(nextup, false);
             std::vector<wrapped_fd> fds_to_pass;
             fds_to_pass.emplace_back(memfd_for_bytearray(codeobject->code));
-            FC_ASSERT(write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ *nextup, _eosvmoc_config }, fds_to_pass), "EOS VM failed to communicate to OOP manager");
+            FC_ASSERT(write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ nextup, _eosvmoc_config }, fds_to_pass), "EOS VM failed to communicate to OOP manager");
             --count_processed;
          }
-         _queued_compiles.erase(nextup);
+         else
+            _compile_stats.forget(nextup);
       }
    }
 
@@ -156,16 +241,16 @@ const code_descriptor* const code_cache_async::get_descriptor_for_code(bool high
       it->second = false;
       return nullptr;
    }
-   if(auto it = _queued_compiles.get<by_hash>().find(boost::make_tuple(std::ref(code_id), vm_version)); it != _queued_compiles.get<by_hash>().end()) {
+   if(_queued_compiles.contains(ct)) {
+      // executed again without OC, move it ahead of colder code
+      _queued_compiles.push(ct, high_priority);
       failure = get_cd_failure::temporary; // Compile might not be done yet
       return nullptr;
    }
 
    if(_outstanding_compiles_and_poison.size() >= _threads) {
-      if (high_priority)
-         _queued_compiles.push_front(ct);
-      else
-         _queued_compiles.push_back(ct);
+      _queued_compiles.push(ct, high_priority);
+      _compile_stats.requested(ct);
       failure = get_cd_failure::temporary; // Compile might not be done yet
       return nullptr;
    }
@@ -177,6 +262,7 @@ const code_descriptor* const code_cache_async::get_descriptor_for_code(bool high
    }
 
    _outstanding_compiles_and_poison.emplace(ct, false);
+   _compile_stats.requested(ct);
    std::vector<wrapped_fd> fds_to_pass;
    fds_to_pass.emplace_back(memfd_for_bytearray(codeobject->code));
    write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ ct, _eosvmoc_config }, fds_to_pass);
@@ -184,6 +270,41 @@ const code_descriptor* const code_cache_async::get_descriptor_for_code(bool high
    return nullptr;
 }
 
+compile_stats code_cache_async::get_compile_stats() const {
+   compile_stats stats = _compile_stats.stats();
+   stats.queued = _queued_compiles.size();
+   stats.in_progress = _outstanding_compiles_and_poison.size();
+   return stats;
+}
+
+void code_cache_async::preload() {
+   size_t compiles = 0;
+   for(const code_tuple& ct : _preload_candidates) {
+      if(_cache_index.get<by_hash>().count(boost::make_tuple(ct.code_id, ct.vm_version)) ||
+         _queued_compiles.contains(ct) ||
+         _outstanding_compiles_and_poison.count(ct) || _blacklist.count(ct))
+         continue;
+      const code_object* const codeobject = _db.find<code_object,by_code_hash>(boost::make_tuple(ct.code_id, 0, ct.vm_version));
+      if(!codeobject) //no longer used by any account
+         continue;
+
+      ++compiles;
+      _compile_stats.requested(ct);
+      if(_outstanding_compiles_and_poison.size() >= _threads) {
+         //not executed yet in this run, behind any code that is
+         _queued_compiles.push(ct, false, 0);
+         continue;
+      }
+      _outstanding_compiles_and_poison.emplace(ct, false);
+      std::vector<wrapped_fd> fds_to_pass;
+      fds_to_pass.emplace_back(memfd_for_bytearray(codeobject->code));
+      write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ ct, _eosvmoc_config }, fds_to_pass);
+   }
+   if(compiles)
+      ilog("EOS VM Optimized Compiler compiling ${c} recently used contracts missing from the code cache", ("c", compiles));
+   _preload_candidates.clear();
+}
+
 code_cache_sync::~code_cache_sync() {
    //it's exceedingly critical that we wait for the compile monitor to be done with all its work
    //This is easy in the sync case
@@ -221,13 +342,16 @@ const code_descriptor* const code_cache_sync::get_descriptor_for_code_sync(const
 
    check_eviction_threshold(result.cache_free_bytes);
 
-   return &*_cache_index.push_front(std::move(std::get<code_descriptor>(result.result))).first;
+   const code_descriptor& cd = *_cache_index.push_front(std::move(std::get<code_descriptor>(result.result))).first;
+   append_to_journal(cd);
+   return &cd;
 }
 
 code_cache_base::code_cache_base(const std::filesystem::path& data_dir, const eosvmoc::config& eosvmoc_config, const chainbase::database& db) :
    _db(db),
    _eosvmoc_config(eosvmoc_config),
-   _cache_file_path(data_dir/"code_cache.bin") {
+   _cache_file_path(data_dir/"code_cache.bin"),
+   _journal_path(data_dir/"code_cache.journal") {
    static_assert(sizeof(allocator_t) <= header_offset, "header offset intersects with allocator");
 
    std::filesystem::create_directories(data_dir);
@@ -246,6 +370,8 @@ code_cache_base::code_cache_base(const std::filesystem::path& data_dir, const eo
    };
 
    code_cache_header cache_header;
+   std::vector<code_descriptor> journaled_index;
+   std::vector<code_tuple> journaled_codes; //including code not recovered, most recently used first
    auto check_code_cache = [&] {
       char header_buff[total_header_size];
       std::ifstream hs(_cache_file_path.generic_string(), std::ifstream::binary);
@@ -254,7 +380,48 @@ code_cache_base::code_cache_base(const std::filesystem::path& data_dir, const eo
       memcpy((char*)&cache_header, header_buff + header_offset, sizeof(cache_header));
 
       EOS_ASSERT(cache_header.id == header_id, bad_database_version_exception, "existing EOS VM OC code cache not compatible with this version");
-      EOS_ASSERT(!cache_header.dirty, database_exception, "code cache is dirty");
+      if(!cache_header.dirty)
+         return;
+
+      //not shut down cleanly: the compiled code is still in the cache, recover its index from the journal
+      EOS_ASSERT(std::filesystem::exists(_journal_path), database_exception, "code cache is dirty");
+      try {
+         const std::vector<journaled_code> journal = read_journal(_journal_path);
+         for(const journaled_code& jc : journal)
+            journaled_codes.emplace_back(code_tuple{jc.descriptor.code_hash, jc.descriptor.vm_version});
+
+         bip::file_mapping recovery_mapping(_cache_file_path.generic_string().c_str(), bip::read_write);
+         bip::mapped_region recovery_region(recovery_mapping, bip::read_write);
+         char* recovery_base = (char*)recovery_region.get_address();
+         allocator_t* recovery_allocator = reinterpret_cast<allocator_t*>(recovery_base);
+         EOS_ASSERT(recovery_allocator->check_sanity(), database_exception, "code cache is dirty and its allocator is corrupt");
+
+         //code is only deallocated after its removal is journaled, but code compiled or evicted right before the unclean
+         // shutdown, or dropped below, can be left allocated without being in the index; start over if that leaks too
+         // much of the cache
+         size_t referenced_bytes = 0;
+         for(const journaled_code& jc : journal) {
+            const code_descriptor& cd = jc.descriptor;
+            EOS_ASSERT(cd.code_begin >= total_header_size && cd.code_begin < recovery_region.get_size() &&
+                       cd.initdata_begin >= total_header_size && cd.initdata_begin < recovery_region.get_size(),
+                       database_exception, "code cache journal entry out of range");
+            //the journal is not synced after the code it describes, after a power loss it can refer to code that was
+            // never written to disk or was overwritten since; leave that code to be compiled again
+            if(recovery_allocator->size(recovery_base + cd.code_begin) != jc.code_size ||
+               jc.code_size > recovery_region.get_size() - cd.code_begin ||
+               cd.initdata_size > recovery_region.get_size() - cd.initdata_begin ||
+               code_checksum(recovery_base, cd, jc.code_size) != jc.checksum) {
+               wlog("EOS VM OC code cache journal entry for ${c} does not match the code in the cache, dropping it", ("c", cd.code_hash));
+               continue;
+            }
+            referenced_bytes += jc.code_size + recovery_allocator->size(recovery_base + cd.initdata_begin);
+            journaled_index.push_back(cd);
+         }
+         const size_t used_bytes = recovery_allocator->get_size() - recovery_allocator->get_free_memory();
+         EOS_ASSERT(used_bytes <= referenced_bytes + recovery_allocator->get_size() / 10, database_exception,
+                    "code cache is dirty and ${u} of ${t} bytes are not referenced by its journal",
+                    ("u", used_bytes - std::min(used_bytes, referenced_bytes))("t", recovery_allocator->get_size()));
+      } FC_RETHROW_EXCEPTIONS(warn, "unable to recover EOS VM OC code cache index from ${j}", ("j", _journal_path))
    };
 
    if (!std::filesystem::exists(_cache_file_path)) {
@@ -272,6 +439,10 @@ code_cache_base::code_cache_base(const std::filesystem::path& data_dir, const eo
       check_code_cache();
    }
 
+   //a journal left next to a clean cache does not describe it
+   if(!cache_header.dirty)
+      std::filesystem::remove(_journal_path);
+
    set_on_disk_region_dirty(true);
 
    auto existing_file_size = std::filesystem::file_size(_cache_file_path);
@@ -289,18 +460,33 @@ code_cache_base::code_cache_base(const std::filesystem::path& data_dir, const eo
    EOS_ASSERT(_cache_fd >= 0, database_exception, "failure to open code cache");
 
    //load up the previous cache index
-   char* code_mapping = (char*)mmap(nullptr, eosvmoc_config.cache_size, PROT_READ|PROT_WRITE, MAP_SHARED, _cache_fd, 0);
+   char* code_mapping = (char*)mmap(nullptr, std::filesystem::file_size(_cache_file_path), PROT_READ|PROT_WRITE, MAP_SHARED, _cache_fd, 0);
    EOS_ASSERT(code_mapping != MAP_FAILED, database_exception, "failure to mmap code cache");
+   _code_mapping = code_mapping;
 
    allocator_t* allocator = reinterpret_cast<allocator_t*>(code_mapping);
 
-   if(cache_header.serialized_descriptor_index) {
+   //the index of the previous run, most recently used first
+   std::vector<code_tuple> previous_index = std::move(journaled_codes);
+
+   if(cache_header.dirty) {
+      //serialized_descriptor_index is stale, it was deallocated when the previous run loaded it
+      for(code_descriptor& cd : journaled_index) {
+         //left allocated: deallocating here would deallocate again if this recovery is interrupted and repeated
+         if(cd.codegen_version == current_codegen_version)
+            _cache_index.push_back(std::move(cd));
+      }
+
+      ilog("EOS VM Optimized Compiler code cache recovered ${c} entries after unclean shutdown; ${f} of ${t} bytes free", ("c", _cache_index.size())("f", allocator->get_free_memory())("t", allocator->get_size()));
+   }
+   else if(cache_header.serialized_descriptor_index) {
       fc::datastream<const char*> ds(code_mapping + cache_header.serialized_descriptor_index, eosvmoc_config.cache_size - cache_header.serialized_descriptor_index);
       unsigned number_entries;
       fc::raw::unpack(ds, number_entries);
       for(unsigned i = 0; i < number_entries; ++i) {
          code_descriptor cd;
          fc::raw::unpack(ds, cd);
+         previous_index.emplace_back(code_tuple{cd.code_hash, cd.vm_version});
          if(cd.codegen_version != current_codegen_version) {
             allocator->deallocate(code_mapping + cd.code_begin);
             allocator->deallocate(code_mapping + cd.initdata_begin);
@@ -312,7 +498,19 @@ code_cache_base::code_cache_base(const std::filesystem::path& data_dir, const eo
 
       ilog("EOS VM Optimized Compiler code cache loaded with ${c} entries; ${f} of ${t} bytes free", ("c", number_entries)("f", allocator->get_free_memory())("t", allocator->get_size()));
    }
-   munmap(code_mapping, eosvmoc_config.cache_size);
+
+   //page in the most recently used code now, the rest is compiled by preload() once the chain state is available
+   previous_index.resize(std::min<size_t>(previous_index.size(), eosvmoc_config.preload_count));
+   _preload_candidates = std::move(previous_index);
+   for(const code_tuple& ct : _preload_candidates) {
+      auto it = _cache_index.get<by_hash>().find(boost::make_tuple(ct.code_id, ct.vm_version));
+      if(it == _cache_index.get<by_hash>().end())
+         continue;
+      posix_fadvise(_cache_fd, it->code_begin, allocator->size(code_mapping + it->code_begin), POSIX_FADV_WILLNEED);
+      posix_fadvise(_cache_fd, it->initdata_begin, allocator->size(code_mapping + it->initdata_begin), POSIX_FADV_WILLNEED);
+   }
+
+   write_journal();
 
    _free_bytes_eviction_threshold = eosvmoc_config.cache_size * .1;
 
@@ -343,14 +541,7 @@ void code_cache_base::serialize_cache_index(fc::datastream<T>& ds) {
 }
 
 code_cache_base::~code_cache_base() {
-   //reopen the code cache in our process
-   struct stat st;
-   if(fstat(_cache_fd, &st))
-      return;
-   char* code_mapping = (char*)mmap(nullptr, st.st_size, PROT_READ|PROT_WRITE, MAP_SHARED, _cache_fd, 0);
-   if(code_mapping == MAP_FAILED)
-      return;
-
+   char* code_mapping = _code_mapping;
    allocator_t* allocator = reinterpret_cast<allocator_t*>(code_mapping);
 
    //serialize out the cache index
@@ -366,6 +557,7 @@ code_cache_base::~code_cache_base() {
       //in theory, there could be too little free space avaiable to store the cache index
       //try to free up some space
       for(unsigned int i = 0; i < 25 && _cache_index.size(); ++i) {
+         append_to_journal(code_tuple{_cache_index.back().code_hash, _cache_index.back().vm_version});
          allocator->deallocate(code_mapping + _cache_index.back().code_begin);
          allocator->deallocate(code_mapping + _cache_index.back().initdata_begin);
          _cache_index.pop_back();
@@ -386,18 +578,79 @@ code_cache_base::~code_cache_base() {
    close(_cache_fd);
    set_on_disk_region_dirty(false);
 
+   _journal.close();
+   std::error_code ec;
+   std::filesystem::remove(_journal_path, ec);
+}
+
+void code_cache_base::write_journal() {
+   std::filesystem::path tmp_path = _journal_path;
+   tmp_path += ".tmp";
+   try {
+      fc::cfile journal;
+      journal.set_file_path(tmp_path);
+      journal.open("wb");
+      journal.write((const char*)&journal_id, sizeof(journal_id));
+      journal.write((const char*)&journal_version, sizeof(journal_version));
+      //least recently used first, so replaying the journal restores the order of the index
+      for(auto it = _cache_index.rbegin(); it != _cache_index.rend(); ++it)
+         write_journal_record(journal, journal_record{journal_entry(*it)});
+      journal.flush();
+      journal.sync();
+      journal.close();
+      std::filesystem::rename(tmp_path, _journal_path);
+
+      _journal.set_file_path(_journal_path);
+      _journal.open("ab");
+   } catch(...) {
+      //without a journal an unclean shutdown recreates the cache, as it did before there was a journal
+      elog("Unable to write EOS VM OC code cache journal ${j}", ("j", _journal_path));
+      _journal.close();
+      std::error_code ec;
+      std::filesystem::remove(tmp_path, ec);
+      std::filesystem::remove(_journal_path, ec);
+   }
+}
+
+journaled_code code_cache_base::journal_entry(const code_descriptor& cd) const {
+   const allocator_t* allocator = reinterpret_cast<const allocator_t*>(_code_mapping);
+   journaled_code jc{cd, allocator->size(_code_mapping + cd.code_begin)};
+   jc.checksum = code_checksum(_code_mapping, cd, jc.code_size);
+   return jc;
+}
+
+void code_cache_base::append_to_journal(const code_descriptor& added) {
+   if(_journal.is_open())
+      append_to_journal(journal_record{journal_entry(added)});
+}
+
+void code_cache_base::append_to_journal(const journal_record& record) {
+   if(!_journal.is_open())
+      return;
+   try {
+      write_journal_record(_journal, record);
+      //flushed to the OS so it survives the process, code cache pages are not synced to disk while running either
+      _journal.flush();
+   } catch(...) {
+      elog("Unable to write EOS VM OC code cache journal ${j}", ("j", _journal_path));
+      _journal.close();
+      std::error_code ec;
+      std::filesystem::remove(_journal_path, ec);
+   }
 }
 
 void code_cache_base::free_code(const digest_type& code_id, const uint8_t& vm_version) {
    code_cache_index::index<by_hash>::type::iterator it = _cache_index.get<by_hash>().find(boost::make_tuple(code_id, vm_version));
    if(it != _cache_index.get<by_hash>().end()) {
+      //journaled before the compile monitor deallocates it, so a recovered index never refers to deallocated code
+      append_to_journal(code_tuple{it->code_hash, it->vm_version});
       write_message_with_fds(_compile_monitor_write_socket, evict_wasms_message{ {*it} });
       _cache_index.get<by_hash>().erase(it);
    }
 
    //if it's in the queued list, erase it
-   if(auto i = _queued_compiles.get<by_hash>().find(boost::make_tuple(std::ref(code_id), vm_version)); i != _queued_compiles.get<by_hash>().end())
-      _queued_compiles.get<by_hash>().erase(i);
+   if(_queued_compiles.erase({code_id, vm_version}))
+      _compile_stats.forget({code_id, vm_version});
 
    //however, if it's currently being compiled there is no way to cancel the compile,
    //so instead set a poison boolean that indicates not to insert the code in to the cache
@@ -410,6 +663,7 @@ void code_cache_base::free_code(const digest_type& code_id, const uint8_t& vm_ve
 void code_cache_base::run_eviction_round() {
    evict_wasms_message evict_msg;
    for(unsigned int i = 0; i < 25 && _cache_index.size() > 1; ++i) {
+      append_to_journal(code_tuple{_cache_index.back().code_hash, _cache_index.back().vm_version});
       evict_msg.codes.emplace_back(_cache_index.back());
       _cache_index.pop_back();
    }
@@ -420,4 +674,61 @@ void code_cache_base::check_eviction_threshold(size_t free_bytes) {
    if(free_bytes < _free_bytes_eviction_threshold)
       run_eviction_round();
 }
+
+void compile_queue::push(const code_tuple& ct, bool high_priority, uint64_t requests) {
+   auto& by_code_idx = _queue.get<by_code>();
+   if(auto it = by_code_idx.find(boost::make_tuple(std::ref(ct.code_id), ct.vm_version)); it != by_code_idx.end()) {
+      by_code_idx.modify(it, [&](queued_compile& qc) {
+         qc.requests += requests;
+         qc.high_priority = qc.high_priority || high_priority;
+      });
+      return;
+   }
+   queued_compile qc;
+   static_cast<code_tuple&>(qc) = ct;
+   qc.high_priority = high_priority;
+   qc.requests = requests;
+   qc.sequence = _next_sequence++;
+   _queue.insert(std::move(qc));
+}
+
+bool compile_queue::contains(const code_tuple& ct) const {
+   return _queue.get<by_code>().count(boost::make_tuple(std::ref(ct.code_id), ct.vm_version));
+}
+
+bool compile_queue::erase(const code_tuple& ct) {
+   auto& by_code_idx = _queue.get<by_code>();
+   auto it = by_code_idx.find(boost::make_tuple(std::ref(ct.code_id), ct.vm_version));
+   if(it == by_code_idx.end())
+      return false;
+   by_code_idx.erase(it);
+   return true;
+}
+
+const code_tuple& compile_queue::front() const {
+   return *_queue.begin();
+}
+
+void compile_queue::pop_front() {
+   _queue.erase(_queue.begin());
+}
+
+void compile_stats_tracker::requested(const code_tuple& ct, fc::time_point now) {
+   _request_times.emplace(ct, now);
+}
+
+void compile_stats_tracker::completed(const code_tuple& ct, bool success, fc::time_point now) {
+   if(success) {
+      ++_stats.compiled;
+      if(auto it = _request_times.find(ct); it != _request_times.end())
+         _stats.latency_us += (now - it->second).count();
+   }
+   else
+      ++_stats.failed;
+   _request_times.erase(ct);
+}
+
+void compile_stats_tracker::forget(const code_tuple& ct) {
+   _request_times.erase(ct);
+}
 }}}
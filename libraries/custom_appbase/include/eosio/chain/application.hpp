@@ -2,6 +2,7 @@
 
 #include <appbase/application_base.hpp>
 #include <eosio/chain/exec_pri_queue.hpp>
+#include <atomic>
 #include <chrono>
 #include <optional>
 #include <mutex>
@@ -93,7 +94,11 @@ public:
 
       bool more = false;
       while (true) {
-         get_io_service().poll(); // schedule any queued
+         // schedule any queued, one read thread at a time, the others would only contend on the io_service lock
+         if (!polling_.test_and_set(std::memory_order_acquire)) {
+            get_io_service().poll();
+            polling_.clear(std::memory_order_release);
+         }
          more = pri_queue_.execute_highest_blocking_locked(exec_queue::read_only, exec_queue::read_exclusive);
          if (!more || std::chrono::high_resolution_clock::now() > end)
             break;
@@ -147,6 +152,7 @@ private:
    appbase::exec_pri_queue            pri_queue_;
    std::atomic<std::size_t>           order_{ std::numeric_limits<size_t>::max() }; // to maintain FIFO ordering in all queues within priority
    exec_window                        exec_window_{ exec_window::write };
+   std::atomic_flag                   polling_; // a read thread is polling io_serv_
 };
 
 using application = application_t<priority_queue_executor>;
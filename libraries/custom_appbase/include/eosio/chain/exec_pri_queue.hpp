@@ -1,10 +1,13 @@
 #pragma once
 #include <boost/asio.hpp>
 
+#include <array>
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 #include <optional>
 #include <queue>
+#include <thread>
 
 namespace appbase {
 // adapted from: https://www.boost.org/doc/libs/1_69_0/doc/html/boost_asio/example/cpp11/invocation/prioritised_handlers.cpp
@@ -65,95 +68,99 @@ public:
    template <typename Function>
    void add(int priority, exec_queue q, size_t order, Function function) {
       assert( num_read_threads_ > 0 || q != exec_queue::read_exclusive);
-      prio_queue& que = priority_que(q);
       std::unique_ptr<queued_handler_base> handler(new queued_handler<Function>(priority, order, std::move(function)));
-      if (lock_enabled_ || q == exec_queue::read_exclusive) { // called directly from any thread for read_exclusive
-         std::lock_guard g( mtx_ );
-         que.push( std::move( handler ) );
-         if (num_waiting_)
+      if (q == exec_queue::read_write) { // never executed by read threads, no need to wake them
+         if (lock_enabled_) {
+            std::lock_guard g( mtx_ );
+            read_write_handlers_.push( std::move( handler ) );
+         } else {
+            read_write_handlers_.push( std::move( handler ) );
+         }
+      } else { // called directly from any thread for read_exclusive
+         sharded_que(q).push( std::move( handler ) );
+         if (num_waiting_) {
+            std::lock_guard g( mtx_ );
             cond_.notify_one();
-      } else {
-         que.push( std::move( handler ) );
+         }
       }
    }
 
    // only call when no lock required
    void clear() {
-      read_only_handlers_ = prio_queue();
+      read_only_handlers_.clear();
       read_write_handlers_ = prio_queue();
-      read_exclusive_handlers_ = prio_queue();
+      read_exclusive_handlers_.clear();
    }
 
    bool execute_highest_locked(exec_queue q) {
-      prio_queue& que = priority_que(q);
-      std::unique_lock g(mtx_);
-      if (que.empty())
+      auto t = pop_locked(q);
+      if (!t)
          return false;
-      auto t = pop(que);
-      g.unlock();
       t->execute();
       return true;
    }
 
    // only call when no lock required
    bool execute_highest(exec_queue lhs, exec_queue rhs) {
-      prio_queue& lhs_que = priority_que(lhs);
-      prio_queue& rhs_que = priority_que(rhs);
-      size_t size = lhs_que.size() + rhs_que.size();
+      size_t size = this->size(lhs) + this->size(rhs);
       if (size == 0)
          return false;
       exec_queue q = rhs;
-      if (!lhs_que.empty() && (rhs_que.empty() || *rhs_que.top() < *lhs_que.top()))
+      if (!empty(lhs) && (empty(rhs) || top_key(rhs) < top_key(lhs)))
          q = lhs;
-      prio_queue& que = priority_que(q);
-      assert(que.top());
       // pop, then execute since read_write queue is used to switch to read window and the pop needs to happen before that lambda starts
-      auto t = pop(que);
+      auto t = pop_locked(q);
+      assert(t);
       t->execute();
       --size;
       return size > 0;
    }
 
+   // handlers are popped without taking mtx_, which is only used by threads that found both queues empty and wait
    bool execute_highest_blocking_locked(exec_queue lhs, exec_queue rhs) {
-      prio_queue& lhs_que = priority_que(lhs);
-      prio_queue& rhs_que = priority_que(rhs);
-      std::unique_lock g(mtx_);
-      ++num_waiting_;
-      cond_.wait(g, [&](){
-         bool exit = exiting_blocking_ || should_exit_();
-         bool empty = lhs_que.empty() && rhs_que.empty();
-         if (empty || exit) {
-            if (((empty && num_waiting_ == max_waiting_) || exit) && !exiting_blocking_) {
+      sharded_prio_queue& lhs_que = sharded_que(lhs);
+      sharded_prio_queue& rhs_que = sharded_que(rhs);
+      while (true) {
+         if (exiting_blocking_ || should_exit_()) {
+            std::lock_guard g(mtx_);
+            if (!exiting_blocking_) {
                exiting_blocking_ = true;
                cond_.notify_all();
             }
-            return exit || exiting_blocking_; // same as calling should_exit(), but faster
+            return false;
          }
-         return true;
-      });
-      --num_waiting_;
-      if (exiting_blocking_ || should_exit_())
-         return false;
-      if (lhs_que.empty() && rhs_que.empty())
-         return false;
-      exec_queue q = rhs;
-      if (!lhs_que.empty() && (rhs_que.empty() || *rhs_que.top() < *lhs_que.top()))
-         q = lhs;
-      auto t = pop(priority_que(q));
-      g.unlock();
-      t->execute();
-      return true; // this should never return false unless all read threads should exit
+         if (auto t = pop_highest(lhs_que, rhs_que)) {
+            t->execute();
+            return true;
+         }
+
+         std::unique_lock g(mtx_);
+         ++num_waiting_; // before checking the queues, add() checks num_waiting_ after pushing
+         cond_.wait(g, [&](){
+            bool exit = exiting_blocking_ || should_exit_();
+            bool empty = lhs_que.empty() && rhs_que.empty();
+            if (empty || exit) {
+               if (((empty && num_waiting_ == max_waiting_) || exit) && !exiting_blocking_) {
+                  exiting_blocking_ = true;
+                  cond_.notify_all();
+               }
+               return exit || exiting_blocking_; // same as calling should_exit(), but faster
+            }
+            return true;
+         });
+         --num_waiting_;
+         if (exiting_blocking_ || should_exit_())
+            return false;
+         // not empty, another thread might pop the handler first in which case wait again
+      }
    }
 
    // Only call when locking disabled
-   size_t size(exec_queue q) const { return priority_que(q).size(); }
+   size_t size(exec_queue q) const { return q == exec_queue::read_write ? read_write_handlers_.size() : sharded_que(q).size(); }
    size_t size() const { return read_only_handlers_.size() + read_write_handlers_.size() + read_exclusive_handlers_.size(); }
 
    // Only call when locking disabled
-   bool empty(exec_queue q) const { return priority_que(q).empty(); }
-
-   // Only call when locking disabled
-   const auto& top(exec_queue q) const { return priority_que(q).top(); }
+   bool empty(exec_queue q) const { return size(q) == 0; }
 
    class executor
    {
@@ -228,6 +235,7 @@ private:
       virtual void execute() = 0;
 
       int priority() const { return priority_; }
+      size_t order() const { return order_; }
       // C++20
       // friend std::weak_ordering operator<=>(const queued_handler_base&,
       //                                       const queued_handler_base&) noexcept = default;
@@ -272,32 +280,6 @@ private:
 
    using prio_queue = std::priority_queue<std::unique_ptr<queued_handler_base>, std::deque<std::unique_ptr<queued_handler_base>>, deref_less>;
 
-   prio_queue& priority_que(exec_queue q) {
-      switch (q) {
-         case exec_queue::read_only:
-            return read_only_handlers_;
-         case exec_queue::read_write:
-            return read_write_handlers_;
-         case exec_queue::read_exclusive:
-            return read_exclusive_handlers_;
-      }
-      assert(false);
-      return read_only_handlers_;
-   }
-
-   const prio_queue& priority_que(exec_queue q) const {
-      switch (q) {
-         case exec_queue::read_only:
-            return read_only_handlers_;
-         case exec_queue::read_write:
-            return read_write_handlers_;
-         case exec_queue::read_exclusive:
-            return read_exclusive_handlers_;
-      }
-      assert(false);
-      return read_only_handlers_;
-   }
-
    static std::unique_ptr<exec_pri_queue::queued_handler_base> pop(prio_queue& que) {
       // work around std::priority_queue not having a pop() that returns value
       auto t = std::move(const_cast<std::unique_ptr<queued_handler_base>&>(que.top()));
@@ -305,17 +287,191 @@ private:
       return t;
    }
 
+   // priority and order of a handler, copied so it can be compared without holding the lock of its queue
+   struct handler_key {
+      bool   valid    = false;
+      int    priority = 0;
+      size_t order    = 0;
+
+      friend bool operator<(const handler_key& a, const handler_key& b) noexcept {
+         return std::tie( a.priority, a.order ) < std::tie( b.priority, b.order );
+      }
+   };
+
+   // Priority queue of the read_only and read_exclusive handlers which are popped concurrently by all read threads.
+   // It is split into shards, each with its own lock, and handlers are pushed round-robin. Every shard publishes the
+   // key of its highest handler through a seqlock, so pop() finds the highest shard without taking any lock. When the
+   // lock of that shard is held by another thread, pop() moves on to a shard whose highest handler has the same
+   // priority instead of waiting. Priority order is always kept, post order within a priority is kept when there is
+   // no contention.
+   class sharded_prio_queue {
+   public:
+      static constexpr size_t num_shards = 8;
+
+      void push(std::unique_ptr<queued_handler_base> handler) {
+         shard& s = shards_[next_shard_.fetch_add(1, std::memory_order_relaxed) % num_shards];
+         std::lock_guard g( s.mtx );
+         s.que.push( std::move( handler ) );
+         s.publish_top();
+         ++size_;
+      }
+
+      std::unique_ptr<queued_handler_base> pop() {
+         while (size_ > 0) {
+            std::array<handler_key, num_shards> keys;
+            size_t best = num_shards;
+            for (size_t i = 0; i < num_shards; ++i) {
+               keys[i] = shards_[i].read_top();
+               if (keys[i].valid && (best == num_shards || keys[best] < keys[i]))
+                  best = i;
+            }
+            if (best == num_shards)
+               return {};
+            const int priority = keys[best].priority;
+
+            // highest shard first, then the others with a handler of the same priority, without waiting for a lock
+            for (size_t n = 0; n < num_shards; ++n) {
+               const size_t i = (best + n) % num_shards;
+               if (!keys[i].valid || keys[i].priority != priority)
+                  continue;
+               std::unique_lock g( shards_[i].mtx, std::try_to_lock );
+               if (g && !shards_[i].que.empty() && shards_[i].que.top()->priority() >= priority)
+                  return pop_top(shards_[i]);
+            }
+
+            std::lock_guard g( shards_[best].mtx );
+            if (!shards_[best].que.empty() && shards_[best].que.top()->priority() >= priority)
+               return pop_top(shards_[best]);
+            // popped by another thread meanwhile, look again
+         }
+         return {};
+      }
+
+      // empty if no handler, key of the highest handler otherwise
+      handler_key top_key() const {
+         handler_key result;
+         for (const shard& s : shards_) {
+            handler_key k = s.read_top();
+            if (k.valid && (!result.valid || result < k))
+               result = k;
+         }
+         return result;
+      }
+
+      size_t size() const { return size_; }
+      bool empty() const { return size_ == 0; }
+
+      void clear() {
+         for (shard& s : shards_) {
+            std::lock_guard g( s.mtx );
+            size_ -= s.que.size();
+            s.que = prio_queue();
+            s.publish_top();
+         }
+      }
+
+   private:
+      struct alignas(64) shard {
+         std::mutex            mtx;
+         prio_queue            que;
+         // seqlock protecting the copy of the key of que.top(), written holding mtx, read without
+         std::atomic<uint32_t> seq{0};
+         std::atomic<bool>     has_top{false};
+         std::atomic<int>      top_priority{0};
+         std::atomic<size_t>   top_order{0};
+
+         void publish_top() {
+            const uint32_t s = seq.load(std::memory_order_relaxed);
+            seq.store(s + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            has_top.store(!que.empty(), std::memory_order_relaxed);
+            if (!que.empty()) {
+               top_priority.store(que.top()->priority(), std::memory_order_relaxed);
+               top_order.store(que.top()->order(), std::memory_order_relaxed);
+            }
+            seq.store(s + 2, std::memory_order_release);
+         }
+
+         handler_key read_top() const {
+            while (true) {
+               const uint32_t s = seq.load(std::memory_order_acquire);
+               if (s & 1) { // being written, writers hold the lock for a few instructions
+                  std::this_thread::yield();
+                  continue;
+               }
+               handler_key k{ has_top.load(std::memory_order_relaxed),
+                              top_priority.load(std::memory_order_relaxed),
+                              top_order.load(std::memory_order_relaxed) };
+               std::atomic_thread_fence(std::memory_order_acquire);
+               if (seq.load(std::memory_order_relaxed) == s)
+                  return k;
+            }
+         }
+      };
+
+      // call holding s.mtx
+      std::unique_ptr<queued_handler_base> pop_top(shard& s) {
+         auto t = exec_pri_queue::pop(s.que);
+         s.publish_top();
+         --size_;
+         return t;
+      }
+
+      std::array<shard, num_shards> shards_;
+      std::atomic<size_t>           next_shard_{0};
+      std::atomic<size_t>           size_{0};
+   };
+
+   sharded_prio_queue& sharded_que(exec_queue q) {
+      assert(q != exec_queue::read_write);
+      return q == exec_queue::read_only ? read_only_handlers_ : read_exclusive_handlers_;
+   }
+
+   const sharded_prio_queue& sharded_que(exec_queue q) const {
+      assert(q != exec_queue::read_write);
+      return q == exec_queue::read_only ? read_only_handlers_ : read_exclusive_handlers_;
+   }
+
+   handler_key top_key(exec_queue q) const {
+      if (q != exec_queue::read_write)
+         return sharded_que(q).top_key();
+      if (read_write_handlers_.empty())
+         return {};
+      return { true, read_write_handlers_.top()->priority(), read_write_handlers_.top()->order() };
+   }
+
+   std::unique_ptr<queued_handler_base> pop_locked(exec_queue q) {
+      if (q != exec_queue::read_write)
+         return sharded_que(q).pop();
+      std::lock_guard g( mtx_ );
+      if (read_write_handlers_.empty())
+         return {};
+      return pop(read_write_handlers_);
+   }
+
+   static std::unique_ptr<queued_handler_base> pop_highest(sharded_prio_queue& lhs_que, sharded_prio_queue& rhs_que) {
+      const handler_key lhs_top = lhs_que.top_key();
+      const handler_key rhs_top = rhs_que.top_key();
+      if (!lhs_top.valid && !rhs_top.valid)
+         return {};
+      sharded_prio_queue& que = lhs_top.valid && (!rhs_top.valid || rhs_top < lhs_top) ? lhs_que : rhs_que;
+      if (auto t = que.pop())
+         return t;
+      // emptied by other threads meanwhile
+      return (&que == &lhs_que ? rhs_que : lhs_que).pop();
+   }
+
    size_t num_read_threads_ = 0;
    bool lock_enabled_ = false;
    mutable std::mutex mtx_;
    std::condition_variable cond_;
-   uint32_t num_waiting_{0};
+   std::atomic<uint32_t> num_waiting_{0};
    uint32_t max_waiting_{0};
-   bool exiting_blocking_{false};
-   std::function<bool()> should_exit_; // called holding mtx_
-   prio_queue read_only_handlers_;
+   std::atomic<bool> exiting_blocking_{false};
+   std::function<bool()> should_exit_; // thread-safe, called with and without holding mtx_
+   sharded_prio_queue read_only_handlers_;
    prio_queue read_write_handlers_;
-   prio_queue read_exclusive_handlers_;
+   sharded_prio_queue read_exclusive_handlers_;
 };
 
 } // appbase
@@ -449,4 +449,65 @@ BOOST_AUTO_TEST_CASE( execute_many_from_read_only_and_read_exclusive_queues ) {
    BOOST_CHECK(run_on_main > 0);
 }
 
+// many read threads popping small tasks concurrently, reports the throughput of the read queues
+BOOST_AUTO_TEST_CASE( read_threads_contention ) {
+   scoped_app_thread app(true);
+
+   constexpr size_t num_read_threads = 32;
+   constexpr size_t num_posting_threads = 4;
+   constexpr size_t num_per_posting_thread = 25000;
+   constexpr size_t num_expected = num_posting_threads * num_per_posting_thread;
+   app->executor().init_read_threads(num_read_threads);
+   app->executor().set_to_read_window([](){return false;});
+
+   // post from several threads at once, read_exclusive directly into the queue and read_only through the io_service
+   std::atomic<size_t> num_executed = 0;
+   std::atomic<size_t> num_out_of_order = 0; // highest executed after a lowest
+   std::atomic<bool>   lowest_executed = false;
+   std::vector<std::thread> posting_threads;
+   for (size_t t = 0; t < num_posting_threads; ++t) {
+      posting_threads.emplace_back([&, t]() {
+         for (size_t i = 0; i < num_per_posting_thread; ++i) {
+            const int prio = i % 100 == 0 ? priority::highest : i % 2 ? priority::low : priority::lowest;
+            const exec_queue q = (t + i) % 2 ? exec_queue::read_only : exec_queue::read_exclusive;
+            app->executor().post( prio, q, [&, prio]() {
+               if (prio == priority::lowest)
+                  lowest_executed = true;
+               else if (prio == priority::highest && lowest_executed)
+                  ++num_out_of_order;
+               ++num_executed;
+            } );
+         }
+      });
+   }
+   for (auto& t : posting_threads)
+      t.join();
+
+   std::optional<boost::asio::io_service::work> work;
+   work.emplace(app->get_io_service());
+   while( app->executor().read_only_queue_size() + app->executor().read_exclusive_queue_size() < num_expected ) {
+      app->get_io_service().poll();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+   }
+
+   app.start_exec();
+   const auto start = std::chrono::steady_clock::now();
+   std::vector<std::thread> read_threads;
+   for (size_t t = 0; t < num_read_threads; ++t)
+      read_threads.emplace_back(start_read_thread(app));
+   for (auto& t : read_threads)
+      t.join();
+   const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+   work.reset();
+   app->quit();
+   app.join();
+
+   BOOST_TEST_MESSAGE( num_expected << " tasks on " << num_read_threads << " read threads in " << elapsed.count() << " us" );
+   BOOST_REQUIRE_EQUAL( num_executed, num_expected );
+   // priority order is kept, all highest are popped before the first lowest. Each thread, including the main thread,
+   // can still be executing a highest popped before then.
+   BOOST_CHECK_LE( num_out_of_order, num_read_threads + 1 );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -30,6 +30,12 @@ class sha256
     static sha256 hash( const std::string& );
     static sha256 hash( const sha256& );
 
+    /**
+     * Hashes count pairs of digests, out[i] = hash of the 64 bytes of in[2*i] followed by in[2*i+1].
+     * Batches the independent hashes of a merkle tree level, out may be equal to in.
+     */
+    static void hash_pairs( const sha256* in, size_t count, sha256* out );
+
     template<typename T>
     static sha256 hash( const T& t ) 
     { 
@@ -112,6 +118,17 @@ class sha256
 
   uint64_t hash64(const char* buf, size_t len);    
 
+  namespace detail {
+     /// kernels sha256::hash_pairs() selects from, exposed to compare them in tests
+     enum class hash_pairs_kernel { scalar, avx2 };
+
+     /// @return true if the cpu can run kernel
+     bool hash_pairs_kernel_supported( hash_pairs_kernel kernel );
+
+     /// sha256::hash_pairs() through kernel, which must be supported
+     void hash_pairs( hash_pairs_kernel kernel, const sha256* in, size_t count, sha256* out );
+  }
+
 } // fc
 
 namespace std
@@ -84,6 +84,37 @@ namespace fc
 
    std::string escape_string( const std::string_view& str, const json::yield_function_t& yield, bool escape_control_chars = true );
 
+   /**
+    *  Writes the JSON of a variant incrementally so a large value can be sent while it is still being serialized.
+    *  The concatenation of all chunks is the same as json::to_string() of the variant, yield is called with the total
+    *  number of bytes written so far. The variant must outlive the writer.
+    */
+   class json_chunk_writer
+   {
+      public:
+         explicit json_chunk_writer( const variant& v, const json::output_formatting format = json::output_formatting::stringify_large_ints_and_doubles );
+
+         /// Appends at least max_size bytes of JSON to out unless the end of the value is reached first
+         /// @return true once the complete value has been written
+         bool write( std::string& out, size_t max_size, const json::yield_function_t& yield );
+
+         bool done()const { return started && stack.empty(); }
+
+      private:
+         struct frame {
+            const variant* v     = nullptr; ///< array or object being written
+            size_t         index = 0;       ///< of the next element
+         };
+
+         void write_value( const variant& v, std::string& out, const json::yield_function_t& yield );
+
+         const variant&           root;
+         json::output_formatting  format;
+         bool                     started = false;
+         size_t                   written = 0; ///< by previous calls to write()
+         std::vector<frame>       stack;
+   };
+
 } // fc
 
 #undef DEFAULT_MAX_RECURSION_DEPTH
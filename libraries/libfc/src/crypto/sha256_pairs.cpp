@@ -0,0 +1,201 @@
+#include <fc/crypto/sha256.hpp>
+#include <fc/exception/exception.hpp>
+#include <openssl/sha.h>
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+// sha256::hash_pairs() hashes many independent 64 byte messages, the nodes of a merkle tree. Every message takes
+// exactly two compressions: the message itself and a padding block which is the same for all of them, so the
+// schedule of the padding block is computed at compile time.
+//
+// OpenSSL already uses the SHA extensions when the cpu has them, and a single stream of those is as fast as
+// interleaving several messages. Without them, OpenSSL hashes one block at a time with scalar or SIMD code, while
+// the AVX2 kernel below hashes 8 messages at once, one per 32 bit lane, about 3 times faster.
+
+namespace fc {
+
+namespace {
+
+constexpr std::array<uint32_t, 64> k = {
+   0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+   0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+   0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+   0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+   0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+   0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+   0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+   0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+constexpr std::array<uint32_t, 8> initial_state = {
+   0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+constexpr uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+// schedule of the padding block of a 64 byte message: 0x80, zeros and the message length in bits
+constexpr std::array<uint32_t, 64> padding_schedule() {
+   std::array<uint32_t, 64> w{};
+   w[0]  = 0x80000000;
+   w[15] = 64 * 8;
+   for (size_t t = 16; t < 64; ++t) {
+      uint32_t s0 = rotr(w[t - 15], 7) ^ rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+      uint32_t s1 = rotr(w[t - 2], 17) ^ rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+      w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+   }
+   return w;
+}
+
+// padding schedule with the round constants added, what the rounds of the padding block consume
+constexpr std::array<uint32_t, 64> padding_kw = [] {
+   auto w = padding_schedule();
+   for (size_t t = 0; t < 64; ++t)
+      w[t] += k[t];
+   return w;
+}();
+
+void hash_pairs_openssl(const char* in, size_t count, char* out) {
+   for (size_t i = 0; i < count; ++i) {
+      unsigned char digest[SHA256_DIGEST_LENGTH];
+      SHA256_CTX    ctx;
+      SHA256_Init(&ctx);
+      SHA256_Update(&ctx, in + 64 * i, 64);
+      SHA256_Final(digest, &ctx);
+      memcpy(out + 32 * i, digest, sizeof(digest));
+   }
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2")))
+inline __m256i rotr8x(__m256i x, int n) {
+   return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+__attribute__((target("avx2")))
+inline void avx2_round(__m256i (&r)[8], __m256i kw) {
+   auto& [a, b, c, d, e, f, g, h] = r;
+   __m256i s1  = _mm256_xor_si256(_mm256_xor_si256(rotr8x(e, 6), rotr8x(e, 11)), rotr8x(e, 25));
+   __m256i ch  = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+   __m256i t1  = _mm256_add_epi32(_mm256_add_epi32(h, s1), _mm256_add_epi32(ch, kw));
+   __m256i s0  = _mm256_xor_si256(_mm256_xor_si256(rotr8x(a, 2), rotr8x(a, 13)), rotr8x(a, 22));
+   __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+   __m256i t2  = _mm256_add_epi32(s0, maj);
+   h = g;
+   g = f;
+   f = e;
+   e = _mm256_add_epi32(d, t1);
+   d = c;
+   c = b;
+   b = a;
+   a = _mm256_add_epi32(t1, t2);
+}
+
+__attribute__((target("avx2")))
+void hash_pairs_avx2(const char* in, size_t count, char* out) {
+   constexpr size_t lanes = 8;
+   for (; count >= lanes; count -= lanes, in += 64 * lanes, out += 32 * lanes) {
+      __m256i w[16];
+      for (int t = 0; t < 16; ++t) {
+         uint32_t words[lanes];
+         for (size_t j = 0; j < lanes; ++j) {
+            memcpy(&words[j], in + 64 * j + 4 * t, sizeof(uint32_t));
+            words[j] = __builtin_bswap32(words[j]);
+         }
+         w[t] = _mm256_loadu_si256((const __m256i*)words);
+      }
+
+      __m256i r[8];
+      for (int i = 0; i < 8; ++i)
+         r[i] = _mm256_set1_epi32(initial_state[i]);
+
+      for (int t = 0; t < 64; ++t) {
+         if (t >= 16) {
+            const __m256i w15 = w[(t - 15) & 15];
+            const __m256i w2  = w[(t - 2) & 15];
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr8x(w15, 7), rotr8x(w15, 18)), _mm256_srli_epi32(w15, 3));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr8x(w2, 17), rotr8x(w2, 19)), _mm256_srli_epi32(w2, 10));
+            w[t & 15] = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0), _mm256_add_epi32(w[(t - 7) & 15], s1));
+         }
+         avx2_round(r, _mm256_add_epi32(w[t & 15], _mm256_set1_epi32(k[t])));
+      }
+      __m256i mid[8];
+      for (int i = 0; i < 8; ++i)
+         r[i] = mid[i] = _mm256_add_epi32(r[i], _mm256_set1_epi32(initial_state[i]));
+
+      for (int t = 0; t < 64; ++t)
+         avx2_round(r, _mm256_set1_epi32(padding_kw[t]));
+
+      // all input of this batch has been read, out may alias in
+      alignas(32) uint32_t digest[8][lanes];
+      for (int i = 0; i < 8; ++i)
+         _mm256_store_si256((__m256i*)digest[i], _mm256_add_epi32(r[i], mid[i]));
+      for (size_t j = 0; j < lanes; ++j) {
+         for (int i = 0; i < 8; ++i) {
+            uint32_t word = __builtin_bswap32(digest[i][j]);
+            memcpy(out + 32 * j + 4 * i, &word, sizeof(word));
+         }
+      }
+   }
+   hash_pairs_openssl(in, count, out);
+}
+
+#endif
+
+using hash_pairs_impl = void (*)(const char* in, size_t count, char* out);
+
+hash_pairs_impl select_hash_pairs_impl() {
+#if defined(__x86_64__)
+   unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+   const bool has_sha = __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1u << 29));
+   if (!has_sha && __builtin_cpu_supports("avx2"))
+      return hash_pairs_avx2;
+#endif
+   return hash_pairs_openssl;
+}
+
+} // anonymous namespace
+
+void sha256::hash_pairs( const sha256* in, size_t count, sha256* out ) {
+   static const hash_pairs_impl impl = select_hash_pairs_impl();
+   static_assert( sizeof(sha256) == 32 );
+   impl( (const char*)in, count, (char*)out );
+}
+
+namespace detail {
+
+bool hash_pairs_kernel_supported( hash_pairs_kernel kernel ) {
+   switch (kernel) {
+   case hash_pairs_kernel::scalar:
+      return true;
+   case hash_pairs_kernel::avx2:
+#if defined(__x86_64__)
+      return __builtin_cpu_supports("avx2");
+#else
+      return false;
+#endif
+   }
+   return false;
+}
+
+void hash_pairs( hash_pairs_kernel kernel, const sha256* in, size_t count, sha256* out ) {
+   FC_ASSERT( hash_pairs_kernel_supported(kernel), "sha256 hash_pairs kernel not supported by this cpu" );
+   switch (kernel) {
+   case hash_pairs_kernel::scalar:
+      hash_pairs_openssl( (const char*)in, count, (char*)out );
+      return;
+   case hash_pairs_kernel::avx2:
+#if defined(__x86_64__)
+      hash_pairs_avx2( (const char*)in, count, (char*)out );
+#endif
+      return;
+   }
+}
+
+} // namespace detail
+
+} // namespace fc
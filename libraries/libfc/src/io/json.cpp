@@ -655,6 +655,80 @@ namespace fc
       return ss.str();
    }
 
+   namespace {
+      // just enough of an ostream for to_stream() of a scalar variant, appending to a string
+      struct string_append_stream {
+         std::string& out;
+         size_t       offset; // bytes written before out
+
+         size_t tellp()const { return offset + out.size(); }
+
+         string_append_stream& operator<<( char c )               { out.push_back( c ); return *this; }
+         string_append_stream& operator<<( std::string_view s )   { out.append( s ); return *this; }
+         string_append_stream& operator<<( int64_t i )            { out.append( std::to_string( i ) ); return *this; }
+         string_append_stream& operator<<( uint64_t i )           { out.append( std::to_string( i ) ); return *this; }
+      };
+   }
+
+   json_chunk_writer::json_chunk_writer( const variant& v, const json::output_formatting format )
+   : root( v ), format( format ) {}
+
+   void json_chunk_writer::write_value( const variant& v, std::string& out, const json::yield_function_t& yield ) {
+      string_append_stream os{ out, written };
+      switch( v.get_type() ) {
+         case variant::array_type:
+         case variant::object_type:
+            yield( os.tellp() );
+            out.push_back( v.get_type() == variant::array_type ? '[' : '{' );
+            stack.push_back( frame{ &v, 0 } );
+            return;
+         default:
+            fc::to_stream( os, v, yield, format );
+      }
+   }
+
+   bool json_chunk_writer::write( std::string& out, size_t max_size, const json::yield_function_t& yield ) {
+      const size_t start = out.size();
+      written -= start; // so that written + out.size() is the position in the JSON, wraps around harmlessly
+
+      if( !started ) {
+         started = true;
+         write_value( root, out, yield );
+      }
+      while( !stack.empty() && out.size() - start < max_size ) {
+         frame& f = stack.back();
+         if( f.v->get_type() == variant::array_type ) {
+            const variants& a = f.v->get_array();
+            if( f.index == a.size() ) {
+               out.push_back( ']' );
+               stack.pop_back();
+               continue;
+            }
+            if( f.index > 0 )
+               out.push_back( ',' );
+            write_value( a[f.index++], out, yield ); // may invalidate f
+         } else {
+            const variant_object& o = f.v->get_object();
+            if( f.index == o.size() ) {
+               out.push_back( '}' );
+               stack.pop_back();
+               continue;
+            }
+            if( f.index > 0 )
+               out.push_back( ',' );
+            const auto& e = *( o.begin() + f.index++ );
+            out.push_back( '"' );
+            out.append( escape_string( e.key(), yield ) );
+            out.append( "\":" );
+            write_value( e.value(), out, yield ); // may invalidate f
+         }
+      }
+      if( stack.empty() )
+         yield( written + out.size() );
+      written += out.size();
+      return stack.empty();
+   }
+
    std::string pretty_print( const std::string& v, const uint8_t indent ) {
       int level = 0;
       std::stringstream ss;
@@ -2,6 +2,8 @@
 
 #include <fc/crypto/hex.hpp>
 #include <fc/crypto/sha3.hpp>
+#include <fc/crypto/sha256.hpp>
+#include <fc/io/raw.hpp>
 #include <fc/utility.hpp>
 
 using namespace fc;
@@ -66,4 +68,58 @@ BOOST_AUTO_TEST_CASE(keccak256) try {
 
 } FC_LOG_AND_RETHROW();
 
+BOOST_AUTO_TEST_CASE(sha256_hash_pairs) try {
+
+   // cover the batched kernels as well as the remainder hashed one pair at a time
+   for (size_t count : {0, 1, 2, 7, 8, 9, 16, 17, 100}) {
+      std::vector<sha256> in;
+      for (size_t i = 0; i < 2 * count; ++i)
+         in.push_back(sha256::hash(std::to_string(i)));
+
+      std::vector<sha256> expected;
+      for (size_t i = 0; i < count; ++i)
+         expected.push_back(sha256::hash(std::make_pair(in[2 * i], in[2 * i + 1])));
+
+      std::vector<sha256> out(count);
+      sha256::hash_pairs(in.data(), count, out.data());
+      BOOST_CHECK(out == expected);
+
+      // in place, the way merkle() hashes each level
+      sha256::hash_pairs(in.data(), count, in.data());
+      in.resize(count);
+      BOOST_CHECK(in == expected);
+   }
+
+} FC_LOG_AND_RETHROW();
+
+BOOST_AUTO_TEST_CASE(sha256_hash_pairs_kernels) try {
+
+   // every kernel the cpu supports gives the same digests as the scalar path, whichever one hash_pairs() selected
+   std::vector<sha256> in;
+   for (size_t i = 0; i < 2 * 100; ++i)
+      in.push_back(sha256::hash(std::to_string(i)));
+   in[3]._hash[0] |= 0x80; // a canonical right node, as merkle() hashes them
+
+   for (auto kernel : {detail::hash_pairs_kernel::scalar, detail::hash_pairs_kernel::avx2}) {
+      if (!detail::hash_pairs_kernel_supported(kernel)) {
+         BOOST_TEST_MESSAGE("sha256 hash_pairs kernel " << (int)kernel << " not supported, skipped");
+         continue;
+      }
+      for (size_t count : {0, 1, 7, 8, 9, 16, 17, 100}) {
+         std::vector<sha256> expected(count);
+         detail::hash_pairs(detail::hash_pairs_kernel::scalar, in.data(), count, expected.data());
+
+         std::vector<sha256> out(count);
+         detail::hash_pairs(kernel, in.data(), count, out.data());
+         BOOST_CHECK(out == expected);
+
+         std::vector<sha256> in_place(in.begin(), in.begin() + 2 * count);
+         detail::hash_pairs(kernel, in_place.data(), count, in_place.data());
+         in_place.resize(count);
+         BOOST_CHECK(in_place == expected);
+      }
+   }
+
+} FC_LOG_AND_RETHROW();
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -242,4 +242,51 @@ BOOST_AUTO_TEST_CASE(escape_string_test)
    }
 }
 
+
+BOOST_AUTO_TEST_CASE(json_chunk_writer_test)
+{
+   mutable_variant_object o;
+   o("small", 1)("large", uint64_t(1) << 40)("negative", int64_t(-5000000000))("double", 1.5)("bool", true)("null", variant())
+    ("escaped", json_test_util::escape_input_str)("empty_array", variants{})("empty_object", variant_object{});
+   variants rows;
+   for (uint32_t i = 0; i < 100; ++i)
+      rows.emplace_back(mutable_variant_object()("id", i)("values", variants{variant(i), variant(std::string(i, 'x'))}));
+   o("rows", rows);
+
+   for (const variant& v : {variant(o), variant(5), variant("string"), variant(variants{}), variant(variant_object{})}) {
+      const std::string expected = json::to_string(v, json_test_util::yield_no_limitation);
+      for (size_t chunk_size : {size_t(1), size_t(7), size_t(100), expected.size()}) {
+         json_chunk_writer writer(v);
+         std::string json, chunk;
+         size_t chunks = 0;
+         bool done = false;
+         while (!done) {
+            chunk.clear();
+            done = writer.write(chunk, chunk_size, json_test_util::yield_no_limitation);
+            BOOST_CHECK(!chunk.empty());
+            json += chunk;
+            ++chunks;
+         }
+         BOOST_CHECK(writer.done());
+         BOOST_CHECK_EQUAL(json, expected);
+         if (chunk_size == 1 && expected.size() > 100)
+            BOOST_CHECK_GT(chunks, 100u);
+      }
+   }
+
+   // yield sees the position in the complete JSON, not in the chunk
+   {
+      variant v(variants(100, variant("abcdefghij")));
+      json_chunk_writer writer(v);
+      std::string chunk;
+      BOOST_CHECK(!writer.write(chunk, 100, json_test_util::yield_length_exception));
+      chunk.clear();
+      BOOST_CHECK(!writer.write(chunk, 100, json_test_util::yield_length_exception));
+      chunk.clear();
+      BOOST_CHECK_EXCEPTION(writer.write(chunk, 100, json_test_util::yield_length_exception),
+                            fc::assert_exception,
+                            json_test_util::length_limit_except_verf_func);
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -28,7 +28,29 @@ bytes zlib_decompress(std::string_view data) {
    return out;
 }
 
+std::optional<compression_type> compression_type_from_string(std::string_view s) {
+   if (s == "zlib")
+      return compression_type::zlib;
+   if (s == "zstd")
+      return compression_type::zstd;
+   return {};
+}
+
+const char* to_string(compression_type type) {
+   switch (type) {
+      case compression_type::zlib: return "zlib";
+      case compression_type::zstd: return "zstd";
+   }
+   return "unknown";
+}
 
+bool is_valid_compression_level(compression_type type, int level) {
+   switch (type) {
+      case compression_type::zlib: return level >= bio::zlib::no_compression && level <= bio::zlib::best_compression;
+      case compression_type::zstd: return level >= 1 && level <= 22;
+   }
+   return false;
+}
 
 } // namespace state_history
 } // namespace eosio
@@ -1,6 +1,10 @@
 #include <eosio/state_history/create_deltas.hpp>
 #include <eosio/state_history/serialization.hpp>
 
+#include <optional>
+#include <tuple>
+#include <vector>
+
 namespace eosio {
 namespace state_history {
 
@@ -57,6 +61,48 @@ bool include_delta(const chain::protocol_state_object& old, const chain::protoco
    return old.activated_protocol_features != curr.activated_protocol_features;
 }
 
+// Rows of an index changed by the last undo session. Collected once per block so include_delta() and the lookup of
+// the current row run once per changed row, instead of once for counting tables, once for counting rows and once
+// for packing. Untouched indexes cost only the emptiness check of their undo session.
+template <typename Index>
+struct changed_rows {
+   using row_type = typename Index::value_type;
+
+   std::vector<const row_type*> modified; // current value of modified rows
+   std::vector<const row_type*> removed;
+   std::vector<const row_type*> created;
+
+   explicit changed_rows(const Index& index) {
+      auto undo = index.last_undo_session();
+      for (auto& old : undo.old_values) {
+         auto& row = index.get(old.id);
+         if (include_delta(old, row))
+            modified.push_back(&row);
+      }
+      for (auto& old : undo.removed_values)
+         removed.push_back(&old);
+      for (auto& row : undo.new_values)
+         created.push_back(&row);
+   }
+
+   size_t size() const { return modified.size() + removed.size() + created.size(); }
+   bool   empty() const { return size() == 0; }
+};
+
+template <typename... MultiIndex>
+auto get_changed_rows(const chainbase::database& db, std::tuple<MultiIndex*...>) {
+   return std::make_tuple(changed_rows<std::decay_t<decltype(db.get_index<MultiIndex>())>>(db.get_index<MultiIndex>())...);
+}
+
+using delta_tables = std::tuple<chain::account_index*, chain::account_metadata_index*, chain::code_index*,
+                                chain::table_id_multi_index*, chain::key_value_index*, chain::index64_index*, chain::index128_index*,
+                                chain::index256_index*, chain::index_double_index*, chain::index_long_double_index*,
+                                chain::global_property_multi_index*, chain::generated_transaction_multi_index*,
+                                chain::protocol_state_multi_index*, chain::permission_index*, chain::permission_link_index*,
+                                chain::resource_limits::resource_limits_index*, chain::resource_limits::resource_usage_index*,
+                                chain::resource_limits::resource_limits_state_index*,
+                                chain::resource_limits::resource_limits_config_index*>;
+
 void pack_deltas(boost::iostreams::filtering_ostreambuf& obuf, const chainbase::database& db, bool full_snapshot) {
 
    fc::datastream<boost::iostreams::filtering_ostreambuf&> ds{obuf};
@@ -80,6 +126,12 @@ void pack_deltas(boost::iostreams::filtering_ostreambuf& obuf, const chainbase::
       fc::raw::pack(ds, make_history_context_wrapper(db, get_table_id(row.t_id._id), row));
    };
 
+   // only used for incremental deltas; full snapshots pack every row
+   using changes_t = decltype(get_changed_rows(db, delta_tables()));
+   std::optional<changes_t> changes;
+   if (!full_snapshot)
+      changes.emplace(get_changed_rows(db, delta_tables()));
+
    auto process_table = [&](auto& ds, auto* name, auto& index, auto& pack_row) {
 
       auto pack_row_v0 = [&](auto& ds, bool present, auto& row) {
@@ -101,33 +153,24 @@ void pack_deltas(boost::iostreams::filtering_ostreambuf& obuf, const chainbase::
             pack_row_v0(ds, true, row);
          }
       } else {
-         auto undo = index.last_undo_session();
-
-         size_t num_entries =
-             std::count_if(undo.old_values.begin(), undo.old_values.end(),
-                           [&index](const auto& old) { return include_delta(old, index.get(old.id)); }) +
-             std::distance(undo.removed_values.begin(), undo.removed_values.end()) +
-             std::distance(undo.new_values.begin(), undo.new_values.end());
-
-         if (num_entries) {
-            fc::raw::pack(ds, fc::unsigned_int(0)); // table_delta = std::variant<table_delta_v0> and fc::unsigned_int struct_version
-            fc::raw::pack(ds, name);
-            fc::raw::pack(ds, fc::unsigned_int((uint32_t)num_entries));
-
-            for (auto& old : undo.old_values) {
-               auto& row = index.get(old.id);
-               if (include_delta(old, row)) {
-                  pack_row_v0(ds, true, row);
-               }
-            }
-
-            for (auto& old : undo.removed_values) {
-               pack_row_v0(ds, false, old);
-            }
-
-            for (auto& row : undo.new_values) {
-               pack_row_v0(ds, true, row);
-            }
+         const auto& rows = std::get<changed_rows<std::decay_t<decltype(index)>>>(*changes);
+         if (rows.empty())
+            return;
+
+         fc::raw::pack(ds, fc::unsigned_int(0)); // table_delta = std::variant<table_delta_v0> and fc::unsigned_int struct_version
+         fc::raw::pack(ds, name);
+         fc::raw::pack(ds, fc::unsigned_int((uint32_t)rows.size()));
+
+         for (auto* row : rows.modified) {
+            pack_row_v0(ds, true, *row);
+         }
+
+         for (auto* row : rows.removed) {
+            pack_row_v0(ds, false, *row);
+         }
+
+         for (auto* row : rows.created) {
+            pack_row_v0(ds, true, *row);
          }
       }
    };
@@ -137,23 +180,13 @@ void pack_deltas(boost::iostreams::filtering_ostreambuf& obuf, const chainbase::
       if (full_snapshot) {
          return !index.indices().empty();
       } else {
-         auto undo = index.last_undo_session();
-         return std::find_if(undo.old_values.begin(), undo.old_values.end(),
-                           [&index](const auto& old) { return include_delta(old, index.get(old.id)); }) != undo.old_values.end() ||
-             !undo.removed_values.empty() || !undo.new_values.empty();
+         return !std::get<changed_rows<std::decay_t<decltype(index)>>>(*changes).empty();
       }
    };
 
    int num_tables = std::apply(
        [&has_table](auto... args) { return (has_table(args) + ... ); },
-       std::tuple<chain::account_index*, chain::account_metadata_index*, chain::code_index*,
-                  chain::table_id_multi_index*, chain::key_value_index*, chain::index64_index*, chain::index128_index*,
-                  chain::index256_index*, chain::index_double_index*, chain::index_long_double_index*,
-                  chain::global_property_multi_index*, chain::generated_transaction_multi_index*,
-                  chain::protocol_state_multi_index*, chain::permission_index*, chain::permission_link_index*,
-                  chain::resource_limits::resource_limits_index*, chain::resource_limits::resource_usage_index*,
-                  chain::resource_limits::resource_limits_state_index*,
-                  chain::resource_limits::resource_limits_config_index*>());
+       delta_tables());
 
    fc::raw::pack(ds, fc::unsigned_int(num_tables));
 
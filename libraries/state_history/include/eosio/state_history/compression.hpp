@@ -2,6 +2,12 @@
 
 #include <eosio/chain/types.hpp>
 
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filter/zstd.hpp>
+
+#include <optional>
+#include <string_view>
+
 namespace eosio {
 namespace state_history {
 
@@ -10,5 +16,49 @@ using chain::bytes;
 bytes zlib_compress_bytes(const bytes& in);
 bytes zlib_decompress(std::string_view);
 
+/// Compression of state history log entries. The value is stored as the leading uint32_t of each entry payload, so
+/// entries of different types can be mixed in one log and are always read back with the right decompressor.
+enum class compression_type : uint32_t {
+   zlib = 1,
+   zstd = 2
+};
+
+struct compression_config {
+   compression_type   type = compression_type::zlib;
+   std::optional<int> level; ///< unset uses the default level of type
+};
+
+std::optional<compression_type> compression_type_from_string(std::string_view);
+const char* to_string(compression_type);
+
+/// zlib supports levels 0 - 9, zstd 1 - 22
+bool is_valid_compression_level(compression_type, int level);
+
+template <typename FilteringBuf>
+void push_compressor(FilteringBuf& buf, const compression_config& config) {
+   namespace bio = boost::iostreams;
+   switch (config.type) {
+      case compression_type::zstd:
+         buf.push(bio::zstd_compressor(bio::zstd_params(config.level.value_or(bio::zstd::default_compression))));
+         break;
+      case compression_type::zlib:
+         buf.push(bio::zlib_compressor(bio::zlib_params(config.level.value_or(bio::zlib::default_compression))));
+         break;
+   }
+}
+
+template <typename FilteringBuf>
+void push_decompressor(FilteringBuf& buf, compression_type type) {
+   namespace bio = boost::iostreams;
+   switch (type) {
+      case compression_type::zstd:
+         buf.push(bio::zstd_decompressor());
+         break;
+      case compression_type::zlib:
+         buf.push(bio::zlib_decompressor());
+         break;
+   }
+}
+
 } // namespace state_history
 } // namespace eosio
@@ -16,7 +16,6 @@
 #include <boost/asio.hpp>
 #include <boost/iostreams/device/file.hpp>
 #include <boost/iostreams/device/file_descriptor.hpp>
-#include <boost/iostreams/filter/zlib.hpp>
 #include <boost/iostreams/filtering_streambuf.hpp>
 #include <boost/iostreams/restrict.hpp>
 
@@ -44,6 +43,13 @@ namespace bio = boost::iostreams;
  *    state_history_log_header
  *    payload
  *
+ * payload:
+ *    uint32_t compression_type (1 = zlib, 2 = zstd)
+ *    uint64_t decompressed size
+ *    compressed data
+ * Entries written before the compression type was recorded start with a uint32_t length prefix followed by zlib
+ * compressed data; they are still readable.
+ *
  * When block pruning is enabled, a slight modification to the format is as followed:
  * For first entry in log, a unique version is used to indicate the log is a "pruned log": this prevents
  *  older versions from trying to read something with holes in it
@@ -95,28 +101,25 @@ namespace state_history {
 
 using state_history_log_config = std::variant<std::monostate, state_history::prune_config, state_history::partition_config>;
 
-struct locked_decompress_stream {
-   std::unique_lock<std::mutex> lock; // state_history_log mutex
+/// A read-only cursor over a single decompressed log entry. The cursor owns its own file handle (or, for the legacy
+/// entry format, a decompressed copy of the entry), so after state_history_log::get_unpacked_entry() returns it no
+/// longer references the log or its mutex. Any number of cursors may be consumed concurrently, e.g. one per SHiP
+/// session, while the main thread keeps appending to the log.
+struct decompress_stream {
    std::variant<std::vector<char>, std::unique_ptr<bio::filtering_istreambuf>> buf;
 
-   locked_decompress_stream() = delete;
-   locked_decompress_stream(locked_decompress_stream&&) = default;
-
-   explicit locked_decompress_stream(std::unique_lock<std::mutex> l)
-   : lock(std::move(l)) {};
-
    template <typename StateHistoryLog>
-   void init(StateHistoryLog&& log, fc::cfile& stream, uint64_t compressed_size) {
+   void init(StateHistoryLog&& log, fc::cfile& stream, uint64_t compressed_size, state_history::compression_type type) {
       auto istream = std::make_unique<bio::filtering_istreambuf>();
-      istream->push(bio::zlib_decompressor());
+      state_history::push_decompressor(*istream, type);
       istream->push(bio::restrict(bio::file_source(stream.get_file_path().string()), stream.tellp(), compressed_size));
       buf = std::move(istream);
    }
 
    template <typename LogData>
-   void init(LogData&& log, fc::datastream<const char*>& stream, uint64_t compressed_size) {
+   void init(LogData&& log, fc::datastream<const char*>& stream, uint64_t compressed_size, state_history::compression_type type) {
       auto istream = std::make_unique<bio::filtering_istreambuf>();
-      istream->push(bio::zlib_decompressor());
+      state_history::push_decompressor(*istream, type);
       istream->push(bio::restrict(bio::file_source(log.filename), stream.pos() - log.data(), compressed_size));
       buf = std::move(istream);
    }
@@ -146,16 +149,18 @@ inline std::vector<char> zlib_decompress(fc::datastream<const char*>& strm, uint
 }
 
 template <typename Log, typename Stream>
-uint64_t read_unpacked_entry(Log&& log, Stream& stream, uint64_t payload_size, locked_decompress_stream& result) {
-   // result has state_history_log mutex locked
+uint64_t read_unpacked_entry(Log&& log, Stream& stream, uint64_t payload_size, decompress_stream& result) {
+   // caller holds the state_history_log mutex, result is independent of it once initialized
 
    uint32_t s;
    stream.read((char*)&s, sizeof(s));
-   if (s == 1 && payload_size > (s + sizeof(uint32_t))) {
+   const auto type = static_cast<state_history::compression_type>(s);
+   if ((type == state_history::compression_type::zlib || type == state_history::compression_type::zstd) &&
+       payload_size >= sizeof(uint32_t) + sizeof(uint64_t)) {
       uint64_t compressed_size = payload_size - sizeof(uint32_t) - sizeof(uint64_t);
       uint64_t decompressed_size;
       stream.read((char*)&decompressed_size, sizeof(decompressed_size));
-      result.init(log, stream, compressed_size);
+      result.init(log, stream, compressed_size, type);
       return decompressed_size;
    } else {
       // Compressed deltas now exceeds 4GB on one of the public chains. This length prefix
@@ -195,7 +200,7 @@ class state_history_log_data : public chain::log_data_base<state_history_log_dat
 
    bool is_currently_pruned() const { return is_currently_pruned_; }
 
-   uint64_t ro_stream_at(uint64_t pos, locked_decompress_stream& result) {
+   uint64_t ro_stream_at(uint64_t pos, decompress_stream& result) {
       uint64_t                    payload_size = payload_size_at(pos);
       file.seek(pos + sizeof(state_history_log_header));
       // fc::datastream<const char*> stream(file.const_data() + pos + sizeof(state_history_log_header), payload_size);
@@ -284,6 +289,7 @@ class state_history_log {
  private:
    const char* const       name = "";
    state_history_log_config _config;
+   state_history::compression_config _compression;
 
    // provide exclusive access to all data of this object since accessed from the main thread and the ship thread
    mutable std::mutex      _mx;
@@ -303,9 +309,14 @@ class state_history_log {
    state_history_log( const state_history_log&) = delete;
 
    state_history_log(const char* name, const std::filesystem::path& log_dir,
-                     state_history_log_config conf = {})
+                     state_history_log_config conf = {}, state_history::compression_config compression = {})
        : name(name)
-       , _config(std::move(conf)) {
+       , _config(std::move(conf))
+       , _compression(compression) {
+
+      EOS_ASSERT(!_compression.level || state_history::is_valid_compression_level(_compression.type, *_compression.level),
+                 chain::plugin_exception, "invalid ${type} compression level ${level} for ${name}.log",
+                 ("type", state_history::to_string(_compression.type))("level", *_compression.level)("name", name));
 
       log.set_file_path(log_dir/(std::string(name) + ".log"));
       index.set_file_path(log_dir/(std::string(name) + ".index"));
@@ -376,6 +387,11 @@ class state_history_log {
       return _config;
    }
 
+   /// compression used for new entries, existing entries keep the compression they were written with
+   const state_history::compression_config& compression() const {
+      return _compression;
+   }
+
    //        begin     end
    std::pair<uint32_t, uint32_t> block_range() const {
       std::lock_guard g(_mx);
@@ -387,14 +403,12 @@ class state_history_log {
       return r.first == r.second;
    }
 
-   locked_decompress_stream create_locked_decompress_stream() {
-      return locked_decompress_stream{ std::unique_lock<std::mutex>( _mx ) };
-   }
-
-   /// @return the decompressed entry size
-   uint64_t get_unpacked_entry(uint32_t block_num, locked_decompress_stream& result) {
-
-      // result has mx locked
+   /// Position a read-only cursor at the entry for block_num. The log mutex is only held while the entry is located,
+   /// the returned cursor can then be consumed without blocking writers or other readers.
+   /// thread-safe
+   /// @return the decompressed entry size, 0 if block_num is not in the log
+   uint64_t get_unpacked_entry(uint32_t block_num, decompress_stream& result) {
+      std::lock_guard g(_mx);
 
       auto opt_decompressed_size = catalog.ro_stream_for_block(block_num, result);
       if (opt_decompressed_size)
@@ -418,12 +432,13 @@ class state_history_log {
 
          // In order to conserve memory usage for reading the chain state later, we need to
          // encode the uncompressed data size to the disk so that the reader can send the
-         // decompressed data size before decompressing data. Here we use the number
-         // 1 indicates the format contains a 64 bits unsigned integer for decompressed data
-         // size and then the actually compressed data. The compressed data size can be
-         // computed from the payload size in the header minus sizeof(uint32_t) + sizeof(uint64_t).
+         // decompressed data size before decompressing data. The leading number is the
+         // compression_type, 1 (zlib) or 2 (zstd); it indicates the format contains a 64 bits
+         // unsigned integer for decompressed data size and then the actually compressed data.
+         // The compressed data size can be computed from the payload size in the header minus
+         // sizeof(uint32_t) + sizeof(uint64_t).
 
-         uint32_t s = 1;
+         uint32_t s = static_cast<uint32_t>(_compression.type);
          stream.write((char*)&s, sizeof(s));
          uint64_t uncompressioned_size = 0;
          stream.skip(sizeof(uncompressioned_size));
@@ -434,7 +449,7 @@ class state_history_log {
          {
             bio::filtering_ostreambuf buf;
             buf.push(boost::ref(cnt));
-            buf.push(bio::zlib_compressor());
+            state_history::push_compressor(buf, _compression);
             buf.push(bio::file_descriptor_sink(stream.fileno(), bio::never_close_handle));
             pack_to(buf);
          }
@@ -0,0 +1,168 @@
+#include <eosio/chain_plugin/abi_cache.hpp>
+
+#include <eosio/chain/abi_plan.hpp>
+#include <eosio/chain/account_object.hpp>
+#include <eosio/chain/controller.hpp>
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+using namespace eosio;
+using namespace eosio::chain;
+
+namespace {
+
+struct cached_abi {
+   uint64_t           abi_sequence = 0;
+   std::string        abi;        // raw ABI the serializer was created from, used to validate the entry
+   abi_serializer_ptr serializer; // nullptr if the account has no ABI
+   abi_plan_ptr       plan;       // compiled from serializer
+   size_t             memory_size = 0;
+
+   void set_memory_size() {
+      memory_size = sizeof(*this) + abi.capacity() + (serializer ? serializer->memory_size() : 0)
+                    + (plan ? plan->memory_size() : 0);
+   }
+};
+using cached_abi_ptr = std::shared_ptr<const cached_abi>;
+
+struct cache_shard {
+   using lru_t = std::list<std::pair<account_name, cached_abi_ptr>>; // front is most recently used
+
+   std::mutex                                      mtx;
+   lru_t                                           lru;
+   std::unordered_map<account_name, lru_t::iterator> index;
+   size_t                                          bytes = 0;
+};
+
+} // anonymous namespace
+
+namespace eosio::chain_apis {
+
+struct abi_cache_impl {
+   static constexpr size_t num_shards = 16;
+
+   explicit abi_cache_impl( size_t max_bytes )
+   : max_shard_bytes( max_bytes / num_shards )
+   {}
+
+   cache_shard& shard_for( const account_name& account ) {
+      // names have little entropy in their low bits, mix before picking a shard
+      uint64_t v = account.to_uint64_t();
+      v ^= v >> 33;
+      v *= 0xff51afd7ed558ccdULL;
+      v ^= v >> 33;
+      return shards[v % num_shards];
+   }
+
+   cached_abi_ptr find( const account_name& account ) {
+      auto& s = shard_for( account );
+      std::lock_guard g( s.mtx );
+      auto itr = s.index.find( account );
+      if( itr == s.index.end() )
+         return {};
+      s.lru.splice( s.lru.begin(), s.lru, itr->second );
+      return itr->second->second;
+   }
+
+   void insert( const account_name& account, cached_abi_ptr entry ) {
+      const size_t entry_bytes = entry->memory_size;
+      if( entry_bytes > max_shard_bytes )
+         return;
+
+      auto& s = shard_for( account );
+      std::lock_guard g( s.mtx );
+      if( auto itr = s.index.find( account ); itr != s.index.end() ) {
+         s.bytes -= itr->second->second->memory_size;
+         s.lru.erase( itr->second );
+         s.index.erase( itr );
+      }
+      s.lru.emplace_front( account, std::move( entry ) );
+      s.index.emplace( account, s.lru.begin() );
+      s.bytes += entry_bytes;
+
+      while( s.bytes > max_shard_bytes ) {
+         auto& [evict_account, evict_entry] = s.lru.back();
+         s.bytes -= evict_entry->memory_size;
+         s.index.erase( evict_account );
+         s.lru.pop_back();
+         ++evictions;
+      }
+   }
+
+   cached_abi_ptr get( const controller& control, const account_name& account, const fc::microseconds& abi_serializer_max_time ) {
+      const auto& d = control.db();
+      const auto* accnt = d.find<account_object, by_name>( account );
+      if( accnt == nullptr )
+         return {};
+      const auto* meta = d.find<account_metadata_object, by_name>( account );
+      const uint64_t abi_sequence = meta ? meta->abi_sequence : 0;
+      const std::string_view abi_bytes( accnt->abi.data(), accnt->abi.size() );
+
+      if( auto entry = find( account ); entry && entry->abi_sequence == abi_sequence && entry->abi == abi_bytes ) {
+         ++hits;
+         return entry;
+      }
+      ++misses;
+
+      auto entry = std::make_shared<cached_abi>();
+      entry->abi_sequence = abi_sequence;
+      entry->abi = abi_bytes;
+      if( abi_def abi; abi_serializer::to_abi( accnt->abi, abi ) ) {
+         entry->serializer = std::make_shared<const abi_serializer>( std::move( abi ), abi_serializer::create_yield_function( abi_serializer_max_time ) );
+         entry->plan = std::make_shared<const abi_plan>( entry->serializer );
+      }
+      entry->set_memory_size();
+      insert( account, entry );
+      return entry;
+   }
+
+   const size_t                         max_shard_bytes;
+   std::array<cache_shard, num_shards>  shards;
+   std::atomic<uint64_t>                hits      = 0;
+   std::atomic<uint64_t>                misses    = 0;
+   std::atomic<uint64_t>                evictions = 0;
+};
+
+abi_cache::abi_cache( size_t max_bytes )
+: _impl( std::make_unique<abi_cache_impl>( max_bytes ) )
+{}
+
+abi_cache::~abi_cache() = default;
+
+abi_serializer_ptr abi_cache::get( const controller& control, const account_name& account,
+                                   const fc::microseconds& abi_serializer_max_time ) {
+   auto entry = _impl->get( control, account, abi_serializer_max_time );
+   return entry ? entry->serializer : abi_serializer_ptr{};
+}
+
+abi_plan_ptr abi_cache::get_plan( const controller& control, const account_name& account,
+                                  const fc::microseconds& abi_serializer_max_time ) {
+   auto entry = _impl->get( control, account, abi_serializer_max_time );
+   return entry ? entry->plan : abi_plan_ptr{};
+}
+
+abi_cache::stats abi_cache::get_stats() const {
+   stats result{ .hits = _impl->hits, .misses = _impl->misses, .evictions = _impl->evictions };
+   for( auto& s : _impl->shards ) {
+      std::lock_guard g( s.mtx );
+      result.entries += s.index.size();
+      result.bytes += s.bytes;
+   }
+   return result;
+}
+
+void abi_cache::clear() {
+   for( auto& s : _impl->shards ) {
+      std::lock_guard g( s.mtx );
+      s.index.clear();
+      s.lru.clear();
+      s.bytes = 0;
+   }
+}
+
+} // namespace eosio::chain_apis
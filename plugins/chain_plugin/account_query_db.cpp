@@ -4,6 +4,9 @@
 #include <eosio/chain/controller.hpp>
 #include <eosio/chain/permission_object.hpp>
 
+#include <fc/io/cfile.hpp>
+#include <fc/io/raw.hpp>
+
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/composite_key.hpp>
@@ -13,7 +16,9 @@
 #include <boost/bimap/multiset_of.hpp>
 #include <boost/bimap/set_of.hpp>
 
+#include <atomic>
 #include <shared_mutex>
+#include <thread>
 
 using namespace eosio;
 using namespace eosio::chain::literals;
@@ -33,6 +38,7 @@ namespace {
 
       // un-indexed data
       uint32_t       threshold;
+      fc::time_point last_updated; ///< `last_updated` of the permission_object, used to validate persisted entries
 
       using cref = std::reference_wrapper<const permission_info>;
    };
@@ -129,22 +135,49 @@ namespace eosio::chain_apis {
     * Implementation details of the account query DB
     */
    struct account_query_db_impl {
-      account_query_db_impl(const chain::controller& controller)
+      static constexpr uint32_t magic_number = 0x30510ACD;
+      static constexpr uint32_t min_supported_version = 2;
+      static constexpr uint32_t max_supported_version = 2;
+
+      account_query_db_impl(const chain::controller& controller, const std::filesystem::path& persist_file, uint32_t persist_interval)
       :controller(controller)
+      ,persist_file(persist_file)
+      ,persist_interval(persist_interval)
       {}
 
+      ~account_query_db_impl() {
+         if (persist_thread.joinable())
+            persist_thread.join();
+      }
+
       /**
-       * Build the initial database from the chain controller by extracting the information contained in the
-       * blockchain state at the current HEAD
+       * Build the database from the chain controller, reusing the entries of the persistence file that are still
+       * current.
        */
-      void build_account_query_map() {
+      void open() {
          std::unique_lock write_lock(rw_mutex);
 
-         ilog("Building account query DB");
-         auto start = fc::time_point::now();
-         const auto& index = controller.db().get_index<chain::permission_index>().indices().get<by_id>();
+         build_time_map();
+
+         bool loaded = false;
+         if (!persist_file.empty() && std::filesystem::exists(persist_file)) {
+            try {
+               loaded = load_account_query_map();
+            } FC_LOG_AND_DROP(("Unable to load account query DB")(persist_file));
+         }
 
-         // build a initial time to block number map
+         if (!loaded) {
+            name_bimap.clear();
+            key_bimap.clear();
+            permission_info_index.clear();
+            build_account_query_map();
+         }
+      }
+
+      /**
+       * Build a initial time to block number map of the reversible blocks
+       */
+      void build_time_map() {
          const auto lib_num = controller.last_irreversible_block_num();
          const auto head_num = controller.head_block_num();
 
@@ -153,16 +186,247 @@ namespace eosio::chain_apis {
             EOS_ASSERT(block_p, chain::plugin_exception, "cannot fetch reversible block ${block_num}, required for account_db initialization", ("block_num", block_num));
             time_to_block_num.emplace(block_p->timestamp.to_time_point(), block_num);
          }
+      }
+
+      /**
+       * Add a permission from the chain state to the database
+       */
+      void add_permission( const chain::permission_object& po ) {
+         uint32_t last_updated_height = last_updated_time_to_height(po.last_updated);
+         const auto& pi = permission_info_index.emplace( permission_info{ po.owner, po.name, last_updated_height, po.auth.threshold, po.last_updated } ).first;
+         add_to_bimaps(*pi, po);
+      }
+
+      /**
+       * Build the initial database from the chain controller by extracting the information contained in the
+       * blockchain state at the current HEAD
+       */
+      void build_account_query_map() {
+         ilog("Building account query DB");
+         auto start = fc::time_point::now();
+         const auto& index = controller.db().get_index<chain::permission_index>().indices().get<by_id>();
 
          for (const auto& po : index ) {
-            uint32_t last_updated_height = last_updated_time_to_height(po.last_updated);
-            const auto& pi = permission_info_index.emplace( permission_info{ po.owner, po.name, last_updated_height, po.auth.threshold } ).first;
-            add_to_bimaps(*pi, po);
+            add_permission(po);
          }
          auto duration = fc::time_point::now() - start;
          ilog("Finished building account query DB in ${sec}", ("sec", (duration.count() / 1'000'000.0 )));
       }
 
+      /**
+       * Add an entry of the persistence file to the database
+       */
+      void add_file_entry( const permission_info& pi,
+                           const std::vector<std::pair<chain::permission_level, chain::weight_type>>& accounts,
+                           const std::vector<std::pair<chain::public_key_type, chain::weight_type>>& keys ) {
+         const permission_info& ref = *permission_info_index.emplace(pi).first;
+         for (const auto& [permission, weight] : accounts) {
+            name_bimap.insert(name_bimap_t::value_type {{permission, weight}, ref});
+         }
+         for (const auto& [key, weight] : keys) {
+            key_bimap.insert(key_bimap_t::value_type {{key, weight}, ref});
+         }
+      }
+
+      /**
+       * Build the initial database from the persistence file.
+       *
+       * When the file was written at the current HEAD, as on a clean shutdown or right after a checkpoint, it is
+       * loaded as is without reading the chain state.
+       *
+       * Otherwise it may have been written at any block, including one past HEAD or on a fork that was since dropped
+       * (e.g. a checkpoint written before a crash and a replay). An entry of the file is then used only if it was last
+       * updated in a block that was irreversible when the file was written and the permission of the chain state was
+       * last updated at the same time, it then reflects the same update. Every other permission is built from the
+       * chain state. Both are ordered by {owner,name} so they are merged in a single pass.
+       *
+       * Either way every entry of the file is read and indexed, so loading is still proportional to the number of
+       * permissions, see `benchmark -f account_query_db`.
+       *
+       * @return false if the file was written for a different chain
+       */
+      bool load_account_query_map() {
+         ilog("Loading account query DB from ${f}", ("f", persist_file));
+         auto start = fc::time_point::now();
+
+         fc::datastream<fc::cfile> file;
+         file.set_file_path(persist_file);
+         file.open("rb");
+
+         uint32_t totem = 0;
+         fc::raw::unpack(file, totem);
+         EOS_ASSERT(totem == magic_number, chain::plugin_exception,
+                    "Account query DB file '${filename}' has unexpected magic number: ${actual_totem}. Expected ${expected_totem}",
+                    ("filename", persist_file)("actual_totem", totem)("expected_totem", magic_number));
+
+         uint32_t version = 0;
+         fc::raw::unpack(file, version);
+         EOS_ASSERT(version >= min_supported_version && version <= max_supported_version, chain::plugin_exception,
+                    "Unsupported version of account query DB file '${filename}'. "
+                    "Account query DB version is ${version} while code supports version(s) [${min},${max}]",
+                    ("filename", persist_file)("version", version)("min", min_supported_version)("max", max_supported_version));
+
+         chain::chain_id_type chain_id = chain::chain_id_type::empty_chain_id();
+         chain::block_id_type head_id;
+         fc::time_point lib_time;
+         fc::raw::unpack(file, chain_id);
+         fc::raw::unpack(file, head_id);
+         fc::raw::unpack(file, lib_time);
+         if (chain_id != controller.get_chain_id()) {
+            ilog("Account query DB file was written for chain ${id}", ("id", chain_id));
+            return false;
+         }
+
+         fc::unsigned_int count;
+         fc::raw::unpack(file, count);
+
+         // the next entry of the file not added yet
+         permission_info file_pi;
+         std::vector<std::pair<chain::permission_level, chain::weight_type>> accounts;
+         std::vector<std::pair<chain::public_key_type, chain::weight_type>> keys;
+         uint32_t remaining = count.value;
+         auto read_next = [&]() {
+            if (remaining == 0)
+               return false;
+            --remaining;
+            fc::raw::unpack(file, file_pi.owner);
+            fc::raw::unpack(file, file_pi.name);
+            fc::raw::unpack(file, file_pi.last_updated);
+            fc::raw::unpack(file, file_pi.threshold);
+            fc::raw::unpack(file, accounts);
+            fc::raw::unpack(file, keys);
+            return true;
+         };
+
+         if (head_id == controller.head_block_id()) {
+            while (read_next()) {
+               file_pi.last_updated_height = last_updated_time_to_height(file_pi.last_updated);
+               add_file_entry(file_pi, accounts, keys);
+            }
+
+            auto duration = fc::time_point::now() - start;
+            ilog("Finished loading account query DB at head ${id} in ${sec}",
+                 ("id", head_id)("sec", (duration.count() / 1'000'000.0 )));
+            return true;
+         }
+
+         ilog("Account query DB file was written at block ${id}, head is ${head}, merging it with the chain state",
+              ("id", head_id)("head", controller.head_block_id()));
+         size_t reused = 0;
+         bool has_next = read_next();
+         const auto& index = controller.db().get_index<chain::permission_index>().indices().get<chain::by_owner>();
+         for (const auto& po : index) {
+            const auto po_key = std::make_tuple(po.owner, po.name);
+            while (has_next && std::make_tuple(file_pi.owner, file_pi.name) < po_key)
+               has_next = read_next(); // permission deleted since the file was written
+
+            if (has_next && std::make_tuple(file_pi.owner, file_pi.name) == po_key &&
+                file_pi.last_updated == po.last_updated && po.last_updated <= lib_time) {
+               file_pi.last_updated_height = last_updated_time_to_height(po.last_updated);
+               add_file_entry(file_pi, accounts, keys);
+               ++reused;
+            } else {
+               add_permission(po);
+            }
+         }
+
+         auto duration = fc::time_point::now() - start;
+         ilog("Finished loading account query DB in ${sec}, ${reused} of ${total} permissions from the file",
+              ("sec", (duration.count() / 1'000'000.0 ))("reused", reused)("total", permission_info_index.size()));
+         return true;
+      }
+
+      /**
+       * Serialize the database along with the chain, HEAD and the time of the last irreversible block. Called on the
+       * main thread, the only one modifying the database, so the result is the database at HEAD.
+       */
+      std::vector<char> pack_persist_data() const {
+         std::shared_lock read_lock(rw_mutex);
+
+         fc::datastream<std::vector<char>> ds;
+         fc::raw::pack(ds, magic_number);
+         fc::raw::pack(ds, max_supported_version); // write out current version which is always max_supported_version
+         fc::raw::pack(ds, controller.get_chain_id());
+         fc::raw::pack(ds, controller.head_block_id());
+         fc::raw::pack(ds, controller.last_irreversible_block_time());
+         fc::raw::pack(ds, fc::unsigned_int(permission_info_index.size()));
+
+         std::vector<std::pair<chain::permission_level, chain::weight_type>> accounts;
+         std::vector<std::pair<chain::public_key_type, chain::weight_type>> keys;
+         for (const auto& pi : permission_info_index) {
+            fc::raw::pack(ds, pi.owner);
+            fc::raw::pack(ds, pi.name);
+            fc::raw::pack(ds, pi.last_updated);
+            fc::raw::pack(ds, pi.threshold);
+
+            accounts.clear();
+            keys.clear();
+            const auto name_range = name_bimap.right.equal_range(pi);
+            for (auto itr = name_range.first; itr != name_range.second; ++itr) {
+               accounts.emplace_back(itr->second.value, itr->second.weight);
+            }
+            const auto key_range = key_bimap.right.equal_range(pi);
+            for (auto itr = key_range.first; itr != key_range.second; ++itr) {
+               keys.emplace_back(itr->second.value, itr->second.weight);
+            }
+            fc::raw::pack(ds, accounts);
+            fc::raw::pack(ds, keys);
+         }
+         return std::move(ds.storage());
+      }
+
+      /**
+       * Write serialized data to the persistence file. It is written to a temporary file first so an interrupted
+       * write never leaves a truncated file behind.
+       */
+      void write_persist_file(const std::vector<char>& data) const {
+         auto tmp_file = persist_file;
+         tmp_file += ".tmp";
+
+         fc::cfile file;
+         file.set_file_path(tmp_file);
+         file.open(fc::cfile::truncate_rw_mode);
+         file.write(data.data(), data.size());
+         file.flush();
+         file.close();
+         std::filesystem::rename(tmp_file, persist_file);
+      }
+
+      /**
+       * Serialize the database in memory and write it to the persistence file on a separate thread, unless the
+       * previous write is still in progress. The write does not hold any lock, block application never waits on it.
+       */
+      void checkpoint() {
+         if (persist_file.empty() || !persistable || persist_thread_running)
+            return;
+         if (persist_thread.joinable())
+            persist_thread.join();
+
+         persist_thread_running = true;
+         persist_thread = std::thread([this, data = pack_persist_data()]() {
+            try {
+               write_persist_file(data);
+            } FC_LOG_AND_DROP(("Unable to write account query DB checkpoint")(persist_file));
+            persist_thread_running = false;
+         });
+      }
+
+      /**
+       * Write the database to the persistence file, waiting for a checkpoint in progress first
+       */
+      void close() {
+         if (persist_thread.joinable())
+            persist_thread.join();
+         if (persist_file.empty())
+            return;
+         if (!persistable) {
+            elog("account query DB missed an update; not writing out '${filename}'", ("filename", persist_file));
+            return;
+         }
+
+         write_persist_file(pack_persist_data());
+      }
+
       /**
        * Add a permission to the bimaps for keys and accounts
        * @param pi - the ephemeral permission info structure being added
@@ -271,6 +535,7 @@ namespace eosio::chain_apis {
                index.modify(index.iterator_to(pi), [&po, last_updated_height](auto& mutable_pi) {
                   mutable_pi.last_updated_height = last_updated_height;
                   mutable_pi.threshold = po.auth.threshold;
+                  mutable_pi.last_updated = po.last_updated;
                });
                add_to_bimaps(pi, po);
                ++curr_iter;
@@ -389,12 +654,13 @@ namespace eosio::chain_apis {
                auto itr = index.find(key);
                if (itr == index.end()) {
                   const auto& po = *source_itr;
-                  itr = index.emplace(permission_info{ po.owner, po.name, bnum, po.auth.threshold }).first;
+                  itr = index.emplace(permission_info{ po.owner, po.name, bnum, po.auth.threshold, po.last_updated }).first;
                } else {
                   remove_from_bimaps(*itr);
                   index.modify(itr, [&](auto& mutable_pi){
                      mutable_pi.last_updated_height = bnum;
                      mutable_pi.threshold = source_itr->auth.threshold;
+                     mutable_pi.last_updated = source_itr->last_updated;
                   });
                }
 
@@ -415,6 +681,9 @@ namespace eosio::chain_apis {
          // drop any unprocessed cached traces
          cached_trace_map.clear();
          onblock_trace.reset();
+
+         if (persist_interval > 0 && block->block_num() % persist_interval == 0)
+            checkpoint();
       }
 
       account_query_db::get_accounts_by_authorizers_result
@@ -484,6 +753,11 @@ namespace eosio::chain_apis {
       using onblock_trace_t = std::optional<chain::transaction_trace_ptr>;
 
       const chain::controller&   controller;               ///< the controller to read data from
+      std::filesystem::path      persist_file;             ///< file the database is loaded from and written to, if any
+      uint32_t                   persist_interval = 0;     ///< number of blocks between checkpoints, 0 for none
+      bool                       persistable = true;       ///< false once an update failed to apply
+      std::thread                persist_thread;           ///< thread writing the last checkpoint
+      std::atomic<bool>          persist_thread_running = false;
       cached_trace_map_t         cached_trace_map;         ///< temporary cache of uncommitted traces
       onblock_trace_t            onblock_trace;            ///< temporary cache of on_block trace
 
@@ -506,25 +780,35 @@ namespace eosio::chain_apis {
       mutable std::shared_mutex  rw_mutex;                 ///< mutex for read/write locking on the Multi-index and bimaps
    };
 
-   account_query_db::account_query_db( const chain::controller& controller )
-   :_impl(std::make_unique<account_query_db_impl>(controller))
+   account_query_db::account_query_db( const chain::controller& controller, const std::filesystem::path& persist_file, uint32_t persist_interval )
+   :_impl(std::make_unique<account_query_db_impl>(controller, persist_file, persist_interval))
    {
-      _impl->build_account_query_map();
+      _impl->open();
    }
 
    account_query_db::~account_query_db() = default;
    account_query_db & account_query_db::operator=(account_query_db &&) = default;
 
+   void account_query_db::close() {
+      try {
+         _impl->close();
+      } FC_LOG_AND_DROP(("ACCOUNT DB close ERROR"));
+   }
+
    void account_query_db::cache_transaction_trace( const chain::transaction_trace_ptr& trace ) {
       try {
          _impl->cache_transaction_trace(trace);
+         return;
       } FC_LOG_AND_DROP(("ACCOUNT DB cache_transaction_trace ERROR"));
+      _impl->persistable = false;
    }
 
    void account_query_db::commit_block( const chain::signed_block_ptr& block ) {
       try {
          _impl->commit_block(block);
+         return;
       } FC_LOG_AND_DROP(("ACCOUNT DB commit_block ERROR"));
+      _impl->persistable = false;
    }
 
    account_query_db::get_accounts_by_authorizers_result account_query_db::get_accounts_by_authorizers( const account_query_db::get_accounts_by_authorizers_params& args) const {
@@ -161,6 +161,7 @@ public:
    bool                              accept_transactions     = false;
    bool                              api_accept_transactions = true;
    bool                              account_queries_enabled = false;
+   uint32_t                          account_queries_persist_interval = 0;
 
    std::optional<controller::config> chain_config;
    std::optional<controller>         chain;
@@ -197,6 +198,13 @@ public:
    std::optional<chain_apis::account_query_db>                        _account_query_db;
    std::optional<chain_apis::trx_retry_db>                            _trx_retry_db;
    chain_apis::trx_finality_status_processing_ptr                     _trx_finality_status_processing;
+   std::optional<chain_apis::abi_cache>                               _abi_cache;
+   std::function<void(const chain_apis::abi_cache::stats&)>           _update_abi_cache_metrics;
+   std::function<void(const chain::signature_recovery_cache::stats&)> _update_signature_recovery_cache_metrics;
+   std::function<void(const chain::eosvmoc::compile_stats&)>          _update_eos_vm_oc_compile_metrics;
+   std::function<void(const chain::instantiated_module_cache_stats&)> _update_instantiation_cache_metrics;
+
+   chain_apis::abi_cache* get_abi_cache() { return _abi_cache ? &*_abi_cache : nullptr; }
 
    static void handle_guard_exception(const chain::guard_exception& e);
    void do_hard_replay(const variables_map& options);
@@ -282,8 +290,17 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
          )
          ("profile-account", boost::program_options::value<vector<string>>()->composing(),
           "The name of an account whose code will be profiled")
+         ("wasm-instantiation-cache-size-mb", bpo::value<uint64_t>()->default_value(config::default_wasm_instantiation_cache_size / (1024 * 1024)),
+          "Maximum size (in MiB) of the instantiated contracts kept for reuse. The budget counts the wasm code size of the "
+          "contracts, not the size of their instantiated form which is much larger with eos-vm-jit. When exceeded, "
+          "contracts that are quick to instantiate again for their size and rarely used are evicted first. 0 for no limit")
          ("abi-serializer-max-time-ms", bpo::value<uint32_t>()->default_value(config::default_abi_serializer_max_time_us / 1000),
           "Override default maximum ABI serialization time allowed in ms")
+         ("abi-serializer-cache-size-mb", bpo::value<uint64_t>()->default_value(64),
+          "Maximum estimated size (in MiB) of the parsed contract ABIs kept for chain API requests, 0 disables the cache")
+         ("signature-recovery-cache-size", bpo::value<uint64_t>()->default_value(chain::signature_recovery_cache::default_capacity),
+          "Maximum number of public keys recovered from transaction signatures kept for reuse by p2p, API and block validation, 0 disables the cache. "
+          "The recovery time of a cached key is billed again on every use, so caching does not change billed signature CPU time")
          ("chain-state-db-size-mb", bpo::value<uint64_t>()->default_value(config::default_state_size / (1024  * 1024)), "Maximum size (in MiB) of the chain state database")
          ("chain-state-db-guard-size-mb", bpo::value<uint64_t>()->default_value(config::default_state_guard_size / (1024  * 1024)), "Safely shut down node when free space remaining in the chain state database drops below this size (in MiB).")
          ("signature-cpu-billable-pct", bpo::value<uint32_t>()->default_value(config::default_sig_cpu_bill_pct / config::percent_1),
@@ -348,6 +365,9 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
                   EOS_ASSERT(false, plugin_exception, "");
                }
          }), "Number of threads to use for EOS VM OC tier-up")
+         ("eos-vm-oc-preload-count", bpo::value<uint32_t>()->default_value(0),
+          "Number of most recently used contracts of the previous run to page in from the EOS VM OC code cache at startup, "
+          "or to compile before replaying blocks when they are no longer in the code cache. 0 disables preloading.")
          ("eos-vm-oc-enable", bpo::value<chain::wasm_interface::vm_oc_enable>()->default_value(chain::wasm_interface::vm_oc_enable::oc_auto),
           "Enable EOS VM OC tier-up runtime ('auto', 'all', 'none').\n"
           "'auto' - EOS VM OC tier-up is enabled for eosio.* accounts, read-only trxs, and except on producers applying blocks.\n"
@@ -355,6 +375,9 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
           "'none' - EOS VM OC tier-up is completely disabled.\n")
 #endif
          ("enable-account-queries", bpo::value<bool>()->default_value(false), "enable queries to find accounts by various metadata.")
+         ("account-queries-persist-interval", bpo::value<uint32_t>()->default_value(7200),
+          "Number of blocks between checkpoints of the account query DB written to the state directory, so that a restart "
+          "after a crash does not recreate it from every permission. 0 to write it only on shutdown.")
          ("transaction-retry-max-storage-size-gb", bpo::value<uint64_t>(),
           "Maximum size (in GiB) allowed to be allocated for the Transaction Retry feature. Setting above 0 enables this feature.")
          ("transaction-retry-interval-sec", bpo::value<uint32_t>()->default_value(20),
@@ -372,7 +395,11 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
          ("disable-replay-opts", bpo::bool_switch()->default_value(false),
           "disable optimizations that specifically target replay")
          ("integrity-hash-on-start", bpo::bool_switch(), "Log the state integrity hash on startup")
-         ("integrity-hash-on-stop", bpo::bool_switch(), "Log the state integrity hash on shutdown");
+         ("integrity-hash-on-stop", bpo::bool_switch(), "Log the state integrity hash on shutdown")
+         ("integrity-hash-version", bpo::value<uint32_t>()->default_value(1),
+          "Version of the state integrity hash logged on startup and shutdown and returned by the producer API.\n"
+          "1 hashes the whole state in order, 2 hashes every snapshot section on the chain thread pool and combines them in a merkle tree.\n"
+          "Hashes of different versions can not be compared.");
 
     cfg.add_options()("block-log-retain-blocks", bpo::value<uint32_t>(), "If set to greater than 0, periodically prune the block log to store only configured number of most recent blocks.\n"
         "If set to 0, no blocks are be written to the block log; block log file is removed after startup.");
@@ -591,8 +618,13 @@ void chain_plugin_impl::plugin_initialize(const variables_map& options) {
 
       LOAD_VALUE_SET( options, "profile-account", chain_config->profile_accounts );
 
+      chain_config->wasm_instantiation_cache_size = options.at( "wasm-instantiation-cache-size-mb" ).as<uint64_t>() * 1024 * 1024;
+
       abi_serializer_max_time_us = fc::microseconds(options.at("abi-serializer-max-time-ms").as<uint32_t>() * 1000);
 
+      if( const uint64_t abi_cache_size = options.at( "abi-serializer-cache-size-mb" ).as<uint64_t>() * 1024 * 1024; abi_cache_size > 0 )
+         _abi_cache.emplace( abi_cache_size );
+
       chain_config->blocks_dir = blocks_dir;
       chain_config->state_dir = state_dir;
       chain_config->read_only = readonly;
@@ -632,6 +664,8 @@ void chain_plugin_impl::plugin_initialize(const variables_map& options) {
                   "signature-cpu-billable-pct must be 0 - 100, ${pct}", ("pct", chain_config->sig_cpu_bill_pct) );
       chain_config->sig_cpu_bill_pct *= config::percent_1;
 
+      chain_config->signature_recovery_cache_size = options.at( "signature-recovery-cache-size" ).as<uint64_t>();
+
       if( wasm_runtime )
          chain_config->wasm_runtime = *wasm_runtime;
 
@@ -918,13 +952,19 @@ void chain_plugin_impl::plugin_initialize(const variables_map& options) {
          chain_config->eosvmoc_config.cache_size = options.at( "eos-vm-oc-cache-size-mb" ).as<uint64_t>() * 1024u * 1024u;
       if( options.count("eos-vm-oc-compile-threads") )
          chain_config->eosvmoc_config.threads = options.at("eos-vm-oc-compile-threads").as<uint64_t>();
+      if( options.count("eos-vm-oc-preload-count") )
+         chain_config->eosvmoc_config.preload_count = options.at("eos-vm-oc-preload-count").as<uint32_t>();
       chain_config->eosvmoc_tierup = options["eos-vm-oc-enable"].as<chain::wasm_interface::vm_oc_enable>();
 #endif
 
       account_queries_enabled = options.at("enable-account-queries").as<bool>();
+      account_queries_persist_interval = options.at("account-queries-persist-interval").as<uint32_t>();
 
       chain_config->integrity_hash_on_start = options.at("integrity-hash-on-start").as<bool>();
       chain_config->integrity_hash_on_stop = options.at("integrity-hash-on-stop").as<bool>();
+      chain_config->integrity_hash_version = options.at("integrity-hash-version").as<uint32_t>();
+      EOS_ASSERT( chain_config->integrity_hash_version == 1 || chain_config->integrity_hash_version == 2, plugin_config_exception,
+                  "integrity-hash-version must be 1 or 2" );
 
       chain.emplace( *chain_config, std::move(pfs), *chain_id );
 
@@ -1024,6 +1064,22 @@ void chain_plugin_impl::plugin_initialize(const variables_map& options) {
             _trx_finality_status_processing->signal_accepted_block(block, id);
          }
 
+         if (_abi_cache && _update_abi_cache_metrics) {
+            _update_abi_cache_metrics(_abi_cache->get_stats());
+         }
+
+         if (_update_signature_recovery_cache_metrics) {
+            _update_signature_recovery_cache_metrics(chain->get_signature_recovery_cache().get_stats());
+         }
+
+         if (_update_eos_vm_oc_compile_metrics) {
+            _update_eos_vm_oc_compile_metrics(chain->get_wasm_interface().get_eos_vm_oc_compile_stats());
+         }
+
+         if (_update_instantiation_cache_metrics) {
+            _update_instantiation_cache_metrics(chain->get_wasm_interface().get_instantiation_cache_stats());
+         }
+
          accepted_block_channel.publish( priority::high, t );
       } );
 
@@ -1088,10 +1144,8 @@ void chain_plugin_impl::plugin_startup()
       auto shutdown = [](){ return app().quit(); };
       auto check_shutdown = [](){ return app().is_quiting(); };
       if (snapshot_path) {
-         auto infile = std::ifstream(snapshot_path->generic_string(), (std::ios::in | std::ios::binary));
-         auto reader = std::make_shared<istream_snapshot_reader>(infile);
+         auto reader = std::make_shared<threaded_snapshot_reader>(*snapshot_path);
          chain->startup(shutdown, check_shutdown, reader);
-         infile.close();
       } else if( genesis ) {
          chain->startup(shutdown, check_shutdown, *genesis);
       } else {
@@ -1121,7 +1175,7 @@ void chain_plugin_impl::plugin_startup()
    if (account_queries_enabled) {
       account_queries_enabled = false;
       try {
-         _account_query_db.emplace(*chain);
+         _account_query_db.emplace(*chain, state_dir / "account_query_db.dat", account_queries_persist_interval);
          account_queries_enabled = true;
       } FC_LOG_AND_DROP(("Unable to enable account queries"));
    }
@@ -1139,6 +1193,8 @@ void chain_plugin_impl::plugin_shutdown() {
    irreversible_block_connection.reset();
    applied_transaction_connection.reset();
    block_start_connection.reset();
+   if (_account_query_db)
+      _account_query_db->close();
    chain.reset();
 }
 
@@ -1154,12 +1210,14 @@ chain_apis::read_write::read_write(controller& db,
                                    std::optional<trx_retry_db>& trx_retry,
                                    const fc::microseconds& abi_serializer_max_time,
                                    const fc::microseconds& http_max_response_time,
-                                   bool api_accept_transactions)
+                                   bool api_accept_transactions,
+                                   abi_cache* shared_abi_cache)
 : db(db)
 , trx_retry(trx_retry)
 , abi_serializer_max_time(abi_serializer_max_time)
 , http_max_response_time(http_max_response_time)
 , api_accept_transactions(api_accept_transactions)
+, shared_abi_cache(shared_abi_cache)
 {
 }
 
@@ -1169,11 +1227,13 @@ void chain_apis::read_write::validate() const {
 }
 
 chain_apis::read_write chain_plugin::get_read_write_api(const fc::microseconds& http_max_response_time) {
-   return chain_apis::read_write(chain(), my->_trx_retry_db, get_abi_serializer_max_time(), http_max_response_time, api_accept_transactions());
+   return chain_apis::read_write(chain(), my->_trx_retry_db, get_abi_serializer_max_time(), http_max_response_time, api_accept_transactions(),
+                                 my->get_abi_cache());
 }
 
 chain_apis::read_only chain_plugin::get_read_only_api(const fc::microseconds& http_max_response_time) const {
-   return chain_apis::read_only(chain(), my->_account_query_db, get_abi_serializer_max_time(), http_max_response_time, my->_trx_finality_status_processing.get());
+   return chain_apis::read_only(chain(), my->_account_query_db, get_abi_serializer_max_time(), http_max_response_time, my->_trx_finality_status_processing.get(),
+                                my->get_abi_cache());
 }
 
 
@@ -1375,6 +1435,19 @@ read_only::get_activated_protocol_features( const read_only::get_activated_proto
    return result;
 }
 
+fc::variant read_only::table_row_to_variant(const abi_serializer& abis, const chain::abi_plan* plan, std::string_view table_type,
+                                            const bytes& row, const fc::microseconds& abi_serializer_max_time,
+                                            bool shorten_abi_errors) {
+   if( plan ) {
+      try {
+         return plan->binary_to_variant( table_type, row, abi_serializer::create_yield_function( abi_serializer_max_time ) );
+      } catch( ... ) {
+         // the abi_serializer reports the error with the path into the row
+      }
+   }
+   return abis.binary_to_variant( table_type, row, abi_serializer::create_yield_function( abi_serializer_max_time ), shorten_abi_errors );
+}
+
 uint64_t read_only::get_table_index_name(const read_only::get_table_rows_params& p, bool& primary) {
    using boost::algorithm::starts_with;
    // see multi_index packing of index name
@@ -1524,39 +1597,49 @@ string get_table_type( const abi_def& abi, const name& table_name ) {
 
 read_only::get_table_rows_return_t
 read_only::get_table_rows( const read_only::get_table_rows_params& p, const fc::time_point& deadline ) const {
-   abi_def abi = eosio::chain_apis::get_abi( db, p.code );
+   EOS_ASSERT( db.db().find<account_object, by_name>(p.code) != nullptr, chain::account_query_exception,
+               "Fail to retrieve account for ${account}", ("account", p.code) );
+   abi_plan_ptr plan;
+   abi_serializer_ptr abis;
+   if( shared_abi_cache ) {
+      plan = shared_abi_cache->get_plan( db, p.code, abi_serializer_max_time );
+      abis = plan ? plan->get_serializer() : abi_serializer_ptr{};
+   } else {
+      abis = make_resolver( db, abi_serializer_max_time, throw_on_yield::yes )( p.code );
+   }
    bool primary = false;
    auto table_with_index = get_table_index_name( p, primary );
    if( primary ) {
       EOS_ASSERT( p.table == table_with_index, chain::contract_table_query_exception, "Invalid table name ${t}", ( "t", p.table ));
-      auto table_type = get_table_type( abi, p.table );
+      auto table_type = abis ? abis->get_table_type( p.table ) : type_name();
+      EOS_ASSERT( !table_type.empty(), chain::contract_table_query_exception, "Table ${table} is not specified in the ABI", ("table",p.table) );
       if( table_type == KEYi64 || p.key_type == "i64" || p.key_type == "name" ) {
-         return get_table_rows_ex<key_value_index>(p,std::move(abi),deadline);
+         return get_table_rows_ex<key_value_index>(p,std::move(abis),std::move(plan),deadline);
       }
-      EOS_ASSERT( false, chain::contract_table_query_exception,  "Invalid table type ${type}", ("type",table_type)("abi",abi));
+      EOS_ASSERT( false, chain::contract_table_query_exception,  "Invalid table type ${type}", ("type",table_type));
    } else {
       EOS_ASSERT( !p.key_type.empty(), chain::contract_table_query_exception, "key type required for non-primary index" );
 
       if (p.key_type == chain_apis::i64 || p.key_type == "name") {
-         return get_table_rows_by_seckey<index64_index, uint64_t>(p, std::move(abi), deadline, [](uint64_t v)->uint64_t {
+         return get_table_rows_by_seckey<index64_index, uint64_t>(p, std::move(abis), std::move(plan), deadline, [](uint64_t v)->uint64_t {
             return v;
          });
       }
       else if (p.key_type == chain_apis::i128) {
-         return get_table_rows_by_seckey<index128_index, uint128_t>(p, std::move(abi), deadline, [](uint128_t v)->uint128_t {
+         return get_table_rows_by_seckey<index128_index, uint128_t>(p, std::move(abis), std::move(plan), deadline, [](uint128_t v)->uint128_t {
             return v;
          });
       }
       else if (p.key_type == chain_apis::i256) {
          if ( p.encode_type == chain_apis::hex) {
             using  conv = keytype_converter<chain_apis::sha256,chain_apis::hex>;
-            return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, std::move(abi), deadline, conv::function());
+            return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, std::move(abis), std::move(plan), deadline, conv::function());
          }
          using  conv = keytype_converter<chain_apis::i256>;
-         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, std::move(abi), deadline, conv::function());
+         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, std::move(abis), std::move(plan), deadline, conv::function());
       }
       else if (p.key_type == chain_apis::float64) {
-         return get_table_rows_by_seckey<index_double_index, double>(p, std::move(abi), deadline, [](double v)->float64_t {
+         return get_table_rows_by_seckey<index_double_index, double>(p, std::move(abis), std::move(plan), deadline, [](double v)->float64_t {
             float64_t f;
             double_to_float64(v, f);
             return f;
@@ -1564,13 +1647,13 @@ read_only::get_table_rows( const read_only::get_table_rows_params& p, const fc::
       }
       else if (p.key_type == chain_apis::float128) {
          if ( p.encode_type == chain_apis::hex) {
-            return get_table_rows_by_seckey<index_long_double_index, uint128_t>(p, std::move(abi), deadline, [](uint128_t v)->float128_t{
+            return get_table_rows_by_seckey<index_long_double_index, uint128_t>(p, std::move(abis), std::move(plan), deadline, [](uint128_t v)->float128_t{
                float128_t f;
                uint128_to_float128(v, f);
                return f;
             });
          }
-         return get_table_rows_by_seckey<index_long_double_index, double>(p, std::move(abi), deadline, [](double v)->float128_t{
+         return get_table_rows_by_seckey<index_long_double_index, double>(p, std::move(abis), std::move(plan), deadline, [](double v)->float128_t{
             float64_t f;
             double_to_float64(v, f);
             float128_t f128;
@@ -1580,11 +1663,11 @@ read_only::get_table_rows( const read_only::get_table_rows_params& p, const fc::
       }
       else if (p.key_type == chain_apis::sha256) {
          using  conv = keytype_converter<chain_apis::sha256,chain_apis::hex>;
-         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, std::move(abi), deadline, conv::function());
+         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, std::move(abis), std::move(plan), deadline, conv::function());
       }
       else if(p.key_type == chain_apis::ripemd160) {
          using  conv = keytype_converter<chain_apis::ripemd160,chain_apis::hex>;
-         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, std::move(abi), deadline, conv::function());
+         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, std::move(abis), std::move(plan), deadline, conv::function());
       }
       EOS_ASSERT(false, chain::contract_table_query_exception,  "Unsupported secondary index type: ${t}", ("t", p.key_type));
    }
@@ -1837,7 +1920,7 @@ read_only::get_scheduled_transactions( const read_only::get_scheduled_transactio
 
    read_only::get_scheduled_transactions_result result;
 
-   auto resolver = make_resolver(db, abi_serializer_max_time, throw_on_yield::no);
+   auto resolver = make_resolver(db, abi_serializer_max_time, throw_on_yield::no, shared_abi_cache);
 
    uint32_t remaining = p.limit;
    if (deadline != fc::time_point::maximum() && remaining > max_return_items)
@@ -1912,7 +1995,7 @@ std::function<chain::t_or_exception<fc::variant>()> read_only::get_block(const g
 
    using return_type = t_or_exception<fc::variant>;
    return [this,
-           resolver = get_serializers_cache(db, block, abi_serializer_max_time),
+           resolver = get_serializers_cache(db, block, abi_serializer_max_time, shared_abi_cache),
            block    = std::move(block)]() mutable -> return_type {
       try {
          return convert_block(block, resolver);
@@ -1960,7 +2043,7 @@ read_only::get_block_header_result read_only::get_block_header(const read_only::
 
 abi_resolver
 read_only::get_block_serializers( const chain::signed_block_ptr& block, const fc::microseconds& max_time ) const {
-   return get_serializers_cache(db, block, max_time);
+   return get_serializers_cache(db, block, max_time, shared_abi_cache);
 }
 
 fc::variant read_only::convert_block( const chain::signed_block_ptr& block, abi_resolver& resolver ) const {
@@ -2042,7 +2125,7 @@ void read_write::push_block(read_write::push_block_params&& params, next_functio
 void read_write::push_transaction(const read_write::push_transaction_params& params, next_function<read_write::push_transaction_results> next) {
    try {
       auto pretty_input = std::make_shared<packed_transaction>();
-      auto resolver = caching_resolver(make_resolver(db, abi_serializer_max_time, throw_on_yield::yes));
+      auto resolver = caching_resolver(make_resolver(db, abi_serializer_max_time, throw_on_yield::yes, shared_abi_cache));
       try {
          abi_serializer::from_variant(params, *pretty_input, resolver, abi_serializer_max_time);
       } EOS_RETHROW_EXCEPTIONS(chain::packed_transaction_type_exception, "Invalid packed transaction")
@@ -2057,7 +2140,7 @@ void read_write::push_transaction(const read_write::push_transaction_params& par
             try {
                fc::variant output;
                try {
-                  auto resolver = get_serializers_cache(db, trx_trace_ptr, abi_serializer_max_time);
+                  auto resolver = get_serializers_cache(db, trx_trace_ptr, abi_serializer_max_time, shared_abi_cache);
                   abi_serializer::to_variant(*trx_trace_ptr, output, resolver, abi_serializer_max_time);
 
                   // Create map of (closest_unnotified_ancestor_action_ordinal, global_sequence) with action trace
@@ -2165,7 +2248,7 @@ template<class API, class Result>
 void api_base::send_transaction_gen(API &api, send_transaction_params_t params, next_function<Result> next) {
    try {
       auto ptrx = std::make_shared<packed_transaction>();
-      auto resolver = caching_resolver(make_resolver(api.db, api.abi_serializer_max_time, throw_on_yield::yes));
+      auto resolver = caching_resolver(make_resolver(api.db, api.abi_serializer_max_time, throw_on_yield::yes, api.shared_abi_cache));
       try {
          abi_serializer::from_variant(params.transaction, *ptrx, resolver, api.abi_serializer_max_time);
       } EOS_RETHROW_EXCEPTIONS(packed_transaction_type_exception, "Invalid packed transaction")
@@ -2215,7 +2298,7 @@ void api_base::send_transaction_gen(API &api, send_transaction_params_t params,
                      using return_type = t_or_exception<Result>;
                      next([&api,
                            trx_trace_ptr,
-                           resolver = get_serializers_cache(api.db, trx_trace_ptr, api.abi_serializer_max_time)]() mutable {
+                           resolver = get_serializers_cache(api.db, trx_trace_ptr, api.abi_serializer_max_time, api.shared_abi_cache)]() mutable {
                         try {
                            fc::variant output;
                            try {
@@ -2510,7 +2593,7 @@ read_only::get_account_return_t read_only::get_account( const get_account_params
 
 read_only::get_required_keys_result read_only::get_required_keys( const get_required_keys_params& params, const fc::time_point& )const {
    transaction pretty_input;
-   auto resolver = caching_resolver(make_resolver(db, abi_serializer_max_time, throw_on_yield::yes));
+   auto resolver = caching_resolver(make_resolver(db, abi_serializer_max_time, throw_on_yield::yes, shared_abi_cache));
    try {
       abi_serializer::from_variant(params.transaction, pretty_input, resolver, abi_serializer_max_time);
    } EOS_RETHROW_EXCEPTIONS(chain::transaction_type_exception, "Invalid transaction")
@@ -2621,7 +2704,7 @@ fc::variant chain_plugin::get_log_trx_trace(const transaction_trace_ptr& trx_tra
     fc::variant pretty_output;
     try {
         abi_serializer::to_log_variant(trx_trace, pretty_output,
-                                       caching_resolver(make_resolver(chain(), get_abi_serializer_max_time(), throw_on_yield::no)),
+                                       caching_resolver(make_resolver(chain(), get_abi_serializer_max_time(), throw_on_yield::no, my->get_abi_cache())),
                                        get_abi_serializer_max_time());
     } catch (...) {
         pretty_output = trx_trace;
@@ -2633,7 +2716,7 @@ fc::variant chain_plugin::get_log_trx(const transaction& trx) const {
     fc::variant pretty_output;
     try {
         abi_serializer::to_log_variant(trx, pretty_output,
-                                       caching_resolver(make_resolver(chain(), get_abi_serializer_max_time(), throw_on_yield::no)),
+                                       caching_resolver(make_resolver(chain(), get_abi_serializer_max_time(), throw_on_yield::no, my->get_abi_cache())),
                                        get_abi_serializer_max_time());
     } catch (...) {
         pretty_output = trx;
@@ -2645,6 +2728,22 @@ const controller::config& chain_plugin::chain_config() const {
    EOS_ASSERT(my->chain_config.has_value(), plugin_exception, "chain_config not initialized");
    return *my->chain_config;
 }
+
+void chain_plugin::register_update_abi_cache_metrics(std::function<void(const chain_apis::abi_cache::stats&)>&& fun) {
+   my->_update_abi_cache_metrics = std::move(fun);
+}
+
+void chain_plugin::register_update_signature_recovery_cache_metrics(std::function<void(const chain::signature_recovery_cache::stats&)>&& fun) {
+   my->_update_signature_recovery_cache_metrics = std::move(fun);
+}
+
+void chain_plugin::register_update_eos_vm_oc_compile_metrics(std::function<void(const chain::eosvmoc::compile_stats&)>&& fun) {
+   my->_update_eos_vm_oc_compile_metrics = std::move(fun);
+}
+
+void chain_plugin::register_update_instantiation_cache_metrics(std::function<void(const chain::instantiated_module_cache_stats&)>&& fun) {
+   my->_update_instantiation_cache_metrics = std::move(fun);
+}
 } // namespace eosio
 
 FC_REFLECT( eosio::chain_apis::detail::ram_market_exchange_state_t, (ignore1)(ignore2)(ignore3)(core_symbol)(ignore4) )
@@ -0,0 +1,75 @@
+#pragma once
+#include <eosio/chain/types.hpp>
+#include <eosio/chain/abi_serializer.hpp>
+
+#include <memory>
+
+namespace eosio::chain {
+   class controller;
+}
+
+namespace eosio::chain_apis {
+
+/**
+ * This class provides a cache of parsed ABIs shared by all chain API requests, including those executed on the
+ * read-only thread pool, so popular contract ABIs are parsed once instead of once per request.
+ *
+ * Entries are keyed by account. On every lookup an entry is validated against the account's current abi_sequence and
+ * ABI bytes, so a setabi, including one in a block that is later forked out or in an aborted speculative block, never
+ * yields a stale serializer. Memory is bounded by the estimated size of the cached entries, their raw ABI, parsed
+ * abi_serializer and the abi_plan compiled from it; least recently used entries are evicted first. The cache is split
+ * into shards to keep lock contention low.
+ *
+ * All methods are thread-safe.
+ */
+class abi_cache {
+public:
+   struct stats {
+      uint64_t hits      = 0;
+      uint64_t misses    = 0;
+      uint64_t evictions = 0;
+      uint64_t entries   = 0;
+      uint64_t bytes     = 0; ///< estimated size of all cached entries
+   };
+
+   /**
+    * @param max_bytes - maximum total estimated size of the entries kept in the cache, 0 disables caching
+    */
+   explicit abi_cache( size_t max_bytes );
+   ~abi_cache();
+
+   abi_cache(abi_cache&&) = delete;
+   abi_cache& operator=(abi_cache&&) = delete;
+
+   /**
+    * Find the serializer for the current ABI of account, parsing and caching it if needed.
+    * The controller's database must not be modified for the duration of the call.
+    * @return nullptr if the account does not exist or has no ABI
+    * @throws if the ABI can not be parsed within abi_serializer_max_time, failures are not cached
+    */
+   chain::abi_serializer_ptr get( const chain::controller& control, const chain::account_name& account,
+                                  const fc::microseconds& abi_serializer_max_time );
+
+   /**
+    * Same as get(), for the abi_plan compiled from the serializer and cached with it; its get_serializer() is the
+    * serializer get() returns.
+    * @return nullptr if the account does not exist or has no ABI
+    */
+   chain::abi_plan_ptr get_plan( const chain::controller& control, const chain::account_name& account,
+                                 const fc::microseconds& abi_serializer_max_time );
+
+   /**
+    * @return counters since creation and the current size of the cache
+    */
+   stats get_stats() const;
+
+   /**
+    * Remove all entries
+    */
+   void clear();
+
+private:
+   std::unique_ptr<struct abi_cache_impl> _impl;
+};
+
+} // namespace eosio::chain_apis
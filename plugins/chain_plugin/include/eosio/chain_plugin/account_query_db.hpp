@@ -2,11 +2,17 @@
 #include <eosio/chain/types.hpp>
 #include <eosio/chain/trace.hpp>
 
+#include <filesystem>
+
 namespace eosio::chain_apis {
    /**
-    * This class manages the ephemeral indices and data that provide the `get_accounts_by_authorizers` RPC call
-    * There is no persistence and the indices/caches are recreated when the class is instantiated based on the
-    * current state of the chain.
+    * This class manages the indices and data that provide the `get_accounts_by_authorizers` RPC call
+    * The indices are maintained incrementally as blocks are committed. When a persistence file is given they are
+    * written to it on close and, if requested, periodically as checkpoints. On the next instantiation the entries of
+    * the file which are still current are loaded from it and the others are recreated from the current state of the
+    * chain, so a checkpoint written before a crash is also used.
+    *
+    * All indices are kept in memory, their size is proportional to the number of permissions of the chain.
     */
    class account_query_db {
    public:
@@ -16,8 +22,11 @@ namespace eosio::chain_apis {
        * The caller is expected to manage lifetimes such that this controller reference does not go stale
        * for the life of the account query DB
        * @param chain - controller to read data from
+       * @param persist_file - optional file to load the indices from and write them to on close
+       * @param persist_interval - number of blocks between checkpoints written to persist_file, 0 for none
        */
-      account_query_db( const class eosio::chain::controller& chain );
+      account_query_db( const class eosio::chain::controller& chain, const std::filesystem::path& persist_file = {},
+                        uint32_t persist_interval = 0 );
       ~account_query_db();
 
       /**
@@ -26,6 +35,12 @@ namespace eosio::chain_apis {
       account_query_db(account_query_db&&);
       account_query_db& operator=(account_query_db&&);
 
+      /**
+       * Write the indices to the persistence file, if any, so the next instantiation can load them instead of
+       * recreating them from every permission. Must be called while the controller is still valid.
+       */
+      void close();
+
       /**
        * Add a transaction trace to the account query DB that has been applied to the contoller even though it may
        * not yet be committed to by a block.
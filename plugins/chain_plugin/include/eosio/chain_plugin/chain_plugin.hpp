@@ -9,6 +9,7 @@
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/transaction.hpp>
 #include <eosio/chain/abi_serializer.hpp>
+#include <eosio/chain/abi_plan.hpp>
 #include <eosio/chain/plugin_interface.hpp>
 #include <eosio/chain/types.hpp>
 #include <eosio/chain/fixed_bytes.hpp>
@@ -16,6 +17,10 @@
 #include <boost/container/flat_set.hpp>
 #include <boost/multiprecision/cpp_int.hpp>
 
+#include <eosio/chain_plugin/abi_cache.hpp>
+#include <eosio/chain/signature_recovery_cache.hpp>
+#include <eosio/chain/instantiated_module_cache.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/code_cache.hpp>
 #include <eosio/chain_plugin/account_query_db.hpp>
 #include <eosio/chain_plugin/trx_retry_db.hpp>
 #include <eosio/chain_plugin/trx_finality_status_processing.hpp>
@@ -49,20 +54,28 @@ namespace eosio {
    using chain::abi_resolver;
    using chain::packed_transaction;
 
+   using chain::abi_serializer_ptr;
+   using chain::abi_plan_ptr;
+   using chain_apis::abi_cache;
+
    enum class throw_on_yield { no, yes };
-   inline auto make_resolver(const controller& control, fc::microseconds abi_serializer_max_time, throw_on_yield yield_throw ) {
-      return [&control, abi_serializer_max_time, yield_throw](const account_name& name) -> std::optional<abi_serializer> {
+   /// @param cache shared cache of parsed ABIs to use, if null every ABI is parsed
+   inline auto make_resolver(const controller& control, fc::microseconds abi_serializer_max_time, throw_on_yield yield_throw,
+                             abi_cache* cache = nullptr) {
+      return [&control, abi_serializer_max_time, yield_throw, cache](const account_name& name) -> abi_serializer_ptr {
          if (name.good()) {
-            const auto* accnt = control.db().template find<chain::account_object, chain::by_name>( name );
-            if( accnt != nullptr ) {
-               try {
+            try {
+               if (cache)
+                  return cache->get(control, name, abi_serializer_max_time);
+               const auto* accnt = control.db().template find<chain::account_object, chain::by_name>( name );
+               if( accnt != nullptr ) {
                   if( abi_def abi; abi_serializer::to_abi( accnt->abi, abi ) ) {
-                     return abi_serializer( std::move( abi ), abi_serializer::create_yield_function( abi_serializer_max_time ) );
+                     return std::make_shared<const abi_serializer>( std::move( abi ), abi_serializer::create_yield_function( abi_serializer_max_time ) );
                   }
-               } catch( ... ) {
-                  if( yield_throw == throw_on_yield::yes )
-                     throw;
                }
+            } catch( ... ) {
+               if( yield_throw == throw_on_yield::yes )
+                  throw;
             }
          }
          return {};
@@ -70,8 +83,24 @@ namespace eosio {
    }
 
    template<class T>
-   inline abi_resolver get_serializers_cache(const controller& db, const T& obj, const fc::microseconds& max_time) {
-      return abi_resolver(abi_serializer_cache_builder(make_resolver(db, max_time, throw_on_yield::no)).add_serializers(obj).get());
+   inline abi_resolver get_serializers_cache(const controller& db, const T& obj, const fc::microseconds& max_time,
+                                             abi_cache* cache = nullptr) {
+      if (!cache)
+         return abi_resolver(abi_serializer_cache_builder(make_resolver(db, max_time, throw_on_yield::no)).add_serializers(obj).get());
+
+      // the cached plans convert the action data, their serializers the rest
+      chain::abi_plan_cache_t plans;
+      auto serializers = abi_serializer_cache_builder([&](const account_name& name) -> abi_serializer_ptr {
+         if (!name.good())
+            return {};
+         abi_plan_ptr plan = cache->get_plan(db, name, max_time);
+         if (!plan)
+            return {};
+         auto serializer = plan->get_serializer();
+         plans.emplace(name, std::move(plan));
+         return serializer;
+      }).add_serializers(obj).get();
+      return abi_resolver(std::move(serializers), std::move(plans));
    }
 
 namespace chain_apis {
@@ -143,6 +172,7 @@ class read_only : public api_base {
    const fc::microseconds http_max_response_time;
    bool  shorten_abi_errors = true;
    const trx_finality_status_processing* trx_finality_status_proc;
+   abi_cache* shared_abi_cache;
    friend class api_base;
    
 public:
@@ -150,12 +180,13 @@ public:
 
    read_only(const controller& db, const std::optional<account_query_db>& aqdb,
              const fc::microseconds& abi_serializer_max_time, const fc::microseconds& http_max_response_time,
-             const trx_finality_status_processing* trx_finality_status_proc)
+             const trx_finality_status_processing* trx_finality_status_proc, abi_cache* shared_abi_cache = nullptr)
       : db(db)
       , aqdb(aqdb)
       , abi_serializer_max_time(abi_serializer_max_time)
       , http_max_response_time(http_max_response_time)
-      , trx_finality_status_proc(trx_finality_status_proc) {
+      , trx_finality_status_proc(trx_finality_status_proc)
+      , shared_abi_cache(shared_abi_cache) {
    }
 
    void validate() const {}
@@ -571,10 +602,16 @@ public:
 
    static uint64_t get_table_index_name(const read_only::get_table_rows_params& p, bool& primary);
 
+   /// converts a table row with plan if there is one, rows it fails on are converted again by abis to report the error
+   static fc::variant table_row_to_variant(const abi_serializer& abis, const chain::abi_plan* plan, std::string_view table_type,
+                                           const bytes& row, const fc::microseconds& abi_serializer_max_time,
+                                           bool shorten_abi_errors);
+
    template <typename IndexType, typename SecKeyType, typename ConvFn>
    get_table_rows_return_t
    get_table_rows_by_seckey( const read_only::get_table_rows_params& p,
-                             abi_def&& abi,
+                             abi_serializer_ptr abis,
+                             abi_plan_ptr plan,
                              const fc::time_point& deadline,
                              ConvFn conv ) const {
 
@@ -675,19 +712,18 @@ public:
 
       // not enforcing the deadline for that second processing part (the serialization), as it is not taking place
       // on the main thread, but in the http thread pool.
-      return [p = std::move(http_params), abi=std::move(abi), abi_serializer_max_time=abi_serializer_max_time]() mutable ->
+      return [p = std::move(http_params), abis=std::move(abis), plan=std::move(plan), abi_serializer_max_time=abi_serializer_max_time]() mutable ->
          chain::t_or_exception<read_only::get_table_rows_result> {
          read_only::get_table_rows_result result;
-         abi_serializer abis;
-         abis.set_abi(std::move(abi), abi_serializer::create_yield_function(abi_serializer_max_time));
-         auto table_type = abis.get_table_type(p.table);
+         if( !abis )
+            abis = std::make_shared<const abi_serializer>();
+         auto table_type = abis->get_table_type(p.table);
          
          for (auto& row : p.rows) {
             fc::variant data_var;
             if( p.json ) {
-               data_var = abis.binary_to_variant(table_type, row.first,
-                                                 abi_serializer::create_yield_function(abi_serializer_max_time),
-                                                 p.shorten_abi_errors );
+               data_var = table_row_to_variant(*abis, plan.get(), table_type, row.first, abi_serializer_max_time,
+                                               p.shorten_abi_errors);
             } else {
                data_var = fc::variant(row.first);
             }
@@ -707,7 +743,8 @@ public:
    template <typename IndexType>
    get_table_rows_return_t
    get_table_rows_ex( const read_only::get_table_rows_params& p,
-                      abi_def&& abi,
+                      abi_serializer_ptr abis,
+                      abi_plan_ptr plan,
                       const fc::time_point& deadline ) const {
 
       fc::time_point params_deadline = p.time_limit_ms ? std::min(fc::time_point::now().safe_add(fc::milliseconds(*p.time_limit_ms)), deadline) : deadline;
@@ -787,19 +824,18 @@ public:
       
       // not enforcing the deadline for that second processing part (the serialization), as it is not taking place
       // on the main thread, but in the http thread pool.
-      return [p = std::move(http_params), abi=std::move(abi), abi_serializer_max_time=abi_serializer_max_time]() mutable ->
+      return [p = std::move(http_params), abis=std::move(abis), plan=std::move(plan), abi_serializer_max_time=abi_serializer_max_time]() mutable ->
          chain::t_or_exception<read_only::get_table_rows_result> {
          read_only::get_table_rows_result result;
-         abi_serializer abis;
-         abis.set_abi(std::move(abi), abi_serializer::create_yield_function(abi_serializer_max_time));
-         auto table_type = abis.get_table_type(p.table);
+         if( !abis )
+            abis = std::make_shared<const abi_serializer>();
+         auto table_type = abis->get_table_type(p.table);
          
          for (auto& row : p.rows) {
             fc::variant data_var;
             if( p.json ) {
-               data_var = abis.binary_to_variant(table_type, row.first,
-                                                 abi_serializer::create_yield_function(abi_serializer_max_time),
-                                                 p.shorten_abi_errors );
+               data_var = table_row_to_variant(*abis, plan.get(), table_type, row.first, abi_serializer_max_time,
+                                               p.shorten_abi_errors);
             } else {
                data_var = fc::variant(row.first);
             }
@@ -836,12 +872,13 @@ class read_write : public api_base {
    const fc::microseconds abi_serializer_max_time;
    const fc::microseconds http_max_response_time;
    const bool api_accept_transactions;
+   abi_cache* shared_abi_cache;
    friend class api_base;
    
 public:
    read_write(controller& db, std::optional<trx_retry_db>& trx_retry,
               const fc::microseconds& abi_serializer_max_time, const fc::microseconds& http_max_response_time,
-              bool api_accept_transactions);
+              bool api_accept_transactions, abi_cache* shared_abi_cache = nullptr);
    void validate() const;
 
    // return deadline for call
@@ -1004,6 +1041,18 @@ public:
    fc::variant get_log_trx(const transaction& trx) const;
 
    const controller::config& chain_config() const;
+
+   // called on the main thread for each accepted block when the abi cache is enabled
+   void register_update_abi_cache_metrics(std::function<void(const chain_apis::abi_cache::stats&)>&&);
+
+   // called on the main thread for each accepted block
+   void register_update_signature_recovery_cache_metrics(std::function<void(const chain::signature_recovery_cache::stats&)>&&);
+
+   // called on the main thread for each accepted block
+   void register_update_eos_vm_oc_compile_metrics(std::function<void(const chain::eosvmoc::compile_stats&)>&&);
+
+   // called on the main thread for each accepted block
+   void register_update_instantiation_cache_metrics(std::function<void(const chain::instantiated_module_cache_stats&)>&&);
 private:
 
    unique_ptr<class chain_plugin_impl> my;
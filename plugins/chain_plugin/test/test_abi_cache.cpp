@@ -0,0 +1,165 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/types.hpp>
+#include <eosio/chain_plugin/abi_cache.hpp>
+
+#include <thread>
+
+using namespace eosio;
+using namespace eosio::chain;
+using namespace eosio::testing;
+using namespace eosio::chain_apis;
+
+namespace {
+
+const std::string abi_v1 = R"=====(
+{
+   "version": "eosio::abi/1.0",
+   "types": [],
+   "structs": [ { "name": "hi", "base": "", "fields": [ { "name": "user", "type": "name" } ] } ],
+   "actions": [ { "name": "hi", "type": "hi", "ricardian_contract": "" } ],
+   "tables": []
+}
+)=====";
+
+const std::string abi_v2 = R"=====(
+{
+   "version": "eosio::abi/1.0",
+   "types": [],
+   "structs": [ { "name": "bye", "base": "", "fields": [ { "name": "user", "type": "name" } ] } ],
+   "actions": [ { "name": "bye", "type": "bye", "ricardian_contract": "" } ],
+   "tables": []
+}
+)=====";
+
+const fc::microseconds max_time = fc::seconds(10);
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(abi_cache_tests)
+
+BOOST_FIXTURE_TEST_CASE(hit_and_miss_test, validating_tester) { try {
+   abi_cache cache(1024 * 1024);
+
+   create_account("alice"_n);
+   create_account("bob"_n);
+   set_abi("alice"_n, abi_v1);
+   produce_block();
+
+   auto abis = cache.get(*control, "alice"_n, max_time);
+   BOOST_REQUIRE(abis);
+   BOOST_TEST(abis->get_action_type("hi"_n) == "hi");
+   BOOST_TEST(cache.get_stats().misses == 1u);
+
+   // second lookup returns the same parsed serializer
+   BOOST_TEST(cache.get(*control, "alice"_n, max_time) == abis);
+   BOOST_TEST(cache.get_stats().hits == 1u);
+   BOOST_TEST(cache.get_stats().entries == 1u);
+
+   // the parsed serializer is charged, not only the raw abi
+   BOOST_TEST(abis->memory_size() > abi_v1.size());
+   BOOST_TEST(cache.get_stats().bytes >= abis->memory_size());
+
+   // account without abi and missing account
+   BOOST_TEST(!cache.get(*control, "bob"_n, max_time));
+   BOOST_TEST(!cache.get(*control, "bob"_n, max_time));
+   BOOST_TEST(!cache.get(*control, "nobody"_n, max_time));
+   BOOST_TEST(cache.get_stats().hits == 2u);
+   BOOST_TEST(cache.get_stats().entries == 2u);
+
+   cache.clear();
+   BOOST_TEST(cache.get_stats().entries == 0u);
+   BOOST_TEST(cache.get_stats().bytes == 0u);
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_FIXTURE_TEST_CASE(setabi_test, validating_tester) { try {
+   abi_cache cache(1024 * 1024);
+
+   create_account("alice"_n);
+   set_abi("alice"_n, abi_v1);
+   produce_block();
+
+   auto v1 = cache.get(*control, "alice"_n, max_time);
+   BOOST_REQUIRE(v1);
+
+   set_abi("alice"_n, abi_v2);
+   produce_block();
+
+   auto v2 = cache.get(*control, "alice"_n, max_time);
+   BOOST_REQUIRE(v2);
+   BOOST_TEST(v2 != v1);
+   BOOST_TEST(v2->get_action_type("hi"_n) == "");
+   BOOST_TEST(v2->get_action_type("bye"_n) == "bye");
+   BOOST_TEST(cache.get_stats().misses == 2u);
+
+   // setabi in a block that is forked out must not leave a stale serializer behind
+   set_abi("alice"_n, abi_v1);
+   auto speculative = cache.get(*control, "alice"_n, max_time);
+   BOOST_REQUIRE(speculative);
+   BOOST_TEST(speculative->get_action_type("hi"_n) == "hi");
+   control->abort_block();
+
+   auto after_abort = cache.get(*control, "alice"_n, max_time);
+   BOOST_REQUIRE(after_abort);
+   BOOST_TEST(after_abort->get_action_type("bye"_n) == "bye");
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_FIXTURE_TEST_CASE(eviction_test, validating_tester) { try {
+   std::vector<account_name> accounts;
+   for (char c = 'a'; c <= 'z'; ++c) {
+      accounts.emplace_back(std::string("acct") + c);
+      create_account(accounts.back());
+      set_abi(accounts.back(), abi_v1);
+   }
+   produce_block();
+
+   abi_cache probe(1024 * 1024);
+   BOOST_REQUIRE(probe.get(*control, accounts.front(), max_time));
+   const size_t entry_bytes = probe.get_stats().bytes;
+
+   // room for only two abis in each of the 16 shards
+   const size_t max_bytes = 16 * 2 * entry_bytes;
+   abi_cache cache(max_bytes);
+
+   for (const auto& a : accounts)
+      BOOST_TEST(!!cache.get(*control, a, max_time));
+
+   const auto stats = cache.get_stats();
+   BOOST_TEST(stats.bytes <= max_bytes);
+   BOOST_TEST(stats.entries + stats.evictions == accounts.size());
+
+   // an evicted abi is parsed again on demand
+   for (const auto& a : accounts)
+      BOOST_TEST(cache.get(*control, a, max_time)->get_action_type("hi"_n) == "hi");
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_FIXTURE_TEST_CASE(concurrent_get_test, validating_tester) { try {
+   abi_cache cache(1024 * 1024);
+
+   create_account("alice"_n);
+   set_abi("alice"_n, abi_v1);
+   produce_block();
+
+   std::vector<std::thread> threads;
+   std::atomic<uint32_t> found = 0;
+   for (size_t i = 0; i < 8; ++i) {
+      threads.emplace_back([&]() {
+         for (size_t j = 0; j < 100; ++j) {
+            if (auto abis = cache.get(*control, "alice"_n, max_time); abis && abis->get_action_type("hi"_n) == "hi")
+               ++found;
+         }
+      });
+   }
+   for (auto& t : threads)
+      t.join();
+
+   BOOST_TEST(found == 800u);
+   BOOST_TEST(cache.get_stats().hits + cache.get_stats().misses == 800u);
+   BOOST_TEST(cache.get_stats().entries == 1u);
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -143,6 +143,132 @@ BOOST_FIXTURE_TEST_CASE(updateauth_test_multi_threaded, validating_tester) { try
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_FIXTURE_TEST_CASE(persist_test, validating_tester) { try {
+   fc::temp_directory temp_dir;
+   const auto persist_file = temp_dir.path() / "account_query_db.dat";
+
+   const auto tester_account = "tester"_n;
+   const auto tester_account2 = "tester2"_n;
+   const string role = "first";
+
+   {
+      auto aq_db = account_query_db(*control, persist_file);
+      auto c = control->accepted_block.connect([&](const block_signal_params& t) {
+         const auto& [ block, id ] = t;
+         aq_db.commit_block( block );
+      });
+      auto c2 = control->applied_transaction.connect([&](std::tuple<const transaction_trace_ptr&, const packed_transaction_ptr&> t) {
+         aq_db.cache_transaction_trace( std::get<0>(t) );
+      });
+
+      produce_blocks(10);
+      create_account(tester_account);
+      push_action(config::system_account_name, updateauth::get_name(), tester_account, fc::mutable_variant_object()
+            ("account", tester_account)
+            ("permission", "role"_n)
+            ("parent", "active")
+            ("auth",  authority(get_public_key(tester_account, role), 5))
+      );
+      produce_block();
+
+      aq_db.close();
+   }
+   BOOST_TEST_REQUIRE(std::filesystem::exists(persist_file));
+
+   params pars;
+   pars.keys.emplace_back(get_public_key(tester_account, role));
+   pars.keys.emplace_back(get_public_key(tester_account2, role));
+
+   {
+      // same head, loaded from the file which is kept
+      auto aq_db = account_query_db(*control, persist_file);
+      BOOST_TEST(std::filesystem::exists(persist_file));
+      const auto results = aq_db.get_accounts_by_authorizers(pars);
+      BOOST_TEST_REQUIRE(find_account_auth(results, tester_account, "role"_n) == true);
+      BOOST_TEST_REQUIRE(find_account_auth(results, tester_account2, "role"_n) == false);
+      aq_db.close();
+   }
+
+   // advance the chain while no account query DB is attached
+   create_account(tester_account2);
+   push_action(config::system_account_name, updateauth::get_name(), tester_account2, fc::mutable_variant_object()
+         ("account", tester_account2)
+         ("permission", "role"_n)
+         ("parent", "active")
+         ("auth",  authority(get_public_key(tester_account2, role), 5))
+   );
+   produce_block();
+
+   {
+      // different head, the permissions added since the file was written are built from the chain state
+      auto aq_db = account_query_db(*control, persist_file);
+      const auto results = aq_db.get_accounts_by_authorizers(pars);
+      BOOST_TEST_REQUIRE(find_account_auth(results, tester_account, "role"_n) == true);
+      BOOST_TEST_REQUIRE(find_account_auth(results, tester_account2, "role"_n) == true);
+   }
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_FIXTURE_TEST_CASE(checkpoint_test, validating_tester) { try {
+   fc::temp_directory temp_dir;
+   const auto persist_file = temp_dir.path() / "account_query_db.dat";
+
+   const auto tester_account = "tester"_n;
+   const auto tester_account2 = "tester2"_n;
+   const string role = "first";
+   const string role2 = "second";
+
+   create_account(tester_account);
+   create_account(tester_account2);
+   auto set_role = [&](name account, const string& key_role) {
+      push_action(config::system_account_name, updateauth::get_name(), account, fc::mutable_variant_object()
+            ("account", account)
+            ("permission", "role"_n)
+            ("parent", "active")
+            ("auth",  authority(get_public_key(account, key_role), 5))
+      );
+   };
+
+   {
+      auto aq_db = account_query_db(*control, persist_file, 5);
+      auto c = control->accepted_block.connect([&](const block_signal_params& t) {
+         const auto& [ block, id ] = t;
+         aq_db.commit_block( block );
+      });
+      auto c2 = control->applied_transaction.connect([&](std::tuple<const transaction_trace_ptr&, const packed_transaction_ptr&> t) {
+         aq_db.cache_transaction_trace( std::get<0>(t) );
+      });
+
+      set_role(tester_account, role);
+      set_role(tester_account2, role);
+      produce_blocks(10);
+      // not closed, as after a crash only the last checkpoint was written
+   }
+   BOOST_TEST_REQUIRE(std::filesystem::exists(persist_file));
+
+   // update and delete permissions written to the checkpoint while no account query DB is attached
+   set_role(tester_account, role2);
+   push_action(config::system_account_name, deleteauth::get_name(), tester_account2, fc::mutable_variant_object()
+         ("account", tester_account2)
+         ("permission", "role"_n)
+   );
+   produce_block();
+
+   params pars;
+   pars.keys.emplace_back(get_public_key(tester_account, role));
+   pars.keys.emplace_back(get_public_key(tester_account2, role));
+   auto aq_db = account_query_db(*control, persist_file);
+   auto results = aq_db.get_accounts_by_authorizers(pars);
+   BOOST_TEST_REQUIRE(find_account_auth(results, tester_account, "role"_n) == false);
+   BOOST_TEST_REQUIRE(find_account_auth(results, tester_account2, "role"_n) == false);
+
+   pars.keys.clear();
+   pars.keys.emplace_back(get_public_key(tester_account, role2));
+   results = aq_db.get_accounts_by_authorizers(pars);
+   BOOST_TEST_REQUIRE(find_account_auth(results, tester_account, "role"_n) == true);
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE(future_fork_test) { try {
    tester node_a(setup_policy::none);
    tester node_b(setup_policy::none);
@@ -362,6 +362,9 @@ namespace eosio {
              "Maximum number of requests http_plugin should use for processing http requests. 503 error response when exceeded." )
             ("http-max-response-time-ms", bpo::value<int64_t>()->default_value(15),
              "Maximum time on main thread for processing a request, -1 for unlimited")
+            ("http-response-chunk-size-kb", bpo::value<uint32_t>()->default_value(my->plugin_state->response_chunk_size / 1024),
+             "JSON responses estimated larger than this are sent as a chunked body of chunks of about this size while being serialized, "
+             "instead of serializing the complete response first. 0 to disable.")
             ("verbose-http-errors", bpo::bool_switch()->default_value(false),
              "Append the error log to HTTP responses")
             ("http-validate-host", boost::program_options::value<bool>()->default_value(true),
@@ -400,6 +403,8 @@ namespace eosio {
          my->plugin_state->max_response_time = max_reponse_time_ms == -1 ?
                fc::microseconds::maximum() : fc::microseconds( max_reponse_time_ms * 1000 );
 
+         my->plugin_state->response_chunk_size = size_t(options.at("http-response-chunk-size-kb").as<uint32_t>()) * 1024;
+
          my->plugin_state->validate_host = options.at("http-validate-host").as<bool>();
          if( options.count( "http-alias" )) {
             const auto& aliases = options["http-alias"].as<vector<string>>();
@@ -103,6 +103,31 @@ class beast_http_session : public detail::abstract_conn,
       }
    }
 
+   // a response written as a chunked body while it is being serialized, see send_streaming_response()
+   struct streaming_response {
+      std::shared_ptr<http_plugin_state>                          plugin_state;
+      size_t                                                      bytes_in_flight;
+      fc::variant                                                 response;
+      fc::json_chunk_writer                                       writer{response};
+      std::string                                                 chunk;
+      http::response<http::buffer_body>                           res;
+      std::optional<http::response_serializer<http::buffer_body>> sr;
+
+      streaming_response(std::shared_ptr<http_plugin_state> state, fc::variant&& v, size_t response_size)
+         : plugin_state(std::move(state))
+         , bytes_in_flight(response_size + plugin_state->response_chunk_size)
+         , response(std::move(v)) {
+         plugin_state->bytes_in_flight += bytes_in_flight;
+      }
+      ~streaming_response() { plugin_state->bytes_in_flight -= bytes_in_flight; }
+
+      // like the complete response, serialization is only bounded by the time given to build the response
+      void next_chunk() {
+         chunk.clear();
+         writer.write(chunk, plugin_state->response_chunk_size, fc::json::yield_function_t{});
+      }
+   };
+
    enum class continue_state_t { none, read_body, reject };
    continue_state_t continue_state_ { continue_state_t::none };
 
@@ -490,6 +515,56 @@ public:
          });
    }
 
+   virtual void send_streaming_response(fc::variant&& response, size_t response_size, unsigned int code) final {
+      auto stream = std::make_shared<streaming_response>(plugin_state_, std::move(response), response_size);
+      // serialize the first chunk before anything is sent, an exception can still be reported by handle_exception()
+      stream->next_chunk();
+
+      write_begin_ = steady_clock::now();
+      auto dt = write_begin_ - handle_begin_;
+      handle_time_us_ += std::chrono::duration_cast<std::chrono::microseconds>(dt).count();
+
+      res_->result(code);
+      res_->chunked(true);
+      bool close = !(plugin_state_->keep_alive) || res_->need_eof();
+      stream->res.base() = std::move(res_->base());
+      stream->sr.emplace(stream->res);
+
+      fc_dlog( plugin_state_->get_logger(), "Response: ${ep} ${b}",
+               ("ep", remote_endpoint_)("b", to_log_string(stream->res.base())) );
+
+      write_chunk(std::move(stream), close);
+   }
+
+   // write the current chunk, serializing the next one once it has been sent
+   void write_chunk(std::shared_ptr<streaming_response> stream, bool close) {
+      auto& body = stream->res.body();
+      body.data = stream->chunk.empty() ? nullptr : stream->chunk.data();
+      body.size = stream->chunk.size();
+      body.more = !stream->writer.done();
+
+      http::async_write(
+         socket_,
+         *stream->sr,
+         [self = this->shared_from_this(), stream, close](beast::error_code ec, std::size_t bytes_transferred) mutable {
+            if(ec == http::error::need_buffer)
+               ec = {};
+            if(ec || stream->sr->is_done())
+               return self->on_write(ec, bytes_transferred, close);
+
+            try {
+               stream->next_chunk();
+            } catch(const fc::exception& e) {
+               fc_elog(self->plugin_state_->get_logger(), "fc::exception streaming response: ${w}", ("w", e.to_detail_string()));
+               return self->do_eof();
+            } catch(const std::exception& e) {
+               fc_elog(self->plugin_state_->get_logger(), "std::exception streaming response: ${w}", ("w", e.what()));
+               return self->do_eof();
+            }
+            self->write_chunk(std::move(stream), close);
+         });
+   }
+
    void run_session() {
       if(auto error_str = verify_max_requests_in_flight(); !error_str.empty()) {
          res_->keep_alive(false);
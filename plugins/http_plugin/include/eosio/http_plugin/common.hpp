@@ -62,6 +62,8 @@ struct abstract_conn {
    virtual void handle_exception() = 0;
 
    virtual void send_response(std::string&& json_body, unsigned int code) = 0;
+   // response_size is the in flight size of response, which is released once it has been sent
+   virtual void send_streaming_response(fc::variant&& response, size_t response_size, unsigned int code) = 0;
 };
 
 using abstract_conn_ptr = std::shared_ptr<abstract_conn>;
@@ -121,6 +123,7 @@ struct http_plugin_state {
    size_t max_bytes_in_flight = 0;
    int32_t max_requests_in_flight = -1;
    fc::microseconds max_response_time{30 * 1000};
+   size_t response_chunk_size = 1024 * 1024; // 0 to never stream a response
 
    bool validate_host = true;
    set<string> valid_hosts;
@@ -146,7 +149,8 @@ struct http_plugin_state {
 
 /**
 * Construct a lambda appropriate for url_response_callback that will
-* JSON-stringify the provided response
+* JSON-stringify the provided response. A JSON response estimated larger than
+* response_chunk_size is streamed to the client as a chunked body.
 *
 * @param plugin_state - plugin state object, shared state of http_plugin
 * @param session_ptr - beast_http_session object on which to invoke send_response
@@ -160,7 +164,7 @@ inline auto make_http_response_handler(http_plugin_state& plugin_state, detail::
 
       // post back to an HTTP thread to allow the response handler to be called from any thread
       boost::asio::dispatch(plugin_state.thread_pool.get_executor(),
-                        [&plugin_state, session_ptr{std::move(session_ptr)}, code, payload_size, response = std::move(response), content_type]() {
+                        [&plugin_state, session_ptr{std::move(session_ptr)}, code, payload_size, response = std::move(response), content_type]() mutable {
                            auto on_exit = fc::scoped_exit<std::function<void()>>([&](){plugin_state.bytes_in_flight -= payload_size;});
 
                            if(auto error_str = session_ptr->verify_max_bytes_in_flight(0); !error_str.empty()) {
@@ -169,7 +173,10 @@ inline auto make_http_response_handler(http_plugin_state& plugin_state, detail::
                            }
 
                            try {
-                              if (response.has_value()) {
+                              if (response.has_value() && content_type == http_content_type::json &&
+                                  plugin_state.response_chunk_size > 0 && payload_size > plugin_state.response_chunk_size) {
+                                 session_ptr->send_streaming_response(std::move(*response), payload_size, code);
+                              } else if (response.has_value()) {
                                  std::string json = (content_type == http_content_type::plaintext) ? response->as_string() : fc::json::to_string(*response, fc::time_point::maximum());
                                  if (auto error_str = session_ptr->verify_max_bytes_in_flight(json.size()); error_str.empty())
                                     session_ptr->send_response(std::move(json), code);
@@ -11,6 +11,7 @@
 #include <boost/asio/local/stream_protocol.hpp>
 #include <fc/scoped_exit.hpp>
 #include <fc/crypto/rand.hpp>
+#include <fc/variant_object.hpp>
 
 #define BOOST_TEST_MODULE http_plugin unit tests
 #include <boost/test/included/unit_test.hpp>
@@ -716,5 +717,59 @@ BOOST_FIXTURE_TEST_CASE(requests_in_flight, http_plugin_test_fixture) {
    connections.clear();
 }
 
+BOOST_FIXTURE_TEST_CASE(streamed_response, http_plugin_test_fixture) {
+   http_plugin* http_plugin = init({"--plugin=eosio::http_plugin",
+                                    "--http-server-address=127.0.0.1:8893",
+                                    "--http-response-chunk-size-kb=16"});
+   BOOST_REQUIRE(http_plugin);
+
+   fc::variants rows;
+   for(uint64_t i = 0; i < 10000; ++i)
+      rows.emplace_back(fc::mutable_variant_object()("id", i << 33)("name", "row " + std::to_string(i))("tags", fc::variants{"a", "b\n"}));
+   const fc::variant large(fc::mutable_variant_object()("rows", rows)("more", false));
+   const std::string large_json = fc::json::to_string(large, fc::time_point::maximum());
+
+   http_plugin->add_api({{std::string("/large"), api_category::node,
+                          [&](string&&, string&& body, url_response_callback&& cb) {
+                             cb(200, large);
+                          }},
+                         {std::string("/small"), api_category::node,
+                          [&](string&&, string&& body, url_response_callback&& cb) {
+                             cb(200, fc::variant("small"));
+                          }}}, appbase::exec_queue::read_write);
+
+   boost::asio::io_context ctx;
+   boost::asio::ip::tcp::resolver resolver(ctx);
+   boost::asio::ip::tcp::socket s(ctx, boost::asio::ip::tcp::v4());
+   boost::asio::connect(s, resolver.resolve("127.0.0.1", "8893"));
+
+   auto request = [&](const char* target) {
+      boost::beast::http::request<boost::beast::http::empty_body> req(boost::beast::http::verb::get, target, 11);
+      req.keep_alive(true);
+      req.set(http::field::host, "127.0.0.1:8893");
+      boost::beast::http::write(s, req);
+
+      boost::beast::http::response<boost::beast::http::string_body> resp;
+      boost::beast::flat_buffer buffer;
+      boost::beast::http::read(s, buffer, resp);
+      return resp;
+   };
+
+   // streamed responses keep the connection alive, in between requests as well
+   for(unsigned i = 0; i < 2; ++i) {
+      auto resp = request("/large");
+      BOOST_REQUIRE_EQUAL(resp.result(), boost::beast::http::status::ok);
+      BOOST_CHECK(resp.chunked());
+      BOOST_CHECK(resp.keep_alive());
+      BOOST_CHECK_EQUAL(resp[http::field::content_type], "application/json");
+      BOOST_CHECK(resp.body() == large_json);
+
+      resp = request("/small");
+      BOOST_REQUIRE_EQUAL(resp.result(), boost::beast::http::status::ok);
+      BOOST_CHECK(!resp.chunked());
+      BOOST_CHECK_EQUAL(resp.body(), "\"small\"");
+   }
+}
+
 //A warning for future tests: destruction of http_plugin_test_fixture sometimes does not destroy http_plugin's listeners. Tests
 // added in the future should avoid reusing ports of other tests in http_plugin_unit_tests.
\ No newline at end of file
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <eosio/chain/block_header.hpp>
+#include <eosio/chain/types.hpp>
+#include <fc/mutex.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/mem_fun.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace eosio {
+
+struct block_buffer_state {
+   chain::block_id_type               id;
+   std::shared_ptr<std::vector<char>> buffer; // signed_block packed as a net_message, including the message header
+   std::shared_ptr<std::vector<char>> compressed_buffer; // for peers that support compression, may be buffer if not worth compressing
+   bool                               irreversible = false; // fetched by number from the irreversible block log
+
+   uint32_t block_num() const { return chain::block_header::num_from_id(id); }
+   const std::vector<char>* buffer_ptr() const { return buffer.get(); }
+   size_t size() const {
+      return buffer->size() + (compressed_buffer && compressed_buffer != buffer ? compressed_buffer->size() : 0);
+   }
+};
+
+/**
+ * Send buffers of blocks, shared by every connection the block is sent to so that a block is packed once for all of its
+ * broadcasts and sync requests. Holds the blocks of the fork database window, which are expired as lib moves, and the
+ * irreversible blocks served to syncing peers. When larger than max_size, the least recently used blocks are removed
+ * first, so the head blocks being broadcast and the blocks syncing peers are currently fetching stay cached.
+ *
+ * Buffers are created and compressed outside of the lock. All methods are thread safe.
+ */
+class block_buffer_cache {
+private:
+   struct by_lru;
+   struct by_block_num_id;
+   struct by_irreversible;
+   struct by_buffer;
+   using block_buffer_state_index = boost::multi_index_container<
+         block_buffer_state,
+         boost::multi_index::indexed_by<
+               boost::multi_index::sequenced<boost::multi_index::tag<by_lru>>, // front is most recently used
+               boost::multi_index::ordered_unique<boost::multi_index::tag<by_block_num_id>,
+                     boost::multi_index::composite_key<block_buffer_state,
+                           boost::multi_index::const_mem_fun<block_buffer_state, uint32_t, &block_buffer_state::block_num>,
+                           boost::multi_index::member<block_buffer_state, chain::block_id_type, &block_buffer_state::id>
+                     >,
+                     boost::multi_index::composite_key_compare<std::less<>, chain::sha256_less>
+               >,
+               boost::multi_index::ordered_non_unique<boost::multi_index::tag<by_irreversible>,
+                     boost::multi_index::composite_key<block_buffer_state,
+                           boost::multi_index::member<block_buffer_state, bool, &block_buffer_state::irreversible>,
+                           boost::multi_index::const_mem_fun<block_buffer_state, uint32_t, &block_buffer_state::block_num>
+                     >
+               >,
+               boost::multi_index::hashed_unique<boost::multi_index::tag<by_buffer>,
+                     boost::multi_index::const_mem_fun<block_buffer_state, const std::vector<char>*, &block_buffer_state::buffer_ptr>
+               >
+         >
+   >;
+
+   mutable fc::mutex        block_buffer_mtx;
+   block_buffer_state_index block_buffers GUARDED_BY(block_buffer_mtx);
+   size_t                   cache_size GUARDED_BY(block_buffer_mtx) {0};
+   size_t                   max_size GUARDED_BY(block_buffer_mtx);
+
+   std::atomic<uint64_t>    bytes_packed{0};
+   std::atomic<uint64_t>    bytes_sent{0};
+
+   template<typename Iterator>
+   void touch( const Iterator& itr ) REQUIRES(block_buffer_mtx) {
+      auto& lru = block_buffers.get<by_lru>();
+      lru.relocate( lru.begin(), block_buffers.project<by_lru>( itr ) );
+   }
+
+   void evict() REQUIRES(block_buffer_mtx) {
+      auto& lru = block_buffers.get<by_lru>();
+      while( cache_size > max_size && lru.size() > 1 ) {
+         cache_size -= lru.back().size();
+         lru.pop_back();
+      }
+   }
+
+   std::shared_ptr<std::vector<char>> insert( block_buffer_state&& state ) {
+      const bool irreversible = state.irreversible;
+      fc::lock_guard g( block_buffer_mtx );
+      auto& index = block_buffers.get<by_block_num_id>();
+      auto [itr, inserted] = index.insert( std::move(state) );
+      if( !inserted ) { // packed concurrently, or now fetched as irreversible
+         if( irreversible && !itr->irreversible )
+            index.modify( itr, []( auto& s ) { s.irreversible = true; } );
+         touch( itr );
+         return itr->buffer;
+      }
+      touch( itr );
+      auto buffer = itr->buffer;
+      cache_size += buffer->size();
+      evict();
+      return buffer;
+   }
+
+public:
+   // large enough for the fork database window of full blocks of a normally running chain
+   static constexpr size_t default_max_size = 256 * 1024 * 1024;
+
+   explicit block_buffer_cache( size_t max_size = default_max_size )
+      : max_size( max_size ) {}
+
+   void set_max_size( size_t size ) {
+      fc::lock_guard g( block_buffer_mtx );
+      max_size = size;
+      evict();
+   }
+
+   /// @return send buffer of block id, create_buffer() is called outside of the lock on a cache miss
+   template<typename F>
+   std::shared_ptr<std::vector<char>> get_send_buffer( const chain::block_id_type& id, F&& create_buffer ) {
+      {
+         fc::lock_guard g( block_buffer_mtx );
+         auto& index = block_buffers.get<by_block_num_id>();
+         auto itr = index.find( std::make_tuple( chain::block_header::num_from_id( id ), id ) );
+         if( itr != index.end() ) {
+            touch( itr );
+            return itr->buffer;
+         }
+      }
+      std::shared_ptr<std::vector<char>> buffer = create_buffer();
+      bytes_packed += buffer->size();
+      return insert( {id, std::move(buffer), {}, false} );
+   }
+
+   /// @return send buffer of irreversible block_num, fetch_buffer() returns the block id and buffer on a cache miss
+   template<typename F>
+   std::shared_ptr<std::vector<char>> get_irreversible_send_buffer( uint32_t block_num, F&& fetch_buffer ) {
+      {
+         fc::lock_guard g( block_buffer_mtx );
+         // reversible blocks of the same number may be on another fork
+         auto& index = block_buffers.get<by_irreversible>();
+         auto itr = index.find( std::make_tuple( true, block_num ) );
+         if( itr != index.end() ) {
+            touch( itr );
+            return itr->buffer;
+         }
+      }
+      std::optional<std::pair<chain::block_id_type, std::shared_ptr<std::vector<char>>>> fetched = fetch_buffer();
+      if( !fetched )
+         return {};
+      bytes_packed += fetched->second->size();
+      return insert( {fetched->first, std::move(fetched->second), {}, true} );
+   }
+
+   /// @return compressed send buffer of a buffer returned by get_send_buffer() or get_irreversible_send_buffer(),
+   ///         compress_buffer() is called outside of the lock on a cache miss
+   template<typename F>
+   std::shared_ptr<std::vector<char>> get_compressed_send_buffer( const std::shared_ptr<std::vector<char>>& buffer, F&& compress_buffer ) {
+      {
+         fc::lock_guard g( block_buffer_mtx );
+         auto& index = block_buffers.get<by_buffer>();
+         auto itr = index.find( buffer.get() );
+         if( itr != index.end() && itr->compressed_buffer ) {
+            touch( itr );
+            return itr->compressed_buffer;
+         }
+      }
+      std::shared_ptr<std::vector<char>> compressed = compress_buffer();
+      fc::lock_guard g( block_buffer_mtx );
+      auto& index = block_buffers.get<by_buffer>();
+      auto itr = index.find( buffer.get() );
+      if( itr == index.end() ) // evicted, not worth keeping
+         return compressed;
+      if( itr->compressed_buffer ) // compressed concurrently
+         return itr->compressed_buffer;
+      cache_size -= itr->size();
+      index.modify( itr, [&]( auto& s ) { s.compressed_buffer = compressed; } );
+      cache_size += itr->size();
+      evict();
+      return compressed;
+   }
+
+   void add_bytes_sent( size_t bytes ) { bytes_sent += bytes; }
+   uint64_t get_bytes_packed() const { return bytes_packed; }
+   uint64_t get_bytes_sent() const { return bytes_sent; }
+
+   // reversible blocks at or below lib are either irreversible now or on a dead fork
+   void expire_blocks( uint32_t lib_num ) {
+      fc::lock_guard g( block_buffer_mtx );
+      auto& index = block_buffers.get<by_irreversible>();
+      auto end = index.upper_bound( std::make_tuple( false, lib_num ) );
+      for( auto itr = index.lower_bound( false ); itr != end; ) {
+         cache_size -= itr->size();
+         itr = index.erase( itr );
+      }
+   }
+
+   size_t size() const {
+      fc::lock_guard g( block_buffer_mtx );
+      return block_buffers.size();
+   }
+
+   /// @return estimated bytes held
+   size_t memory_size() const {
+      fc::lock_guard g( block_buffer_mtx );
+      return cache_size;
+   }
+};
+
+} // namespace eosio
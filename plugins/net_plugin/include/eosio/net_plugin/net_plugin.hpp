@@ -80,11 +80,23 @@ namespace eosio {
            p2p_connections_metrics(p2p_connections_metrics&& statistics)
               : num_peers{std::move(statistics.num_peers)}
               , num_clients{std::move(statistics.num_clients)}
+              , block_bytes_packed{statistics.block_bytes_packed}
+              , block_bytes_sent{statistics.block_bytes_sent}
+              , trx_bytes_sent{statistics.trx_bytes_sent}
+              , trx_announce_bytes_sent{statistics.trx_announce_bytes_sent}
+              , trxs_requested{statistics.trxs_requested}
+              , duplicate_trxs_received{statistics.duplicate_trxs_received}
               , stats{std::move(statistics.stats)}
            {}
            p2p_connections_metrics(const p2p_connections_metrics&) = delete;
            std::size_t num_peers   = 0;
            std::size_t num_clients = 0;
+           std::size_t block_bytes_packed = 0; // blocks serialized into send buffers
+           std::size_t block_bytes_sent   = 0; // block send buffers queued to peers
+           std::size_t trx_bytes_sent     = 0; // transactions queued to peers
+           std::size_t trx_announce_bytes_sent = 0; // transaction id announcements and requests queued to peers
+           std::size_t trxs_requested     = 0; // announced transactions requested from peers
+           std::size_t duplicate_trxs_received = 0; // transactions received that were already known
            p2p_per_connection_metrics stats;
         };
 
@@ -2,6 +2,11 @@
 
 #include <eosio/chain/exceptions.hpp>
 
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/zstd.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+
 #include <string>
 #include <sstream>
 #include <regex>
@@ -64,4 +69,40 @@ namespace detail {
       return {listen_addr, block_sync_rate_limit};
    }
 
+   /// @return zstd compression of size bytes of data, level 1 - 22
+   inline std::vector<char> zstd_compress( const char* data, size_t size, int level ) {
+      namespace bio = boost::iostreams;
+      std::vector<char> out;
+      bio::filtering_ostream comp;
+      comp.push( bio::zstd_compressor( bio::zstd_params( level ) ) );
+      comp.push( bio::back_inserter( out ) );
+      bio::write( comp, data, size );
+      bio::close( comp );
+      return out;
+   }
+
+   /// @throws plugin_exception if data is not zstd compressed or decompresses to more than max_size bytes
+   inline std::vector<char> zstd_decompress( const std::vector<char>& data, size_t max_size ) {
+      namespace bio = boost::iostreams;
+      constexpr size_t read_size = 64*1024;
+      std::vector<char> out;
+      try {
+         bio::filtering_istream decomp;
+         decomp.push( bio::zstd_decompressor() );
+         decomp.push( bio::array_source( data.data(), data.size() ) );
+         decomp.exceptions( std::ios::badbit );
+         while( decomp ) {
+            const size_t size = out.size();
+            out.resize( size + read_size );
+            decomp.read( out.data() + size, read_size );
+            out.resize( size + decomp.gcount() );
+            EOS_ASSERT( out.size() <= max_size, chain::plugin_exception,
+                        "compressed message larger than ${max} bytes", ("max", max_size) );
+         }
+      } catch( const std::ios_base::failure& e ) {
+         EOS_THROW( chain::plugin_exception, "invalid compressed message: ${e}", ("e", e.what()) );
+      }
+      return out;
+   }
+
 } // namespace eosio::net_utils
\ No newline at end of file
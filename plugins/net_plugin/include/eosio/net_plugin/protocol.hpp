@@ -134,6 +134,12 @@ namespace eosio {
       uint32_t end_block{0};
    };
 
+   /// signed_block or packed_transaction sent zstd compressed to peers of network version proto_compression or later
+   struct compressed_message {
+      fc::unsigned_int  which; ///< net_message index of the compressed message
+      std::vector<char> data;  ///< zstd compressed fc::raw::pack of the message
+   };
+
    using net_message = std::variant<handshake_message,
                                     chain_size_message,
                                     go_away_message,
@@ -142,7 +148,8 @@ namespace eosio {
                                     request_message,
                                     sync_request_message,
                                     signed_block,         // which = 7
-                                    packed_transaction>;  // which = 8
+                                    packed_transaction,   // which = 8
+                                    compressed_message>;  // which = 9
 
 } // namespace eosio
 
@@ -161,6 +168,7 @@ FC_REFLECT( eosio::time_message, (org)(rec)(xmt)(dst) )
 FC_REFLECT( eosio::notice_message, (known_trx)(known_blocks) )
 FC_REFLECT( eosio::request_message, (req_trx)(req_blocks) )
 FC_REFLECT( eosio::sync_request_message, (start_block)(end_block) )
+FC_REFLECT( eosio::compressed_message, (which)(data) )
 
 /**
  *
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+#include <fc/time.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/member.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace eosio {
+
+/**
+ * Transactions announced by id and requested from one of the peers that announced them, until they are received.
+ *
+ * A transaction is requested from the first peer to announce it. If it is not received within the timeout, or that
+ * peer's connection closes, it is requested from the next peer that announced it, in the order they announced it.
+ * Once no peer that announced it is left it is no longer tracked, a later announcement requests it again.
+ *
+ * Not thread safe.
+ */
+class trx_request_tracker {
+public:
+   using transaction_id_type = chain::transaction_id_type;
+
+   struct request {
+      uint32_t            connection_id = 0;
+      transaction_id_type id;
+   };
+
+   explicit trx_request_tracker(fc::microseconds timeout)
+      : timeout(timeout) {}
+
+   /// id was announced by connection_id and is not known
+   /// @return true if it should be requested from connection_id now, false if it is already requested from another
+   ///         peer, connection_id is then next in line
+   bool announced(const transaction_id_type& id, uint32_t connection_id, const fc::time_point& now) {
+      auto it = index.find(id);
+      if (it == index.end()) {
+         index.insert(request_state{ .id = id, .connection_id = connection_id, .deadline = now + timeout });
+         return true;
+      }
+      if (it->connection_id != connection_id &&
+          std::find(it->announcers.begin(), it->announcers.end(), connection_id) == it->announcers.end()) {
+         index.modify(it, [connection_id](request_state& s) { s.announcers.push_back(connection_id); });
+      }
+      return false;
+   }
+
+   /// id is known, no longer request it
+   void received(const transaction_id_type& id) {
+      if (!index.empty())
+         index.erase(id);
+   }
+
+   /// requests of connection_id are due for the next peer, and it is no longer next in line for others
+   void connection_closed(uint32_t connection_id, const fc::time_point& now) {
+      for (auto it = index.begin(); it != index.end(); ++it) {
+         index.modify(it, [&](request_state& s) {
+            if (s.connection_id == connection_id)
+               s.deadline = std::min(s.deadline, now);
+            s.announcers.erase(std::remove(s.announcers.begin(), s.announcers.end(), connection_id), s.announcers.end());
+         });
+      }
+   }
+
+   /// @return the requests due at now, each to the next peer that announced it; transactions no peer left announced
+   ///         are dropped
+   std::vector<request> retry(const fc::time_point& now) {
+      std::vector<request> retries;
+      auto& by_due = index.get<by_deadline>();
+      for (auto it = by_due.begin(); it != by_due.end() && it->deadline <= now; it = by_due.begin()) {
+         if (it->announcers.empty()) {
+            by_due.erase(it);
+            continue;
+         }
+         by_due.modify(it, [&](request_state& s) {
+            s.connection_id = s.announcers.front();
+            s.announcers.erase(s.announcers.begin());
+            s.deadline = now + timeout;
+         });
+         retries.push_back(request{ .connection_id = it->connection_id, .id = it->id });
+      }
+      return retries;
+   }
+
+   size_t size() const { return index.size(); }
+
+private:
+   struct request_state {
+      transaction_id_type   id;
+      uint32_t              connection_id = 0; ///< requested from
+      fc::time_point        deadline;          ///< to receive it from connection_id
+      std::vector<uint32_t> announcers;        ///< not yet requested from, in the order they announced it
+   };
+
+   struct by_deadline;
+   using index_type = boost::multi_index_container<
+      request_state,
+      boost::multi_index::indexed_by<
+         boost::multi_index::hashed_unique<
+            boost::multi_index::member<request_state, transaction_id_type, &request_state::id>,
+            std::hash<transaction_id_type>
+         >,
+         boost::multi_index::ordered_non_unique<boost::multi_index::tag<by_deadline>,
+            boost::multi_index::member<request_state, fc::time_point, &request_state::deadline>>
+      >
+   >;
+
+   const fc::microseconds timeout;
+   index_type             index;
+};
+
+} // namespace eosio
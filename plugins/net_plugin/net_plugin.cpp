@@ -2,6 +2,8 @@
 #include <eosio/net_plugin/protocol.hpp>
 #include <eosio/net_plugin/net_utils.hpp>
 #include <eosio/net_plugin/auto_bp_peering.hpp>
+#include <eosio/net_plugin/trx_request_tracker.hpp>
+#include <eosio/net_plugin/block_buffer_cache.hpp>
 #include <eosio/chain/types.hpp>
 #include <eosio/chain/controller.hpp>
 #include <eosio/chain/exceptions.hpp>
@@ -26,6 +28,7 @@
 #include <boost/asio/ip/host_name.hpp>
 #include <boost/asio/steady_timer.hpp>
 #include <boost/multi_index/key.hpp>
+#include <boost/multi_index/hashed_index.hpp>
 
 #include <atomic>
 #include <cmath>
@@ -102,6 +105,7 @@ namespace eosio {
       transaction_id_type id;
       time_point_sec  expires;        /// time after which this may be purged.
       uint32_t        connection_id = 0;
+      bool            announced = false; /// id announced by connection_id, transaction not received or sent
    };
 
    struct by_expiry;
@@ -124,6 +128,27 @@ namespace eosio {
       >
    node_transaction_index;
 
+   struct announced_trx_state {
+      transaction_id_type    id;
+      time_point_sec         expires;
+      packed_transaction_ptr trx;
+   };
+
+   typedef multi_index_container<
+      announced_trx_state,
+      indexed_by<
+         ordered_unique<
+            tag<by_id>,
+            member<announced_trx_state, transaction_id_type, &announced_trx_state::id>,
+            sha256_less
+         >,
+         ordered_non_unique<
+            tag< by_expiry >,
+            member< announced_trx_state, fc::time_point_sec, &announced_trx_state::expires > >
+         >
+      >
+   announced_trx_index;
+
    struct peer_block_state {
       block_id_type id;
       uint32_t      connection_id = 0;
@@ -150,6 +175,7 @@ namespace eosio {
    struct unlinkable_block_state {
       block_id_type    id;
       signed_block_ptr block;
+      connection_ptr   conn; // received from
 
       uint32_t block_num() const { return block_header::num_from_id(id); }
       const block_id_type& prev() const { return block->previous; }
@@ -187,13 +213,20 @@ namespace eosio {
       // almost immediately (blocks came in from multiple peers out of order). 30 allows for one block per
       // producer round until lib. When queue larger than max, remove by block timestamp farthest in the past.
       static constexpr size_t max_unlinkable_cache_size = 30;
+      // while syncing, blocks received ahead of the blocks they link to are held here as well
+      size_t                       max_cache_size GUARDED_BY(unlinkable_blk_state_mtx) = max_unlinkable_cache_size;
 
    public:
+      void set_max_blocks_ahead( size_t blocks ) {
+         fc::lock_guard g(unlinkable_blk_state_mtx);
+         max_cache_size = max_unlinkable_cache_size + blocks;
+      }
+
       // returns block id of any block removed because of a full cache
-      std::optional<block_id_type> add_unlinkable_block( signed_block_ptr b, const block_id_type& id ) {
+      std::optional<block_id_type> add_unlinkable_block( signed_block_ptr b, const block_id_type& id, connection_ptr c ) {
          fc::lock_guard g(unlinkable_blk_state_mtx);
-         unlinkable_blk_state.insert( {id, std::move(b)} ); // does not insert if already there
-         if (unlinkable_blk_state.size() > max_unlinkable_cache_size) {
+         unlinkable_blk_state.insert( {id, std::move(b), std::move(c)} ); // does not insert if already there
+         if (unlinkable_blk_state.size() > max_cache_size) {
             auto& index = unlinkable_blk_state.get<by_timestamp>();
             auto begin = index.begin();
             block_id_type rm_block_id = begin->id;
@@ -215,6 +248,42 @@ namespace eosio {
          return {};
       }
 
+      // blocks numbered after blkid that are left once the blocks linking to blkid are popped do not link. Removes
+      // them, and the blocks received after them from the same connections which link to them.
+      // returns the removed blocks numbered after blkid
+      std::vector<unlinkable_block_state> pop_unlinked_blocks(const block_id_type& blkid) {
+         fc::lock_guard g(unlinkable_blk_state_mtx);
+         auto& index = unlinkable_blk_state.get<by_block_num_id>();
+         const uint32_t blk_num = block_header::num_from_id(blkid) + 1;
+         std::vector<unlinkable_block_state> result;
+         for (auto i = index.lower_bound(blk_num); i != index.end() && i->block_num() == blk_num; i = index.erase(i)) {
+            result.push_back(*i);
+         }
+         if (!result.empty()) {
+            for (auto i = index.lower_bound(blk_num); i != index.end();) {
+               if (std::any_of(result.begin(), result.end(), [&](const auto& r) { return r.conn == i->conn; })) {
+                  i = index.erase(i);
+               } else {
+                  ++i;
+               }
+            }
+         }
+         return result;
+      }
+
+      // removes the blocks received from c
+      void rm_blocks( const connection_ptr& c ) {
+         fc::lock_guard g(unlinkable_blk_state_mtx);
+         auto& index = unlinkable_blk_state.get<by_block_num_id>();
+         for (auto i = index.begin(); i != index.end();) {
+            if (i->conn == c) {
+               i = index.erase(i);
+            } else {
+               ++i;
+            }
+         }
+      }
+
       void expire_blocks( uint32_t lib_num ) {
          fc::lock_guard g(unlinkable_blk_state_mtx);
          auto& stale_blk = unlinkable_blk_state.get<by_block_num_id>();
@@ -230,15 +299,23 @@ namespace eosio {
          in_sync
       };
 
+      struct sync_range {
+         uint32_t       end = 0;   // last block number of the range, inclusive
+         uint32_t       next = 0;  // next block number expected from conn
+         connection_ptr conn;      // peer the range is requested from, empty when it needs to be requested again
+         fc::time_point requested; // when requested from conn
+      };
+
       alignas(hardware_destructive_interference_size)
       fc::mutex      sync_mtx;
       uint32_t       sync_known_lib_num      GUARDED_BY(sync_mtx) {0};  // highest known lib num from currently connected peers
       uint32_t       sync_last_requested_num GUARDED_BY(sync_mtx) {0};  // end block number of the last requested range, inclusive
-      uint32_t       sync_next_expected_num  GUARDED_BY(sync_mtx) {0};  // the next block number we need from peer
-      connection_ptr sync_source             GUARDED_BY(sync_mtx);      // connection we are currently syncing from
+      uint32_t       sync_next_expected_num  GUARDED_BY(sync_mtx) {0};  // the next block number we need from peers
+      std::map<uint32_t, sync_range> sync_ranges GUARDED_BY(sync_mtx); // ranges not fully received by first block number, one per peer
 
       const uint32_t sync_req_span {0};
       const uint32_t sync_peer_limit {0};
+      const uint32_t sync_fetch_ranges {0};
 
       alignas(hardware_destructive_interference_size)
       std::atomic<stages> sync_state{in_sync};
@@ -255,18 +332,27 @@ namespace eosio {
       bool set_state( stages newstate );
       bool is_sync_required( uint32_t fork_head_block_num ); // call with locked mutex
       void request_next_chunk( const connection_ptr& conn = connection_ptr() ) REQUIRES(sync_mtx);
-      connection_ptr find_next_sync_node(); // call with locked mutex
+      connection_ptr find_next_sync_node( uint32_t start ) REQUIRES(sync_mtx);
+      size_t assigned_ranges() const REQUIRES(sync_mtx);
+      bool has_range( const connection_ptr& c ) const REQUIRES(sync_mtx);
+      bool release_ranges( const connection_ptr& c ) REQUIRES(sync_mtx);
+      bool can_request_range( uint32_t head_num ) const REQUIRES(sync_mtx);
+      void sync_recv_range_block( const connection_ptr& c, uint32_t blk_num ) REQUIRES(sync_mtx);
+      void reassign_slow_range( const connection_ptr& c, uint32_t range_blocks, fc::microseconds range_time ) REQUIRES(sync_mtx);
       void start_sync( const connection_ptr& c, uint32_t target ); // locks mutex
       bool verify_catchup( const connection_ptr& c, uint32_t num, const block_id_type& id ); // locks mutex
 
    public:
-      explicit sync_manager( uint32_t span, uint32_t sync_peer_limit, uint32_t min_blocks_distance );
+      explicit sync_manager( uint32_t span, uint32_t sync_peer_limit, uint32_t sync_fetch_ranges, uint32_t min_blocks_distance );
       static void send_handshakes();
       bool syncing_from_peer() const { return sync_state == lib_catchup; }
+      // most blocks received ahead of head while syncing, held until the blocks before them are received
+      uint32_t max_blocks_ahead() const { return (sync_fetch_ranges + 1) * sync_req_span; }
       bool is_in_sync() const { return sync_state == in_sync; }
       void sync_reset_lib_num( const connection_ptr& conn, bool closing );
       void sync_reassign_fetch( const connection_ptr& c, go_away_reason reason );
       void rejected_block( const connection_ptr& c, uint32_t blk_num );
+      void unlinked_block( const connection_ptr& c, uint32_t blk_num );
       void sync_recv_block( const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num, bool blk_applied );
       void recv_handshake( const connection_ptr& c, const handshake_message& msg, uint32_t nblk_combined_latency );
       void sync_recv_notice( const connection_ptr& c, const notice_message& msg );
@@ -280,14 +366,26 @@ namespace eosio {
       alignas(hardware_destructive_interference_size)
       mutable fc::mutex      local_txns_mtx;
       node_transaction_index  local_txns GUARDED_BY(local_txns_mtx);
+      trx_request_tracker     trx_requests GUARDED_BY(local_txns_mtx);
+
+      // transactions announced by id, kept to be sent to the peers that request them
+      alignas(hardware_destructive_interference_size)
+      mutable fc::mutex      announced_trxs_mtx;
+      announced_trx_index     announced_trxs GUARDED_BY(announced_trxs_mtx);
 
       unlinkable_block_state_cache unlinkable_block_cache;
 
    public:
       boost::asio::io_context::strand  strand;
+      alignas(hardware_destructive_interference_size)
+      block_buffer_cache               block_buffers;
+
+      std::atomic<uint64_t>            trx_bytes_sent{0};          // transactions queued to peers
+      std::atomic<uint64_t>            trx_announce_bytes_sent{0}; // transaction id announcements and requests queued to peers
+      std::atomic<uint64_t>            trxs_requested{0};          // announced transactions requested from peers
+      std::atomic<uint64_t>            duplicate_trxs_received{0}; // transactions received that were already known
 
-      explicit dispatch_manager(boost::asio::io_context& io_context)
-      : strand( io_context ) {}
+      explicit dispatch_manager(boost::asio::io_context& io_context);
 
       void bcast_transaction(const packed_transaction_ptr& trx);
       void rejected_transaction(const packed_transaction_ptr& trx);
@@ -307,11 +405,18 @@ namespace eosio {
 
       bool add_peer_txn( const transaction_id_type& id, const time_point_sec& trx_expires, uint32_t connection_id,
                          const time_point_sec& now = time_point_sec(time_point::now()) );
+      bool add_announced_txn( const transaction_id_type& id, uint32_t connection_id, const time_point& now );
+      std::vector<trx_request_tracker::request> retry_announced_txns( const time_point& now );
+      void rm_announced_txns( uint32_t connection_id );
       bool have_txn( const transaction_id_type& tid ) const;
       void expire_txns();
 
-      void add_unlinkable_block( signed_block_ptr b, const block_id_type& id ) {
-         std::optional<block_id_type> rm_blk_id = unlinkable_block_cache.add_unlinkable_block(std::move(b), id);
+      void add_announced_trx( const packed_transaction_ptr& trx, const time_point_sec& now );
+      packed_transaction_ptr get_announced_trx( const transaction_id_type& id ) const;
+
+      void set_max_blocks_ahead( size_t blocks ) { unlinkable_block_cache.set_max_blocks_ahead( blocks ); }
+      void add_unlinkable_block( signed_block_ptr b, const block_id_type& id, connection_ptr c ) {
+         std::optional<block_id_type> rm_blk_id = unlinkable_block_cache.add_unlinkable_block(std::move(b), id, std::move(c));
          if (rm_blk_id) {
             // rm_block since we are no longer tracking this not applied block, allowing it to flow back in if needed
             rm_block(*rm_blk_id);
@@ -320,6 +425,14 @@ namespace eosio {
       unlinkable_block_state pop_possible_linkable_block( const block_id_type& blkid ) {
          return unlinkable_block_cache.pop_possible_linkable_block(blkid);
       }
+      std::vector<unlinkable_block_state> pop_unlinked_blocks( const block_id_type& blkid ) {
+         return unlinkable_block_cache.pop_unlinked_blocks(blkid);
+      }
+      void rm_unlinkable_blocks( const connection_ptr& c ) { unlinkable_block_cache.rm_blocks( c ); }
+
+      // last block header accepted while syncing, 0 until one is accepted after the sync started.
+      // only accessed from dispatcher strand
+      uint32_t sync_accepted_header_num = 0;
    };
 
    /**
@@ -337,10 +450,15 @@ namespace eosio {
    constexpr auto     def_resp_expected_wait = std::chrono::seconds(5);
    constexpr auto     def_sync_fetch_span = 1000;
    constexpr auto     def_keepalive_interval = 10000;
+   constexpr auto     def_compression_threshold = 1024; // bytes, smaller blocks and transactions are not worth compressing
+   constexpr auto     def_max_trx_announce_ids = 1000; // transaction ids per announcement or request
+   constexpr auto     def_trx_announce_interval = std::chrono::milliseconds(10); // collects ids into an announcement
+   constexpr auto     def_trx_request_timeout = std::chrono::seconds(1); // then requested from the next peer that announced it
 
    constexpr auto     message_header_size = sizeof(uint32_t);
    constexpr uint32_t signed_block_which       = fc::get_index<net_message, signed_block>();       // see protocol net_message
    constexpr uint32_t packed_transaction_which = fc::get_index<net_message, packed_transaction>(); // see protocol net_message
+   constexpr uint32_t compressed_message_which = fc::get_index<net_message, compressed_message>(); // see protocol net_message
 
    class connections_manager {
    public:
@@ -479,6 +597,9 @@ namespace eosio {
       uint32_t                              max_nodes_per_host = 1;
       bool                                  p2p_accept_transactions = true;
       fc::microseconds                      p2p_dedup_cache_expire_time_us{};
+      int                                   p2p_compression_level = 0; // zstd level, 0 sends uncompressed
+      bool                                  p2p_trx_announce = false;
+      uint32_t                              p2p_compression_threshold = def_compression_threshold;
 
       chain_id_type                         chain_id;
       fc::sha256                            node_id;
@@ -493,6 +614,10 @@ namespace eosio {
       fc::mutex                             expire_timer_mtx;
       boost::asio::steady_timer             expire_timer GUARDED_BY(expire_timer_mtx) {thread_pool.get_executor()};
 
+      alignas(hardware_destructive_interference_size)
+      fc::mutex                             trx_request_timer_mtx;
+      boost::asio::steady_timer             trx_request_timer GUARDED_BY(trx_request_timer_mtx) {thread_pool.get_executor()};
+
       alignas(hardware_destructive_interference_size)
       fc::mutex                             keepalive_timer_mtx;
       boost::asio::steady_timer             keepalive_timer GUARDED_BY(keepalive_timer_mtx) {thread_pool.get_executor()};
@@ -535,6 +660,7 @@ namespace eosio {
       void on_irreversible_block( const block_id_type& id, uint32_t block_num );
 
       void start_expire_timer();
+      void start_trx_request_timer();
       void start_monitors();
 
       // we currently pause on snapshot generation
@@ -546,6 +672,7 @@ namespace eosio {
       }
 
       void expire();
+      void retry_trx_requests();
       /** \name Peer Timestamps
        *  Time message handling
        *  @{
@@ -663,9 +790,11 @@ namespace eosio {
    constexpr uint16_t proto_dup_node_id_goaway = 6;        // eosio 2.1: support peer node_id based duplicate connection resolution
    constexpr uint16_t proto_leap_initial = 7;              // leap client, needed because none of the 2.1 versions are supported
    constexpr uint16_t proto_block_range = 8;               // include block range in notice_message
+   constexpr uint16_t proto_compression = 9;               // accepts compressed_message
+   constexpr uint16_t proto_trx_announce = 10;             // transaction ids in notice_message, requested by request_message
 #pragma GCC diagnostic pop
 
-   constexpr uint16_t net_version_max = proto_leap_initial;
+   constexpr uint16_t net_version_max = proto_trx_announce;
 
    /**
     * Index by start_block_num
@@ -846,6 +975,10 @@ namespace eosio {
       bool is_blocks_only_connection()const { return connection_type == blocks_only; }
       bool is_transactions_connection() const { return connection_type != blocks_only; } // thread safe, atomic
       bool is_blocks_connection() const { return connection_type != transactions_only; } // thread safe, atomic
+      // send blocks and transactions as compressed_message, thread safe, atomic
+      bool compress_messages() const { return my_impl->p2p_compression_level > 0 && protocol_version >= proto_compression; }
+      // announce transaction ids instead of sending transactions, thread safe, atomic
+      bool announce_trxs() const { return my_impl->p2p_trx_announce && protocol_version >= proto_trx_announce; }
       uint32_t get_peer_start_block_num() const { return peer_start_block_num.load(); }
       uint32_t get_peer_head_block_num() const { return peer_head_block_num.load(); }
       uint32_t get_last_received_block_num() const { return last_received_block_num.load(); }
@@ -945,6 +1078,10 @@ namespace eosio {
       fc::mutex                        response_expected_timer_mtx;
       boost::asio::steady_timer        response_expected_timer GUARDED_BY(response_expected_timer_mtx);
 
+      // transaction ids to announce, only accessed from connection strand
+      boost::asio::steady_timer        trx_announce_timer;
+      vector<transaction_id_type>      pending_trx_announce;
+
       alignas(hardware_destructive_interference_size)
       std::atomic<go_away_reason>      no_retry{no_reason};
 
@@ -993,6 +1130,11 @@ namespace eosio {
 
       bool process_next_block_message(uint32_t message_length);
       bool process_next_trx_message(uint32_t message_length);
+      bool process_next_compressed_message(uint32_t message_length);
+      bool accept_block_message(const block_header& bh, const block_id_type& blk_id, uint32_t message_length);
+      bool process_block_message(const block_id_type& blk_id, signed_block_ptr ptr);
+      bool accept_trx_message();
+      void process_trx_message(packed_transaction_ptr ptr);
       void update_endpoints(const tcp::endpoint& endpoint = tcp::endpoint());
    public:
 
@@ -1041,6 +1183,12 @@ namespace eosio {
       }
       /** @} */
 
+      void announce_trx( const transaction_id_type& id );
+      void send_trx_announce();
+      void request_announced_trxs( const vector<transaction_id_type>& ids );
+      void send_trx_request( const vector<transaction_id_type>& ids );
+      void send_requested_trxs( const vector<transaction_id_type>& ids );
+
       void blk_send_branch( const block_id_type& msg_head_id );
       void blk_send_branch( uint32_t msg_head_num, uint32_t lib_num, uint32_t head_num );
       void blk_send(const block_id_type& blkid);
@@ -1048,6 +1196,7 @@ namespace eosio {
 
       void enqueue( const net_message &msg );
       size_t enqueue_block( const signed_block_ptr& sb, bool to_sync_queue = false);
+      size_t enqueue_block( const std::shared_ptr<std::vector<char>>& send_buffer, bool to_sync_queue = false);
       void enqueue_buffer( const std::shared_ptr<std::vector<char>>& send_buffer,
                            go_away_reason close_after_send,
                            bool to_sync_queue = false);
@@ -1098,6 +1247,8 @@ namespace eosio {
       // returns calculated number of blocks combined latency
       uint32_t calc_block_latency();
 
+      void process_block_header( const block_id_type& id, signed_block_ptr ptr, int apply_priority );
+
       void process_signed_block( const block_id_type& id, signed_block_ptr block, block_state_legacy_ptr bsp );
 
       fc::variant_object get_logger_variant() const {
@@ -1260,6 +1411,7 @@ namespace eosio {
         log_p2p_address( endpoint ),
         connection_id( ++my_impl->current_connection_id ),
         response_expected_timer( my_impl->thread_pool.get_executor() ),
+        trx_announce_timer( my_impl->thread_pool.get_executor() ),
         last_handshake_recv(),
         last_handshake_sent(),
         p2p_address( endpoint )
@@ -1277,6 +1429,7 @@ namespace eosio {
         listen_address( listen_address ),
         connection_id( ++my_impl->current_connection_id ),
         response_expected_timer( my_impl->thread_pool.get_executor() ),
+        trx_announce_timer( my_impl->thread_pool.get_executor() ),
         last_handshake_recv(),
         last_handshake_sent()
    {
@@ -1460,6 +1613,9 @@ namespace eosio {
       if( !shutdown) my_impl->sync_master->sync_reset_lib_num( shared_from_this(), true );
       peer_ilog( this, "closing" );
       cancel_wait();
+      trx_announce_timer.cancel();
+      pending_trx_announce.clear();
+      my_impl->dispatcher.rm_announced_txns( connection_id );
       sync_last_requested_block = 0;
       org = std::chrono::nanoseconds{0};
       latest_msg_time = std::chrono::system_clock::time_point::min();
@@ -1732,60 +1888,6 @@ namespace eosio {
       }
    }
 
-   // called from connection strand
-   bool connection::enqueue_sync_block() {
-      if( !peer_requested ) {
-         return false;
-      } else {
-         peer_dlog( this, "enqueue sync block ${num}", ("num", peer_requested->last + 1) );
-      }
-      uint32_t num = peer_requested->last + 1;
-
-      controller& cc = my_impl->chain_plug->chain();
-      signed_block_ptr sb;
-      try {
-         sb = cc.fetch_block_by_number( num ); // thread-safe
-      } FC_LOG_AND_DROP();
-      if( sb ) {
-         // Skip transmitting block this loop if threshold exceeded
-         if (block_sync_send_start == 0ns) { // start of enqueue blocks
-            block_sync_send_start = get_time();
-            block_sync_frame_bytes_sent = 0;
-         }
-         if( block_sync_rate_limit > 0 && block_sync_frame_bytes_sent > 0 && peer_syncing_from_us ) {
-            auto now = get_time();
-            auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(now - block_sync_send_start);
-            double current_rate_sec = (double(block_sync_frame_bytes_sent) / elapsed_us.count()) * 100000; // convert from bytes/us => bytes/sec
-            peer_dlog(this, "start enqueue block time ${st}, now ${t}, elapsed ${e}, rate ${r}, limit ${l}",
-                      ("st", block_sync_send_start.count())("t", now.count())("e", elapsed_us.count())("r", current_rate_sec)("l", block_sync_rate_limit));
-            if( current_rate_sec >= block_sync_rate_limit ) {
-               block_sync_throttling = true;
-               peer_dlog( this, "throttling block sync to peer ${host}:${port}", ("host", log_remote_endpoint_ip)("port", log_remote_endpoint_port));
-               return false;
-            }
-         }
-         block_sync_throttling = false;
-         auto sent = enqueue_block( sb, true );
-         block_sync_total_bytes_sent += sent;
-         block_sync_frame_bytes_sent += sent;
-         ++peer_requested->last;
-         if(num == peer_requested->end_block) {
-            peer_requested.reset();
-            block_sync_send_start = 0ns;
-            block_sync_frame_bytes_sent = 0;
-            peer_dlog( this, "completing enqueue_sync_block ${num}", ("num", num) );
-         }
-      } else {
-         peer_ilog( this, "enqueue sync, unable to fetch block ${num}, sending benign_other go away", ("num", num) );
-         peer_requested.reset(); // unable to provide requested blocks
-         block_sync_send_start = 0ns;
-         block_sync_frame_bytes_sent = 0;
-         no_retry = benign_other;
-         enqueue( go_away_message( benign_other ) );
-      }
-      return true;
-   }
-
    //------------------------------------------------------------------------
 
    using send_buffer_type = std::shared_ptr<std::vector<char>>;
@@ -1836,18 +1938,40 @@ namespace eosio {
          return send_buffer;
       }
 
+      /// @return sb as a compressed_message, or sb when smaller than p2p-compression-threshold or not smaller compressed
+      static send_buffer_type create_compressed_send_buffer( const send_buffer_type& sb ) {
+         const size_t payload_size = sb->size() - message_header_size;
+         if( payload_size < my_impl->p2p_compression_threshold )
+            return sb;
+
+         fc::datastream<const char*> ds( sb->data() + message_header_size, payload_size );
+         compressed_message msg;
+         fc::raw::unpack( ds, msg.which );
+         msg.data = net_utils::zstd_compress( sb->data() + message_header_size + ds.tellp(), payload_size - ds.tellp(),
+                                              my_impl->p2p_compression_level );
+         const size_t compressed_size = fc::raw::pack_size( unsigned_int( compressed_message_which ) ) + fc::raw::pack_size( msg );
+         if( compressed_size >= payload_size )
+            return sb;
+         return create_send_buffer( compressed_message_which, msg );
+      }
    };
 
    struct block_buffer_factory : public buffer_factory {
 
       /// caches result for subsequent calls, only provide same signed_block_ptr instance for each invocation.
-      const send_buffer_type& get_send_buffer( const signed_block_ptr& sb ) {
+      /// The buffer is shared through the block_buffer_cache with every other send of the block.
+      const send_buffer_type& get_send_buffer( const signed_block_ptr& sb, const block_id_type& id ) {
          if( !send_buffer ) {
-            send_buffer = create_send_buffer( sb );
+            send_buffer = my_impl->dispatcher.block_buffers.get_send_buffer( id, [&sb]() { return create_send_buffer( sb ); } );
          }
          return send_buffer;
       }
 
+      /// @return compressed send buffer of a block send buffer, shared through the block_buffer_cache
+      static send_buffer_type get_compressed_send_buffer( const send_buffer_type& sb ) {
+         return my_impl->dispatcher.block_buffers.get_compressed_send_buffer( sb, [&sb]() { return create_compressed_send_buffer( sb ); } );
+      }
+
    private:
 
       static std::shared_ptr<std::vector<char>> create_send_buffer( const signed_block_ptr& sb ) {
@@ -1859,17 +1983,54 @@ namespace eosio {
       }
    };
 
+   struct serialized_block_buffer_factory : public buffer_factory {
+
+      /// caches result for subsequent calls, only provide same serialized block for each invocation.
+      const send_buffer_type& get_send_buffer( const std::vector<char>& serialized_block ) {
+         if( !send_buffer ) {
+            send_buffer = create_send_buffer( serialized_block );
+         }
+         return send_buffer;
+      }
+
+      static send_buffer_type create_send_buffer( const std::vector<char>& serialized_block ) {
+         static_assert( signed_block_which == fc::get_index<net_message, signed_block>() );
+         // serialized_block is fc::raw::pack of a signed_block, prefix it the same way as a net_message
+         const uint32_t which_size = fc::raw::pack_size( unsigned_int( signed_block_which ) );
+         const uint32_t payload_size = which_size + serialized_block.size();
+
+         const char* const header = reinterpret_cast<const char* const>(&payload_size); // avoid variable size encoding of uint32_t
+         const size_t buffer_size = message_header_size + payload_size;
+
+         auto send_buffer = std::make_shared<vector<char>>( buffer_size );
+         fc::datastream<char*> ds( send_buffer->data(), buffer_size );
+         ds.write( header, message_header_size );
+         fc::raw::pack( ds, unsigned_int( signed_block_which ) );
+         ds.write( serialized_block.data(), serialized_block.size() );
+
+         return send_buffer;
+      }
+   };
+
    struct trx_buffer_factory : public buffer_factory {
 
       /// caches result for subsequent calls, only provide same packed_transaction_ptr instance for each invocation.
-      const send_buffer_type& get_send_buffer( const packed_transaction_ptr& trx ) {
+      /// @param compress for a peer that supports compressed_message
+      const send_buffer_type& get_send_buffer( const packed_transaction_ptr& trx, bool compress ) {
          if( !send_buffer ) {
             send_buffer = create_send_buffer( trx );
          }
-         return send_buffer;
+         if( !compress ) {
+            return send_buffer;
+         }
+         if( !compressed_send_buffer ) {
+            compressed_send_buffer = create_compressed_send_buffer( send_buffer );
+         }
+         return compressed_send_buffer;
       }
 
    private:
+      send_buffer_type compressed_send_buffer;
 
       static std::shared_ptr<std::vector<char>> create_send_buffer( const packed_transaction_ptr& trx ) {
          static_assert( packed_transaction_which == fc::get_index<net_message, packed_transaction>() );
@@ -1881,6 +2042,163 @@ namespace eosio {
 
    //------------------------------------------------------------------------
 
+   // called from connection strand
+   void connection::announce_trx( const transaction_id_type& id ) {
+      pending_trx_announce.push_back( id );
+      if( pending_trx_announce.size() >= def_max_trx_announce_ids ) {
+         trx_announce_timer.cancel();
+         send_trx_announce();
+      } else if( pending_trx_announce.size() == 1 ) {
+         trx_announce_timer.expires_from_now( def_trx_announce_interval );
+         trx_announce_timer.async_wait( boost::asio::bind_executor( strand, [c = shared_from_this()]( boost::system::error_code ec ) {
+            if( !ec ) {
+               c->send_trx_announce();
+            }
+         } ) );
+      }
+   }
+
+   // called from connection strand
+   void connection::send_trx_announce() {
+      if( pending_trx_announce.empty() ) {
+         return;
+      }
+      notice_message note;
+      note.known_blocks.mode = none;
+      note.known_trx.mode = normal;
+      note.known_trx.pending = pending_trx_announce.size();
+      note.known_trx.ids = std::move( pending_trx_announce );
+      pending_trx_announce.clear();
+      peer_dlog( this, "announcing ${n} trxs", ("n", note.known_trx.pending) );
+
+      buffer_factory buff_factory;
+      const auto& sb = buff_factory.get_send_buffer( note );
+      my_impl->dispatcher.trx_announce_bytes_sent += sb->size();
+      enqueue_buffer( sb, no_reason );
+   }
+
+   // called from connection strand
+   void connection::request_announced_trxs( const vector<transaction_id_type>& ids ) {
+      if( !accept_trx_message() ) {
+         return;
+      }
+      const time_point now = time_point::now();
+      vector<transaction_id_type> unknown_ids;
+      for( const auto& id : ids ) {
+         if( my_impl->dispatcher.add_announced_txn( id, connection_id, now ) ) {
+            unknown_ids.push_back( id );
+         }
+      }
+      peer_dlog( this, "requesting ${n} of ${a} announced trxs", ("n", unknown_ids.size())("a", ids.size()) );
+      send_trx_request( unknown_ids );
+   }
+
+   // called from connection strand
+   void connection::send_trx_request( const vector<transaction_id_type>& ids ) {
+      for( size_t i = 0; i < ids.size(); i += def_max_trx_announce_ids ) {
+         request_message req;
+         req.req_blocks.mode = none;
+         req.req_trx.mode = normal;
+         req.req_trx.ids.assign( ids.begin() + i, ids.begin() + std::min<size_t>( ids.size(), i + def_max_trx_announce_ids ) );
+         req.req_trx.pending = req.req_trx.ids.size();
+         my_impl->dispatcher.trxs_requested += req.req_trx.ids.size();
+
+         buffer_factory buff_factory;
+         const auto& sb = buff_factory.get_send_buffer( req );
+         my_impl->dispatcher.trx_announce_bytes_sent += sb->size();
+         enqueue_buffer( sb, no_reason );
+      }
+   }
+
+   // called from connection strand
+   void connection::send_requested_trxs( const vector<transaction_id_type>& ids ) {
+      for( const auto& id : ids ) {
+         packed_transaction_ptr trx = my_impl->dispatcher.get_announced_trx( id );
+         if( !trx ) {
+            peer_dlog( this, "requested trx ${id} expired", ("id", id) );
+            continue;
+         }
+         my_impl->dispatcher.add_peer_txn( id, trx->expiration(), connection_id );
+         trx_buffer_factory buff_factory;
+         const send_buffer_type& sb = buff_factory.get_send_buffer( trx, compress_messages() );
+         my_impl->dispatcher.trx_bytes_sent += sb->size();
+         enqueue_buffer( sb, no_reason );
+      }
+   }
+
+   // called from connection strand
+   bool connection::enqueue_sync_block() {
+      if( !peer_requested ) {
+         return false;
+      } else {
+         peer_dlog( this, "enqueue sync block ${num}", ("num", peer_requested->last + 1) );
+      }
+      uint32_t num = peer_requested->last + 1;
+
+      controller& cc = my_impl->chain_plug->chain();
+      send_buffer_type sb;
+      try {
+         if( num <= my_impl->get_chain_lib_num() ) {
+            // irreversible blocks are sent as stored in the block log, without unpacking and packing them again
+            sb = my_impl->dispatcher.block_buffers.get_irreversible_send_buffer( num,
+               [&]() -> std::optional<std::pair<block_id_type, send_buffer_type>> {
+                  std::vector<char> serialized_block = cc.fetch_serialized_block_by_number( num ); // thread-safe
+                  if( serialized_block.empty() )
+                     return {};
+                  fc::datastream<const char*> ds( serialized_block.data(), serialized_block.size() );
+                  signed_block_header header;
+                  fc::raw::unpack( ds, header );
+                  return std::make_pair( header.calculate_id(), serialized_block_buffer_factory::create_send_buffer( serialized_block ) );
+               } );
+         } else {
+            signed_block_ptr b = cc.fetch_block_by_number( num ); // thread-safe
+            if( b ) {
+               block_buffer_factory buff_factory;
+               sb = buff_factory.get_send_buffer( b, b->calculate_id() );
+            }
+         }
+      } FC_LOG_AND_DROP();
+      if( sb ) {
+         // Skip transmitting block this loop if threshold exceeded
+         if (block_sync_send_start == 0ns) { // start of enqueue blocks
+            block_sync_send_start = get_time();
+            block_sync_frame_bytes_sent = 0;
+         }
+         if( block_sync_rate_limit > 0 && block_sync_frame_bytes_sent > 0 && peer_syncing_from_us ) {
+            auto now = get_time();
+            auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(now - block_sync_send_start);
+            double current_rate_sec = (double(block_sync_frame_bytes_sent) / elapsed_us.count()) * 100000; // convert from bytes/us => bytes/sec
+            peer_dlog(this, "start enqueue block time ${st}, now ${t}, elapsed ${e}, rate ${r}, limit ${l}",
+                      ("st", block_sync_send_start.count())("t", now.count())("e", elapsed_us.count())("r", current_rate_sec)("l", block_sync_rate_limit));
+            if( current_rate_sec >= block_sync_rate_limit ) {
+               block_sync_throttling = true;
+               peer_dlog( this, "throttling block sync to peer ${host}:${port}", ("host", log_remote_endpoint_ip)("port", log_remote_endpoint_port));
+               return false;
+            }
+         }
+         block_sync_throttling = false;
+         peer_dlog( this, "enqueue block ${num}", ("num", num) );
+         auto sent = enqueue_block( sb, true );
+         block_sync_total_bytes_sent += sent;
+         block_sync_frame_bytes_sent += sent;
+         ++peer_requested->last;
+         if(num == peer_requested->end_block) {
+            peer_requested.reset();
+            block_sync_send_start = 0ns;
+            block_sync_frame_bytes_sent = 0;
+            peer_dlog( this, "completing enqueue_sync_block ${num}", ("num", num) );
+         }
+      } else {
+         peer_ilog( this, "enqueue sync, unable to fetch block ${num}, sending benign_other go away", ("num", num) );
+         peer_requested.reset(); // unable to provide requested blocks
+         block_sync_send_start = 0ns;
+         block_sync_frame_bytes_sent = 0;
+         no_retry = benign_other;
+         enqueue( go_away_message( benign_other ) );
+      }
+      return true;
+   }
+
    // called from connection strand
    void connection::enqueue( const net_message& m ) {
       verify_strand_in_this_thread( strand, __func__, __LINE__ );
@@ -1900,8 +2218,17 @@ namespace eosio {
       verify_strand_in_this_thread( strand, __func__, __LINE__ );
 
       block_buffer_factory buff_factory;
-      auto sb = buff_factory.get_send_buffer( b );
+      auto sb = buff_factory.get_send_buffer( b, b->calculate_id() );
+      return enqueue_block( sb, to_sync_queue );
+   }
+
+   // called from connection strand
+   size_t connection::enqueue_block( const send_buffer_type& block_buffer, bool to_sync_queue) {
+      verify_strand_in_this_thread( strand, __func__, __LINE__ );
+
+      send_buffer_type sb = compress_messages() ? block_buffer_factory::get_compressed_send_buffer( block_buffer ) : block_buffer;
       latest_blk_time = std::chrono::system_clock::now();
+      my_impl->dispatcher.block_buffers.add_bytes_sent( sb->size() );
       enqueue_buffer( sb, no_reason, to_sync_queue);
       return sb->size();
    }
@@ -2007,13 +2334,14 @@ namespace eosio {
    }
    //-----------------------------------------------------------
 
-    sync_manager::sync_manager( uint32_t span, uint32_t sync_peer_limit, uint32_t min_blocks_distance )
+    sync_manager::sync_manager( uint32_t span, uint32_t sync_peer_limit, uint32_t sync_fetch_ranges, uint32_t min_blocks_distance )
       :sync_known_lib_num( 0 )
       ,sync_last_requested_num( 0 )
       ,sync_next_expected_num( 1 )
-      ,sync_source()
+      ,sync_ranges()
       ,sync_req_span( span )
       ,sync_peer_limit( sync_peer_limit )
+      ,sync_fetch_ranges( sync_fetch_ranges )
       ,sync_state(in_sync)
       ,min_blocks_distance(min_blocks_distance)
    {
@@ -2041,7 +2369,7 @@ namespace eosio {
    void sync_manager::sync_reset_lib_num(const connection_ptr& c, bool closing) {
       fc::unique_lock g( sync_mtx );
       if( sync_state == in_sync ) {
-         sync_source.reset();
+         sync_ranges.clear();
       }
       if( !c ) return;
       if( !closing ) {
@@ -2060,28 +2388,126 @@ namespace eosio {
          } );
          sync_known_lib_num = highest_lib_num;
 
-         // if closing the connection we are currently syncing from then request from a diff peer
-         if( c == sync_source ) {
-            sync_last_requested_num = 0;
-            // if starting to sync need to always start from lib as we might be on our own fork
-            uint32_t lib_num = my_impl->get_chain_lib_num();
-            sync_next_expected_num = std::max( lib_num + 1, sync_next_expected_num );
+         // if closing a connection we are currently syncing from then request the rest of its range from a diff peer
+         if( release_ranges( c ) ) {
             request_next_chunk();
          }
       }
    }
 
-   connection_ptr sync_manager::find_next_sync_node() REQUIRES(sync_mtx) {
-      fc_dlog(logger, "Number connections ${s}, sync_next_expected_num: ${e}, sync_known_lib_num: ${l}",
-              ("s", my_impl->connections.number_connections())("e", sync_next_expected_num)("l", sync_known_lib_num));
+   size_t sync_manager::assigned_ranges() const REQUIRES(sync_mtx) {
+      size_t assigned = 0;
+      for( const auto& r : sync_ranges ) {
+         if( r.second.conn )
+            ++assigned;
+      }
+      return assigned;
+   }
+
+   bool sync_manager::has_range( const connection_ptr& c ) const REQUIRES(sync_mtx) {
+      for( const auto& r : sync_ranges ) {
+         if( r.second.conn == c )
+            return true;
+      }
+      return false;
+   }
+
+   // the blocks of c's range not yet received are left to be requested from another peer
+   // @return true if c was syncing a range
+   bool sync_manager::release_ranges( const connection_ptr& c ) REQUIRES(sync_mtx) {
+      for( auto i = sync_ranges.begin(); i != sync_ranges.end(); ++i ) {
+         if( i->second.conn == c ) {
+            sync_range rest{ i->second.end, i->second.next };
+            sync_ranges.erase( i );
+            sync_ranges[rest.next] = rest;
+            return true;
+         }
+      }
+      return false;
+   }
+
+   // ranges left by closed or slow peers are requested again whenever possible, new ranges only while not too far
+   // ahead of head, (sync_fetch_ranges sync_req_span)
+   bool sync_manager::can_request_range( uint32_t head_num ) const REQUIRES(sync_mtx) {
+      const size_t assigned = assigned_ranges();
+      if( assigned >= sync_fetch_ranges )
+         return false;
+      if( assigned < sync_ranges.size() )
+         return true;
+      return sync_last_requested_num < sync_known_lib_num && head_num + sync_req_span * sync_fetch_ranges > sync_last_requested_num;
+   }
+
+   // called from c's connection strand
+   void sync_manager::sync_recv_range_block( const connection_ptr& c, uint32_t blk_num ) REQUIRES(sync_mtx) {
+      for( auto i = sync_ranges.begin(); i != sync_ranges.end(); ++i ) {
+         sync_range& r = i->second;
+         if( r.conn != c )
+            continue;
+         if( blk_num >= r.next && blk_num <= r.end ) {
+            r.next = blk_num + 1;
+            if( r.next > r.end ) {
+               const uint32_t range_blocks = r.end - i->first + 1;
+               const fc::microseconds range_time = fc::time_point::now() - r.requested;
+               sync_ranges.erase( i );
+               reassign_slow_range( c, range_blocks, range_time );
+            }
+         }
+         break;
+      }
+      // blocks of later ranges may have been received already, they are held until the blocks before them arrive
+      sync_next_expected_num = sync_ranges.empty() ? sync_last_requested_num + 1 : sync_ranges.begin()->second.next;
+   }
+
+   // c received all range_blocks of its range in range_time. Blocks are applied in order, so the lowest range holds
+   // up syncing, if it is arriving at less than half the rate of c then request the rest of it from c instead.
+   void sync_manager::reassign_slow_range( const connection_ptr& c, uint32_t range_blocks, fc::microseconds range_time ) REQUIRES(sync_mtx) {
+      if( sync_ranges.empty() || !c->current() )
+         return;
+      auto i = sync_ranges.begin();
+      const uint32_t start = i->first;
+      sync_range& r = i->second;
+      if( !r.conn || r.conn == c )
+         return;
+      const auto now = fc::time_point::now();
+      const fc::microseconds elapsed = now - r.requested;
+      const uint64_t received = r.next - start;
+      if( elapsed <= range_time || received * 2 * range_time.count() >= uint64_t(range_blocks) * elapsed.count() )
+         return;
+
+      connection_ptr slow = std::move( r.conn );
+      const uint32_t next = r.next, end = r.end;
+      peer_ilog( c, "taking over blocks ${n} to ${e} from slow peer ${cid}, received ${r} blocks in ${t}ms",
+                 ("n", next)("e", end)("cid", slow->connection_id)("r", received)("t", elapsed.count()/1000) );
+      sync_ranges.erase( i );
+      sync_ranges[next] = sync_range{ end, next, c, now };
+      slow->strand.post( [slow]() {
+         slow->cancel_sync( benign_other );
+      } );
+      c->strand.post( [c, next, end]() {
+         peer_ilog( c, "requesting range ${s} to ${e} of slow peer", ("s", next)("e", end) );
+         c->request_sync_blocks( next, end );
+      } );
+   }
+
+   connection_ptr sync_manager::find_next_sync_node( uint32_t start ) REQUIRES(sync_mtx) {
+      fc_dlog(logger, "Number connections ${s}, start: ${e}, sync_known_lib_num: ${l}",
+              ("s", my_impl->connections.number_connections())("e", start)("l", sync_known_lib_num));
       deque<connection_ptr> conns;
-      my_impl->connections.for_each_block_connection([sync_next_expected_num = sync_next_expected_num,
+      my_impl->connections.for_each_block_connection([start,
                                                       sync_known_lib_num = sync_known_lib_num,
                                                       &conns](const auto& c) {
-         if (c->should_sync_from(sync_next_expected_num, sync_known_lib_num)) {
+         if (c->should_sync_from(start, sync_known_lib_num)) {
             conns.push_back(c);
          }
       });
+      // each range is requested from a different peer
+      for (auto i = conns.begin(); i != conns.end();) {
+         if (has_range(*i)) {
+            i = conns.erase(i);
+         } else {
+            ++i;
+         }
+      }
       if (conns.size() > sync_peer_limit) {
          std::partial_sort(conns.begin(), conns.begin() + sync_peer_limit, conns.end(), [](const connection_ptr& lhs, const connection_ptr& rhs) {
             return lhs->get_peer_ping_time_ns() < rhs->get_peer_ping_time_ns();
@@ -2124,13 +2550,14 @@ namespace eosio {
    void sync_manager::request_next_chunk( const connection_ptr& conn ) REQUIRES(sync_mtx) {
       auto chain_info = my_impl->get_chain_info();
 
-      fc_dlog( logger, "sync_last_requested_num: ${r}, sync_next_expected_num: ${e}, sync_known_lib_num: ${k}, sync_req_span: ${s}, head: ${h}, lib: ${lib}",
-               ("r", sync_last_requested_num)("e", sync_next_expected_num)("k", sync_known_lib_num)("s", sync_req_span)("h", chain_info.head_num)("lib", chain_info.lib_num) );
+      fc_dlog( logger, "sync_last_requested_num: ${r}, sync_next_expected_num: ${e}, sync_known_lib_num: ${k}, sync_req_span: ${s}, ranges: ${n}, head: ${h}, lib: ${lib}",
+               ("r", sync_last_requested_num)("e", sync_next_expected_num)("k", sync_known_lib_num)("s", sync_req_span)
+               ("n", sync_ranges.size())("h", chain_info.head_num)("lib", chain_info.lib_num) );
 
-      if( chain_info.head_num + sync_req_span < sync_last_requested_num && sync_source && sync_source->current() ) {
-         fc_dlog( logger, "ignoring request, head is ${h} last req = ${r}, sync_next_expected_num: ${e}, sync_known_lib_num: ${k}, sync_req_span: ${s}, source connection ${c}",
+      if( !can_request_range( chain_info.head_num ) && assigned_ranges() > 0 ) {
+         fc_dlog( logger, "ignoring request, head is ${h} last req = ${r}, sync_next_expected_num: ${e}, sync_known_lib_num: ${k}, sync_req_span: ${s}, ranges ${n}",
                   ("h", chain_info.head_num)("r", sync_last_requested_num)("e", sync_next_expected_num)
-                  ("k", sync_known_lib_num)("s", sync_req_span)("c", sync_source->connection_id) );
+                  ("k", sync_known_lib_num)("s", sync_req_span)("n", sync_ranges.size()) );
          return;
       }
 
@@ -2144,42 +2571,65 @@ namespace eosio {
        * next chunk provider selection criteria
        * a provider is supplied and able to be used, use it.
        * otherwise select the next available from the list, round-robin style.
+       * up to sync_fetch_ranges ranges are requested at once, each from a different peer. The rest of a range left by
+       * a closed or slow peer is requested before any new range.
        */
 
-      connection_ptr new_sync_source = (conn && conn->current()) ? conn :
-                                                                 find_next_sync_node();
+      connection_ptr provider = (conn && conn->current() && !has_range( conn )) ? conn : connection_ptr();
+      bool no_source = false;
+      bool no_range = false;
+      while( can_request_range( chain_info.head_num ) ) {
+         auto unassigned = sync_ranges.begin();
+         while( unassigned != sync_ranges.end() && unassigned->second.conn )
+            ++unassigned;
+         uint32_t start = 0, end = 0;
+         if( unassigned != sync_ranges.end() ) {
+            start = unassigned->first;
+            end = unassigned->second.end;
+         } else {
+            start = std::max( sync_next_expected_num, sync_last_requested_num + 1 );
+            end = start + sync_req_span - 1;
+            if( end > sync_known_lib_num )
+               end = sync_known_lib_num;
+            if( end == 0 || end < start ) {
+               no_range = true;
+               break;
+            }
+         }
+
+         connection_ptr new_sync_source = provider ? provider : find_next_sync_node( start );
+         provider.reset();
+         if( !new_sync_source ) {
+            no_source = true;
+            break;
+         }
 
+         sync_ranges[start] = sync_range{ end, start, new_sync_source, fc::time_point::now() };
+         if( end > sync_last_requested_num )
+            sync_last_requested_num = end;
+         new_sync_source->strand.post( [new_sync_source, start, end, head_num=chain_info.head_num, lib=chain_info.lib_num]() {
+            peer_ilog( new_sync_source, "requesting range ${s} to ${e}, head ${h}, lib ${lib}", ("s", start)("e", end)("h", head_num)("lib", lib) );
+            new_sync_source->request_sync_blocks( start, end );
+         } );
+      }
+
+      if( assigned_ranges() > 0 ) {
+         return;
+      }
       // verify there is an available source
-      if( !new_sync_source ) {
+      if( no_source ) {
          fc_wlog( logger, "Unable to continue syncing at this time");
-         sync_source.reset();
+         sync_ranges.clear();
          sync_known_lib_num = chain_info.lib_num;
          sync_last_requested_num = 0;
          set_state( in_sync ); // probably not, but we can't do anything else
          return;
       }
-
-      bool request_sent = false;
-      if( sync_last_requested_num != sync_known_lib_num ) {
-         uint32_t start = sync_next_expected_num;
-         uint32_t end = start + sync_req_span - 1;
-         if( end > sync_known_lib_num )
-            end = sync_known_lib_num;
-         if( end > 0 && end >= start ) {
-            sync_last_requested_num = end;
-            sync_source = new_sync_source;
-            request_sent = true;
-            new_sync_source->strand.post( [new_sync_source, start, end, head_num=chain_info.head_num, lib=chain_info.lib_num]() {
-               peer_ilog( new_sync_source, "requesting range ${s} to ${e}, head ${h}, lib ${lib}", ("s", start)("e", end)("h", head_num)("lib", lib) );
-               new_sync_source->request_sync_blocks( start, end );
-            } );
-         }
-      }
-      if( !request_sent ) {
-         sync_source.reset();
+      if( no_range || sync_last_requested_num >= sync_known_lib_num ) {
          fc_wlog(logger, "Unable to request range, sending handshakes to everyone");
          send_handshakes();
       }
+      // otherwise the requested blocks are received, more are requested as they are applied
    }
 
    // static, thread safe
@@ -2216,7 +2666,13 @@ namespace eosio {
 
       if( sync_state != lib_catchup ) {
          set_state( lib_catchup );
+         sync_ranges.clear();
+         sync_last_requested_num = 0;
          sync_next_expected_num = chain_info.lib_num + 1;
+         // posted before any block is requested, so blocks of this sync are not compared to headers accepted before it
+         my_impl->dispatcher.strand.post( []() {
+            my_impl->dispatcher.sync_accepted_header_num = 0;
+         } );
       } else {
          sync_next_expected_num = std::max( chain_info.lib_num + 1, sync_next_expected_num );
       }
@@ -2230,9 +2686,9 @@ namespace eosio {
       peer_ilog( c, "reassign_fetch, our last req is ${cc}, next expected is ${ne}",
                ("cc", sync_last_requested_num)("ne", sync_next_expected_num) );
 
-      if( c == sync_source ) {
+      if( has_range( c ) ) {
          c->cancel_sync(reason);
-         sync_last_requested_num = 0;
+         release_ranges( c );
          request_next_chunk();
       }
    }
@@ -2402,7 +2858,7 @@ namespace eosio {
          if (msg.known_blocks.ids.empty()) {
             peer_wlog( c, "got a catch up with ids size = 0" );
          } else {
-            const block_id_type& id = msg.known_blocks.ids.back();
+            const block_id_type& id = msg.known_blocks.ids.front(); // head, followed by begin of block range
             peer_ilog( c, "notice_message, pending ${p}, blk_num ${n}, id ${id}...",
                      ("p", msg.known_blocks.pending)("n", block_header::num_from_id(id))("id",id.str().substr(8,16)) );
             if( !my_impl->dispatcher.have_block( id ) ) {
@@ -2429,11 +2885,11 @@ namespace eosio {
       c->block_status_monitor_.rejected();
       // reset sync on rejected block
       fc::unique_lock g( sync_mtx );
+      sync_ranges.clear();
       sync_last_requested_num = 0;
       sync_next_expected_num = my_impl->get_chain_lib_num() + 1;
       if( c->block_status_monitor_.max_events_violated()) {
          peer_wlog( c, "block ${bn} not accepted, closing connection", ("bn", blk_num) );
-         sync_source.reset();
          g.unlock();
          c->close();
       } else {
@@ -2443,6 +2899,49 @@ namespace eosio {
       }
    }
 
+   // called from c's connection strand
+   // sync block blk_num received from c was held until the block before it was accepted, and it does not link to it.
+   // The blocks c sent from blk_num on are dropped and requested again from another peer.
+   void sync_manager::unlinked_block( const connection_ptr& c, uint32_t blk_num ) {
+      c->block_status_monitor_.rejected();
+      if( c->block_status_monitor_.max_events_violated() ) {
+         peer_wlog( c, "block ${bn} does not link, closing connection", ("bn", blk_num) );
+         c->close();
+      } else {
+         peer_ilog( c, "block ${bn} does not link, requesting it from another peer", ("bn", blk_num) );
+         c->cancel_sync( benign_other );
+      }
+
+      fc::lock_guard g( sync_mtx );
+      if( sync_state != lib_catchup || sync_last_requested_num == 0 || blk_num > sync_last_requested_num )
+         return;
+
+      // c's ranges are requested again from blk_num, or from their start if after it
+      bool covered = false;
+      std::vector<std::pair<uint32_t, sync_range>> released;
+      for( auto i = sync_ranges.begin(); i != sync_ranges.end(); ) {
+         if( i->first <= blk_num && blk_num <= i->second.end )
+            covered = true;
+         if( i->second.conn == c ) {
+            const uint32_t start = std::max( i->first, std::min( blk_num, i->second.next ) );
+            released.emplace_back( start, sync_range{ i->second.end, start } );
+            i = sync_ranges.erase( i );
+         } else {
+            ++i;
+         }
+      }
+      sync_ranges.insert( released.begin(), released.end() );
+      // blk_num is of a range already received, request the blocks from blk_num to the next range again
+      if( !covered ) {
+         auto next = sync_ranges.upper_bound( blk_num );
+         const uint32_t end = next == sync_ranges.end() ? sync_last_requested_num : next->first - 1;
+         sync_ranges[blk_num] = sync_range{ end, blk_num };
+      }
+      sync_next_expected_num = sync_ranges.begin()->second.next;
+
+      request_next_chunk();
+   }
+
    // called from c's connection strand
    void sync_manager::sync_recv_block(const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num, bool blk_applied) {
       peer_dlog( c, "${d} block ${bn}", ("d", blk_applied ? "applied" : "got")("bn", blk_num) );
@@ -2457,7 +2956,7 @@ namespace eosio {
       if( state == head_catchup ) {
          fc::unique_lock g_sync( sync_mtx );
          peer_dlog( c, "sync_manager in head_catchup state" );
-         sync_source.reset();
+         sync_ranges.clear();
          g_sync.unlock();
 
          block_id_type null_id;
@@ -2508,17 +3007,15 @@ namespace eosio {
                if (sync_last_requested_num == 0) { // block was rejected
                   sync_next_expected_num = my_impl->get_chain_lib_num() + 1;
                } else {
-                  sync_next_expected_num = blk_num + 1;
+                  sync_recv_range_block(c, blk_num);
                }
             }
 
             uint32_t head = my_impl->get_chain_head_num();
-            if (head + sync_req_span > sync_last_requested_num) { // don't allow to get too far head (one sync_req_span)
-               if (sync_next_expected_num > sync_last_requested_num && sync_last_requested_num < sync_known_lib_num) {
-                  fc_dlog(logger, "Requesting range ahead, head: ${h} blk_num: ${bn} sync_next_expected_num ${nen} sync_last_requested_num: ${lrn}",
-                          ("h", head)("bn", blk_num)("nen", sync_next_expected_num)("lrn", sync_last_requested_num));
-                  request_next_chunk();
-               }
+            if (can_request_range(head)) { // don't allow to get too far head (sync_fetch_ranges sync_req_span)
+               fc_dlog(logger, "Requesting range ahead, head: ${h} blk_num: ${bn} sync_next_expected_num ${nen} sync_last_requested_num: ${lrn}",
+                       ("h", head)("bn", blk_num)("nen", sync_next_expected_num)("lrn", sync_last_requested_num));
+               request_next_chunk();
             }
 
          }
@@ -2563,10 +3060,16 @@ namespace eosio {
       index.erase(p.first, p.second);
    }
 
+   dispatch_manager::dispatch_manager(boost::asio::io_context& io_context)
+   : trx_requests( fc::microseconds( std::chrono::duration_cast<std::chrono::microseconds>( def_trx_request_timeout ).count() ) )
+   , strand( io_context ) {}
+
    bool dispatch_manager::add_peer_txn( const transaction_id_type& id, const time_point_sec& trx_expires,
                                         uint32_t connection_id, const time_point_sec& now ) {
       fc::lock_guard g( local_txns_mtx );
-      auto tptr = local_txns.get<by_id>().find( std::make_tuple( std::ref( id ), connection_id ) );
+      trx_requests.received( id );
+      auto& index = local_txns.get<by_id>();
+      auto tptr = index.find( std::make_tuple( std::ref( id ), connection_id ) );
       bool added = (tptr == local_txns.end());
       if( added ) {
          // expire at either transaction expiration or configured max expire time whichever is less
@@ -2576,14 +3079,62 @@ namespace eosio {
             .id = id,
             .expires = expires,
             .connection_id = connection_id} );
+      } else if( tptr->announced ) {
+         index.modify( tptr, []( auto& s ) { s.announced = false; } );
       }
       return added;
    }
 
+   // @return true if the transaction is unknown and should be requested from connection_id now. It is requested from
+   //         one peer that announced it at a time, see retry_announced_txns
+   bool dispatch_manager::add_announced_txn( const transaction_id_type& id, uint32_t connection_id, const time_point& now ) {
+      fc::lock_guard g( local_txns_mtx );
+      auto& index = local_txns.get<by_id>();
+      auto [begin, end] = index.equal_range( id );
+      const bool known = std::any_of( begin, end, []( const auto& s ) { return !s.announced; } );
+      if( std::none_of( begin, end, [connection_id]( const auto& s ) { return s.connection_id == connection_id; } ) ) {
+         // the expiration of the transaction is not known until it is received
+         local_txns.insert( node_transaction_state{
+            .id = id,
+            .expires = time_point_sec{now + my_impl->p2p_dedup_cache_expire_time_us},
+            .connection_id = connection_id,
+            .announced = true} );
+      }
+      return !known && trx_requests.announced( id, connection_id, now );
+   }
+
+   // @return requested transactions not received in time, to request from the next peer that announced them
+   std::vector<trx_request_tracker::request> dispatch_manager::retry_announced_txns( const time_point& now ) {
+      fc::lock_guard g( local_txns_mtx );
+      return trx_requests.retry( now );
+   }
+
+   // the transactions requested from connection_id are requested from the next peer that announced them on the next retry
+   void dispatch_manager::rm_announced_txns( uint32_t connection_id ) {
+      fc::lock_guard g( local_txns_mtx );
+      trx_requests.connection_closed( connection_id, time_point::now() );
+   }
+
    bool dispatch_manager::have_txn( const transaction_id_type& tid ) const {
       fc::lock_guard g( local_txns_mtx );
-      const auto tptr = local_txns.get<by_id>().find( tid );
-      return tptr != local_txns.end();
+      auto [begin, end] = local_txns.get<by_id>().equal_range( tid );
+      return std::any_of( begin, end, []( const auto& s ) { return !s.announced; } );
+   }
+
+   void dispatch_manager::add_announced_trx( const packed_transaction_ptr& trx, const time_point_sec& now ) {
+      time_point_sec expires{now.to_time_point() + my_impl->p2p_dedup_cache_expire_time_us};
+      expires = std::min( trx->expiration(), expires );
+      fc::lock_guard g( announced_trxs_mtx );
+      announced_trxs.insert( announced_trx_state{
+         .id = trx->id(),
+         .expires = expires,
+         .trx = trx} );
+   }
+
+   packed_transaction_ptr dispatch_manager::get_announced_trx( const transaction_id_type& id ) const {
+      fc::lock_guard g( announced_trxs_mtx );
+      auto itr = announced_trxs.find( id );
+      return itr != announced_trxs.end() ? itr->trx : packed_transaction_ptr{};
    }
 
    void dispatch_manager::expire_txns() {
@@ -2596,13 +3147,19 @@ namespace eosio {
       auto ex_lo = old.lower_bound( fc::time_point_sec( 0 ) );
       auto ex_up = old.upper_bound( now );
       old.erase( ex_lo, ex_up );
+      end_size = local_txns.size();
       g.unlock();
 
+      fc::lock_guard g_announced( announced_trxs_mtx );
+      auto& announced = announced_trxs.get<by_expiry>();
+      announced.erase( announced.begin(), announced.upper_bound( now ) );
+
       fc_dlog( logger, "expire_local_txns size ${s} removed ${r}", ("s", start_size)( "r", start_size - end_size ) );
    }
 
    void dispatch_manager::expire_blocks( uint32_t lib_num ) {
       unlinkable_block_cache.expire_blocks( lib_num );
+      block_buffers.expire_blocks( lib_num );
 
       fc::lock_guard g( blk_state_mtx );
       auto& stale_blk = blk_state.get<by_connection_id>();
@@ -2627,14 +3184,14 @@ namespace eosio {
             return;
          }
 
-         send_buffer_type sb = buff_factory.get_send_buffer( b );
+         send_buffer_type sb = buff_factory.get_send_buffer( b, id );
 
          cp->strand.post( [cp, bnum, sb{std::move(sb)}]() {
             cp->latest_blk_time = std::chrono::system_clock::now();
             bool has_block = cp->peer_lib_num >= bnum;
             if( !has_block ) {
                peer_dlog( cp, "bcast block ${b}", ("b", bnum) );
-               cp->enqueue_buffer( sb, no_reason );
+               cp->enqueue_block( sb );
             }
          });
       } );
@@ -2665,6 +3222,10 @@ namespace eosio {
    void dispatch_manager::bcast_transaction(const packed_transaction_ptr& trx) {
       trx_buffer_factory buff_factory;
       const fc::time_point_sec now{fc::time_point::now()};
+      if( my_impl->p2p_trx_announce ) {
+         // before any announcement, a peer may request it right away
+         add_announced_trx( trx, now );
+      }
       my_impl->connections.for_each_connection( [this, &trx, &now, &buff_factory]( const connection_ptr& cp ) {
          if( !cp->is_transactions_connection() || !cp->current() ) {
             return;
@@ -2673,8 +3234,17 @@ namespace eosio {
             return;
          }
 
-         send_buffer_type sb = buff_factory.get_send_buffer( trx );
+         if( cp->announce_trxs() ) {
+            fc_dlog( logger, "announcing trx: ${id}, to connection ${cid}", ("id", trx->id())("cid", cp->connection_id) );
+            cp->strand.post( [cp, id{trx->id()}]() {
+               cp->announce_trx( id );
+            } );
+            return;
+         }
+
+         send_buffer_type sb = buff_factory.get_send_buffer( trx, cp->compress_messages() );
          fc_dlog( logger, "sending trx: ${id}, to connection ${cid}", ("id", trx->id())("cid", cp->connection_id) );
+         trx_bytes_sent += sb->size();
          cp->strand.post( [cp, sb{std::move(sb)}]() {
             cp->enqueue_buffer( sb, no_reason );
          } );
@@ -3036,6 +3606,9 @@ namespace eosio {
          } else if( which == packed_transaction_which ) {
             return process_next_trx_message( message_length );
 
+         } else if( which == compressed_message_which ) {
+            return process_next_compressed_message( message_length );
+
          } else {
             auto ds = pending_message_buffer.create_datastream();
             net_message msg;
@@ -3060,6 +3633,21 @@ namespace eosio {
       block_header bh;
       fc::raw::unpack( peek_ds, bh );
       const block_id_type blk_id = bh.calculate_id();
+      if( !accept_block_message( bh, blk_id, message_length ) ) {
+         pending_message_buffer.advance_read_ptr( message_length );
+         return true;
+      }
+
+      auto ds = pending_message_buffer.create_datastream();
+      fc::raw::unpack( ds, which );
+      shared_ptr<signed_block> ptr = std::make_shared<signed_block>();
+      fc::raw::unpack( ds, *ptr );
+      return process_block_message( blk_id, std::move( ptr ) );
+   }
+
+   // called from connection strand
+   // @return false if the block is not needed
+   bool connection::accept_block_message(const block_header& bh, const block_id_type& blk_id, uint32_t message_length) {
       const uint32_t blk_num = last_received_block_num = block_header::num_from_id(blk_id);
       // don't add_peer_block because we have not validated this block header yet
       if( my_impl->dispatcher.have_block( blk_id ) ) {
@@ -3067,9 +3655,7 @@ namespace eosio {
                     ("num", blk_num)("id", blk_id.str().substr(8,16)) );
          my_impl->sync_master->sync_recv_block( shared_from_this(), blk_id, blk_num, false );
          cancel_wait();
-
-         pending_message_buffer.advance_read_ptr( message_length );
-         return true;
+         return false;
       }
       peer_dlog( this, "received block ${num}, id ${id}..., latency: ${latency}ms, head ${h}",
                  ("num", bh.block_num())("id", blk_id.str().substr(8,16))
@@ -3087,9 +3673,7 @@ namespace eosio {
             enqueue( (sync_request_message) {0, 0} );
             send_handshake();
             cancel_wait();
-
-            pending_message_buffer.advance_read_ptr( message_length );
-            return true;
+            return false;
          }
       } else {
          block_sync_bytes_received += message_length;
@@ -3097,17 +3681,15 @@ namespace eosio {
          uint32_t lib_num = my_impl->get_chain_lib_num();
          if( blk_num <= lib_num ) {
             cancel_wait();
-
-            pending_message_buffer.advance_read_ptr( message_length );
-            return true;
+            return false;
          }
       }
 
-      auto ds = pending_message_buffer.create_datastream();
-      fc::raw::unpack( ds, which );
-      shared_ptr<signed_block> ptr = std::make_shared<signed_block>();
-      fc::raw::unpack( ds, *ptr );
+      return true;
+   }
 
+   // called from connection strand
+   bool connection::process_block_message(const block_id_type& blk_id, signed_block_ptr ptr) {
       auto is_webauthn_sig = []( const fc::crypto::signature& s ) {
          return s.which() == fc::get_index<fc::crypto::signature::storage_type, fc::crypto::webauthn::signature>();
       };
@@ -3132,24 +3714,37 @@ namespace eosio {
 
    // called from connection strand
    bool connection::process_next_trx_message(uint32_t message_length) {
-      if( !my_impl->p2p_accept_transactions ) {
-         peer_dlog( this, "p2p-accept-transaction=false - dropping trx" );
-         pending_message_buffer.advance_read_ptr( message_length );
-         return true;
-      }
-      if (my_impl->sync_master->syncing_from_peer()) {
-         peer_dlog(this, "syncing, dropping trx");
+      if( !accept_trx_message() ) {
          pending_message_buffer.advance_read_ptr( message_length );
          return true;
       }
 
-      const unsigned long trx_in_progress_sz = this->trx_in_progress_size.load();
-
       auto ds = pending_message_buffer.create_datastream();
       unsigned_int which{};
       fc::raw::unpack( ds, which );
       shared_ptr<packed_transaction> ptr = std::make_shared<packed_transaction>();
       fc::raw::unpack( ds, *ptr );
+      process_trx_message( std::move( ptr ) );
+      return true;
+   }
+
+   // called from connection strand
+   // @return false if transactions are not accepted from the peer
+   bool connection::accept_trx_message() {
+      if( !my_impl->p2p_accept_transactions ) {
+         peer_dlog( this, "p2p-accept-transaction=false - dropping trx" );
+         return false;
+      }
+      if (my_impl->sync_master->syncing_from_peer()) {
+         peer_dlog(this, "syncing, dropping trx");
+         return false;
+      }
+      return true;
+   }
+
+   // called from connection strand
+   void connection::process_trx_message(packed_transaction_ptr ptr) {
+      const unsigned long trx_in_progress_sz = this->trx_in_progress_size.load();
       if( trx_in_progress_sz > def_max_trx_in_progress_size) {
          char reason[72];
          snprintf(reason, 72, "Dropping trx, too many trx in progress %lu bytes", trx_in_progress_sz);
@@ -3161,18 +3756,57 @@ namespace eosio {
             }
             peer_wlog(this, reason);
          }
-         return true;
+         return;
       }
       bool have_trx = my_impl->dispatcher.have_txn( ptr->id() );
       my_impl->dispatcher.add_peer_txn( ptr->id(), ptr->expiration(), connection_id );
 
       if( have_trx ) {
          peer_dlog( this, "got a duplicate transaction - dropping" );
-         return true;
+         ++my_impl->dispatcher.duplicate_trxs_received;
+         return;
       }
 
       handle_message( std::move( ptr ) );
-      return true;
+   }
+
+   // called from connection strand
+   bool connection::process_next_compressed_message(uint32_t message_length) {
+      auto ds = pending_message_buffer.create_datastream();
+      unsigned_int which{};
+      fc::raw::unpack( ds, which ); // throw away
+      compressed_message msg;
+      fc::raw::unpack( ds, msg );
+      if( msg.which == packed_transaction_which && !accept_trx_message() ) {
+         return true;
+      }
+
+      // decompressed size is limited the same as an uncompressed message
+      const std::vector<char> data = net_utils::zstd_decompress( msg.data, def_send_buffer_size*2 );
+      fc::datastream<const char*> data_ds( data.data(), data.size() );
+      if( msg.which == signed_block_which ) {
+         latest_blk_time = std::chrono::system_clock::now();
+         auto peek_ds = data_ds;
+         block_header bh;
+         fc::raw::unpack( peek_ds, bh );
+         const block_id_type blk_id = bh.calculate_id();
+         if( !accept_block_message( bh, blk_id, message_length ) ) {
+            return true;
+         }
+
+         shared_ptr<signed_block> ptr = std::make_shared<signed_block>();
+         fc::raw::unpack( data_ds, *ptr );
+         return process_block_message( blk_id, std::move( ptr ) );
+      } else if( msg.which == packed_transaction_which ) {
+         shared_ptr<packed_transaction> ptr = std::make_shared<packed_transaction>();
+         fc::raw::unpack( data_ds, *ptr );
+         process_trx_message( std::move( ptr ) );
+         return true;
+      }
+
+      peer_wlog( this, "Invalid compressed_message of ${w}, closing connection", ("w", msg.which.value) );
+      close();
+      return false;
    }
 
    void net_plugin_impl::plugin_shutdown() {
@@ -3538,9 +4172,15 @@ namespace eosio {
          close( false );
          return;
       }
+      if( msg.known_trx.ids.size() > def_max_trx_announce_ids ) {
+         peer_wlog( this, "Invalid notice_message, known_trx.ids.size ${s}, closing connection",
+                    ("s", msg.known_trx.ids.size()) );
+         close( false );
+         return;
+      }
       if( msg.known_trx.mode != none ) {
          if( logger.is_enabled( fc::log_level::debug ) ) {
-            const block_id_type& blkid = msg.known_blocks.ids.empty() ? block_id_type{} : msg.known_blocks.ids.back();
+            const block_id_type& blkid = msg.known_blocks.ids.empty() ? block_id_type{} : msg.known_blocks.ids.front();
             peer_dlog( this, "this is a ${m} notice with ${n} pending blocks: ${num} ${id}...",
                        ("m", modes_str( msg.known_blocks.mode ))("n", msg.known_blocks.pending)
                        ("num", block_header::num_from_id( blkid ))("id", blkid.str().substr( 8, 16 )) );
@@ -3557,6 +4197,9 @@ namespace eosio {
       case catch_up:
          break;
       case normal: {
+         if( !msg.known_trx.ids.empty() ) {
+            request_announced_trxs( msg.known_trx.ids );
+         }
          my_impl->dispatcher.recv_notice( shared_from_this(), msg, false );
       }
       }
@@ -3621,14 +4264,23 @@ namespace eosio {
          if( msg.req_blocks.mode == none ) {
             stop_send();
          }
-         // no break
-      case normal :
          if( !msg.req_trx.ids.empty() ) {
             peer_wlog( this, "Invalid request_message, req_trx.ids.size ${s}", ("s", msg.req_trx.ids.size()) );
             close();
             return;
          }
          break;
+      case normal :
+         if( !msg.req_trx.ids.empty() ) {
+            // only requested of peers that announce transaction ids
+            if( protocol_version < proto_trx_announce || msg.req_trx.ids.size() > def_max_trx_announce_ids ) {
+               peer_wlog( this, "Invalid request_message, req_trx.ids.size ${s}", ("s", msg.req_trx.ids.size()) );
+               close();
+               return;
+            }
+            send_requested_trxs( msg.req_trx.ids );
+         }
+         break;
       default:;
       }
    }
@@ -3687,59 +4339,87 @@ namespace eosio {
    // called from connection strand
    void connection::handle_message( const block_id_type& id, signed_block_ptr ptr ) {
       // post to dispatcher strand so that we don't have multiple threads validating the block header
-      my_impl->dispatcher.strand.post([id, c{shared_from_this()}, ptr{std::move(ptr)}, cid=connection_id]() mutable {
-         controller& cc = my_impl->chain_plug->chain();
+      my_impl->dispatcher.strand.post([id, c{shared_from_this()}, ptr{std::move(ptr)}]() mutable {
+         c->process_block_header( id, std::move(ptr), priority::medium );
+      });
+   }
 
-         // may have come in on a different connection and posted into dispatcher strand before this one
-         if( my_impl->dispatcher.have_block( id ) || cc.fetch_block_state_by_id( id ) ) { // thread-safe
-            my_impl->dispatcher.add_peer_block( id, c->connection_id );
-            c->strand.post( [c, id]() {
-               my_impl->sync_master->sync_recv_block( c, id, block_header::num_from_id(id), false );
-            });
-            return;
-         }
+   // called from dispatcher strand
+   void connection::process_block_header( const block_id_type& id, signed_block_ptr ptr, int apply_priority ) {
+      // use c in this method instead of this to highlight that all methods called on c-> must be thread safe
+      connection_ptr c = shared_from_this();
+      const uint32_t cid = connection_id;
+      controller& cc = my_impl->chain_plug->chain();
 
-         block_state_legacy_ptr bsp;
-         bool exception = false;
-         try {
-            // this may return null if block is not immediately ready to be processed
-            bsp = cc.create_block_state( id, ptr );
-         } catch( const fc::exception& ex ) {
-            exception = true;
-            fc_ilog( logger, "bad block exception connection ${cid}: #${n} ${id}...: ${m}",
-                     ("cid", cid)("n", ptr->block_num())("id", id.str().substr(8,16))("m",ex.to_string()));
-         } catch( ... ) {
-            exception = true;
-            fc_wlog( logger, "bad block connection ${cid}: #${n} ${id}...: unknown exception",
-                     ("cid", cid)("n", ptr->block_num())("id", id.str().substr(8,16)));
-         }
-         if( exception ) {
-            c->strand.post( [c, id, blk_num=ptr->block_num()]() {
-               my_impl->sync_master->rejected_block( c, blk_num );
+      // may have come in on a different connection and posted into dispatcher strand before this one
+      if( my_impl->dispatcher.have_block( id ) || cc.fetch_block_state_by_id( id ) ) { // thread-safe
+         my_impl->dispatcher.add_peer_block( id, c->connection_id );
+         c->strand.post( [c, id]() {
+            my_impl->sync_master->sync_recv_block( c, id, block_header::num_from_id(id), false );
+         });
+         return;
+      }
+
+      block_state_legacy_ptr bsp;
+      bool exception = false;
+      try {
+         // this may return null if block is not immediately ready to be processed
+         bsp = cc.create_block_state( id, ptr );
+      } catch( const fc::exception& ex ) {
+         exception = true;
+         fc_ilog( logger, "bad block exception connection ${cid}: #${n} ${id}...: ${m}",
+                  ("cid", cid)("n", ptr->block_num())("id", id.str().substr(8,16))("m",ex.to_string()));
+      } catch( ... ) {
+         exception = true;
+         fc_wlog( logger, "bad block connection ${cid}: #${n} ${id}...: unknown exception",
+                  ("cid", cid)("n", ptr->block_num())("id", id.str().substr(8,16)));
+      }
+      if( exception ) {
+         c->strand.post( [c, id, blk_num=ptr->block_num()]() {
+            my_impl->sync_master->rejected_block( c, blk_num );
+            my_impl->dispatcher.rejected_block( id );
+         });
+         return;
+      }
+
+      if( !bsp && my_impl->sync_master->syncing_from_peer() ) {
+         const uint32_t blk_num = ptr->block_num();
+         if( my_impl->dispatcher.sync_accepted_header_num != 0 && blk_num <= my_impl->dispatcher.sync_accepted_header_num + 1 ) {
+            // the block before it was accepted before this one was received, it does not link
+            fc_dlog( logger, "block #${n} ${id}... does not link to accepted block #${a}, connection ${cid}",
+                     ("n", blk_num)("id", id.str().substr(8,16))("a", my_impl->dispatcher.sync_accepted_header_num)("cid", cid) );
+            my_impl->dispatcher.rm_unlinkable_blocks( c );
+            c->strand.post( [c, id, blk_num]() {
+               my_impl->sync_master->unlinked_block( c, blk_num );
                my_impl->dispatcher.rejected_block( id );
             });
             return;
          }
+         // received ahead of the block it links to, held until that block header is accepted and then validated
+         // here while that block is applied, see on_accepted_block_header
+         fc_dlog( logger, "holding block #${n} ${id}... until ${p}... is accepted, connection ${cid}",
+                  ("n", blk_num)("id", id.str().substr(8,16))("p", ptr->previous.str().substr(8,16))("cid", cid) );
+         my_impl->dispatcher.add_unlinkable_block( std::move(ptr), id, std::move(c) );
+         return;
+      }
 
+      uint32_t block_num = bsp ? bsp->block_num : 0;
 
-         uint32_t block_num = bsp ? bsp->block_num : 0;
-
-         if( block_num != 0 ) {
-            fc_dlog( logger, "validated block header, broadcasting immediately, connection ${cid}, blk num = ${num}, id = ${id}",
-                     ("cid", cid)("num", block_num)("id", bsp->id) );
-            my_impl->dispatcher.add_peer_block( bsp->id, cid ); // no need to send back to sender
-            my_impl->dispatcher.bcast_block( bsp->block, bsp->id );
-         }
-
-         app().executor().post(priority::medium, exec_queue::read_write, [ptr{std::move(ptr)}, bsp{std::move(bsp)}, id, c{std::move(c)}]() mutable {
-            c->process_signed_block( id, std::move(ptr), std::move(bsp) );
-         });
+      if( block_num != 0 ) {
+         fc_dlog( logger, "validated block header, broadcasting immediately, connection ${cid}, blk num = ${num}, id = ${id}",
+                  ("cid", cid)("num", block_num)("id", bsp->id) );
+         my_impl->dispatcher.add_peer_block( bsp->id, cid ); // no need to send back to sender
+         my_impl->dispatcher.bcast_block( bsp->block, bsp->id );
+      }
 
-         if( block_num != 0 ) {
-            // ready to process immediately, so signal producer to interrupt start_block
-            my_impl->producer_plug->received_block(block_num);
-         }
+      app().executor().post(apply_priority, exec_queue::read_write, [ptr{std::move(ptr)}, bsp{std::move(bsp)}, id, c{std::move(c)}]() mutable {
+         c->process_signed_block( id, std::move(ptr), std::move(bsp) );
       });
+
+      if( block_num != 0 ) {
+         // ready to process immediately, so signal producer to interrupt start_block
+         my_impl->producer_plug->received_block(block_num);
+      }
    }
 
    // called from application thread
@@ -3823,7 +4503,7 @@ namespace eosio {
          c->strand.post( [sync_master = my_impl->sync_master.get(), &dispatcher = my_impl->dispatcher, c,
                           block{std::move(block)}, blk_id, blk_num, reason]() mutable {
             if( reason == unlinkable || reason == no_reason ) {
-               dispatcher.add_unlinkable_block( std::move(block), blk_id );
+               dispatcher.add_unlinkable_block( std::move(block), blk_id, c );
             }
             // reason==no_reason means accept_block() return false because we are producing, don't call rejected_block which sends handshake
             if( reason != no_reason ) {
@@ -3873,9 +4553,26 @@ namespace eosio {
          } );
    }
 
+   // thread safe
+   void net_plugin_impl::start_trx_request_timer() {
+      if( in_shutdown ) return;
+      fc::lock_guard g( trx_request_timer_mtx );
+      trx_request_timer.expires_from_now( def_trx_request_timeout );
+      trx_request_timer.async_wait( [my = shared_from_this()]( boost::system::error_code ec ) {
+         if( !ec ) {
+            my->retry_trx_requests();
+         } else {
+            if( my->in_shutdown ) return;
+            fc_elog( logger, "Error from transaction request monitor: ${m}", ("m", ec.message()) );
+            my->start_trx_request_timer();
+         }
+      } );
+   }
+
    void net_plugin_impl::start_monitors() {
       connections.start_conn_timers();
       start_expire_timer();
+      start_trx_request_timer();
    }
 
    void net_plugin_impl::expire() {
@@ -3888,6 +4585,27 @@ namespace eosio {
       start_expire_timer();
    }
 
+   void net_plugin_impl::retry_trx_requests() {
+      std::vector<trx_request_tracker::request> retries = dispatcher.retry_announced_txns( time_point::now() );
+      if( !retries.empty() ) {
+         std::map<uint32_t, vector<transaction_id_type>> ids_by_connection;
+         for( const auto& r : retries ) {
+            ids_by_connection[r.connection_id].push_back( r.id );
+         }
+         fc_dlog( logger, "requesting ${n} announced trxs again from ${c} peers", ("n", retries.size())("c", ids_by_connection.size()) );
+         connections.for_each_connection( [&ids_by_connection]( const connection_ptr& c ) {
+            auto it = ids_by_connection.find( c->connection_id );
+            if( it != ids_by_connection.end() ) {
+               c->strand.post( [c, ids = std::move( it->second )]() {
+                  c->send_trx_request( ids );
+               } );
+            }
+         } );
+      }
+
+      start_trx_request_timer();
+   }
+
    // called from application thread
    void net_plugin_impl::on_accepted_block_header(const signed_block_ptr& block, const block_id_type& id) {
       update_chain_info();
@@ -3895,6 +4613,29 @@ namespace eosio {
       dispatcher.strand.post([block, id]() {
          fc_dlog(logger, "signaled accepted_block_header, blk num = ${num}, id = ${id}", ("num", block->block_num())("id", id));
          my_impl->dispatcher.bcast_block(block, id);
+
+         // validate the headers of blocks held until this one was accepted while this one is applied, so they are
+         // ready to be applied right after it
+         while (true) {
+            unlinkable_block_state linkable = my_impl->dispatcher.pop_possible_linkable_block(id);
+            if (!linkable.block)
+               break;
+            // post at medium_high since this is likely the next block that should be processed
+            linkable.conn->process_block_header(linkable.id, std::move(linkable.block), priority::medium_high);
+         }
+
+         if (my_impl->sync_master->syncing_from_peer()) {
+            // sync blocks are irreversible, held blocks that are next after this one and did not link never will
+            my_impl->dispatcher.sync_accepted_header_num = block->block_num();
+            for (const unlinkable_block_state& unlinked : my_impl->dispatcher.pop_unlinked_blocks(id)) {
+               fc_dlog(logger, "block #${n} ${id}... does not link to accepted block ${a}, connection ${cid}",
+                       ("n", unlinked.block_num())("id", unlinked.id.str().substr(8,16))("a", id)("cid", unlinked.conn->connection_id));
+               unlinked.conn->strand.post([c = unlinked.conn, unlinked_id = unlinked.id, blk_num = unlinked.block_num()]() {
+                  my_impl->sync_master->unlinked_block(c, blk_num);
+                  my_impl->dispatcher.rejected_block(unlinked_id);
+               });
+            }
+         }
       });
    }
 
@@ -4084,6 +4825,11 @@ namespace eosio {
            "Number of blocks to retrieve in a chunk from any individual peer during synchronization")
          ( "sync-peer-limit", bpo::value<uint32_t>()->default_value(3),
            "Number of peers to sync from")
+         ( "sync-fetch-ranges", bpo::value<uint32_t>()->default_value(1),
+           "Number of chunks of sync-fetch-span blocks requested at once during synchronization, each from a different peer. "
+           "Blocks received ahead of the blocks before them are held until those arrive, "
+           "up to (sync-fetch-ranges + 1) * sync-fetch-span blocks. The rest of a chunk is requested from another peer "
+           "when its peer is too slow.")
          ( "use-socket-read-watermark", bpo::value<bool>()->default_value(false), "Enable experimental socket read watermark optimization")
          ( "peer-log-format", bpo::value<string>()->default_value( "[\"${_name}\" - ${_cid} ${_ip}:${_port}] " ),
            "The string used to format peers when logging messages about them.  Variables are escaped with ${<variable name>}.\n"
@@ -4097,6 +4843,17 @@ namespace eosio {
            "   _lip   \tlocal IP address connected to peer\n\n"
            "   _lport \tlocal port number connected to peer\n\n")
          ( "p2p-keepalive-interval-ms", bpo::value<int>()->default_value(def_keepalive_interval), "peer heartbeat keepalive message interval in milliseconds")
+         ( "p2p-compression-level", bpo::value<int>()->default_value(0),
+           "zstd compression level (1-22) of blocks and transactions sent to peers that support compression, 0 to send uncompressed. "
+           "Trades CPU for bandwidth, useful on bandwidth limited links.")
+         ( "p2p-compression-threshold", bpo::value<uint32_t>()->default_value(def_compression_threshold),
+           "Blocks and transactions smaller than this number of bytes are sent uncompressed")
+         ( "p2p-trx-announce", bpo::value<bool>()->default_value(false),
+           "Announce the ids of transactions to peers that support it, which request the transactions they do not have, "
+           "instead of sending every transaction to every peer. Saves bandwidth at the cost of a round trip per transaction.")
+         ( "p2p-block-buffer-cache-size-mb", bpo::value<uint32_t>()->default_value(block_buffer_cache::default_max_size / (1024 * 1024)),
+           "Maximum size (in MiB) of the cache of blocks packed for sending to peers, shared by all peers. Should hold the "
+           "reversible blocks and the blocks syncing peers are fetching, least recently used blocks are evicted first.")
 
         ;
    }
@@ -4122,16 +4879,26 @@ namespace eosio {
          keepalive_interval = std::chrono::milliseconds( options.at( "p2p-keepalive-interval-ms" ).as<int>() );
          EOS_ASSERT( keepalive_interval.count() > 0, chain::plugin_config_exception,
                      "p2p-keepalive_interval-ms must be greater than 0" );
+         p2p_compression_level = options.at( "p2p-compression-level" ).as<int>();
+         EOS_ASSERT( p2p_compression_level >= 0 && p2p_compression_level <= 22, chain::plugin_config_exception,
+                     "p2p-compression-level must be 0 - 22" );
+         p2p_compression_threshold = options.at( "p2p-compression-threshold" ).as<uint32_t>();
+         p2p_trx_announce = options.at( "p2p-trx-announce" ).as<bool>();
 
          // To avoid unnecessary transitions between LIB <-> head catchups,
          // min_blocks_distance between LIB and head must be reached.
          // Set it to the number of blocks produced during half of keep alive
          // interval.
          const uint32_t min_blocks_distance = (keepalive_interval.count() / config::block_interval_ms) / 2;
+         const uint32_t sync_fetch_ranges = options.at( "sync-fetch-ranges" ).as<uint32_t>();
+         EOS_ASSERT( sync_fetch_ranges > 0, chain::plugin_config_exception, "sync-fetch-ranges must be greater than 0" );
          sync_master = std::make_unique<sync_manager>(
              options.at( "sync-fetch-span" ).as<uint32_t>(),
              options.at( "sync-peer-limit" ).as<uint32_t>(),
+             sync_fetch_ranges,
              min_blocks_distance);
+         dispatcher.set_max_blocks_ahead( sync_master->max_blocks_ahead() );
+         dispatcher.block_buffers.set_max_size( size_t{options.at( "p2p-block-buffer-cache-size-mb" ).as<uint32_t>()} * 1024 * 1024 );
 
          connections.init( std::chrono::milliseconds( options.at("p2p-keepalive-interval-ms").as<int>() * 2 ),
                                fc::milliseconds( options.at("max-cleanup-time-msec").as<uint32_t>() ),
@@ -4753,7 +5520,14 @@ namespace eosio {
          });
       }
       g.unlock();
-      update_p2p_connection_metrics({num_peers+num_bp_peers, num_clients, std::move(per_connection)});
+      net_plugin::p2p_connections_metrics metrics{num_peers+num_bp_peers, num_clients, std::move(per_connection)};
+      metrics.block_bytes_packed = my_impl->dispatcher.block_buffers.get_bytes_packed();
+      metrics.block_bytes_sent = my_impl->dispatcher.block_buffers.get_bytes_sent();
+      metrics.trx_bytes_sent = my_impl->dispatcher.trx_bytes_sent;
+      metrics.trx_announce_bytes_sent = my_impl->dispatcher.trx_announce_bytes_sent;
+      metrics.trxs_requested = my_impl->dispatcher.trxs_requested;
+      metrics.duplicate_trxs_received = my_impl->dispatcher.duplicate_trxs_received;
+      update_p2p_connection_metrics(std::move(metrics));
       start_conn_timer( connector_period, {}, timer_type::stats );
    }
 } // namespace eosio
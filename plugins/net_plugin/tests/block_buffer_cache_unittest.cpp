@@ -0,0 +1,119 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/net_plugin/block_buffer_cache.hpp>
+#include <fc/bitutil.hpp>
+
+using eosio::block_buffer_cache;
+using eosio::chain::block_id_type;
+
+namespace {
+
+constexpr size_t buffer_size = 100;
+
+// id of block num on fork, the block number is stored in the id as block_header::calculate_id() does
+block_id_type block_id(uint32_t num, int fork = 0) {
+   block_id_type id = block_id_type::hash(std::to_string(num) + "-" + std::to_string(fork));
+   id._hash[0] &= 0xffffffff00000000;
+   id._hash[0] += fc::endian_reverse_u32(num);
+   return id;
+}
+
+struct counting_factory {
+   size_t created = 0;
+
+   auto operator()() {
+      ++created;
+      return std::make_shared<std::vector<char>>(buffer_size);
+   }
+};
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(block_buffer_cache_tests)
+
+BOOST_AUTO_TEST_CASE(hit) {
+   block_buffer_cache cache;
+   counting_factory factory;
+
+   auto b1 = cache.get_send_buffer(block_id(1), std::ref(factory));
+   BOOST_CHECK_EQUAL(factory.created, 1u);
+   BOOST_CHECK(cache.get_send_buffer(block_id(1), std::ref(factory)) == b1);
+   BOOST_CHECK_EQUAL(factory.created, 1u);
+   BOOST_CHECK_EQUAL(cache.get_bytes_packed(), buffer_size);
+
+   // compressed once and shared
+   size_t compressed = 0;
+   auto compress = [&]() { ++compressed; return std::make_shared<std::vector<char>>(buffer_size / 2); };
+   auto c1 = cache.get_compressed_send_buffer(b1, compress);
+   BOOST_CHECK(cache.get_compressed_send_buffer(b1, compress) == c1);
+   BOOST_CHECK_EQUAL(compressed, 1u);
+   BOOST_CHECK_EQUAL(cache.memory_size(), buffer_size + buffer_size / 2);
+
+   // found by number once fetched as irreversible
+   size_t fetched = 0;
+   auto fetch = [&]() {
+      ++fetched;
+      return std::optional(std::make_pair(block_id(2), std::make_shared<std::vector<char>>(buffer_size)));
+   };
+   auto b2 = cache.get_irreversible_send_buffer(2, fetch);
+   BOOST_CHECK(cache.get_irreversible_send_buffer(2, fetch) == b2);
+   BOOST_CHECK(cache.get_send_buffer(block_id(2), std::ref(factory)) == b2);
+   BOOST_CHECK_EQUAL(fetched, 1u);
+   BOOST_CHECK_EQUAL(factory.created, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(lru_eviction) {
+   block_buffer_cache cache(3 * buffer_size);
+   counting_factory factory;
+
+   auto b1 = cache.get_send_buffer(block_id(1), std::ref(factory));
+   cache.get_send_buffer(block_id(2), std::ref(factory));
+   cache.get_send_buffer(block_id(3), std::ref(factory));
+   BOOST_CHECK_EQUAL(cache.size(), 3u);
+
+   // 1 is used again, 2 is now the least recently used although 1 is the lowest block number
+   BOOST_CHECK(cache.get_send_buffer(block_id(1), std::ref(factory)) == b1);
+   cache.get_send_buffer(block_id(4), std::ref(factory));
+   BOOST_CHECK_EQUAL(cache.size(), 3u);
+   BOOST_CHECK_EQUAL(cache.memory_size(), 3 * buffer_size);
+   BOOST_CHECK_EQUAL(factory.created, 4u);
+
+   BOOST_CHECK(cache.get_send_buffer(block_id(1), std::ref(factory)) == b1);
+   BOOST_CHECK_EQUAL(factory.created, 4u);
+   cache.get_send_buffer(block_id(2), std::ref(factory));
+   BOOST_CHECK_EQUAL(factory.created, 5u);
+
+   // a smaller limit evicts right away, the most recently used block is always kept
+   cache.set_max_size(0);
+   BOOST_CHECK_EQUAL(cache.size(), 1u);
+   cache.get_send_buffer(block_id(2), std::ref(factory));
+   BOOST_CHECK_EQUAL(factory.created, 5u);
+}
+
+BOOST_AUTO_TEST_CASE(fork_switch) {
+   block_buffer_cache cache;
+   counting_factory factory;
+
+   // blocks 2 and 3 on two forks
+   auto a2 = cache.get_send_buffer(block_id(2, 0), std::ref(factory));
+   auto a3 = cache.get_send_buffer(block_id(3, 0), std::ref(factory));
+   auto b2 = cache.get_send_buffer(block_id(2, 1), std::ref(factory));
+   auto b3 = cache.get_send_buffer(block_id(3, 1), std::ref(factory));
+   BOOST_CHECK(a2 != b2);
+   BOOST_CHECK(a3 != b3);
+   BOOST_CHECK_EQUAL(factory.created, 4u);
+   BOOST_CHECK(cache.get_send_buffer(block_id(3, 1), std::ref(factory)) == b3);
+
+   // reversible blocks are not served by number, the irreversible one is fetched from the block log
+   auto fetch = [&]() { return std::optional(std::make_pair(block_id(2, 1), std::make_shared<std::vector<char>>(buffer_size))); };
+   BOOST_CHECK(cache.get_irreversible_send_buffer(2, fetch) == b2);
+
+   // fork 1 became irreversible at 3, the reversible blocks at or below lib are dropped
+   cache.expire_blocks(3);
+   BOOST_CHECK_EQUAL(cache.size(), 1u);
+   BOOST_CHECK(cache.get_irreversible_send_buffer(2, []() { return std::optional<std::pair<block_id_type, std::shared_ptr<std::vector<char>>>>{}; }) == b2);
+   BOOST_CHECK(cache.get_send_buffer(block_id(3, 0), std::ref(factory)) != a3);
+   BOOST_CHECK_EQUAL(factory.created, 5u);
+   BOOST_CHECK_EQUAL(cache.memory_size(), 2 * buffer_size);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
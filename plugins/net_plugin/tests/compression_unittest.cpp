@@ -0,0 +1,24 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/net_plugin/net_utils.hpp>
+
+BOOST_AUTO_TEST_CASE(test_zstd_compression) {
+   std::string in;
+   for( size_t i = 0; i < 10000; ++i ) {
+      in += "transfer " + std::to_string(i % 100) + " ";
+   }
+   std::vector<char> compressed = eosio::net_utils::zstd_compress(in.data(), in.size(), 3);
+   BOOST_CHECK_LT(compressed.size(), in.size());
+
+   std::vector<char> decompressed = eosio::net_utils::zstd_decompress(compressed, in.size());
+   BOOST_CHECK_EQUAL(std::string(decompressed.begin(), decompressed.end()), in);
+
+   BOOST_CHECK(eosio::net_utils::zstd_decompress(eosio::net_utils::zstd_compress(in.data(), 0, 1), 0).empty());
+
+   BOOST_CHECK_EXCEPTION(eosio::net_utils::zstd_decompress(compressed, in.size() - 1), eosio::chain::plugin_exception,
+                         [](const eosio::chain::plugin_exception& e)
+                         {return std::strstr(e.top_message().c_str(), "compressed message larger than");});
+   std::vector<char> not_compressed(in.begin(), in.end());
+   BOOST_CHECK_EXCEPTION(eosio::net_utils::zstd_decompress(not_compressed, in.size()), eosio::chain::plugin_exception,
+                         [](const eosio::chain::plugin_exception& e)
+                         {return std::strstr(e.top_message().c_str(), "invalid compressed message");});
+}
@@ -0,0 +1,105 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/net_plugin/trx_request_tracker.hpp>
+
+using eosio::trx_request_tracker;
+using eosio::chain::transaction_id_type;
+
+namespace {
+
+const fc::microseconds timeout = fc::seconds(1);
+const fc::time_point   start   = fc::time_point::now();
+
+transaction_id_type trx_id(int n) {
+   return transaction_id_type::hash(std::to_string(n));
+}
+
+bool requested(const std::vector<trx_request_tracker::request>& requests, uint32_t connection_id, int n) {
+   return std::any_of(requests.begin(), requests.end(), [&](const auto& r) {
+      return r.connection_id == connection_id && r.id == trx_id(n);
+   });
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(trx_request_tracker_tests)
+
+BOOST_AUTO_TEST_CASE(requested_from_first_announcer) {
+   trx_request_tracker tracker(timeout);
+   BOOST_CHECK(tracker.announced(trx_id(1), 1, start));
+   BOOST_CHECK(!tracker.announced(trx_id(1), 2, start));
+   BOOST_CHECK(!tracker.announced(trx_id(1), 1, start));
+   BOOST_CHECK(tracker.announced(trx_id(2), 2, start));
+   BOOST_CHECK_EQUAL(tracker.size(), 2u);
+
+   // nothing is due before the timeout
+   BOOST_CHECK(tracker.retry(start + timeout - fc::microseconds(1)).empty());
+}
+
+BOOST_AUTO_TEST_CASE(retried_from_next_announcer) {
+   trx_request_tracker tracker(timeout);
+   tracker.announced(trx_id(1), 1, start);
+   tracker.announced(trx_id(1), 2, start);
+   tracker.announced(trx_id(1), 3, start);
+   // announced again by a peer it is already requested from or queued for
+   tracker.announced(trx_id(1), 2, start);
+
+   auto retries = tracker.retry(start + timeout);
+   BOOST_REQUIRE_EQUAL(retries.size(), 1u);
+   BOOST_CHECK(requested(retries, 2, 1));
+
+   // the timeout restarts with the new request
+   BOOST_CHECK(tracker.retry(start + timeout + timeout - fc::microseconds(1)).empty());
+   retries = tracker.retry(start + timeout + timeout);
+   BOOST_REQUIRE_EQUAL(retries.size(), 1u);
+   BOOST_CHECK(requested(retries, 3, 1));
+
+   // no peer left that announced it
+   BOOST_CHECK(tracker.retry(start + fc::seconds(3)).empty());
+   BOOST_CHECK_EQUAL(tracker.size(), 0u);
+
+   // a later announcement requests it again
+   BOOST_CHECK(tracker.announced(trx_id(1), 4, start + fc::seconds(3)));
+}
+
+BOOST_AUTO_TEST_CASE(received_is_not_retried) {
+   trx_request_tracker tracker(timeout);
+   tracker.announced(trx_id(1), 1, start);
+   tracker.announced(trx_id(1), 2, start);
+   tracker.announced(trx_id(2), 1, start);
+   tracker.announced(trx_id(2), 2, start);
+
+   tracker.received(trx_id(1));
+   tracker.received(trx_id(3));
+   BOOST_CHECK_EQUAL(tracker.size(), 1u);
+
+   auto retries = tracker.retry(start + timeout);
+   BOOST_REQUIRE_EQUAL(retries.size(), 1u);
+   BOOST_CHECK(requested(retries, 2, 2));
+}
+
+BOOST_AUTO_TEST_CASE(connection_closed) {
+   trx_request_tracker tracker(timeout);
+   tracker.announced(trx_id(1), 1, start);
+   tracker.announced(trx_id(1), 2, start);
+   tracker.announced(trx_id(1), 3, start);
+   tracker.announced(trx_id(2), 2, start);
+   tracker.announced(trx_id(2), 1, start);
+   tracker.announced(trx_id(2), 3, start);
+
+   // requests from 1 are due right away, 1 is no longer next in line for 2
+   tracker.connection_closed(1, start);
+   auto retries = tracker.retry(start);
+   BOOST_REQUIRE_EQUAL(retries.size(), 1u);
+   BOOST_CHECK(requested(retries, 2, 1));
+
+   retries = tracker.retry(start + timeout);
+   BOOST_REQUIRE_EQUAL(retries.size(), 2u);
+   BOOST_CHECK(requested(retries, 3, 1));
+   BOOST_CHECK(requested(retries, 3, 2));
+
+   tracker.connection_closed(3, start + timeout);
+   BOOST_CHECK(tracker.retry(start + timeout).empty());
+   BOOST_CHECK_EQUAL(tracker.size(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -39,6 +39,7 @@ public:
    struct integrity_hash_information {
       chain::block_id_type head_block_id;
       chain::digest_type   integrity_hash;
+      uint32_t             version = 1; ///< of the integrity hash, see controller::calculate_integrity_hash
    };
 
    struct scheduled_protocol_feature_activations {
@@ -187,7 +188,20 @@ public:
 
    void register_update_produced_block_metrics(std::function<void(produced_block_metrics)>&&);
    void register_update_speculative_block_metrics(std::function<void(speculative_block_metrics)>&&);
+   // reported at the end of each read-only read window
+   struct read_only_window_metrics {
+      int64_t     read_window_time_us      = 0; ///< time the read window lasted
+      int64_t     write_window_time_us     = 0; ///< time the write window before it lasted
+      int64_t     exec_time_us             = 0; ///< time spent by all read-only threads executing transactions
+      std::size_t read_queue_size          = 0; ///< read-only and read-exclusive tasks left at the end
+      std::size_t read_write_queue_size    = 0; ///< read-write tasks queued at the end
+      int64_t     next_read_window_time_us = 0; ///< effective time of the next read window
+   };
+
    void register_update_incoming_block_metrics(std::function<void(incoming_block_metrics)>&&);
+   void register_update_read_only_window_metrics(std::function<void(read_only_window_metrics)>&&);
+   // reported at the start of each block while background snapshots are enabled
+   void register_update_background_snapshot_metrics(std::function<void(chain::snapshot_scheduler::background_snapshot_stats)>&&);
 
    inline static bool test_mode_{false}; // to be moved into appbase (application_base)
 
@@ -200,7 +214,7 @@ public:
 FC_REFLECT(eosio::producer_plugin::runtime_options, (max_transaction_time)(max_irreversible_block_age)(produce_block_offset_ms)(subjective_cpu_leeway_us)(greylist_limit));
 FC_REFLECT(eosio::producer_plugin::greylist_params, (accounts));
 FC_REFLECT(eosio::producer_plugin::whitelist_blacklist, (actor_whitelist)(actor_blacklist)(contract_whitelist)(contract_blacklist)(action_blacklist)(key_blacklist) )
-FC_REFLECT(eosio::producer_plugin::integrity_hash_information, (head_block_id)(integrity_hash))
+FC_REFLECT(eosio::producer_plugin::integrity_hash_information, (head_block_id)(integrity_hash)(version))
 FC_REFLECT(eosio::producer_plugin::scheduled_protocol_feature_activations, (protocol_features_to_activate))
 FC_REFLECT(eosio::producer_plugin::get_supported_protocol_features_params, (exclude_disabled)(exclude_unactivatable))
 FC_REFLECT(eosio::producer_plugin::get_account_ram_corrections_params, (lower_bound)(upper_bound)(limit)(reverse))
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <boost/container/deque.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+namespace eosio {
+
+/**
+ * Thread-safe FIFO queue of the previously exhausted read-only transactions to be re-executed by read-only threads.
+ *
+ * Read-only threads tend to exhaust their transactions together at the end of a read window, so the queue is split
+ * into shards selected by the pushing thread to keep them from contending on a single lock. Every element is tagged
+ * with a global sequence number and each shard publishes the sequence number of its front, pop_front() takes the
+ * element with the smallest one so elements are popped in the order they were pushed and no shard is starved.
+ * Elements pushed concurrently by different threads may be popped in either order.
+ */
+template <typename T, size_t NumShards = 8>
+class ro_trx_queue {
+public:
+   void push_back(T&& t) {
+      shard& s = shards[std::hash<std::thread::id>()(std::this_thread::get_id()) % NumShards];
+      std::lock_guard g(s.mtx);
+      // taken under the shard lock so that each shard is ordered by sequence number
+      const uint64_t seq = next_seq.fetch_add(1, std::memory_order_relaxed);
+      if (s.queue.empty())
+         s.front_seq.store(seq, std::memory_order_release);
+      s.queue.push_back({seq, std::move(t)});
+      ++size;
+   }
+
+   bool empty() const {
+      return size == 0;
+   }
+
+   bool pop_front(T& t) {
+      while (size > 0) {
+         shard*   oldest     = nullptr;
+         uint64_t oldest_seq = empty_seq;
+         for (shard& s : shards) {
+            uint64_t seq = s.front_seq.load(std::memory_order_acquire);
+            if (seq < oldest_seq) {
+               oldest     = &s;
+               oldest_seq = seq;
+            }
+         }
+         if (!oldest) // last element is being popped by another thread
+            continue;
+
+         std::lock_guard g(oldest->mtx);
+         if (oldest->queue.empty() || oldest->queue.front().seq != oldest_seq)
+            continue; // popped by another thread, look again
+         t = std::move(oldest->queue.front().value);
+         oldest->queue.pop_front();
+         oldest->front_seq.store(oldest->queue.empty() ? empty_seq : oldest->queue.front().seq, std::memory_order_release);
+         --size;
+         return true;
+      }
+      return false;
+   }
+
+private:
+   static constexpr uint64_t empty_seq = std::numeric_limits<uint64_t>::max();
+
+   struct element {
+      uint64_t seq;
+      T        value;
+   };
+
+   struct alignas(64) shard {
+      std::mutex                       mtx;
+      std::atomic<uint64_t>            front_seq{empty_seq};
+      boost::container::deque<element> queue; // boost deque which is faster than std::deque
+   };
+
+   std::array<shard, NumShards> shards;
+   std::atomic<uint64_t>        next_seq{0};
+   std::atomic<size_t>          size{0};
+};
+
+} // namespace eosio
@@ -1,5 +1,6 @@
 #include <eosio/producer_plugin/producer_plugin.hpp>
 #include <eosio/producer_plugin/block_timing_util.hpp>
+#include <eosio/producer_plugin/ro_trx_queue.hpp>
 #include <eosio/chain/plugin_interface.hpp>
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/generated_transaction_object.hpp>
@@ -23,6 +24,7 @@
 #include <iostream>
 #include <algorithm>
 #include <mutex>
+#include <thread>
 
 using boost::signals2::scoped_connection;
 using std::string;
@@ -446,7 +448,8 @@ public:
          reschedule.cancel();
       }
 
-      return {chain.head_block_id(), chain.calculate_integrity_hash()};
+      const uint32_t version = chain.get_integrity_hash_version();
+      return {chain.head_block_id(), chain.calculate_integrity_hash(version), version};
    }
 
    void create_snapshot(producer_plugin::next_function<chain::snapshot_scheduler::snapshot_information> next) {
@@ -545,6 +548,8 @@ public:
    std::function<void(producer_plugin::produced_block_metrics)> _update_produced_block_metrics;
    std::function<void(producer_plugin::speculative_block_metrics)> _update_speculative_block_metrics;
    std::function<void(producer_plugin::incoming_block_metrics)> _update_incoming_block_metrics;
+   std::function<void(producer_plugin::read_only_window_metrics)> _update_read_only_window_metrics;
+   std::function<void(chain::snapshot_scheduler::background_snapshot_stats)> _update_background_snapshot_metrics;
 
    // ro for read-only
    struct ro_trx_t {
@@ -552,32 +557,7 @@ public:
       next_func_t              next;
    };
    // The queue storing previously exhausted read-only transactions to be re-executed by read-only threads
-   // thread-safe
-   class ro_trx_queue_t {
-   public:
-      void push_front(ro_trx_t&& t) {
-         std::lock_guard g(mtx);
-         queue.push_front(std::move(t));
-      }
-
-      bool empty() const {
-         std::lock_guard g(mtx);
-         return queue.empty();
-      }
-
-      bool pop_front(ro_trx_t& t) {
-         std::unique_lock g(mtx);
-         if (queue.empty())
-            return false;
-         t = queue.front();
-         queue.pop_front();
-         return true;
-      }
-
-   private:
-      mutable std::mutex mtx;
-      deque<ro_trx_t>    queue; // boost deque which is faster than std::deque
-   };
+   using ro_trx_queue_t = ro_trx_queue<ro_trx_t>;
 
    uint32_t _ro_thread_pool_size{0};
    // In EOS VM OC tierup, 10 pages (11 slices) virtual memory is reserved for
@@ -593,6 +573,13 @@ public:
    fc::microseconds                  _ro_read_window_time_us{60000};
    static constexpr fc::microseconds _ro_read_window_minimum_time_us{10000};
    fc::microseconds                  _ro_read_window_effective_time_us{0}; // calculated during option initialization
+   // adaptive windows: the configured windows are upper bounds, the write window ends early when the main thread is
+   // idle and read-only tasks are queued, the read window shrinks under read_write load and grows back with read load
+   bool                              _ro_adaptive_windows{false};
+   static constexpr fc::microseconds _ro_write_window_minimum_time_us{10000};
+   fc::microseconds                  _ro_read_window_target_time_us{0}; // effective time of the next read window
+   fc::time_point                    _ro_write_window_start_time;
+   fc::microseconds                  _ro_last_write_window_time_us{0};
    std::atomic<int64_t>              _ro_all_threads_exec_time_us; // total time spent by all threads executing transactions.
                                                                    // use atomic for simplicity and performance
    fc::time_point                 _ro_read_window_start_time;
@@ -604,7 +591,9 @@ public:
    std::vector<std::future<bool>> _ro_exec_tasks_fut;
 
    void start_write_window();
+   void start_write_window_timer(const fc::time_point& now);
    void switch_to_write_window();
+   void adapt_read_window(const fc::microseconds& read_window_time, size_t read_queue_size, size_t read_write_queue_size);
    void switch_to_read_window();
    bool read_only_execution_task(uint32_t pending_block_num);
    void repost_exhausted_transactions(const fc::time_point& deadline);
@@ -823,7 +812,8 @@ public:
                  transaction_metadata_ptr trx_meta;
                  try {
                     trx_meta = transaction_metadata::recover_keys(trx, chain.get_chain_id(), time_limit, trx_type,
-                                                                  chain.configured_subjective_signature_length_limit());
+                                                                  chain.configured_subjective_signature_length_limit(),
+                                                                  &chain.get_signature_recovery_cache());
                  } catch (...) {
                     // use read_write when read is likely fine; maintains previous behavior of next() always being called from the main thread
                     app().executor().post(
@@ -1082,12 +1072,18 @@ void producer_plugin::set_program_options(
           "Disable subjective CPU billing for API transactions")
          ("snapshots-dir", bpo::value<std::filesystem::path>()->default_value("snapshots"),
           "the location of the snapshots directory (absolute path or relative to application data dir)")
+         ("background-snapshots", bpo::bool_switch()->default_value(false),
+          "Write snapshots from a forked process holding a copy-on-write view of the state instead of stalling the main thread. "
+          "Requires a database-map-mode other than mapped. Memory use grows with the state modified while a snapshot is written.")
          ("read-only-threads", bpo::value<uint32_t>(),
          ("Number of worker threads in read-only execution thread pool. Defaults to 0 if configured as producer, otherwise defaults to "s + std::to_string(producer_plugin_impl::_ro_default_threads_nonproducer) + ". Max "s + std::to_string(producer_plugin_impl::_ro_max_threads_allowed) + "."s).c_str())
          ("read-only-write-window-time-us", bpo::value<uint32_t>()->default_value(my->_ro_write_window_time_us.count()),
           "Time in microseconds the write window lasts.")
          ("read-only-read-window-time-us", bpo::value<uint32_t>()->default_value(my->_ro_read_window_time_us.count()),
           "Time in microseconds the read window lasts.")
+         ("read-only-adaptive-windows", bpo::bool_switch()->default_value(false),
+          "Size the read-only read and write windows from the queued read-only and read-write tasks and the time spent executing "
+          "read-only transactions. read-only-write-window-time-us and read-only-read-window-time-us become upper bounds.")
          ;
    config_file_options.add(producer_options);
 }
@@ -1250,9 +1246,11 @@ void producer_plugin_impl::plugin_initialize(const boost::program_options::varia
                  "read-only-read-window-time-us (${read}) must be at least greater than  ${min} us",
                  ("read", _ro_read_window_time_us)("min", _ro_read_window_minimum_time_us));
       _ro_read_window_effective_time_us = _ro_read_window_time_us - _ro_read_window_minimum_time_us;
+      _ro_read_window_target_time_us    = _ro_read_window_effective_time_us;
+      _ro_adaptive_windows              = options.at("read-only-adaptive-windows").as<bool>();
 
-      ilog("read-only-write-window-time-us: ${ww} us, read-only-read-window-time-us: ${rw} us, effective read window time to be used: ${w} us",
-           ("ww", _ro_write_window_time_us)("rw", _ro_read_window_time_us)("w", _ro_read_window_effective_time_us));
+      ilog("read-only-write-window-time-us: ${ww} us, read-only-read-window-time-us: ${rw} us, effective read window time to be used: ${w} us, adaptive: ${a}",
+           ("ww", _ro_write_window_time_us)("rw", _ro_read_window_time_us)("w", _ro_read_window_effective_time_us)("a", _ro_adaptive_windows));
    }
    app().executor().init_read_threads(_ro_thread_pool_size);
 
@@ -1308,6 +1306,14 @@ void producer_plugin_impl::plugin_initialize(const boost::program_options::varia
 
    _snapshot_scheduler.set_db_path(_snapshots_dir);
    _snapshot_scheduler.set_snapshots_path(_snapshots_dir);
+
+   if (options.at("background-snapshots").as<bool>()) {
+      // with a shared mapping the forked process would see the state change under it
+      EOS_ASSERT(options.at("database-map-mode").as<chainbase::pinnable_mapped_file::map_mode>() != chainbase::pinnable_mapped_file::map_mode::mapped,
+                 plugin_config_exception, "background-snapshots requires database-map-mode mapped_private, heap or locked");
+      _snapshot_scheduler.set_background(true);
+      ilog("Snapshots are written in the background");
+   }
 }
 
 void producer_plugin::plugin_initialize(const boost::program_options::variables_map& options) {
@@ -1350,6 +1356,8 @@ void producer_plugin_impl::plugin_startup() {
          _block_start_connection.emplace(chain.block_start.connect([this, &chain](uint32_t bs) {
             try {
                _snapshot_scheduler.on_start_block(bs, chain);
+               if (_update_background_snapshot_metrics && _snapshot_scheduler.is_background())
+                  _update_background_snapshot_metrics(_snapshot_scheduler.get_background_snapshot_stats());
             } catch (const snapshot_execution_exception& e) {
                fc_elog(_log, "Exception during snapshot execution: ${e}", ("e", e.to_detail_string()));
                app().quit();
@@ -2707,7 +2715,44 @@ void producer_plugin_impl::switch_to_write_window() {
    EOS_ASSERT(_ro_num_active_exec_tasks.load() == 0 && _ro_exec_tasks_fut.empty(), producer_exception,
               "no read-only tasks should be running before switching to write window");
 
+   const fc::microseconds read_window_time = fc::time_point::now() - _ro_read_window_start_time;
    start_write_window();
+
+   // queue sizes can only be read in the write window
+   const size_t read_queue_size       = app().executor().read_only_queue_size() + app().executor().read_exclusive_queue_size();
+   const size_t read_write_queue_size = app().executor().read_write_queue_size();
+   if (_ro_adaptive_windows)
+      adapt_read_window(read_window_time, read_queue_size, read_write_queue_size);
+
+   if (_update_read_only_window_metrics) {
+      _update_read_only_window_metrics({.read_window_time_us      = read_window_time.count(),
+                                        .write_window_time_us     = _ro_last_write_window_time_us.count(),
+                                        .exec_time_us             = _ro_all_threads_exec_time_us.load(),
+                                        .read_queue_size          = read_queue_size,
+                                        .read_write_queue_size    = read_write_queue_size,
+                                        .next_read_window_time_us = _ro_read_window_target_time_us.count()});
+   }
+}
+
+// Called from app thread at the end of a read window.
+// Shrink the next read window while read_write tasks, like p2p transactions, pile up behind the read windows, grow it
+// back toward the configured read window while read-only tasks are left over and the read-only threads were busy.
+void producer_plugin_impl::adapt_read_window(const fc::microseconds& read_window_time, size_t read_queue_size, size_t read_write_queue_size) {
+   const int64_t capacity_us = read_window_time.count() * _ro_thread_pool_size;
+   const bool    busy        = capacity_us > 0 && _ro_all_threads_exec_time_us.load() * 2 > capacity_us; // over half utilized
+
+   fc::microseconds target = _ro_read_window_target_time_us;
+   if (read_write_queue_size > 0 && read_write_queue_size >= read_queue_size) {
+      target = fc::microseconds(target.count() / 2);
+   } else if (read_queue_size > 0 && busy) {
+      target = fc::microseconds(target.count() * 3 / 2);
+   }
+   // a read-only transaction allowed the max read-only transaction time must still fit in a read window
+   const fc::microseconds minimum = std::max(_ro_max_trx_time_us, _ro_read_window_minimum_time_us);
+   _ro_read_window_target_time_us = std::clamp(target, std::min(minimum, _ro_read_window_effective_time_us), _ro_read_window_effective_time_us);
+
+   fc_dlog(_log, "Read window ${r}us, read queue ${rq}, read_write queue ${wq}, next read window ${n}us",
+           ("r", read_window_time)("rq", read_queue_size)("wq", read_write_queue_size)("n", _ro_read_window_target_time_us));
 }
 
 // Called from app thread on plugin_startup
@@ -2721,9 +2766,18 @@ void producer_plugin_impl::start_write_window() {
    auto now = fc::time_point::now();
    _time_tracker.unpause(now);
 
+   _ro_write_window_start_time = now;
    _ro_window_deadline = now + _ro_write_window_time_us; // not allowed on block producers, so no need to limit to block deadline
-   auto expire_time = boost::posix_time::microseconds(_ro_write_window_time_us.count());
-   _ro_timer.expires_from_now(expire_time);
+   start_write_window_timer(now);
+}
+
+// Called only from app thread during the write window
+void producer_plugin_impl::start_write_window_timer(const fc::time_point& now) {
+   fc::microseconds expire_time = _ro_window_deadline - now;
+   // adaptive windows check every _ro_write_window_minimum_time_us if the write window can end early
+   if (_ro_adaptive_windows)
+      expire_time = std::min(expire_time, _ro_write_window_minimum_time_us);
+   _ro_timer.expires_from_now(boost::posix_time::microseconds(expire_time.count()));
    _ro_timer.async_wait(app().executor().wrap( // stay on app thread
       priority::high,
       exec_queue::read_write, // placed in read_write so only called from main thread
@@ -2749,12 +2803,21 @@ void producer_plugin_impl::switch_to_read_window() {
       start_write_window();                          // restart write window timer for next round
       return;
    }
+   auto now = fc::time_point::now();
+   if (_ro_adaptive_windows && now < _ro_window_deadline && !app().executor().read_write_queue_empty()) {
+      // main thread still has work queued, keep the write window until it is idle or the write window ends
+      _time_tracker.unpause(now);
+      start_write_window_timer(now);
+      return;
+   }
+   _ro_last_write_window_time_us = now - _ro_write_window_start_time;
    fc_dlog(_log, "Read only queue size ${s1}, read exclusive size ${s2}",
            ("s1", app().executor().read_only_queue_size())("s2", app().executor().read_exclusive_queue_size()));
 
    uint32_t pending_block_num = chain.head_block_num() + 1;
-   _ro_read_window_start_time = fc::time_point::now();
-   _ro_window_deadline        = _ro_read_window_start_time + _ro_read_window_effective_time_us;
+   const fc::microseconds read_window_time = _ro_adaptive_windows ? _ro_read_window_target_time_us : _ro_read_window_effective_time_us;
+   _ro_read_window_start_time = now;
+   _ro_window_deadline        = _ro_read_window_start_time + read_window_time;
    app().executor().set_to_read_window([received_block = &_received_block, pending_block_num, ro_window_deadline = _ro_window_deadline]() {
          return fc::time_point::now() >= ro_window_deadline || (received_block->load() >= pending_block_num); // should_exit()
       });
@@ -2770,7 +2833,7 @@ void producer_plugin_impl::switch_to_read_window() {
          _ro_thread_pool.get_executor(), [self = this, pending_block_num]() { return self->read_only_execution_task(pending_block_num); }));
    }
 
-   auto expire_time = boost::posix_time::microseconds(_ro_read_window_time_us.count());
+   auto expire_time = boost::posix_time::microseconds((read_window_time + _ro_read_window_minimum_time_us).count());
    _ro_timer.expires_from_now(expire_time);
    // Needs to be on read_only because that is what is being processed until switch_to_write_window().
    _ro_timer.async_wait(
@@ -2848,7 +2911,7 @@ bool producer_plugin_impl::push_read_only_transaction(transaction_metadata_ptr t
       auto               start = fc::time_point::now();
       chain::controller& chain = chain_plug->chain();
       if (!chain.is_building_block()) {
-         _ro_exhausted_trx_queue.push_front({std::move(trx), std::move(next)});
+         _ro_exhausted_trx_queue.push_back({std::move(trx), std::move(next)});
          return true;
       }
 
@@ -2870,7 +2933,7 @@ bool producer_plugin_impl::push_read_only_transaction(transaction_metadata_ptr t
       // the end of read window. Retry in next round.
       retry = pr.trx_exhausted;
       if (retry) {
-         _ro_exhausted_trx_queue.push_front({std::move(trx), std::move(next)});
+         _ro_exhausted_trx_queue.push_back({std::move(trx), std::move(next)});
       }
 
    } catch (const guard_exception& e) {
@@ -2901,4 +2964,12 @@ void producer_plugin::register_update_incoming_block_metrics(std::function<void(
    my->_update_incoming_block_metrics = std::move(fun);
 }
 
+void producer_plugin::register_update_read_only_window_metrics(std::function<void(read_only_window_metrics)>&& fun) {
+   my->_update_read_only_window_metrics = std::move(fun);
+}
+
+void producer_plugin::register_update_background_snapshot_metrics(std::function<void(chain::snapshot_scheduler::background_snapshot_stats)>&& fun) {
+   my->_update_background_snapshot_metrics = std::move(fun);
+}
+
 } // namespace eosio
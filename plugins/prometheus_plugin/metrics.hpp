@@ -42,6 +42,12 @@ struct catalog_type {
    struct p2p_connection_metrics {
       Gauge& num_peers;
       Gauge& num_clients;
+      Counter& block_bytes_packed;
+      Counter& block_bytes_sent;
+      Counter& trx_bytes_sent;
+      Counter& trx_announce_bytes_sent;
+      Counter& trxs_requested;
+      Counter& duplicate_trxs_received;
 
       prometheus::Family<Gauge>& addr; // Empty gauge; ipv6 address can't be transmitted as a double
       prometheus::Family<Gauge>& port;
@@ -108,6 +114,68 @@ struct catalog_type {
    Counter& latency_us_incoming_block;
    Counter& blocks_incoming;
 
+   // read-only windows
+   struct read_only_window_metrics {
+      Counter& read_windows;
+      Counter& read_window_time_us;
+      Counter& write_window_time_us;
+      Counter& exec_time_us;
+      Gauge&   read_queue_size;
+      Gauge&   read_write_queue_size;
+      Gauge&   next_read_window_time_us;
+   };
+   read_only_window_metrics ro_window_metrics;
+
+   // background snapshots
+   struct background_snapshot_metrics {
+      Gauge&   in_progress;
+      Gauge&   rows_written;
+      Counter& completed;
+      Counter& failed;
+   };
+   background_snapshot_metrics             snapshot_metrics;
+   chain::snapshot_scheduler::background_snapshot_stats last_snapshot_stats;
+
+   // chain plugin
+   struct abi_cache_metrics {
+      Counter& hits;
+      Counter& misses;
+      Counter& evictions;
+      Gauge&   entries;
+      Gauge&   bytes;
+   };
+   abi_cache_metrics            abi_metrics;
+   chain_apis::abi_cache::stats last_abi_cache_stats;
+
+   struct signature_recovery_cache_metrics {
+      Counter& hits;
+      Counter& misses;
+      Counter& evictions;
+      Gauge&   entries;
+   };
+   signature_recovery_cache_metrics       sig_cache_metrics;
+   chain::signature_recovery_cache::stats last_sig_cache_stats;
+
+   struct eos_vm_oc_compile_metrics {
+      Gauge&   queued;
+      Gauge&   in_progress;
+      Counter& compiled;
+      Counter& failed;
+      Counter& latency_us;
+   };
+   eos_vm_oc_compile_metrics     oc_compile_metrics;
+   chain::eosvmoc::compile_stats last_oc_compile_stats;
+
+   struct instantiation_cache_metrics {
+      Counter& hits;
+      Counter& misses;
+      Counter& evictions;
+      Gauge&   entries;
+      Gauge&   bytes;
+   };
+   instantiation_cache_metrics            inst_cache_metrics;
+   chain::instantiated_module_cache_stats last_inst_cache_stats;
+
    // prometheus exporter
    Counter& bytes_transferred;
    Counter& num_scrapes;
@@ -121,6 +189,12 @@ struct catalog_type {
        , p2p_metrics{
               .num_peers{build<Gauge>("nodeos_p2p_peers", "current number of connected outgoing peers")}
             , .num_clients{build<Gauge>("nodeos_p2p_clients", "current number of connected incoming clients")}
+            , .block_bytes_packed{build<Counter>("nodeos_p2p_block_bytes_packed_total", "total bytes of blocks serialized for sending to peers")}
+            , .block_bytes_sent{build<Counter>("nodeos_p2p_block_bytes_sent_total", "total bytes of blocks queued for sending to peers")}
+            , .trx_bytes_sent{build<Counter>("nodeos_p2p_trx_bytes_sent_total", "total bytes of transactions queued for sending to peers")}
+            , .trx_announce_bytes_sent{build<Counter>("nodeos_p2p_trx_announce_bytes_sent_total", "total bytes of transaction id announcements and requests queued for sending to peers")}
+            , .trxs_requested{build<Counter>("nodeos_p2p_trxs_requested_total", "total announced transactions requested from peers")}
+            , .duplicate_trxs_received{build<Counter>("nodeos_p2p_duplicate_trxs_received_total", "total transactions received from peers that were already known")}
             , .addr{family<Gauge>("nodeos_p2p_addr", "ipv6 address")}
             , .port{family<Gauge>("nodeos_p2p_port", "port")}
             , .connection_number{family<Gauge>("nodeos_p2p_connection_number", "monatomic increasing connection number")}
@@ -184,6 +258,36 @@ struct catalog_type {
        , net_usage_us_incoming_block(net_usage_us.Add({{"block_type", "incoming"}}))
        , latency_us_incoming_block(build<Counter>("nodeos_incoming_us_block_latency", "total incoming block latency"))
        , blocks_incoming(build<Counter>("nodeos_blocks_incoming", "number of incoming blocks"))
+       , ro_window_metrics{ .read_windows{build<Counter>("nodeos_ro_read_windows_total", "number of read-only read windows")}
+                          , .read_window_time_us{build<Counter>("nodeos_ro_read_window_us_total", "total time of read-only read windows")}
+                          , .write_window_time_us{build<Counter>("nodeos_ro_write_window_us_total", "total time of the write windows before read-only read windows")}
+                          , .exec_time_us{build<Counter>("nodeos_ro_exec_us_total", "total time read-only threads spent executing transactions")}
+                          , .read_queue_size{build<Gauge>("nodeos_ro_read_queue_size", "read-only tasks left at the end of the last read window")}
+                          , .read_write_queue_size{build<Gauge>("nodeos_ro_read_write_queue_size", "read-write tasks queued at the end of the last read window")}
+                          , .next_read_window_time_us{build<Gauge>("nodeos_ro_next_read_window_us", "effective time of the next read-only read window")} }
+       , snapshot_metrics{ .in_progress{build<Gauge>("nodeos_snapshots_in_progress", "number of snapshots being written in the background")}
+                         , .rows_written{build<Gauge>("nodeos_snapshot_rows_written", "rows written so far by the snapshots in progress")}
+                         , .completed{build<Counter>("nodeos_snapshots_completed_total", "number of background snapshots written")}
+                         , .failed{build<Counter>("nodeos_snapshots_failed_total", "number of background snapshots that failed")} }
+       , abi_metrics{ .hits{build<Counter>("nodeos_abi_cache_hits_total", "number of chain API ABI lookups served from the abi cache")}
+                    , .misses{build<Counter>("nodeos_abi_cache_misses_total", "number of chain API ABI lookups that parsed the ABI")}
+                    , .evictions{build<Counter>("nodeos_abi_cache_evictions_total", "number of ABIs evicted from the abi cache")}
+                    , .entries{build<Gauge>("nodeos_abi_cache_entries", "current number of ABIs in the abi cache")}
+                    , .bytes{build<Gauge>("nodeos_abi_cache_bytes", "current size of the ABIs in the abi cache")} }
+       , sig_cache_metrics{ .hits{build<Counter>("nodeos_signature_recovery_cache_hits_total", "number of signature recoveries served from the cache")}
+                          , .misses{build<Counter>("nodeos_signature_recovery_cache_misses_total", "number of signature recoveries that recovered the key")}
+                          , .evictions{build<Counter>("nodeos_signature_recovery_cache_evictions_total", "number of keys evicted from the signature recovery cache")}
+                          , .entries{build<Gauge>("nodeos_signature_recovery_cache_entries", "current number of keys in the signature recovery cache")} }
+       , oc_compile_metrics{ .queued{build<Gauge>("nodeos_eos_vm_oc_compile_queue_depth", "number of EOS VM OC compiles waiting for a compile thread")}
+                           , .in_progress{build<Gauge>("nodeos_eos_vm_oc_compiles_in_progress", "number of EOS VM OC compiles in progress")}
+                           , .compiled{build<Counter>("nodeos_eos_vm_oc_compiles_total", "number of completed EOS VM OC compiles")}
+                           , .failed{build<Counter>("nodeos_eos_vm_oc_compile_failures_total", "number of EOS VM OC compiles that failed or did not fit in the code cache")}
+                           , .latency_us{build<Counter>("nodeos_eos_vm_oc_compile_latency_us_total", "total time from first request until completion of EOS VM OC compiles")} }
+       , inst_cache_metrics{ .hits{build<Counter>("nodeos_wasm_instantiation_cache_hits_total", "number of contract executions that reused an instantiated module")}
+                           , .misses{build<Counter>("nodeos_wasm_instantiation_cache_misses_total", "number of contract executions that instantiated a module")}
+                           , .evictions{build<Counter>("nodeos_wasm_instantiation_cache_evictions_total", "number of instantiated modules evicted to stay within wasm-instantiation-cache-size-mb")}
+                           , .entries{build<Gauge>("nodeos_wasm_instantiation_cache_entries", "current number of instantiated modules")}
+                           , .bytes{build<Gauge>("nodeos_wasm_instantiation_cache_bytes", "current estimated size of the instantiated modules")} }
        , bytes_transferred(build<Counter>("exposer_transferred_bytes_total",
                                           "total number of bytes for responses to prometheus scrape requests"))
        , num_scrapes(build<Counter>("exposer_scrapes_total", "total number of prometheus scrape requests received")) {}
@@ -203,6 +307,16 @@ struct catalog_type {
    void update(const net_plugin::p2p_connections_metrics& metrics) {
       p2p_metrics.num_peers.Set(metrics.num_peers);
       p2p_metrics.num_clients.Set(metrics.num_clients);
+      // net_plugin reports running totals
+      auto increment_to = [](Counter& counter, std::size_t total) {
+         counter.Increment(total - counter.Value());
+      };
+      increment_to(p2p_metrics.block_bytes_packed, metrics.block_bytes_packed);
+      increment_to(p2p_metrics.block_bytes_sent, metrics.block_bytes_sent);
+      increment_to(p2p_metrics.trx_bytes_sent, metrics.trx_bytes_sent);
+      increment_to(p2p_metrics.trx_announce_bytes_sent, metrics.trx_announce_bytes_sent);
+      increment_to(p2p_metrics.trxs_requested, metrics.trxs_requested);
+      increment_to(p2p_metrics.duplicate_trxs_received, metrics.duplicate_trxs_received);
       for(size_t i = 0; i < metrics.stats.peers.size(); ++i) {
          const auto& peer = metrics.stats.peers[i];
          const auto& conn_id = peer.unique_conn_node_id;
@@ -268,6 +382,24 @@ struct catalog_type {
       update(speculative_metrics, metrics);
    }
 
+   void update(const producer_plugin::read_only_window_metrics& metrics) {
+      ro_window_metrics.read_windows.Increment(1);
+      ro_window_metrics.read_window_time_us.Increment(metrics.read_window_time_us);
+      ro_window_metrics.write_window_time_us.Increment(metrics.write_window_time_us);
+      ro_window_metrics.exec_time_us.Increment(metrics.exec_time_us);
+      ro_window_metrics.read_queue_size.Set(metrics.read_queue_size);
+      ro_window_metrics.read_write_queue_size.Set(metrics.read_write_queue_size);
+      ro_window_metrics.next_read_window_time_us.Set(metrics.next_read_window_time_us);
+   }
+
+   void update(const chain::snapshot_scheduler::background_snapshot_stats& stats) {
+      snapshot_metrics.in_progress.Set(stats.in_progress);
+      snapshot_metrics.rows_written.Set(stats.rows_written);
+      snapshot_metrics.completed.Increment(stats.completed - last_snapshot_stats.completed);
+      snapshot_metrics.failed.Increment(stats.failed - last_snapshot_stats.failed);
+      last_snapshot_stats = stats;
+   }
+
    void update(const producer_plugin::incoming_block_metrics& metrics) {
       trxs_incoming_total.Increment(metrics.trxs_incoming_total);
       blocks_incoming.Increment(1);
@@ -281,6 +413,42 @@ struct catalog_type {
       head_block_num.Set(metrics.head_block_num);
    }
 
+   void update(const chain_apis::abi_cache::stats& stats) {
+      // counters only support increments, report the change since the last update
+      abi_metrics.hits.Increment(stats.hits - last_abi_cache_stats.hits);
+      abi_metrics.misses.Increment(stats.misses - last_abi_cache_stats.misses);
+      abi_metrics.evictions.Increment(stats.evictions - last_abi_cache_stats.evictions);
+      abi_metrics.entries.Set(stats.entries);
+      abi_metrics.bytes.Set(stats.bytes);
+      last_abi_cache_stats = stats;
+   }
+
+   void update(const chain::signature_recovery_cache::stats& stats) {
+      sig_cache_metrics.hits.Increment(stats.hits - last_sig_cache_stats.hits);
+      sig_cache_metrics.misses.Increment(stats.misses - last_sig_cache_stats.misses);
+      sig_cache_metrics.evictions.Increment(stats.evictions - last_sig_cache_stats.evictions);
+      sig_cache_metrics.entries.Set(stats.entries);
+      last_sig_cache_stats = stats;
+   }
+
+   void update(const chain::eosvmoc::compile_stats& stats) {
+      oc_compile_metrics.queued.Set(stats.queued);
+      oc_compile_metrics.in_progress.Set(stats.in_progress);
+      oc_compile_metrics.compiled.Increment(stats.compiled - last_oc_compile_stats.compiled);
+      oc_compile_metrics.failed.Increment(stats.failed - last_oc_compile_stats.failed);
+      oc_compile_metrics.latency_us.Increment(stats.latency_us - last_oc_compile_stats.latency_us);
+      last_oc_compile_stats = stats;
+   }
+
+   void update(const chain::instantiated_module_cache_stats& stats) {
+      inst_cache_metrics.hits.Increment(stats.hits - last_inst_cache_stats.hits);
+      inst_cache_metrics.misses.Increment(stats.misses - last_inst_cache_stats.misses);
+      inst_cache_metrics.evictions.Increment(stats.evictions - last_inst_cache_stats.evictions);
+      inst_cache_metrics.entries.Set(stats.entries);
+      inst_cache_metrics.bytes.Set(stats.bytes);
+      last_inst_cache_stats = stats;
+   }
+
    void update_prometheus_info() {
       info_details = info.Add({
             {"server_version", chain_apis::itoh(static_cast<uint32_t>(app().version()))},
@@ -323,6 +491,32 @@ struct catalog_type {
           [&strand, this](const producer_plugin::incoming_block_metrics& metrics) {
              strand.post([metrics, this]() { update(metrics); });
           });
+      producer.register_update_read_only_window_metrics(
+          [&strand, this](const producer_plugin::read_only_window_metrics& metrics) {
+             strand.post([metrics, this]() { update(metrics); });
+          });
+      producer.register_update_background_snapshot_metrics(
+          [&strand, this](const chain::snapshot_scheduler::background_snapshot_stats& stats) {
+             strand.post([stats, this]() { update(stats); });
+          });
+
+      auto& chain = app().get_plugin<chain_plugin>();
+      chain.register_update_abi_cache_metrics(
+          [&strand, this](const chain_apis::abi_cache::stats& stats) {
+             strand.post([stats, this]() { update(stats); });
+          });
+      chain.register_update_signature_recovery_cache_metrics(
+          [&strand, this](const chain::signature_recovery_cache::stats& stats) {
+             strand.post([stats, this]() { update(stats); });
+          });
+      chain.register_update_eos_vm_oc_compile_metrics(
+          [&strand, this](const chain::eosvmoc::compile_stats& stats) {
+             strand.post([stats, this]() { update(stats); });
+          });
+      chain.register_update_instantiation_cache_metrics(
+          [&strand, this](const chain::instantiated_module_cache_stats& stats) {
+             strand.post([stats, this]() { update(stats); });
+          });
    }
 };
 
@@ -8,36 +8,35 @@
 #include <boost/asio/buffer.hpp>
 #include <boost/asio/local/stream_protocol.hpp>
 #include <boost/asio/error.hpp>
+#include <boost/asio/strand.hpp>
 #include <boost/beast/websocket.hpp>
+#include <deque>
 #include <memory>
+#include <mutex>
 
 
 extern const char* const state_history_plugin_abi;
 
 namespace eosio {
 
-class session_manager;
-
 struct send_queue_entry_base {
    virtual ~send_queue_entry_base() = default;
    virtual void send_entry()        = 0;
 };
 
 struct session_base {
-   virtual void send_update(bool changed)                                     = 0;
-   virtual void send_update(const chain::signed_block_ptr& block, const chain::block_id_type& id) = 0;
-   virtual ~session_base()                                                    = default;
-
-   std::optional<state_history::get_blocks_request_v0> current_request;
-   bool need_to_send_update = false;
+   /// queue an update for the newly accepted block, thread-safe
+   virtual void queue_update(const chain::signed_block_ptr& block, const chain::block_id_type& id) = 0;
+   virtual ~session_base()                                                                         = default;
 };
 
+template <typename Session>
 class send_update_send_queue_entry : public send_queue_entry_base {
-   std::shared_ptr<session_base> session;
+   std::shared_ptr<Session> session;
    const chain::signed_block_ptr block;
    const chain::block_id_type id;
 public:
-   send_update_send_queue_entry(std::shared_ptr<session_base> s, chain::signed_block_ptr block, const chain::block_id_type& id)
+   send_update_send_queue_entry(std::shared_ptr<Session> s, chain::signed_block_ptr block, const chain::block_id_type& id)
          : session(std::move(s))
          , block(std::move(block))
          , id(id){}
@@ -51,82 +50,40 @@ public:
    }
 };
 
-/// Coordinate sending of queued entries. Only one session can read from the ship logs at a time so coordinate
-/// their execution on the ship thread.
-/// accessed from ship thread
+/// Track connected sessions and fan out block updates to them. Each session has its own send queue and its own read
+/// cursors into the ship logs (see decompress_stream), so sessions stream independently: a slow client only delays
+/// itself. Sessions run on their own strand of the ship thread pool.
+/// thread-safe
 class session_manager {
 private:
-   using entry_ptr = std::unique_ptr<send_queue_entry_base>;
-
-   boost::asio::io_context& ship_io_context;
+   mutable std::mutex                      mtx;
    std::set<std::shared_ptr<session_base>> session_set;
-   bool sending  = false;
-   std::deque<std::pair<std::shared_ptr<session_base>, entry_ptr>> send_queue;
 
 public:
-   explicit session_manager(boost::asio::io_context& ship_io_context)
-   : ship_io_context(ship_io_context) {}
-
    void insert(std::shared_ptr<session_base> s) {
+      std::lock_guard g(mtx);
       session_set.insert(std::move(s));
    }
 
-   void remove(const std::shared_ptr<session_base>& s, bool active_entry) {
+   void remove(const std::shared_ptr<session_base>& s) {
+      std::lock_guard g(mtx);
       session_set.erase( s );
-      if (active_entry)
-         pop_entry();
    }
 
-   bool is_active(const std::shared_ptr<session_base>& s) {
+   bool is_active(const std::shared_ptr<session_base>& s) const {
+      std::lock_guard g(mtx);
       return session_set.count(s);
    }
 
-   void add_send_queue(std::shared_ptr<session_base> s, entry_ptr p) {
-      send_queue.emplace_back(std::move(s), std::move(p));
-      send();
-   }
-
-   void send() {
-      if (sending)
-         return;
-      if (send_queue.empty()) {
-         send_updates();
-         return;
-      }
-      while (!send_queue.empty() && !is_active(send_queue[0].first)) {
-         send_queue.erase(send_queue.begin());
-      }
-
-      if (!send_queue.empty()) {
-         sending = true;
-         send_queue[0].second->send_entry();
-      } else {
-         send();
-      }
-   }
-
-   void pop_entry(bool call_send = true) {
-      send_queue.erase(send_queue.begin());
-      sending = false;
-      if (call_send || !send_queue.empty()) {
-         // avoid blowing the stack
-         boost::asio::post(ship_io_context, [this]() {
-            send();
-         });
-      }
-   }
-
-   void send_updates() {
-      for( auto& s : session_set ) {
-         if (s->need_to_send_update ) {
-            add_send_queue(s, std::make_unique<send_update_send_queue_entry>(s, nullptr, chain::block_id_type{}));
-         }
-      }
-   }
-
+   // blocks must be sent from a single thread, in order, each session then receives them in that order
    void send_update(const chain::signed_block_ptr& block, const chain::block_id_type& id) {
-      for( auto& s : session_set ) {
-         add_send_queue(s, std::make_unique<send_update_send_queue_entry>(s, block, id));
+      std::vector<std::shared_ptr<session_base>> sessions;
+      {
+         std::lock_guard g(mtx);
+         sessions.assign(session_set.begin(), session_set.end());
+      }
+      for( auto& s : sessions ) {
+         s->queue_update(block, id);
       }
    }
 
@@ -146,11 +103,11 @@ public:
       data = fc::raw::pack(state_history::state_result{session->get_status_result()});
 
       session->socket_stream->async_write(boost::asio::buffer(data),
-                                   [s{session}](boost::system::error_code ec, size_t) {
-                                      s->callback(ec, true, "async_write", [s] {
-                                         s->session_mgr.pop_entry();
+                                   boost::asio::bind_executor(session->strand, [s{session}](boost::system::error_code ec, size_t) {
+                                      s->callback(ec, "async_write", [s] {
+                                         s->pop_entry();
                                       });
-                                   });
+                                   }));
    }
 };
 
@@ -191,20 +148,22 @@ class blocks_result_send_queue_entry : public send_queue_entry_base, public std:
    std::shared_ptr<Session>                                        session;
    state_history::get_blocks_result_v0                             r;
    std::vector<char>                                               data;
-   std::optional<locked_decompress_stream>                         stream;
+   std::optional<decompress_stream>                                stream;
+   uint64_t                                                        stream_remaining = 0;
 
    template <typename Next>
    void async_send(bool fin, const std::vector<char>& d, Next&& next) {
       session->socket_stream->async_write_some(
           fin, boost::asio::buffer(d),
+          boost::asio::bind_executor(session->strand,
           [me=this->shared_from_this(), next = std::forward<Next>(next)](boost::system::error_code ec, size_t) mutable {
              if( ec ) {
                 me->stream.reset();
              }
-             me->session->callback(ec, true, "async_write", [me, next = std::move(next)]() mutable {
+             me->session->callback(ec, "async_write", [me, next = std::move(next)]() mutable {
                 next();
              });
-          });
+          }));
    }
 
    template <typename Next>
@@ -214,19 +173,26 @@ class blocks_result_send_queue_entry : public send_queue_entry_base, public std:
       data.resize(size);
       bool eof = (strm->sgetc() == EOF);
 
+      // the cursor is not protected by the log mutex; an entry truncated by a fork while being streamed must not be
+      // sent as a short message since the client has already been told its size
+      EOS_ASSERT(static_cast<uint64_t>(size) <= stream_remaining && (!eof || static_cast<uint64_t>(size) == stream_remaining),
+                 chain::plugin_exception, "state history log entry changed while being sent");
+      stream_remaining -= size;
+
       session->socket_stream->async_write_some( fin && eof, boost::asio::buffer(data),
+          boost::asio::bind_executor(session->strand,
           [me=this->shared_from_this(), fin, eof, next = std::forward<Next>(next)](boost::system::error_code ec, size_t) mutable {
              if( ec ) {
                 me->stream.reset();
              }
-             me->session->callback(ec, true, "async_write", [me, fin, eof, next = std::move(next)]() mutable {
+             me->session->callback(ec, "async_write", [me, fin, eof, next = std::move(next)]() mutable {
                 if (eof) {
                    next();
                 } else {
                    me->async_send_buf(fin, std::move(next));
                 }
              });
-          });
+          }));
    }
 
    template <typename Next>
@@ -238,6 +204,7 @@ class blocks_result_send_queue_entry : public send_queue_entry_base, public std:
 
    template <typename Next>
    void send_log(uint64_t entry_size, bool is_deltas, Next&& next) {
+      stream_remaining = entry_size;
       if (entry_size) {
          data.resize(16); // should be at least for 1 byte (optional) + 10 bytes (variable sized uint64_t)
          fc::datastream<char*> ds(data.data(), data.size());
@@ -263,7 +230,7 @@ class blocks_result_send_queue_entry : public send_queue_entry_base, public std:
       stream.reset();
       send_log(session->get_delta_log_entry(r, stream), true, [me=this->shared_from_this()]() {
          me->stream.reset();
-         me->session->session_mgr.pop_entry();
+         me->session->pop_entry();
       });
    }
 
@@ -298,16 +265,27 @@ public:
 template <typename Plugin, typename SocketType>
 struct session : session_base, std::enable_shared_from_this<session<Plugin, SocketType>> {
 private:
+   using entry_ptr = std::unique_ptr<send_queue_entry_base>;
+   using strand_t  = boost::asio::strand<boost::asio::io_context::executor_type>;
+
    Plugin&                plugin;
    session_manager&       session_mgr;
-   std::optional<boost::beast::websocket::stream<SocketType>> socket_stream; // ship thread only after creation
+   strand_t               strand; // all members below are only accessed on this strand after creation
+   std::optional<boost::beast::websocket::stream<SocketType>> socket_stream;
    std::string            description;
 
+   std::deque<entry_ptr>  send_queue;
+   bool                   sending = false;
+   bool                   closed  = false;
+
+   std::optional<state_history::get_blocks_request_v0> current_request;
+   bool                   need_to_send_update = false;
    uint32_t               to_send_block_num = 0;
    std::optional<std::vector<state_history::block_position>::const_iterator> position_it;
 
    const int32_t          default_frame_size;
 
+   friend class send_update_send_queue_entry<session>;
    friend class blocks_result_send_queue_entry<session>;
    friend class status_result_send_queue_entry<session>;
    friend class blocks_ack_request_send_queue_entry<session>;
@@ -318,12 +296,27 @@ public:
    session(Plugin& plugin, SocketType socket, session_manager& sm)
        : plugin(plugin)
        , session_mgr(sm)
+       , strand(boost::asio::make_strand(plugin.get_ship_executor()))
        , socket_stream(std::move(socket))
        , default_frame_size(plugin.default_frame_size) {
       description = to_description_string();
    }
 
    void start() {
+      boost::asio::dispatch(strand, [self = this->shared_from_this()]() {
+         self->start_i();
+      });
+   }
+
+   // thread-safe
+   void queue_update(const chain::signed_block_ptr& block, const chain::block_id_type& id) override {
+      boost::asio::post(strand, [self = this->shared_from_this(), block, id]() {
+         self->add_send_queue(std::make_unique<send_update_send_queue_entry<session>>(self, block, id));
+      });
+   }
+
+private:
+   void start_i() {
       fc_ilog(plugin.get_logger(), "incoming connection from ${a}", ("a", description));
       socket_stream->auto_fragment(false);
       socket_stream->binary(true);
@@ -333,27 +326,55 @@ public:
       socket_stream->next_layer().set_option(boost::asio::socket_base::send_buffer_size(1024 * 1024));
       socket_stream->next_layer().set_option(boost::asio::socket_base::receive_buffer_size(1024 * 1024));
 
-      socket_stream->async_accept([self = this->shared_from_this()](boost::system::error_code ec) {
-         self->callback(ec, false, "async_accept", [self] {
+      socket_stream->async_accept(boost::asio::bind_executor(strand, [self = this->shared_from_this()](boost::system::error_code ec) {
+         self->callback(ec, "async_accept", [self] {
             self->socket_stream->binary(false);
             self->socket_stream->async_write(
                   boost::asio::buffer(state_history_plugin_abi, strlen(state_history_plugin_abi)),
-                  [self](boost::system::error_code ec, size_t) {
-                     self->callback(ec, false, "async_write", [self] {
+                  boost::asio::bind_executor(self->strand, [self](boost::system::error_code ec, size_t) {
+                     self->callback(ec, "async_write", [self] {
                         self->socket_stream->binary(true);
                         self->start_read();
                      });
-                  });
+                  }));
          });
-      });
+      }));
+   }
+
+   void add_send_queue(entry_ptr p) {
+      send_queue.emplace_back(std::move(p));
+      send();
+   }
+
+   void send() {
+      if (sending || closed)
+         return;
+      if (send_queue.empty()) {
+         if (need_to_send_update)
+            add_send_queue(std::make_unique<send_update_send_queue_entry<session>>(this->shared_from_this(), nullptr, chain::block_id_type{}));
+         return;
+      }
+
+      sending = true;
+      send_queue.front()->send_entry();
+   }
+
+   void pop_entry(bool call_send = true) {
+      send_queue.pop_front();
+      sending = false;
+      if (call_send || !send_queue.empty()) {
+         // avoid blowing the stack
+         boost::asio::post(strand, [self = this->shared_from_this()]() {
+            self->send();
+         });
+      }
    }
 
-private:
    void start_read() {
       auto in_buffer = std::make_shared<boost::beast::flat_buffer>();
       socket_stream->async_read(
-          *in_buffer, [self = this->shared_from_this(), in_buffer](boost::system::error_code ec, size_t) {
-             self->callback(ec, false, "async_read", [self, in_buffer] {
+          *in_buffer, boost::asio::bind_executor(strand, [self = this->shared_from_this(), in_buffer](boost::system::error_code ec, size_t) {
+             self->callback(ec, "async_read", [self, in_buffer] {
                 auto d = boost::asio::buffer_cast<char const*>(boost::beast::buffers_front(in_buffer->data()));
                 auto s = boost::asio::buffer_size(in_buffer->data());
                 fc::datastream<const char*> ds(d, s);
@@ -364,7 +385,7 @@ private:
                 }, req );
                 self->start_read();
              });
-          });
+          }));
    }
 
    // should only be called once per session
@@ -380,11 +401,11 @@ private:
    }
 
    uint64_t get_trace_log_entry(const eosio::state_history::get_blocks_result_v0& result,
-                                std::optional<locked_decompress_stream>& buf) {
+                                std::optional<decompress_stream>& buf) {
       if (result.traces.has_value()) {
          auto& optional_log = plugin.get_trace_log();
          if( optional_log ) {
-            buf.emplace( optional_log->create_locked_decompress_stream() );
+            buf.emplace();
             return optional_log->get_unpacked_entry( result.this_block->block_num, *buf );
          }
       }
@@ -392,11 +413,11 @@ private:
    }
 
    uint64_t get_delta_log_entry(const eosio::state_history::get_blocks_result_v0& result,
-                                std::optional<locked_decompress_stream>& buf) {
+                                std::optional<decompress_stream>& buf) {
       if (result.deltas.has_value()) {
          auto& optional_log = plugin.get_chain_state_log();
          if( optional_log ) {
-            buf.emplace( optional_log->create_locked_decompress_stream() );
+            buf.emplace();
             return optional_log->get_unpacked_entry( result.this_block->block_num, *buf );
          }
       }
@@ -408,7 +429,7 @@ private:
 
       auto self = this->shared_from_this();
       auto entry_ptr = std::make_unique<status_result_send_queue_entry<session>>(self);
-      session_mgr.add_send_queue(std::move(self), std::move(entry_ptr));
+      add_send_queue(std::move(entry_ptr));
    }
 
    void process(state_history::get_blocks_request_v0& req) {
@@ -416,7 +437,7 @@ private:
 
       auto self = this->shared_from_this();
       auto entry_ptr = std::make_unique<blocks_request_send_queue_entry<session>>(self, std::move(req));
-      session_mgr.add_send_queue(std::move(self), std::move(entry_ptr));
+      add_send_queue(std::move(entry_ptr));
    }
 
    void process(state_history::get_blocks_ack_request_v0& req) {
@@ -428,7 +449,7 @@ private:
 
       auto self = this->shared_from_this();
       auto entry_ptr = std::make_unique<blocks_ack_request_send_queue_entry<session>>(self, std::move(req));
-      session_mgr.add_send_queue(std::move(self), std::move(entry_ptr));
+      add_send_queue(std::move(entry_ptr));
    }
 
    state_history::get_status_result_v0 get_status_result() {
@@ -485,7 +506,7 @@ private:
    void send_update(state_history::get_blocks_result_v0 result, const chain::signed_block_ptr& block, const chain::block_id_type& id) {
       need_to_send_update = true;
       if (!current_request || !current_request->max_messages_in_flight) {
-         session_mgr.pop_entry(false);
+         pop_entry(false);
          return;
       }
 
@@ -496,7 +517,7 @@ private:
       if (to_send_block_num > current || to_send_block_num >= current_request->end_block_num) {
          fc_dlog( plugin.get_logger(), "Not sending, to_send_block_num: ${s}, current: ${c} current_request.end_block_num: ${b}",
                   ("s", to_send_block_num)("c", current)("b", current_request->end_block_num) );
-         session_mgr.pop_entry(false);
+         pop_entry(false);
          return;
       }
 
@@ -517,7 +538,7 @@ private:
 
          if(block_id_seen_by_client == *block_id) {
             ++to_send_block_num;
-            session_mgr.pop_entry(false);
+            pop_entry(false);
             return;
          }
       }
@@ -557,9 +578,9 @@ private:
       std::make_shared<blocks_result_send_queue_entry<session>>(this->shared_from_this(), std::move(result))->send_entry();
    }
 
-   void send_update(const chain::signed_block_ptr& block, const chain::block_id_type& id) override {
+   void send_update(const chain::signed_block_ptr& block, const chain::block_id_type& id) {
       if (!current_request || !current_request->max_messages_in_flight) {
-         session_mgr.pop_entry(false);
+         pop_entry(false);
          return;
       }
 
@@ -570,18 +591,22 @@ private:
       send_update(std::move(result), block, id);
    }
 
-   void send_update(bool changed) override {
+   void send_update(bool changed) {
       if (changed || need_to_send_update) {
          state_history::get_blocks_result_v0 result;
          result.head = plugin.get_block_head();
          send_update(std::move(result), nullptr, chain::block_id_type{});
       } else {
-         session_mgr.pop_entry(false);
+         pop_entry(false);
       }
    }
 
    template <typename F>
-   void callback(const boost::system::error_code& ec, bool active_entry, const char* what, F f) {
+   void callback(const boost::system::error_code& ec, const char* what, F f) {
+      // a read and a write may be outstanding when the session is closed, drop whichever completes last
+      if( closed )
+         return;
+
       if( !ec ) {
          try {
             f();
@@ -605,9 +630,11 @@ private:
       }
 
       // on exception allow session to be destroyed
+      closed = true;
+      send_queue.clear();
 
       fc_ilog(plugin.get_logger(), "Closing connection from ${a}", ("a", description));
-      session_mgr.remove( this->shared_from_this(), active_entry );
+      session_mgr.remove( this->shared_from_this() );
    }
 };
 
@@ -69,8 +69,9 @@ private:
    time_point         head_timestamp;
 
    named_thread_pool<struct ship> thread_pool;
+   uint16_t                       thread_pool_size = 1;
 
-   session_manager                  session_mgr{thread_pool.get_executor()};
+   session_manager                  session_mgr;
 
    bool  plugin_started = false;
 
@@ -224,9 +225,9 @@ public:
       // this is safe as there are no clients connected until after replay is complete
       // this method is called from the main thread and "plugin_started" is set on the main thread as well when plugin is started 
       if (plugin_started) {
-         boost::asio::post(get_ship_executor(), [self = this->shared_from_this(), block, id]() {
-            self->get_session_manager().send_update(block, id);
-         });
+         // queued from the main thread, which posts to each session's strand in block order. Posting to the ship
+         // executor instead could run consecutive blocks concurrently on different ship threads, out of order.
+         get_session_manager().send_update(block, id);
       }
 
    }
@@ -308,6 +309,14 @@ void state_history_plugin::set_program_options(options_description& cli, options
    options("state-history-unix-socket-path", bpo::value<string>(),
            "the path (relative to data-dir) to create a unix socket upon which to listen for incoming connections.");
    options("trace-history-debug-mode", bpo::bool_switch()->default_value(false), "enable debug mode for trace history");
+   options("state-history-threads", bpo::value<uint16_t>()->default_value(1),
+           "number of threads used to stream state history to clients; sessions stream independently of each other "
+           "so more threads allow more sessions to decompress and send log entries in parallel");
+   options("state-history-compression", bpo::value<string>()->default_value("zlib"),
+           "compression of new state history log entries, zlib or zstd. Existing entries keep the compression they were "
+           "written with. Logs containing zstd entries can not be read by earlier versions of nodeos.");
+   options("state-history-compression-level", bpo::value<int>(),
+           "compression level of new state history log entries, zlib: 0-9 (default 6), zstd: 1-22 (default 3)");
 
    if(cfile::supports_hole_punching())
       options("state-history-log-retain-blocks", bpo::value<uint32_t>(), "if set, periodically prune the state history files to store only configured number of most recent blocks");
@@ -364,6 +373,10 @@ void state_history_plugin_impl::plugin_initialize(const variables_map& options)
          trace_debug_mode = true;
       }
 
+      thread_pool_size = options.at("state-history-threads").as<uint16_t>();
+      EOS_ASSERT(thread_pool_size > 0, plugin_config_exception, "state-history-threads ${num} must be greater than 0",
+                 ("num", thread_pool_size));
+
       bool has_state_history_partition_options =
           options.count("state-history-retained-dir") || options.count("state-history-archive-dir") ||
           options.count("state-history-stride") || options.count("max-retained-history-files");
@@ -389,10 +402,22 @@ void state_history_plugin_impl::plugin_initialize(const variables_map& options)
             config.max_retained_files = options.at("max-retained-history-files").as<uint32_t>();
       }
 
+      state_history::compression_config compression_conf;
+      const auto compression_str = options.at("state-history-compression").as<string>();
+      const auto compression = state_history::compression_type_from_string(compression_str);
+      EOS_ASSERT(compression, plugin_config_exception, "unknown state-history-compression ${c}, expected zlib or zstd",
+                 ("c", compression_str));
+      compression_conf.type = *compression;
+      if (options.count("state-history-compression-level")) {
+         compression_conf.level = options.at("state-history-compression-level").as<int>();
+         EOS_ASSERT(state_history::is_valid_compression_level(compression_conf.type, *compression_conf.level), plugin_config_exception,
+                    "invalid state-history-compression-level ${l} for ${c}", ("l", *compression_conf.level)("c", compression_str));
+      }
+
       if (options.at("trace-history").as<bool>())
-         trace_log.emplace("trace_history", state_history_dir , ship_log_conf);
+         trace_log.emplace("trace_history", state_history_dir , ship_log_conf, compression_conf);
       if (options.at("chain-state-history").as<bool>())
-         chain_state_log.emplace("chain_state_history", state_history_dir, ship_log_conf);
+         chain_state_log.emplace("chain_state_history", state_history_dir, ship_log_conf, compression_conf);
    }
    FC_LOG_AND_RETHROW()
 } // state_history_plugin::plugin_initialize
@@ -425,8 +450,8 @@ void state_history_plugin_impl::plugin_startup() {
       }
       fc_ilog(_log, "First available block for SHiP ${b}", ("b", first_available_block));
       listen();
-      // use of executor assumes only one thread
-      thread_pool.start( 1, [](const fc::exception& e) {
+      // sessions run on their own strands, see session_manager
+      thread_pool.start( thread_pool_size, [](const fc::exception& e) {
          fc_elog( _log, "Exception in SHiP thread pool, exiting: ${e}", ("e", e.to_detail_string()) );
          app().quit();
       });
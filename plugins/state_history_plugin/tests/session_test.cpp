@@ -104,7 +104,7 @@ struct mock_state_history_plugin {
    std::optional<eosio::state_history_log> trace_log;
    std::optional<eosio::state_history_log> state_log;
    std::atomic<bool>                       stopping = false;
-   eosio::session_manager                  session_mgr{ship_ioc};
+   eosio::session_manager                  session_mgr;
 
    constexpr static uint32_t default_frame_size = 1024;
 
@@ -345,13 +345,12 @@ void store_read_test_case(uint64_t data_size, eosio::state_history_log_config co
    BOOST_REQUIRE_EQUAL(log.get_log_file().tellp(), pos);
 
 
-   eosio::locked_decompress_stream buf = log.create_locked_decompress_stream();
+   eosio::decompress_stream buf;
    log.get_unpacked_entry(1, buf);
 
    std::vector<char> decompressed;
    auto& strm = std::get<std::unique_ptr<bio::filtering_istreambuf>>(buf.buf);
    BOOST_CHECK(!!strm);
-   BOOST_CHECK(buf.lock.owns_lock());
    bio::copy(*strm, bio::back_inserter(decompressed));
 
    BOOST_CHECK_EQUAL(data.size() * sizeof(data[0]), decompressed.size());
@@ -371,6 +370,46 @@ BOOST_AUTO_TEST_CASE(store_read_entry_prune_enabled) {
    store_read_test_case(1024, eosio::state_history::prune_config{.prune_blocks = 100});
 }
 
+BOOST_AUTO_TEST_CASE(store_read_concurrent_cursors) {
+   fc::temp_directory       log_dir;
+   eosio::state_history_log log("ship", log_dir.path(), {});
+
+   std::vector<std::vector<int32_t>> data;
+   auto write_entry = [&](uint32_t block_num) {
+      eosio::state_history_log_header header;
+      header.block_id     = block_id_for(block_num);
+      header.payload_size = 0;
+      const auto& d = data.emplace_back(generate_data(1024 * block_num));
+      log.pack_and_write_entry(header, block_id_for(block_num - 1),
+         [&](auto&& buf) { bio::write(buf, (const char*)d.data(), d.size() * sizeof(d[0])); });
+   };
+   write_entry(1);
+   write_entry(2);
+
+   // cursors do not hold the log mutex, so several can be open at once and the log can still be appended to
+   eosio::decompress_stream buf1, buf2;
+   BOOST_REQUIRE_EQUAL(log.get_unpacked_entry(1, buf1), data[0].size() * sizeof(int32_t));
+   BOOST_REQUIRE_EQUAL(log.get_unpacked_entry(2, buf2), data[1].size() * sizeof(int32_t));
+   write_entry(3);
+
+   std::vector<std::thread> readers;
+   std::vector<std::vector<char>> decompressed(2);
+   eosio::decompress_stream* bufs[] = {&buf1, &buf2};
+   for (size_t i = 0; i < 2; ++i) {
+      readers.emplace_back([&, i]() {
+         auto& strm = std::get<std::unique_ptr<bio::filtering_istreambuf>>(bufs[i]->buf);
+         bio::copy(*strm, bio::back_inserter(decompressed[i]));
+      });
+   }
+   for (auto& t : readers)
+      t.join();
+
+   for (size_t i = 0; i < 2; ++i) {
+      BOOST_REQUIRE_EQUAL(decompressed[i].size(), data[i].size() * sizeof(int32_t));
+      BOOST_CHECK(std::equal(decompressed[i].begin(), decompressed[i].end(), (const char*)data[i].data()));
+   }
+}
+
 BOOST_AUTO_TEST_CASE(store_with_existing) {
    uint64_t data_size = 512;
    fc::temp_directory       log_dir;
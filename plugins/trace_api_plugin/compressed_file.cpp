@@ -19,6 +19,39 @@ namespace {
 
 namespace eosio::trace_api {
 
+decompressed_window_cache::window_ptr decompressed_window_cache::get( const std::filesystem::path& file_path, uint64_t offset ) {
+   std::scoped_lock g(mtx);
+   auto itr = windows.find(key_t{file_path.generic_string(), offset});
+   if (itr == windows.end()) {
+      return {};
+   }
+   lru.splice(lru.begin(), lru, itr->second);
+   return itr->second->second;
+}
+
+void decompressed_window_cache::put( const std::filesystem::path& file_path, uint64_t offset, window_ptr window ) {
+   if (!window || window->size() > max_size) {
+      return;
+   }
+
+   std::scoped_lock g(mtx);
+   key_t key{file_path.generic_string(), offset};
+   if (windows.count(key)) {
+      // another reader inflated the same window first
+      return;
+   }
+   lru.emplace_front(key, std::move(window));
+   windows.emplace(std::move(key), lru.begin());
+   cached_size += lru.front().second->size();
+
+   while (cached_size > max_size) {
+      const auto& oldest = lru.back();
+      cached_size -= oldest.second->size();
+      windows.erase(oldest.first);
+      lru.pop_back();
+   }
+}
+
 struct compressed_file_impl {
    static constexpr size_t read_buffer_size = 4*1024;
    static constexpr size_t compressed_buffer_size = 4*1024;
@@ -109,6 +142,132 @@ struct compressed_file_impl {
       }
    }
 
+   /**
+    * Load the map of windows, the seek points preceded by the start of the file
+    */
+   void load_windows_map( fc::cfile& file ) {
+      if (!windows_map.empty()) {
+         return;
+      }
+
+      file.seek_end(-expected_seek_point_count_size);
+      seek_point_count_type seek_point_count = 0;
+      file.read(reinterpret_cast<char*>(&seek_point_count), sizeof(seek_point_count));
+
+      std::vector<seek_point_entry> seek_point_map(seek_point_count);
+      const size_t seek_map_size = sizeof(seek_point_entry) * seek_point_count;
+      if (seek_point_count > 0) {
+         file.seek_end(-static_cast<long>(expected_seek_point_count_size + seek_map_size));
+         file.read(reinterpret_cast<char*>(seek_point_map.data()), seek_map_size);
+      }
+
+      windows_map.reserve(seek_point_count + 1);
+      windows_map.emplace_back(0, 0);
+      windows_map.insert(windows_map.end(), seek_point_map.begin(), seek_point_map.end());
+      compressed_data_end = file_size - expected_seek_point_count_size - seek_map_size;
+   }
+
+   /**
+    * Inflate the window starting at the given index of the windows map
+    */
+   std::vector<char> inflate_window( size_t index, fc::cfile& file ) {
+      const bool last_window = index + 1 == windows_map.size();
+      const uint64_t compressed_begin = std::get<1>(windows_map[index]);
+      const uint64_t compressed_end = last_window ? compressed_data_end : std::get<1>(windows_map[index + 1]);
+
+      std::vector<uint8_t> input(compressed_end - compressed_begin);
+      file.seek(compressed_begin);
+      file.read(reinterpret_cast<char*>(input.data()), input.size());
+
+      z_stream wstrm = {};
+      if (Z_OK != inflateInit2(&wstrm, raw_zlib_window_bits)) {
+         throw std::runtime_error("failed to initialize decompression");
+      }
+      wstrm.avail_in = input.size();
+      wstrm.next_in = input.data();
+
+      std::vector<char> result;
+      if (!last_window) {
+         result.reserve(std::get<0>(windows_map[index + 1]) - std::get<0>(windows_map[index]));
+      }
+
+      // a window other than the last ends at a full flush of the compressor, its input decompresses completely
+      // without reaching the end of the stream
+      int ret = Z_OK;
+      while (ret != Z_STREAM_END) {
+         wstrm.avail_out = read_buffer.size();
+         wstrm.next_out = read_buffer.data();
+         ret = inflate(&wstrm, Z_NO_FLUSH);
+
+         if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR) {
+            const std::string msg = wstrm.msg ? wstrm.msg : "";
+            inflateEnd(&wstrm);
+            throw compressed_file_error("Error decompressing: " + msg);
+         }
+
+         result.insert(result.end(), read_buffer.begin(), read_buffer.end() - wstrm.avail_out);
+
+         if (ret == Z_BUF_ERROR || (wstrm.avail_in == 0 && wstrm.avail_out != 0)) {
+            break;
+         }
+      }
+      inflateEnd(&wstrm);
+
+      if (!last_window && result.size() != std::get<0>(windows_map[index + 1]) - std::get<0>(windows_map[index])) {
+         throw compressed_file_error("Error decompressing window " + std::to_string(index) + " of " + file.get_file_path().generic_string());
+      }
+      return result;
+   }
+
+   void load_window( size_t index, fc::cfile& file ) {
+      const uint64_t offset = std::get<0>(windows_map[index]);
+      window = cache->get(file.get_file_path(), offset);
+      if (!window) {
+         window = std::make_shared<const std::vector<char>>(inflate_window(index, file));
+         cache->put(file.get_file_path(), offset, window);
+      }
+      window_index = index;
+      window_pos = 0;
+   }
+
+   void read_windowed( char* d, size_t n, fc::cfile& file ) {
+      if (!window) {
+         seek_windowed(0, file);
+      }
+
+      while (n > 0) {
+         if (window_pos == window->size()) {
+            if (window_index + 1 == windows_map.size()) {
+               throw std::ios_base::failure("Attempting to read past the end of a compressed file");
+            }
+            load_window(window_index + 1, file);
+            continue;
+         }
+
+         const auto to_copy = std::min(n, window->size() - window_pos);
+         std::memcpy(d, window->data() + window_pos, to_copy);
+         d += to_copy;
+         n -= to_copy;
+         window_pos += to_copy;
+      }
+   }
+
+   void seek_windowed( uint64_t loc, fc::cfile& file ) {
+      load_windows_map(file);
+
+      // the first window starts at 0, so there is always a window starting at or before loc
+      auto iter = std::upper_bound(windows_map.begin(), windows_map.end(), loc, []( const auto& lhs, const auto& rhs ){
+         return lhs < std::get<0>(rhs);
+      });
+      load_window(iter - windows_map.begin() - 1, file);
+
+      const uint64_t pos = loc - std::get<0>(windows_map[window_index]);
+      if (pos > window->size()) {
+         throw std::ios_base::failure("Attempting to seek past the end of a compressed file");
+      }
+      window_pos = pos;
+   }
+
    void seek( uint64_t loc, fc::cfile& file ) {
       if (initialized) {
          inflateEnd(&strm);
@@ -166,13 +325,22 @@ struct compressed_file_impl {
    size_t remaining_read_buffer = 0;
    bool initialized = false;
    size_t file_size = 0;
+
+   // windowed reads, only used with a cache
+   std::shared_ptr<decompressed_window_cache> cache;
+   std::vector<seek_point_entry>              windows_map;          ///< uncompressed and compressed offsets of each window
+   uint64_t                                   compressed_data_end = 0;
+   decompressed_window_cache::window_ptr      window;
+   size_t                                     window_index = 0;
+   size_t                                     window_pos = 0;
 };
 
-compressed_file::compressed_file( std::filesystem::path file_path )
+compressed_file::compressed_file( std::filesystem::path file_path, std::shared_ptr<decompressed_window_cache> cache )
 :file_path(std::move(file_path))
 ,file_ptr(nullptr)
 ,impl(std::make_unique<compressed_file_impl>())
 {
+   impl->cache = std::move(cache);
    // this-> is required here; otherwise, the compiler would use the
    // the passed parameter which has been moved.
    impl->file_size = std::filesystem::file_size(this->file_path);
@@ -182,12 +350,19 @@ compressed_file::~compressed_file()
 {}
 
 void compressed_file::seek( uint64_t loc ) {
-   impl->seek(loc, *file_ptr);
-
+   if (impl->cache) {
+      impl->seek_windowed(loc, *file_ptr);
+   } else {
+      impl->seek(loc, *file_ptr);
+   }
 }
 
 void compressed_file::read( char* d, size_t n ) {
-   impl->read(d, n, *file_ptr);
+   if (impl->cache) {
+      impl->read_windowed(d, n, *file_ptr);
+   } else {
+      impl->read(d, n, *file_ptr);
+   }
 }
 
 // these are defaulted now that the opaque impl type is known
@@ -1,12 +1,60 @@
 #pragma once
 
 #include <ios>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <fc/io/cfile.hpp>
 
 namespace eosio::trace_api {
 
    class compressed_file_datastream;
    struct compressed_file_impl;
+
+   /**
+    * LRU cache of decompressed windows of compressed files, shared by every reader of the compressed files in a
+    * directory. A window is the uncompressed data from one seek point to the next, so a reader finding its window
+    * in the cache neither reads nor inflates any of the file.
+    *
+    * Compressed files are never modified once written, windows are identified by file path and uncompressed offset.
+    */
+   class decompressed_window_cache {
+   public:
+      using window_ptr = std::shared_ptr<const std::vector<char>>;
+
+      /**
+       * @param max_size - the number of uncompressed bytes to keep, the least recently used windows are evicted
+       *                   beyond that
+       */
+      explicit decompressed_window_cache( size_t max_size ) : max_size(max_size) {}
+
+      /**
+       * @return the window of the file starting at the uncompressed offset, empty if not cached
+       */
+      window_ptr get( const std::filesystem::path& file_path, uint64_t offset );
+
+      /**
+       * Add a window, evicting the least recently used windows if the cache grows past its maximum size
+       */
+      void put( const std::filesystem::path& file_path, uint64_t offset, window_ptr window );
+
+      size_t size() const {
+         std::scoped_lock g(mtx);
+         return cached_size;
+      }
+
+   private:
+      using key_t = std::pair<std::string, uint64_t>;
+      using lru_list_t = std::list<std::pair<key_t, window_ptr>>;
+
+      const size_t                            max_size;
+      mutable std::mutex                      mtx;
+      lru_list_t                              lru;        ///< most recently used first
+      std::map<key_t, lru_list_t::iterator>   windows;
+      size_t                                  cached_size = 0;
+   };
+
    /**
     * wrapper for read-only access to a compressed file.
     * compressed files support seeking and reading
@@ -44,7 +92,11 @@ namespace eosio::trace_api {
     */
    class compressed_file {
    public:
-      explicit compressed_file( std::filesystem::path file_path );
+      /**
+       * @param file_path - the compressed file
+       * @param cache - optional cache of decompressed windows, when set reads decompress whole windows through it
+       */
+      explicit compressed_file( std::filesystem::path file_path, std::shared_ptr<decompressed_window_cache> cache = {} );
       ~compressed_file();
 
       /**
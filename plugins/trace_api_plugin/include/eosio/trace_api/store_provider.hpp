@@ -1,6 +1,10 @@
 #pragma once
 
+#include <functional>
 #include <ios>
+#include <list>
+#include <map>
+#include <memory>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -86,6 +90,30 @@ namespace eosio::trace_api {
 
    class store_provider;
 
+   /**
+    * Header of the index of an irreversible trx id slice, built by the maintenance thread. It holds a bloom filter
+    * over the transaction ids of the slice and is followed by `count` fixed size trx_id_index_entry records sorted
+    * by id, so a lookup can skip the slice or binary search it instead of reading every entry.
+    */
+   struct trx_id_index_header {
+      uint32_t              version = 0;
+      uint32_t              bloom_hashes = 0;
+      std::vector<uint64_t> bloom;
+      uint32_t              count = 0;
+
+      static constexpr uint32_t bloom_bits_per_id = 10;
+
+      void bloom_add(const chain::transaction_id_type& id);
+      bool bloom_may_contain(const chain::transaction_id_type& id) const;
+   };
+
+   struct trx_id_index_entry {
+      chain::transaction_id_type id;
+      uint32_t                   block_num = 0;
+
+      static constexpr uint64_t packed_size = sizeof(chain::transaction_id_type) + sizeof(uint32_t);
+   };
+
    /**
     * Provides access to the slice directory.  It is only intended to be used by store_provider
     * and unit tests.
@@ -98,7 +126,8 @@ namespace eosio::trace_api {
 
       enum class open_state { read /*read from front to back*/, write /*write to end of file*/ };
       slice_directory(const std::filesystem::path& slice_dir, uint32_t width, std::optional<uint32_t> minimum_irreversible_history_blocks,
-                      std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride);
+                      std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride,
+                      uint32_t maintenance_threads = 1, size_t decompressed_cache_size = 0);
 
       /**
        * Return the slice number that would include the passed in block_height
@@ -201,6 +230,33 @@ namespace eosio::trace_api {
        */
       bool find_trx_id_slice(uint32_t slice_number, open_state state, fc::cfile& trx_id_file, bool open_file = true) const;
 
+      /**
+       * Find the index of the trx id file, only present once the slice is irreversible
+       *
+       * @param slice_number : slice number of the requested slice file
+       * @param index_file : the cfile that will be set to the appropriate slice filename (always)
+       *                     and opened to that file (if it was found)
+       * @param open_file : indicate if the file should be opened (if found) or not
+       * @return true if file was found (i.e. already existed)
+       */
+      bool find_trx_id_index_slice(uint32_t slice_number, fc::cfile& index_file, bool open_file = true) const;
+
+      /**
+       * Write the index of a trx id file, keeping the last block number recorded for each transaction id
+       *
+       * @param slice_number : slice number of the trx id file to index
+       * @return true if the trx id file was found and indexed
+       */
+      bool create_trx_id_index_slice(uint32_t slice_number) const;
+
+      /**
+       * Set the function called with the slice number of each trx id index removed by the maintenance thread when it
+       * prunes the slice, may be called from several maintenance threads at once
+       */
+      void set_trx_id_index_removed_handler(std::function<void(uint32_t)> handler) {
+         _trx_id_index_removed = std::move(handler);
+      }
+
       /**
        * set the LIB for maintenance
        * @param lib
@@ -220,6 +276,7 @@ namespace eosio::trace_api {
       /**
        * Cleans up all slices that are no longer needed to maintain the minimum number of blocks past lib
        * Compresses up all slices that can be compressed
+       * Indexes the trx id files of all slices that are irreversible
        *
        * @param lib : block number of the current lib
        */
@@ -236,7 +293,8 @@ namespace eosio::trace_api {
       // take an open index slice file and verify its header is valid and prepare the file to be appended to (or read from)
       void validate_existing_index_slice_file(fc::cfile& index_file, open_state state) const;
 
-      // helper for methods that process irreversible slice files
+      // helper for methods that process irreversible slice files, slices are processed by up to _maintenance_threads
+      // threads at once
       template<typename F>
       void process_irreversible_slice_range(uint32_t lib, uint32_t upper_bound_block, std::optional<uint32_t>& lower_bound_slice, F&& f);
 
@@ -246,7 +304,11 @@ namespace eosio::trace_api {
       std::optional<uint32_t> _last_cleaned_up_slice;
       const std::optional<uint32_t> _minimum_uncompressed_irreversible_history_blocks;
       std::optional<uint32_t> _last_compressed_slice;
+      std::optional<uint32_t> _last_indexed_slice;
       const size_t _compression_seek_point_stride;
+      const uint32_t _maintenance_threads;
+      const std::shared_ptr<decompressed_window_cache> _decompressed_cache;
+      std::function<void(uint32_t)> _trx_id_index_removed;
 
       std::mutex _maintenance_mtx;
       std::condition_variable _maintenance_condition;
@@ -263,7 +325,12 @@ namespace eosio::trace_api {
       using open_state = slice_directory::open_state;
 
       store_provider(const std::filesystem::path& slice_dir, uint32_t stride_width, std::optional<uint32_t> minimum_irreversible_history_blocks,
-            std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride);
+            std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride,
+            uint32_t maintenance_threads = 1, size_t decompressed_cache_size = 0,
+            size_t trx_id_index_cache_size = default_trx_id_index_cache_size);
+
+      // bytes of trx id index bloom filters kept, the least recently used are evicted beyond that
+      static constexpr size_t default_trx_id_index_cache_size = 64 * 1024 * 1024;
 
       template<typename BlockTrace>
       void append(const BlockTrace& bt);
@@ -372,9 +439,43 @@ namespace eosio::trace_api {
        */
       void validate_existing_index_slice_file(fc::cfile& index, open_state state);
 
+      /**
+       * @return the number of trx id indexes whose header is cached
+       */
+      size_t cached_trx_id_indexes() const {
+         std::scoped_lock lock(_trx_id_index_mtx);
+         return _trx_id_indexes.size();
+      }
+
       slice_directory _slice_directory;
+
+   private:
+      struct trx_id_index {
+         trx_id_index_header header;
+         uint64_t            entries_offset = 0;
+
+         size_t memory_size() const { return sizeof(trx_id_index) + header.bloom.size() * sizeof(uint64_t); }
+      };
+      using trx_id_index_lru_t = std::list<std::pair<uint32_t, std::shared_ptr<const trx_id_index>>>;
+
+      // returns the cached header of the trx id index of the slice, loading it if the index exists
+      std::shared_ptr<const trx_id_index> get_trx_id_index(uint32_t slice_number);
+
+      // drop the cached header of the trx id index of the slice
+      void erase_trx_id_index(uint32_t slice_number);
+
+      // binary search the trx id index of the slice, returns the block number of the transaction if present
+      get_block_n find_in_trx_id_index(uint32_t slice_number, const trx_id_index& index, const chain::transaction_id_type& trx_id) const;
+
+      const size_t                                      _max_trx_id_index_cache_size;
+      mutable std::mutex                                _trx_id_index_mtx;
+      trx_id_index_lru_t                                _trx_id_index_lru;        ///< bloom filters of indexed slices, most recently used first
+      std::map<uint32_t, trx_id_index_lru_t::iterator>  _trx_id_indexes;         ///< by slice number
+      size_t                                            _trx_id_index_cache_size = 0;
    };
 
 }
 
 FC_REFLECT(eosio::trace_api::slice_directory::index_header, (version))
+FC_REFLECT(eosio::trace_api::trx_id_index_header, (version)(bloom_hashes)(bloom)(count))
+FC_REFLECT(eosio::trace_api::trx_id_index_entry, (id)(block_num))
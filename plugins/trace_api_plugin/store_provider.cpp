@@ -3,6 +3,9 @@
 #include <fc/variant_object.hpp>
 #include <fc/log/logger_config.hpp>
 
+#include <algorithm>
+#include <atomic>
+
 namespace {
       static constexpr uint32_t _current_version = 1;
       static constexpr const char* _trace_prefix = "trace_";
@@ -10,6 +13,8 @@ namespace {
       static constexpr const char* _trace_trx_id_prefix = "trace_trx_id_";
       static constexpr const char* _trace_ext = ".log";
       static constexpr const char* _compressed_trace_ext = ".clog";
+      static constexpr const char* _trx_id_index_ext = ".idx";
+      static constexpr uint32_t _trx_id_bloom_hashes = 7;
       static constexpr int _max_filename_size = std::char_traits<char>::length(_trace_index_prefix) + 10 + 1 + 10 + std::char_traits<char>::length(_compressed_trace_ext) + 1; // "trace_index_" + 10-digits + '-' + 10-digits + ".clog" + null-char
 
       std::string make_filename(const char* slice_prefix, const char* slice_ext, uint32_t slice_number, uint32_t slice_width) {
@@ -30,9 +35,44 @@ namespace {
 }
 
 namespace eosio::trace_api {
+   namespace {
+      // transaction ids are sha256 hashes, so two of their words are used directly as the hashes of double hashing
+      template<typename F>
+      void for_each_bloom_bit(const trx_id_index_header& h, const chain::transaction_id_type& id, F&& f) {
+         const uint64_t bits = h.bloom.size() * 64;
+         const uint64_t h1 = id._hash[0];
+         const uint64_t h2 = id._hash[1] | 1;
+         for (uint32_t i = 0; i < h.bloom_hashes; ++i) {
+            f((h1 + i * h2) % bits);
+         }
+      }
+   }
+
+   void trx_id_index_header::bloom_add(const chain::transaction_id_type& id) {
+      for_each_bloom_bit(*this, id, [this](uint64_t bit) {
+         bloom[bit / 64] |= uint64_t(1) << (bit % 64);
+      });
+   }
+
+   bool trx_id_index_header::bloom_may_contain(const chain::transaction_id_type& id) const {
+      bool result = !bloom.empty();
+      if (result) {
+         for_each_bloom_bit(*this, id, [this, &result](uint64_t bit) {
+            result = result && (bloom[bit / 64] & (uint64_t(1) << (bit % 64)));
+         });
+      }
+      return result;
+   }
+
       store_provider::store_provider(const std::filesystem::path& slice_dir, uint32_t stride_width, std::optional<uint32_t> minimum_irreversible_history_blocks,
-                                  std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride)
-   : _slice_directory(slice_dir, stride_width, minimum_irreversible_history_blocks, minimum_uncompressed_irreversible_history_blocks, compression_seek_point_stride) {
+                                  std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride,
+                                  uint32_t maintenance_threads, size_t decompressed_cache_size, size_t trx_id_index_cache_size)
+   : _slice_directory(slice_dir, stride_width, minimum_irreversible_history_blocks, minimum_uncompressed_irreversible_history_blocks, compression_seek_point_stride,
+                      maintenance_threads, decompressed_cache_size)
+   , _max_trx_id_index_cache_size(trx_id_index_cache_size) {
+      _slice_directory.set_trx_id_index_removed_handler([this](uint32_t slice_number) {
+         erase_trx_id_index(slice_number);
+      });
    }
 
    template<typename BlockTrace>
@@ -110,6 +150,18 @@ namespace eosio::trace_api {
       uint32_t trx_block_num = 0; // number of the block that contains the target trx
       uint32_t trx_entries = 0;   // number of entries that contain the target trx
       while (true){
+         // irreversible slices are indexed, a slice whose bloom filter does not match is skipped without being read
+         if (auto index = get_trx_id_index(slice_number)) {
+            yield();
+            if (index->header.bloom_may_contain(trx_id)) {
+               if (auto block_num = find_in_trx_id_index(slice_number, *index, trx_id)) {
+                  return block_num;
+               }
+            }
+            slice_number++;
+            continue;
+         }
+
          const bool found = _slice_directory.find_trx_id_slice(slice_number, open_state::read, trx_id_file);
          if( !found )
             break; // traversed all slices
@@ -149,12 +201,98 @@ namespace eosio::trace_api {
       return get_block_n{};
    }
 
-   slice_directory::slice_directory(const std::filesystem::path& slice_dir, uint32_t width, std::optional<uint32_t> minimum_irreversible_history_blocks, std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride)
+   std::shared_ptr<const store_provider::trx_id_index> store_provider::get_trx_id_index(uint32_t slice_number) {
+      fc::cfile index_file;
+      const bool dont_open_file = false;
+      if (!_slice_directory.find_trx_id_index_slice(slice_number, index_file, dont_open_file)) {
+         // the slice is not indexed yet, or was pruned after being loaded concurrently
+         erase_trx_id_index(slice_number);
+         return {};
+      }
+
+      {
+         std::scoped_lock lock(_trx_id_index_mtx);
+         auto itr = _trx_id_indexes.find(slice_number);
+         if (itr != _trx_id_indexes.end()) {
+            _trx_id_index_lru.splice(_trx_id_index_lru.begin(), _trx_id_index_lru, itr->second);
+            return itr->second->second;
+         }
+      }
+
+      // read outside of the lock, the bloom filter of a large slice takes a while to read
+      if (!_slice_directory.find_trx_id_index_slice(slice_number, index_file)) {
+         return {};
+      }
+      auto index = std::make_shared<trx_id_index>();
+      index->header = extract_store<trx_id_index_header>(index_file);
+      if (index->header.version != _current_version) {
+         throw old_slice_version("Old trx id index file with version: " + std::to_string(index->header.version) +
+                                 " is in directory, only supporting version: " + std::to_string(_current_version));
+      }
+      index->entries_offset = index_file.tellp();
+
+      std::scoped_lock lock(_trx_id_index_mtx);
+      if (_trx_id_indexes.count(slice_number)) {
+         // another reader loaded the same index first
+         return index;
+      }
+      _trx_id_index_lru.emplace_front(slice_number, index);
+      _trx_id_indexes.emplace(slice_number, _trx_id_index_lru.begin());
+      _trx_id_index_cache_size += index->memory_size();
+
+      // the most recently used index is always kept
+      while (_trx_id_index_cache_size > _max_trx_id_index_cache_size && _trx_id_index_lru.size() > 1) {
+         const auto& oldest = _trx_id_index_lru.back();
+         _trx_id_index_cache_size -= oldest.second->memory_size();
+         _trx_id_indexes.erase(oldest.first);
+         _trx_id_index_lru.pop_back();
+      }
+      return index;
+   }
+
+   void store_provider::erase_trx_id_index(uint32_t slice_number) {
+      std::scoped_lock lock(_trx_id_index_mtx);
+      auto itr = _trx_id_indexes.find(slice_number);
+      if (itr == _trx_id_indexes.end()) {
+         return;
+      }
+      _trx_id_index_cache_size -= itr->second->second->memory_size();
+      _trx_id_index_lru.erase(itr->second);
+      _trx_id_indexes.erase(itr);
+   }
+
+   get_block_n store_provider::find_in_trx_id_index(uint32_t slice_number, const trx_id_index& index, const chain::transaction_id_type& trx_id) const {
+      fc::cfile index_file;
+      if (!_slice_directory.find_trx_id_index_slice(slice_number, index_file)) {
+         return get_block_n{};
+      }
+
+      uint32_t lower = 0;
+      uint32_t upper = index.header.count;
+      while (lower < upper) {
+         const uint32_t mid = lower + (upper - lower) / 2;
+         index_file.seek(index.entries_offset + mid * trx_id_index_entry::packed_size);
+         const auto entry = extract_store<trx_id_index_entry>(index_file);
+         if (entry.id < trx_id) {
+            lower = mid + 1;
+         } else if (trx_id < entry.id) {
+            upper = mid;
+         } else {
+            return entry.block_num;
+         }
+      }
+      return get_block_n{};
+   }
+
+   slice_directory::slice_directory(const std::filesystem::path& slice_dir, uint32_t width, std::optional<uint32_t> minimum_irreversible_history_blocks, std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride,
+                                    uint32_t maintenance_threads, size_t decompressed_cache_size)
    : _slice_dir(slice_dir)
    , _width(width)
    , _minimum_irreversible_history_blocks(minimum_irreversible_history_blocks)
    , _minimum_uncompressed_irreversible_history_blocks(minimum_uncompressed_irreversible_history_blocks)
    , _compression_seek_point_stride(compression_seek_point_stride)
+   , _maintenance_threads(std::max<uint32_t>(maintenance_threads, 1))
+   , _decompressed_cache(decompressed_cache_size > 0 ? std::make_shared<decompressed_window_cache>(decompressed_cache_size) : nullptr)
    , _best_known_lib(0) {
       if (!exists(_slice_dir)) {
          std::filesystem::create_directories(slice_dir);
@@ -229,7 +367,7 @@ namespace eosio::trace_api {
       const bool file_exists = exists(slice_path);
 
       if (file_exists) {
-         auto result = compressed_file(slice_path);
+         auto result = compressed_file(slice_path, _decompressed_cache);
          if (open_file) {
             result.open();
          }
@@ -287,6 +425,76 @@ namespace eosio::trace_api {
       return true;
    }
 
+   bool slice_directory::find_trx_id_index_slice(uint32_t slice_number, fc::cfile& index_file, bool open_file) const {
+      const auto slice_path = _slice_dir / make_filename(_trace_trx_id_prefix, _trx_id_index_ext, slice_number, _width);
+      index_file.set_file_path(slice_path);
+
+      const bool file_exists = exists(slice_path);
+      if( !file_exists || !open_file ) {
+         return file_exists;
+      }
+
+      index_file.open("rb");
+      return true;
+   }
+
+   bool slice_directory::create_trx_id_index_slice(uint32_t slice_number) const {
+      fc::cfile trx_id_file;
+      if( !find_trx_id_slice(slice_number, open_state::read, trx_id_file) ) {
+         return false;
+      }
+
+      std::vector<trx_id_index_entry> entries;
+      metadata_log_entry entry;
+      auto ds = trx_id_file.create_datastream();
+      const uint64_t end = file_size(trx_id_file.get_file_path());
+      uint64_t offset = trx_id_file.tellp();
+      while (offset < end) {
+         fc::raw::unpack(ds, entry);
+         if (std::holds_alternative<block_trxs_entry>(entry)) {
+            const auto& trxs_entry = std::get<block_trxs_entry>(entry);
+            for (const auto& id : trxs_entry.ids) {
+               entries.emplace_back(trx_id_index_entry{ .id = id, .block_num = trxs_entry.block_num });
+            }
+         }
+         offset = trx_id_file.tellp();
+      }
+
+      // a transaction of a forked out block is recorded again for the block that includes it on the new fork, keep
+      // the last entry of each id
+      std::stable_sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.id < b.id; });
+      const auto last = std::unique(entries.rbegin(), entries.rend(), [](const auto& a, const auto& b) { return a.id == b.id; });
+      entries.erase(entries.begin(), last.base());
+
+      trx_id_index_header header { .version = _current_version, .bloom_hashes = _trx_id_bloom_hashes };
+      header.bloom.resize(std::max<size_t>(1, (entries.size() * trx_id_index_header::bloom_bits_per_id + 63) / 64));
+      header.count = entries.size();
+      for (const auto& e : entries) {
+         header.bloom_add(e.id);
+      }
+
+      // write to a temporary file first, readers find the index only once it is complete
+      fc::cfile index_file;
+      const bool dont_open_file = false;
+      find_trx_id_index_slice(slice_number, index_file, dont_open_file);
+      auto tmp_path = index_file.get_file_path();
+      tmp_path += ".tmp";
+
+      fc::cfile tmp_file;
+      tmp_file.set_file_path(tmp_path);
+      tmp_file.open(fc::cfile::truncate_rw_mode);
+      auto data = fc::raw::pack(header);
+      tmp_file.write(data.data(), data.size());
+      for (const auto& e : entries) {
+         data = fc::raw::pack(e);
+         tmp_file.write(data.data(), data.size());
+      }
+      tmp_file.flush();
+      tmp_file.close();
+      std::filesystem::rename(tmp_path, index_file.get_file_path());
+      return true;
+   }
+
    void slice_directory::set_lib(uint32_t lib) {
       {
          std::scoped_lock lock(_maintenance_mtx);
@@ -343,11 +551,51 @@ namespace eosio::trace_api {
       const int64_t upper_bound_block_number = static_cast<int64_t>(lib) - static_cast<int64_t>(min_irreversible) - _width;
       if (upper_bound_block_number >= 0) {
          uint32_t upper_bound_slice_num = slice_number(static_cast<uint32_t>(upper_bound_block_number));
-         while (!lower_bound_slice || *lower_bound_slice < upper_bound_slice_num) {
-            const uint32_t slice_to_process = lower_bound_slice ? *lower_bound_slice + 1 : 0;
-            f(slice_to_process);
-            lower_bound_slice = slice_to_process;
+         if (_maintenance_threads == 1) {
+            while (!lower_bound_slice || *lower_bound_slice < upper_bound_slice_num) {
+               const uint32_t slice_to_process = lower_bound_slice ? *lower_bound_slice + 1 : 0;
+               f(slice_to_process);
+               lower_bound_slice = slice_to_process;
+            }
+            return;
          }
+
+         // slices are independent of each other, a backlog of them is worked off by several threads. The lower bound
+         // only advances once all of them are processed, so a failed slice is attempted again on the next call.
+         const uint32_t first_slice = lower_bound_slice ? *lower_bound_slice + 1 : 0;
+         if (first_slice > upper_bound_slice_num)
+            return;
+         std::atomic<uint32_t> next_slice = first_slice;
+         std::mutex            error_mtx;
+         std::exception_ptr    error;
+         auto work = [&]() {
+            for (uint32_t slice_to_process = next_slice++; slice_to_process <= upper_bound_slice_num; slice_to_process = next_slice++) {
+               try {
+                  f(slice_to_process);
+               } catch (...) {
+                  std::scoped_lock g(error_mtx);
+                  if (!error)
+                     error = std::current_exception();
+               }
+            }
+         };
+
+         std::vector<std::thread> workers;
+         const uint32_t num_workers = std::min(_maintenance_threads, upper_bound_slice_num - first_slice + 1);
+         for (uint32_t i = 1; i < num_workers; ++i) {
+            workers.emplace_back([&work, i]() {
+               fc::set_thread_name( "trace-mx-" + std::to_string(i) );
+               work();
+            });
+         }
+         work();
+         for (auto& w : workers) {
+            w.join();
+         }
+
+         if (error)
+            std::rethrow_exception(error);
+         lower_bound_slice = upper_bound_slice_num;
       }
    }
 
@@ -377,6 +625,14 @@ namespace eosio::trace_api {
                log(std::string("Removing: ") + trx_id.get_file_path().generic_string());
                std::filesystem::remove(trx_id.get_file_path());
             }
+            const bool trx_id_index_found = find_trx_id_index_slice(slice_to_clean, trx_id, dont_open_file);
+            if (trx_id_index_found) {
+               log(std::string("Removing: ") + trx_id.get_file_path().generic_string());
+               std::filesystem::remove(trx_id.get_file_path());
+               if (_trx_id_index_removed) {
+                  _trx_id_index_removed(slice_to_clean);
+               }
+            }
 
             auto ctrace = find_compressed_trace_slice(slice_to_clean, dont_open_file);
             if (ctrace) {
@@ -411,5 +667,20 @@ namespace eosio::trace_api {
             }
          });
       }
+
+      // Index the trx id file of every slice whose blocks are all irreversible, nothing is appended to it after that
+      process_irreversible_slice_range(lib, 0, _last_indexed_slice, [this, &log](uint32_t slice_to_index){
+         fc::cfile index;
+         const bool dont_open_file = false;
+         if (find_trx_id_index_slice(slice_to_index, index, dont_open_file)) {
+            return;
+         }
+
+         log(std::string("Attempting index of trx id slice: ") + std::to_string(slice_to_index));
+
+         if (create_trx_id_index_slice(slice_to_index)) {
+            log(std::string("Indexed: ") + index.get_file_path().generic_string());
+         }
+      });
    }
 }
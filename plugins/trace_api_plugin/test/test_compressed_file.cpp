@@ -201,4 +201,40 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(blob_access_no_seek_points, T, test_types, temp
 }
 
 
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(cached_blob_access, T, test_types, temp_file_fixture) {
+   auto data = std::vector<T>(128);
+   std::generate(data.begin(), data.end(), []() {
+      return make_random<T>();
+   });
+
+   auto uncompressed_filename = create_temp_file(data.data(), data.size() * sizeof(T));
+   auto compressed_filename = create_temp_file(nullptr, 0);
+
+   BOOST_TEST(compressed_file::process(uncompressed_filename, compressed_filename, 512));
+
+   // a cache smaller than the file so windows are evicted while reading
+   const size_t max_cache_size = data.size() * sizeof(T) / 2;
+   auto cache = std::make_shared<decompressed_window_cache>(max_cache_size);
+
+   // test that you can read all of the offsets through the end of the file, from the cache or the compressed form
+   for (size_t i = 0; i < data.size(); i++) {
+      auto actual_data = std::vector<T>(128);
+      auto compf = compressed_file(compressed_filename, cache);
+      compf.open();
+      compf.seek(i * sizeof(T));
+      compf.read(reinterpret_cast<char*>(actual_data.data()), (actual_data.size() - i) * sizeof(T));
+      compf.close();
+      BOOST_REQUIRE_EQUAL_COLLECTIONS(data.begin() + i, data.end(), actual_data.begin(), actual_data.end() - i);
+      BOOST_TEST(cache->size() <= max_cache_size);
+   }
+
+   // reading past the end of the file fails
+   auto compf = compressed_file(compressed_filename, cache);
+   compf.open();
+   compf.seek((data.size() - 1) * sizeof(T));
+   T value;
+   BOOST_REQUIRE_THROW(compf.read(reinterpret_cast<char*>(&value), sizeof(T) + 1), std::exception);
+}
+
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -205,11 +205,15 @@ namespace {
    };
 
    struct test_store_provider : public store_provider {
-      test_store_provider(const std::filesystem::path& slice_dir, uint32_t width, std::optional<uint32_t> minimum_irreversible_history_blocks = std::optional<uint32_t>(), std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks = std::optional<uint32_t>(), size_t compression_seek_point_stride = 0)
-         : store_provider(slice_dir, width, minimum_irreversible_history_blocks, minimum_uncompressed_irreversible_history_blocks, compression_seek_point_stride) {
+      test_store_provider(const std::filesystem::path& slice_dir, uint32_t width, std::optional<uint32_t> minimum_irreversible_history_blocks = std::optional<uint32_t>(), std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks = std::optional<uint32_t>(), size_t compression_seek_point_stride = 0,
+                          size_t trx_id_index_cache_size = store_provider::default_trx_id_index_cache_size)
+         : store_provider(slice_dir, width, minimum_irreversible_history_blocks, minimum_uncompressed_irreversible_history_blocks, compression_seek_point_stride,
+                          1, 0, trx_id_index_cache_size) {
       }
       using store_provider::scan_metadata_log_from;
       using store_provider::read_data_log;
+      using store_provider::cached_trx_id_indexes;
+      using store_provider::_slice_directory;
    };
 
    class vslice_datastream;
@@ -724,6 +728,49 @@ BOOST_AUTO_TEST_SUITE(slice_tests)
       }
    }
 
+   BOOST_FIXTURE_TEST_CASE(slice_dir_compress_parallel, test_fixture)
+   {
+      fc::temp_directory tempdir;
+      const uint32_t width = 10;
+      const uint32_t min_uncompressed_blocks = 5;
+      const uint32_t maintenance_threads = 3;
+      slice_directory sd(tempdir.path(), width, std::optional<uint32_t>(), std::optional<uint32_t>(min_uncompressed_blocks), 8, maintenance_threads);
+      fc::cfile file;
+
+      std::set<std::filesystem::path> files;
+      std::set<std::filesystem::path> compressed_files;
+      for (int i = 0; i < 7 ; i++) {
+         BOOST_REQUIRE(!sd.find_or_create_index_slice(i, open_state::read, file));
+         auto index_name = file.get_file_path().filename();
+         BOOST_REQUIRE(create_non_empty_trace_slice(sd, i, file));
+         auto trace_name = file.get_file_path().filename();
+         auto compressed_trace_name = trace_name;
+         compressed_trace_name.replace_extension(".clog");
+         files.insert(index_name);
+         files.insert(trace_name);
+         compressed_files.insert(index_name);
+         compressed_files.insert(compressed_trace_name);
+      }
+      verify_directory_contents(tempdir.path(), files);
+
+      // verify no change up to the last block before a slice becomes compressible
+      sd.run_maintenance_tasks(14, {});
+      verify_directory_contents(tempdir.path(), files);
+
+      // a single maintenance pass compresses all the slices across the maintenance threads
+      sd.run_maintenance_tasks(14 + 7 * width, {});
+      verify_directory_contents(tempdir.path(), compressed_files);
+
+      // the compressed slices are readable
+      for (uint32_t i = 0; i < 7 ; i++) {
+         auto compressed = sd.find_compressed_trace_slice(i);
+         BOOST_REQUIRE(compressed);
+         uint8_t which = 0;
+         compressed->read(reinterpret_cast<char*>(&which), sizeof(which));
+         BOOST_REQUIRE_EQUAL(which, 0x7F);
+      }
+   }
+
    BOOST_FIXTURE_TEST_CASE(slice_dir_compress_and_delete, test_fixture)
    {
       fc::temp_directory tempdir;
@@ -1066,5 +1113,108 @@ BOOST_AUTO_TEST_SUITE(slice_tests)
       BOOST_REQUIRE(!block2);
    }
 
+   BOOST_FIXTURE_TEST_CASE(store_provider_trx_id_index, test_fixture)
+   {
+      fc::temp_directory tempdir;
+      const uint32_t width = 10;
+      store_provider sp(tempdir.path(), width, std::optional<uint32_t>(), std::optional<uint32_t>(), 0);
+      slice_directory sd(tempdir.path(), width, std::optional<uint32_t>(), std::optional<uint32_t>(), 0);
+
+      auto trx_id = [](uint32_t n) { return fc::sha256::hash(std::to_string(n)); };
+
+      // one transaction per block, the transaction of block 12 is forked out and included again in block 13
+      const uint32_t last_block = 44;
+      for (uint32_t block_num = 1; block_num <= last_block; ++block_num) {
+         std::vector<chain::transaction_id_type> ids{ trx_id(block_num) };
+         if (block_num == 13) {
+            ids.push_back(trx_id(12));
+         }
+         sp.append_trx_ids(block_trxs_entry{ .ids = ids, .block_num = block_num });
+         if (block_num > 1) {
+            sp.append_lib(block_num - 1);
+         }
+      }
+
+      auto verify_lookups = [&]() {
+         for (uint32_t block_num = 1; block_num <= last_block; ++block_num) {
+            const auto found = sp.get_trx_block_number(trx_id(block_num), std::optional<uint32_t>());
+            BOOST_REQUIRE(found);
+            BOOST_REQUIRE_EQUAL(*found, block_num == 12 ? 13u : block_num);
+         }
+         BOOST_REQUIRE(!sp.get_trx_block_number(trx_id(last_block + 1), std::optional<uint32_t>()));
+      };
+
+      verify_lookups();
+
+      // only slices whose blocks are all irreversible are indexed
+      sd.run_maintenance_tasks(last_block - 1, {});
+      fc::cfile file;
+      for (uint32_t slice = 0; slice < 5; ++slice) {
+         BOOST_REQUIRE_EQUAL(sd.find_trx_id_index_slice(slice, file, false), slice < 4);
+      }
+
+      verify_lookups();
+
+      // an indexed slice is searched through its index alone
+      BOOST_REQUIRE(sd.find_trx_id_slice(1, open_state::read, file, false));
+      std::filesystem::remove(file.get_file_path());
+      verify_lookups();
+   }
+
+   BOOST_FIXTURE_TEST_CASE(store_provider_trx_id_index_cache, test_fixture)
+   {
+      fc::temp_directory tempdir;
+      const uint32_t width = 10;
+      const uint32_t min_irreversible_blocks = 15;
+      test_store_provider sp(tempdir.path(), width, min_irreversible_blocks);
+
+      auto trx_id = [](uint32_t n) { return fc::sha256::hash(std::to_string(n)); };
+      const uint32_t last_block = 64;
+      for (uint32_t block_num = 1; block_num <= last_block; ++block_num) {
+         sp.append_trx_ids(block_trxs_entry{ .ids = { trx_id(block_num) }, .block_num = block_num });
+         sp.append_lib(block_num);
+      }
+
+      auto num_indexed = [&]() {
+         fc::cfile file;
+         uint32_t num = 0;
+         for (uint32_t slice = 0; slice <= last_block / width; ++slice) {
+            num += sp._slice_directory.find_trx_id_index_slice(slice, file, false);
+         }
+         return num;
+      };
+
+      // slices 0 and 1 are indexed, none is old enough to be pruned
+      sp._slice_directory.run_maintenance_tasks(20, {});
+      BOOST_REQUIRE_EQUAL(num_indexed(), 2u);
+      BOOST_REQUIRE_EQUAL(sp.cached_trx_id_indexes(), 0u);
+      // a missing trx is looked up in every slice, loading every index
+      BOOST_REQUIRE(!sp.get_trx_block_number(trx_id(last_block + 1), std::optional<uint32_t>()));
+      BOOST_REQUIRE_EQUAL(sp.cached_trx_id_indexes(), 2u);
+
+      // pruning slices 0 and 1 drops their indexes from the cache, slice 2 is indexed
+      sp._slice_directory.run_maintenance_tasks(35, {});
+      BOOST_REQUIRE_EQUAL(num_indexed(), 1u);
+      BOOST_REQUIRE_EQUAL(sp.cached_trx_id_indexes(), 0u);
+      const auto found = sp.get_trx_block_number(trx_id(25), std::optional<uint32_t>(25));
+      BOOST_REQUIRE(found);
+      BOOST_REQUIRE_EQUAL(*found, 25u);
+      BOOST_REQUIRE_EQUAL(sp.cached_trx_id_indexes(), 1u);
+
+      // only the most recently used index is kept when the indexes do not fit in the cache
+      fc::temp_directory small_tempdir;
+      test_store_provider small_sp(small_tempdir.path(), width, std::optional<uint32_t>(), std::optional<uint32_t>(), 0, 1);
+      for (uint32_t block_num = 1; block_num <= last_block; ++block_num) {
+         small_sp.append_trx_ids(block_trxs_entry{ .ids = { trx_id(block_num) }, .block_num = block_num });
+         small_sp.append_lib(block_num);
+      }
+      small_sp._slice_directory.run_maintenance_tasks(last_block, {});
+      for (uint32_t block_num = 1; block_num <= last_block; ++block_num) {
+         const auto found = small_sp.get_trx_block_number(trx_id(block_num), std::optional<uint32_t>());
+         BOOST_REQUIRE(found);
+         BOOST_REQUIRE_EQUAL(*found, block_num);
+         BOOST_REQUIRE_EQUAL(small_sp.cached_trx_id_indexes(), 1u);
+      }
+   }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -113,6 +113,11 @@ struct trace_api_common_impl {
       cfg_options("trace-minimum-uncompressed-irreversible-history-blocks", boost::program_options::value<int32_t>()->default_value(-1),
                   "Number of blocks to ensure are uncompressed past LIB. Compressed \"slice\" files are still accessible but may carry a performance loss on retrieval\n"
                   "A value of -1 indicates that automatic compression of \"slice\" files will be turned off.");
+      cfg_options("trace-maintenance-threads", bpo::value<uint32_t>()->default_value(2),
+                  "Number of threads compressing, indexing and removing irreversible \"slice\" files when several are due at once.");
+      cfg_options("trace-decompressed-cache-mb", bpo::value<uint32_t>()->default_value(64),
+                  "Size in MiB of the cache of decompressed data of compressed \"slice\" files shared by all requests.\n"
+                  "A value of 0 disables the cache, every read then decompresses from the nearest seek point.");
    }
 
    void plugin_initialize(const appbase::variables_map& options) {
@@ -141,12 +146,20 @@ struct trace_api_common_impl {
          minimum_uncompressed_irreversible_history_blocks = uncompressed_blocks;
       }
 
+      const uint32_t maintenance_threads = options.at("trace-maintenance-threads").as<uint32_t>();
+      EOS_ASSERT(maintenance_threads > 0, chain::plugin_config_exception,
+                 "\"trace-maintenance-threads\" must be greater than 0.");
+
+      const uint64_t decompressed_cache_size = uint64_t(options.at("trace-decompressed-cache-mb").as<uint32_t>()) * 1024 * 1024;
+
       store = std::make_shared<store_provider>(
          trace_dir,
          slice_stride,
          minimum_irreversible_history_blocks,
          minimum_uncompressed_irreversible_history_blocks,
-         compression_seek_point_stride
+         compression_seek_point_stride,
+         maintenance_threads,
+         decompressed_cache_size
       );
    }
 
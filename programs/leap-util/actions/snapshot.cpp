@@ -83,9 +83,7 @@ int snapshot_actions::run_subcommand() {
    protocol_feature_set pfs = initialize_protocol_features( std::filesystem::path("protocol_features"), false );
 
    try {
-      auto infile = std::ifstream(snapshot_path.generic_string(),
-                                  (std::ios::in | std::ios::binary));
-      auto reader = std::make_shared<istream_snapshot_reader>(infile);
+      auto reader = std::make_shared<threaded_snapshot_reader>(snapshot_path);
 
       auto check_shutdown = []() { return false; };
       auto shutdown = []() { throw; };
@@ -93,7 +91,6 @@ int snapshot_actions::run_subcommand() {
       control.reset(new controller(cfg, std::move(pfs), chain_id));
       control->add_indices();
       control->startup(shutdown, check_shutdown, reader);
-      infile.close();
 
       ilog("Writing snapshot: ${s}", ("s", json_path));
       auto snap_out = std::ofstream(json_path.generic_string(), (std::ios::out));
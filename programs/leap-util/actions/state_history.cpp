@@ -0,0 +1,120 @@
+#include "state_history.hpp"
+#include <eosio/state_history/compression.hpp>
+#include <eosio/state_history/log.hpp>
+
+#include <fc/log/logger.hpp>
+
+#include <iostream>
+#include <limits>
+
+using namespace eosio;
+using namespace eosio::chain;
+
+namespace {
+
+// copy every entry of the log `name` in input_dir to a new log in output_dir, recompressing it with compression
+void convert_log(const char* name, const std::filesystem::path& input_dir, const std::filesystem::path& output_dir,
+                 const state_history::compression_config& compression) {
+   // open a pruned log as pruned, otherwise it would be vacuumed in place
+   state_history_log_config in_conf;
+   if (detail::state_history_log_data(input_dir / (std::string(name) + ".log")).is_currently_pruned())
+      in_conf = state_history::prune_config{.prune_blocks = std::numeric_limits<uint32_t>::max()};
+
+   state_history_log in(name, input_dir, in_conf);
+   state_history_log out(name, output_dir, {}, compression);
+
+   const auto [begin, end] = in.block_range();
+   ilog("converting ${name}.log blocks ${b} - ${e} to ${c}", ("name", name)("b", begin)("e", end - 1)("c", state_history::to_string(compression.type)));
+
+   std::vector<char> chunk(1024 * 1024);
+   block_id_type     prev_id;
+   for (uint32_t block_num = begin; block_num < end; ++block_num) {
+      auto block_id = in.get_block_id(block_num);
+      EOS_ASSERT(block_id, plugin_exception, "${name}.log is missing block ${b}", ("name", name)("b", block_num));
+
+      decompress_stream entry;
+      in.get_unpacked_entry(block_num, entry);
+
+      state_history_log_header header{.magic = ship_magic(ship_current_version, 0), .block_id = *block_id, .payload_size = 0};
+      out.pack_and_write_entry(header, prev_id, [&](auto&& buf) {
+         std::visit(overloaded{
+            [&](std::vector<char>& bytes) { bio::write(buf, bytes.data(), bytes.size()); },
+            [&](std::unique_ptr<bio::filtering_istreambuf>& strm) {
+               for (std::streamsize n; (n = strm->sgetn(chunk.data(), chunk.size())) > 0;)
+                  bio::write(buf, chunk.data(), n);
+            }}, entry.buf);
+      });
+
+      prev_id = *block_id;
+
+      if (block_num % 100000 == 0)
+         ilog("converted ${name}.log block ${b}", ("name", name)("b", block_num));
+   }
+}
+
+} // namespace
+
+void state_history_actions::setup(CLI::App& app) {
+   auto* sub = app.add_subcommand("state-history", "State history log utility");
+   sub->require_subcommand();
+   sub->fallthrough();
+
+   sub->add_option("--state-history-dir", opt->state_history_dir, "The location of the state history directory (absolute path or relative to the current directory).")->capture_default_str();
+
+   auto* convert = sub->add_subcommand("convert", "Write a copy of trace_history.log and chain_state_history.log to 'output-dir' with every entry "
+                                                  "recompressed. Retained log files of a partitioned state history are not converted.");
+   convert->add_option("--output-dir", opt->output_dir, "The output directory for the converted logs, must not contain state history logs.")->required();
+   convert->add_option("--compression", opt->compression, "Compression of the converted logs: zlib or zstd.")->capture_default_str();
+   convert->add_option("--compression-level", opt->compression_level, "Compression level, zlib: 0-9 (default 6), zstd: 1-22 (default 3).");
+
+   convert->callback([this]() {
+      try {
+         int rc = this->convert();
+         if(rc) throw(CLI::RuntimeError(rc));
+      } catch(...) {
+         print_exception();
+         throw(CLI::RuntimeError(-1));
+      }
+   });
+}
+
+int state_history_actions::convert() {
+   const auto type = state_history::compression_type_from_string(opt->compression);
+   if(!type) {
+      std::cerr << "unknown compression '" << opt->compression << "', expected zlib or zstd" << std::endl;
+      return -1;
+   }
+   const state_history::compression_config compression{.type = *type, .level = opt->compression_level};
+   if(compression.level && !state_history::is_valid_compression_level(*type, *compression.level)) {
+      std::cerr << "invalid " << opt->compression << " compression level " << *compression.level << std::endl;
+      return -1;
+   }
+
+   const std::filesystem::path input_dir = opt->state_history_dir;
+   const std::filesystem::path output_dir = opt->output_dir;
+   if(std::filesystem::exists(output_dir) && std::filesystem::equivalent(input_dir, output_dir)) {
+      std::cerr << "output-dir must differ from state-history-dir" << std::endl;
+      return -1;
+   }
+
+   bool converted = false;
+   for(const char* name : {"trace_history", "chain_state_history"}) {
+      const std::string log_file = std::string(name) + ".log";
+      if(!std::filesystem::exists(input_dir / log_file) || std::filesystem::file_size(input_dir / log_file) == 0)
+         continue;
+      if(std::filesystem::exists(output_dir / log_file)) {
+         std::cerr << (output_dir / log_file).generic_string() << " already exists" << std::endl;
+         return -1;
+      }
+      std::filesystem::create_directories(output_dir);
+      convert_log(name, input_dir, output_dir, compression);
+      converted = true;
+   }
+
+   if(!converted) {
+      std::cerr << "no state history logs found in '" << input_dir.generic_string() << "'" << std::endl;
+      return -1;
+   }
+   std::cout << "Successfully converted state history logs to " << output_dir.generic_string() << std::endl;
+   return 0;
+}
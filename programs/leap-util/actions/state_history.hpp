@@ -0,0 +1,17 @@
+#include "subcommand.hpp"
+
+struct state_history_options {
+   std::string state_history_dir = "state-history";
+   std::string output_dir = "";
+   std::string compression = "zstd";
+   std::optional<int> compression_level;
+};
+
+class state_history_actions : public sub_command<state_history_options> {
+public:
+   state_history_actions() : sub_command() {}
+   void setup(CLI::App& app);
+
+   // callbacks
+   int convert();
+};
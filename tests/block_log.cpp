@@ -58,11 +58,15 @@ struct block_log_fixture {
       p->previous._hash[0] = fc::endian_reverse_u32(index-1);
       p->header_extensions.push_back(std::make_pair<uint16_t, std::vector<char>>(0, std::vector<char>(a)));
 
-      log->append(p, p->calculate_id(), fc::raw::pack(*p));
+      auto packed = fc::raw::pack(*p);
+      log->append(p, p->calculate_id(), packed);
 
-      if(index + 1 > written_data.size())
+      if(index + 1 > written_data.size()) {
          written_data.resize(index + 1);
+         written_blocks.resize(index + 1);
+      }
       written_data.at(index) = a;
+      written_blocks.at(index) = std::move(packed);
    }
 
    void check_range_present(uint32_t first, uint32_t last) {
@@ -74,14 +78,17 @@ struct block_log_fixture {
             std::vector<char> buff;
             buff.resize(written_data.at(i).size());
             eosio::chain::signed_block_ptr p = log->read_block_by_num(i);
-            if(i != 1) //don't check "genesis block"
+            if(i != 1) { //don't check "genesis block"
                BOOST_REQUIRE(p->header_extensions.at(0).second == written_data.at(i));
+               BOOST_REQUIRE(log->read_serialized_block_by_num(i) == written_blocks.at(i));
+            }
          }
       }
    }
 
    void check_not_present(uint32_t index) {
       BOOST_REQUIRE(log->read_block_by_num(index) == nullptr);
+      BOOST_REQUIRE(log->read_serialized_block_by_num(index).empty());
    }
 
    template <typename F>
@@ -101,6 +108,7 @@ struct block_log_fixture {
    std::optional<eosio::chain::block_log> log;
 
    std::vector<std::vector<char>> written_data;
+   std::vector<std::vector<char>> written_blocks;
 
 private:
    void bounce() {
@@ -2,6 +2,7 @@
 
 import time
 import os
+import filecmp
 import signal
 import subprocess
 
@@ -13,6 +14,8 @@ from TestHarness.Node import BlockType
 ###############################################################
 # block_log_util_test
 #  Test verifies that the blockLogUtil is still compatible with nodeos
+#  and that leap-util state-history convert round trips the state
+#  history logs of nodeos between zlib and zstd
 ###############################################################
 
 Print=Utils.Print
@@ -49,7 +52,10 @@ try:
     cluster.setWalletMgr(walletMgr)
 
     Print("Stand up cluster")
-    if cluster.launch(prodCount=prodCount, onlyBios=False, pnodes=pnodes, totalNodes=totalNodes, totalProducers=pnodes*prodCount) is False:
+    specificExtraNodeosArgs={}
+    specificExtraNodeosArgs[2]="--plugin eosio::state_history_plugin --trace-history --chain-state-history"
+    if cluster.launch(prodCount=prodCount, onlyBios=False, pnodes=pnodes, totalNodes=totalNodes, totalProducers=pnodes*prodCount,
+                      specificExtraNodeosArgs=specificExtraNodeosArgs) is False:
         Utils.errorExit("Failed to stand up eos cluster.")
 
     Print("Validating system accounts after bootstrap")
@@ -132,6 +138,27 @@ try:
     Print("Kill the non production node, we want to verify its block log")
     cluster.getNode(2).kill(signal.SIGTERM)
 
+    def convertStateHistory(inputDir, outputDir, compression):
+        cmd="state-history --state-history-dir %s convert --output-dir %s --compression %s" % (inputDir, outputDir, compression)
+        Utils.processLeapUtilCmd(cmd, "convert state history to %s" % (compression), silentErrors=False, exitOnError=True)
+
+    stateHistoryDir=Utils.getNodeDataDir(2, "state-history")
+    zstdDir=Utils.getNodeDataDir(2, "state-history-zstd")
+    roundTripDir=Utils.getNodeDataDir(2, "state-history-round-trip")
+    zlibDir=Utils.getNodeDataDir(2, "state-history-zlib")
+    Print("Convert the state history logs of node 2 from zlib to zstd and back")
+    convertStateHistory(stateHistoryDir, zstdDir, "zstd")
+    convertStateHistory(zstdDir, roundTripDir, "zlib")
+    convertStateHistory(stateHistoryDir, zlibDir, "zlib")
+
+    for logName in ["trace_history", "chain_state_history"]:
+        for ext in [".log", ".index"]:
+            fileName=logName + ext
+            assert filecmp.cmp(os.path.join(roundTripDir, fileName), os.path.join(zlibDir, fileName), shallow=False), \
+                "%s converted to zstd and back to zlib differs from %s converted to zlib" % (fileName, fileName)
+        assert not filecmp.cmp(os.path.join(zstdDir, logName + ".log"), os.path.join(zlibDir, logName + ".log"), shallow=False), \
+            "%s.log converted to zstd is the same as converted to zlib" % (logName)
+
     Print("Trim off block num 1 to remove genesis block from block log.")
     output=cluster.getBlockLog(2, blockLogAction=BlockLogAction.trim, first=2, last=4294967295, throwException=True)
 
@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+
+import signal
+import time
+
+from TestHarness import Cluster, TestHelper, Utils, WalletMgr, CORE_SYMBOL, createAccountKeys
+from TestHarness.TestHelper import AppArgs
+
+###############################################################
+# p2p_multi_peer_sync_test
+#
+# Test syncing from several throttled peers at once with --sync-fetch-ranges.
+# Three nodes serve blocks over a throttled listen endpoint. A node syncing one range at a time is limited to the
+# throttle rate of a single peer, a node syncing a range from each of the three peers at once should sync
+# close to three times as fast.
+# Then one serving node forks off and produces its own chain. A node syncing ranges from both chains receives ranges
+# that do not link to the blocks before them, it rejects them and requests them again from another peer.
+#
+###############################################################
+
+Print=Utils.Print
+errorExit=Utils.errorExit
+
+appArgs = AppArgs()
+appArgs.add(flag='--sync-fetch-ranges',type=int,help='Number of ranges requested at once by the parallel syncing node',default=3)
+appArgs.add(flag='--min-speedup',type=float,help='Minimum speedup of the parallel syncing node',default=1.5)
+
+args=TestHelper.parse_args({"-d","--keep-logs"
+                            ,"--dump-error-details","-v","--leave-running"
+                            ,"--unshared"},
+                            applicationSpecificArgs=appArgs)
+pnodes=1
+delay=args.d
+debug=args.v
+prod_count = 2
+serving_nodes = 3
+sync_nodes = 3
+total_nodes = pnodes + serving_nodes + sync_nodes
+sync_fetch_span = 10
+dumpErrorDetails=args.dump_error_details
+
+Utils.Debug=debug
+testSuccessful=False
+
+cluster=Cluster(unshared=args.unshared, keepRunning=args.leave_running, keepLogs=args.keep_logs)
+walletMgr=WalletMgr(True)
+
+def listenPort(node):
+    i = node.cmd.index('--p2p-listen-endpoint')
+    return int(node.cmd[i+1].split(':')[1])
+
+def throttledPort(node):
+    return listenPort(node) + 100
+
+def removeArg(cmd, flag):
+    while flag in cmd:
+        i = cmd.index(flag)
+        del cmd[i:i+2]
+
+def configureSyncNode(node, fetchRanges):
+    # Connect only to the throttled endpoints of the serving nodes, and listen where the other nodes do not connect,
+    # so all blocks are received over the throttled connections.
+    removeArg(node.cmd, '--p2p-peer-address')
+    i = node.cmd.index('--p2p-listen-endpoint')
+    listenIP, port = node.cmd[i+1].split(':')
+    node.cmd[i+1] = f'{listenIP}:{int(port)+200}'
+    for port in throttledPorts:
+        node.cmd += ['--p2p-peer-address', f'localhost:{port}']
+    node.cmd += ['--sync-fetch-span', str(sync_fetch_span), '--sync-fetch-ranges', str(fetchRanges)]
+
+def timeSync(fetchRanges, endBlock):
+    node = cluster.unstartedNodes[0]
+    configureSyncNode(node, fetchRanges)
+    start = time.time()
+    cluster.launchUnstarted(1)
+    assert node.waitForBlock(endBlock, timeout=300), f'Wait for block {endBlock} on node syncing {fetchRanges} ranges timed out'
+    elapsed = time.time() - start
+    node.kill(signal.SIGTERM)
+    return elapsed
+
+def relaunchForkNode(node, throttledPort, producerArgs):
+    # Serve only over the throttled endpoint, which the other nodes do not connect to, so the chains stay apart.
+    node.kill(signal.SIGTERM)
+    removeArg(node.cmd, '--p2p-peer-address')
+    removeArg(node.cmd, '--p2p-listen-endpoint')
+    removeArg(node.cmd, '--producer-name')
+    removeArg(node.cmd, '--signature-provider')
+    node.cmd += ['--p2p-listen-endpoint', f'0.0.0.0:{throttledPort}:100KB/s'] + producerArgs
+    assert node.relaunch(), 'Relaunch of fork node failed'
+
+try:
+    TestHelper.printSystemInfo("BEGIN")
+
+    cluster.setWalletMgr(walletMgr)
+
+    Print(f'producing nodes: {pnodes}, delay between nodes launch: {delay} second{"s" if delay != 1 else ""}')
+
+    Print("Stand up cluster")
+    # Using 100 Kilobytes per second, a block of ~250 transactions at ~175 bytes per transaction resulting from the
+    # trx generators takes about half a second to send over a throttled connection.
+    specificArgs = {}
+    for nodeNum in range(pnodes, pnodes + serving_nodes):
+        port = cluster.p2pBasePort + nodeNum
+        specificArgs[str(nodeNum)] = f'--p2p-listen-endpoint 0.0.0.0:{port+100}:100KB/s'
+    if cluster.launch(pnodes=pnodes, unstartedNodes=sync_nodes, totalNodes=total_nodes, prodCount=prod_count,
+                      topo='mesh', delay=delay, specificExtraNodeosArgs=specificArgs) is False:
+        errorExit("Failed to stand up eos cluster.")
+
+    prodNode = cluster.getNode(0)
+    nonProdNode = cluster.getNode(1)
+    servingNodes = [cluster.getNode(nodeNum) for nodeNum in range(pnodes, pnodes + serving_nodes)]
+    for servingNode in servingNodes:
+        assert f'0.0.0.0:{throttledPort(servingNode)}:100KB/s' in servingNode.cmd, 'Serving node is not listening on its throttled endpoint'
+    throttledPorts = [throttledPort(servingNode) for servingNode in servingNodes]
+
+    accounts=createAccountKeys(2)
+    if accounts is None:
+        Utils.errorExit("FAILURE - create keys")
+
+    accounts[0].name="tester111111"
+    accounts[1].name="tester222222"
+
+    account1PrivKey = accounts[0].activePrivateKey
+    account2PrivKey = accounts[1].activePrivateKey
+
+    testWalletName="test"
+
+    Print("Creating wallet \"%s\"." % (testWalletName))
+    testWallet=walletMgr.create(testWalletName, [cluster.eosioAccount,accounts[0],accounts[1]])
+
+    # create accounts via eosio as otherwise a bid is needed
+    for account in accounts:
+        Print("Create new account %s via %s" % (account.name, cluster.eosioAccount.name))
+        trans=nonProdNode.createInitializeAccount(account, cluster.eosioAccount, stakedDeposit=0, waitForTransBlock=True, stakeNet=1000, stakeCPU=1000, buyRAM=1000, exitOnError=True)
+        transferAmount="100000000.0000 {0}".format(CORE_SYMBOL)
+        Print("Transfer funds %s from account %s to %s" % (transferAmount, cluster.eosioAccount.name, account.name))
+        nonProdNode.transferFunds(cluster.eosioAccount, account, transferAmount, "test transfer", waitForTransBlock=True)
+        trans=nonProdNode.delegatebw(account, 20000000.0000, 20000000.0000, waitForTransBlock=True, exitOnError=True)
+
+    Print("Configure and launch txn generators")
+    targetTpsPerGenerator = 500
+    testTrxGenDurationSec=30
+    trxGeneratorCnt=1
+    cluster.launchTrxGenerators(contractOwnerAcctName=cluster.eosioAccount.name, acctNamesList=[accounts[0].name,accounts[1].name],
+                                acctPrivKeysList=[account1PrivKey,account2PrivKey], nodeId=prodNode.nodeId, tpsPerGenerator=targetTpsPerGenerator,
+                                numGenerators=trxGeneratorCnt, durationSec=testTrxGenDurationSec, waitToComplete=True)
+
+    endLargeBlocksHeadBlock = nonProdNode.getHeadBlockNum()
+    for servingNode in servingNodes:
+        assert servingNode.waitForBlock(endLargeBlocksHeadBlock), f'Wait for block {endLargeBlocksHeadBlock} on serving node timed out'
+
+    cluster.biosNode.kill(signal.SIGTERM)
+
+    Print("Sync one range at a time")
+    singleElapsed = timeSync(1, endLargeBlocksHeadBlock)
+    Print(f"Sync {args.sync_fetch_ranges} ranges at once")
+    parallelElapsed = timeSync(args.sync_fetch_ranges, endLargeBlocksHeadBlock)
+
+    speedup = singleElapsed / parallelElapsed
+    Print(f'Synced {endLargeBlocksHeadBlock} blocks from {serving_nodes} peers, '
+          f'1 range: {singleElapsed:.2f} seconds ({endLargeBlocksHeadBlock/singleElapsed:.2f} blocks/second), '
+          f'{args.sync_fetch_ranges} ranges: {parallelElapsed:.2f} seconds ({endLargeBlocksHeadBlock/parallelElapsed:.2f} blocks/second), '
+          f'speedup {speedup:.2f}')
+    assert speedup >= args.min_speedup, f'Syncing {args.sync_fetch_ranges} ranges at once was only {speedup:.2f} times as fast'
+
+    Print("Fork the last serving node off, producing with the producers of the producing node")
+    forkNode = servingNodes[-1]
+    producerArgs = []
+    for flag in ['--producer-name', '--signature-provider']:
+        for i, arg in enumerate(prodNode.cmd):
+            if arg == flag:
+                producerArgs += [flag, prodNode.cmd[i+1]]
+    relaunchForkNode(forkNode, throttledPorts[-1],
+                     producerArgs + ['--plugin', 'eosio::producer_plugin', '--enable-stale-production'])
+    forkBlock = forkNode.getHeadBlockNum()
+    assert forkNode.waitForBlock(forkBlock + 60, timeout=60), f'Fork node did not produce past block {forkBlock + 60}'
+
+    Print("Stop producing on both chains")
+    prodNode.kill(signal.SIGTERM)
+    relaunchForkNode(forkNode, throttledPorts[-1], [])
+    mainInfo = servingNodes[0].getInfo()
+    forkInfo = forkNode.getInfo()
+    Print(f'Forked at block {forkBlock}, main chain head {mainInfo["head_block_num"]} lib {mainInfo["last_irreversible_block_num"]}, '
+          f'fork head {forkInfo["head_block_num"]} lib {forkInfo["last_irreversible_block_num"]}')
+    # peers are synced from only if their head is at least the highest lib, ranges are requested from both chains
+    assert forkInfo["head_block_num"] >= mainInfo["last_irreversible_block_num"] and \
+           mainInfo["head_block_num"] >= forkInfo["last_irreversible_block_num"], 'Chains can not both be synced from'
+    endForkBlock = min(mainInfo["head_block_num"], forkInfo["head_block_num"])
+
+    Print(f"Sync {args.sync_fetch_ranges} ranges at once from both chains")
+    node = cluster.unstartedNodes[0]
+    configureSyncNode(node, args.sync_fetch_ranges)
+    cluster.launchUnstarted(1)
+    assert node.waitForBlock(endForkBlock, timeout=300), f'Wait for block {endForkBlock} on node syncing from both chains timed out'
+    assert node.findInLog('does not link'), 'No block received from the other chain was rejected'
+
+    testSuccessful=True
+finally:
+    TestHelper.shutdown(cluster, walletMgr, testSuccessful=testSuccessful, dumpErrorDetails=dumpErrorDetails)
+
+exitCode = 0 if testSuccessful else 1
+exit(exitCode)
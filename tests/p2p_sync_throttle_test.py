@@ -14,6 +14,8 @@ from TestHarness.TestHelper import AppArgs
 # p2p_sync_throttle_test
 #
 # Test throttling of a peer during block syncing.
+# With --p2p-compression-level the nodes send compressed blocks, syncing more blocks over the throttled link. The
+# bytes the throttled node receives are then checked against the uncompressed size of the blocks sent to it.
 #
 ###############################################################
 
@@ -23,6 +25,7 @@ errorExit=Utils.errorExit
 appArgs = AppArgs()
 appArgs.add(flag='--plugin',action='append',type=str,help='Run nodes with additional plugins')
 appArgs.add(flag='--connection-cleanup-period',type=int,help='Interval in whole seconds to run the connection reaper and metric collection')
+appArgs.add(flag='--p2p-compression-level',type=int,help='zstd compression level of blocks sent between nodes',default=0)
 
 args=TestHelper.parse_args({"-d","--keep-logs"
                             ,"--dump-error-details","-v","--leave-running"
@@ -46,6 +49,10 @@ def extractPrometheusMetric(connID: str, metric: str, text: str):
     begin = text.find(searchStr) + len(searchStr)
     return int(text[begin:text.find('\n', begin)])
 
+def extractPrometheusNodeMetric(metric: str, text: str):
+    match = re.search(rf'^nodeos_p2p_{metric} (\S+)$', text, re.MULTILINE)
+    return float(match.group(1)) if match else 0
+
 prometheusHostPortPattern = re.compile(r'^nodeos_p2p_port.connid="([a-f0-9]*)". ([0-9]*)', re.MULTILINE)
 
 try:
@@ -56,7 +63,7 @@ try:
     Print(f'producing nodes: {pnodes}, delay between nodes launch: {delay} second{"s" if delay != 1 else ""}')
 
     Print("Stand up cluster")
-    extraNodeosArgs = '--plugin eosio::prometheus_plugin --connection-cleanup-period 3'
+    extraNodeosArgs = f'--plugin eosio::prometheus_plugin --connection-cleanup-period 3 --p2p-compression-level {args.p2p_compression_level}'
     # Custom topology is a line of singlely connected nodes from highest node number in sequence to lowest,
     # the reverse of the usual TestHarness line topology.
     if cluster.launch(pnodes=pnodes, unstartedNodes=2, totalNodes=total_nodes, prodCount=prod_count, 
@@ -152,6 +159,7 @@ try:
             startSyncThrottlingState = extractPrometheusMetric(throttlingNodeConnId,
                                                                'block_sync_throttling',
                                                                response)
+            startThrottlingBlockBytesPacked = extractPrometheusNodeMetric('block_bytes_packed_total', response)
             Print(f'Start sync throttling bytes sent: {startSyncThrottlingBytesSent}')
             Print(f'Start sync throttling node throttling: {"True" if startSyncThrottlingState else "False"}')
             if time.time() > clusterStart + 30: errorExit('Timed out')
@@ -222,11 +230,24 @@ try:
                                                             'block_sync_bytes_received',
                                                             response)
     Print(f'End sync throttled bytes received: {endSyncThrottledBytesReceived}')
+    # every block the throttling node sends is packed once, uncompressed, into its block buffer cache
+    response = throttlingNode.processUrllibRequest('prometheus', 'metrics', exitOnError=True, returnType=ReturnType.raw, printReturnLimit=16).decode()
+    throttlingBlockBytesPacked = extractPrometheusNodeMetric('block_bytes_packed_total', response) - startThrottlingBlockBytesPacked
+    Print(f'Throttling node block bytes packed: {throttlingBlockBytesPacked:.0f}')
     throttlingElapsed = endThrottlingSync - clusterStart
     throttledElapsed = endThrottledSync - clusterStart
     Print(f'Unthrottled sync time: {throttlingElapsed} seconds')
     Print(f'Throttled sync time: {throttledElapsed} seconds')
+    syncedBlocks = endLargeBlocksHeadBlock - beginLargeBlocksHeadBlock
+    Print(f'Throttled sync throughput: {syncedBlocks/throttledElapsed:.2f} blocks/second, '
+          f'{(endSyncThrottledBytesReceived - startSyncThrottledBytesReceived)/syncedBlocks:.0f} bytes received per block, '
+          f'compression level {args.p2p_compression_level}')
     assert wasThrottled, 'Throttling node never reported throttling its transmission rate'
+    if args.p2p_compression_level > 0:
+        syncedBytes = endSyncThrottledBytesReceived - startSyncThrottledBytesReceived
+        Print(f'Compressed to {syncedBytes/throttlingBlockBytesPacked:.2f} of the uncompressed size')
+        assert syncedBytes < 0.9 * throttlingBlockBytesPacked, \
+            f'Compressed sync received {syncedBytes} bytes, not measurably fewer than the {throttlingBlockBytesPacked:.0f} bytes of the uncompressed blocks'
 
     testSuccessful=True
 finally:
@@ -52,7 +52,7 @@ struct ship_log_fixture {
       BOOST_REQUIRE_EQUAL(r.second-1, last);
       if(enable_read) {
          for(auto i = first; i <= last; i++) {
-            auto result = log->create_locked_decompress_stream();
+            eosio::decompress_stream result;
             log->get_unpacked_entry(i, result);
             std::visit(eosio::chain::overloaded{
                [&](std::vector<char>& buff) { BOOST_REQUIRE(buff == written_data.at(i)); },
@@ -66,7 +66,7 @@ struct ship_log_fixture {
    }
 
    void check_not_present(uint32_t index) {
-      auto result = log->create_locked_decompress_stream();
+      eosio::decompress_stream result;
       BOOST_REQUIRE_EQUAL(log->get_unpacked_entry(index, result), 0u);
    }
 
@@ -86,6 +86,7 @@ struct ship_log_fixture {
 
    bool enable_read, reopen_on_mark, remove_index_on_reopen, vacuum_on_exit_if_small;
    eosio::state_history_log_config conf;
+   eosio::state_history::compression_config compression;
    fc::temp_directory log_dir;
 
    std::optional<eosio::state_history_log> log;
@@ -103,7 +104,7 @@ private:
          if(vacuum_on_exit_if_small)
             prune_conf->vacuum_on_close = 1024*1024*1024; //something large: always vacuum on close for these tests
       }
-      log.emplace("shipit", log_dir.path(), conf);
+      log.emplace("shipit", log_dir.path(), conf, compression);
    }
 };
 
@@ -431,5 +432,45 @@ BOOST_DATA_TEST_CASE(prune_to_partitioned, bdata::xrange(2) * bdata::xrange(2),
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_DATA_TEST_CASE(mixed_compression, bdata::xrange(2) * bdata::xrange(2), enable_read, remove_index_on_reopen)  { try {
+   ship_log_fixture t(enable_read, true, remove_index_on_reopen, false, std::optional<uint32_t>());
+
+   t.check_empty();
+   size_t payload_size = larger_than_tmpfile_blocksize();
+
+   t.add(2, payload_size, 'A', 'A');
+   t.add(3, payload_size, 'B', 'A');
+
+   //switch to zstd, zlib entries must stay readable
+   t.compression = {.type = eosio::state_history::compression_type::zstd, .level = 19};
+   t.check_n_bounce([&]() {
+      t.check_range_present(2, 3);
+   });
+   t.add(4, payload_size, 'C', 'B');
+   t.add(5, payload_size, 'D', 'C');
+   t.check_n_bounce([&]() {
+      t.check_range_present(2, 5);
+   });
+
+   //and back to zlib
+   t.compression = {.type = eosio::state_history::compression_type::zlib, .level = 1};
+   t.check_n_bounce([&]() {
+      t.check_range_present(2, 5);
+   });
+   t.add(6, payload_size, 'E', 'D');
+   t.add(5, payload_size, 'F', 'C');
+   t.check_n_bounce([&]() {
+      t.check_range_present(2, 5);
+   });
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(invalid_compression_level) { try {
+   fc::temp_directory log_dir;
+   BOOST_REQUIRE_THROW(eosio::state_history_log("shipit", log_dir.path(), {}, {.type = eosio::state_history::compression_type::zlib, .level = 10}),
+                       eosio::chain::plugin_exception);
+   BOOST_REQUIRE_THROW(eosio::state_history_log("shipit", log_dir.path(), {}, {.type = eosio::state_history::compression_type::zstd, .level = 0}),
+                       eosio::chain::plugin_exception);
+} FC_LOG_AND_RETHROW() }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -2,6 +2,7 @@
 
 #include <test_utils.hpp>
 #include <eosio/producer_plugin/producer_plugin.hpp>
+#include <eosio/producer_plugin/ro_trx_queue.hpp>
 #include <eosio/testing/tester.hpp>
 #include <eosio/chain/block.hpp>
 #include <eosio/chain/config.hpp>
@@ -19,6 +20,8 @@
 
 #include <fc/scoped_exit.hpp>
 #include <chrono>
+#include <deque>
+#include <thread>
 
 
 namespace {
@@ -224,4 +227,82 @@ BOOST_AUTO_TEST_CASE(with_8_read_only_threads_no_tierup) {
    test_trxs_common(specific_args, true);
 }
 
+// exhausted read-only trxs are popped in the order they were pushed, whichever thread pushed them
+BOOST_AUTO_TEST_CASE(ro_trx_queue_order) {
+   constexpr size_t num_threads = 16;
+   constexpr size_t num_per_thread = 100;
+   ro_trx_queue<size_t> que;
+   BOOST_CHECK( que.empty() );
+
+   // one thread at a time so the push order is known, threads land on different shards
+   std::deque<size_t> expected;
+   size_t next = 0;
+   for (size_t t = 0; t < num_threads; ++t) {
+      std::thread([&]() {
+         for (size_t i = 0; i < num_per_thread; ++i) {
+            que.push_back(size_t{next});
+            expected.push_back(next++);
+         }
+      }).join();
+      if (t % 2) { // interleave pops with pushes, a popped value pushed again goes last
+         size_t v = 0;
+         BOOST_REQUIRE( que.pop_front(v) );
+         BOOST_REQUIRE_EQUAL( v, expected.front() );
+         expected.pop_front();
+         que.push_back(size_t{v});
+         expected.push_back(v);
+      }
+   }
+
+   std::vector<size_t> popped;
+   size_t v = 0;
+   while (que.pop_front(v))
+      popped.push_back(v);
+   BOOST_CHECK( que.empty() );
+   BOOST_REQUIRE_EQUAL( popped.size(), num_threads * num_per_thread );
+   BOOST_CHECK( std::equal(popped.begin(), popped.end(), expected.begin()) );
+}
+
+// read-only threads exhausting their trxs together at the end of a read window while others pop
+BOOST_AUTO_TEST_CASE(ro_trx_queue_contention) {
+   constexpr size_t num_threads = 32;
+   constexpr size_t num_per_thread = 10000;
+   ro_trx_queue<std::pair<size_t, size_t>> que; // thread, index within thread
+
+   std::atomic<size_t> num_popped = 0;
+   std::atomic<bool> out_of_order = false;
+   std::vector<std::vector<size_t>> popped_by_popper(num_threads / 2);
+   const auto start = std::chrono::steady_clock::now();
+   std::vector<std::thread> threads;
+   for (size_t t = 0; t < num_threads; ++t) {
+      threads.emplace_back([&, t]() {
+         if (t % 2 == 0) {
+            for (size_t i = 0; i < num_per_thread; ++i)
+               que.push_back({t, i});
+         } else {
+            // each popper sees the elements of a pusher in the order they were pushed
+            std::vector<size_t>& last = popped_by_popper[t / 2];
+            last.assign(num_threads, 0);
+            std::pair<size_t, size_t> v;
+            while (num_popped < num_threads / 2 * num_per_thread) {
+               if (!que.pop_front(v))
+                  continue;
+               if (v.second != 0 && v.second < last[v.first])
+                  out_of_order = true;
+               last[v.first] = v.second;
+               ++num_popped;
+            }
+         }
+      });
+   }
+   for (auto& t : threads)
+      t.join();
+   const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+   BOOST_TEST_MESSAGE( num_threads / 2 * num_per_thread << " exhausted trxs pushed and popped by " << num_threads << " threads in " << elapsed.count() << " us" );
+   BOOST_CHECK_EQUAL( num_popped.load(), num_threads / 2 * num_per_thread );
+   BOOST_CHECK( que.empty() );
+   BOOST_CHECK( !out_of_order );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
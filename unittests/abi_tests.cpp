@@ -14,6 +14,7 @@
 
 #include <eosio/chain/contract_types.hpp>
 #include <eosio/chain/abi_serializer.hpp>
+#include <eosio/chain/abi_plan.hpp>
 #include <eosio/chain/eosio_contract.hpp>
 #include <eosio/testing/tester.hpp>
 
@@ -51,6 +52,15 @@ static fc::time_point get_deadline() {
    return fc::time_point::now().safe_add(max_serialization_time);
 }
 
+// verify that the compiled plan writes the same JSON, and builds the same variant, as abi_serializer
+void verify_plan_json( const abi_serializer& abis, const type_name& type, const bytes& binary, const std::string& expected_json )
+{
+   abi_plan plan(std::make_shared<const abi_serializer>(abis));
+   BOOST_REQUIRE_EQUAL( plan.binary_to_json(type, binary, abi_serializer::create_yield_function( max_serialization_time )), expected_json );
+   BOOST_REQUIRE_EQUAL( fc::json::to_string(plan.binary_to_variant(type, binary, abi_serializer::create_yield_function( max_serialization_time )), get_deadline()),
+                        expected_json );
+}
+
 // verify that round trip conversion, via bytes, reproduces the exact same data
 fc::variant verify_byte_round_trip_conversion( const abi_serializer& abis, const type_name& type, const fc::variant& var )
 {
@@ -64,6 +74,7 @@ fc::variant verify_byte_round_trip_conversion( const abi_serializer& abis, const
    std::string r2 = fc::json::to_string(var2, get_deadline());
    std::string r3 = fc::json::to_string(var3, get_deadline());
    BOOST_TEST( r2 == r3 );
+   verify_plan_json(abis, type, bytes, r2);
 
    auto bytes2 = abis.variant_to_binary(type, var2, abi_serializer::create_yield_function( max_serialization_time ));
    auto bytes3 = abis.variant_to_binary(type, var3, max_serialization_time);
@@ -83,6 +94,7 @@ void verify_round_trip_conversion( const abi_serializer& abis, const type_name&
    BOOST_REQUIRE_EQUAL(fc::to_hex(b), hex);
    auto var2 = abis.binary_to_variant(type, bytes, abi_serializer::create_yield_function( max_serialization_time ));
    BOOST_REQUIRE_EQUAL(fc::json::to_string(var2, get_deadline()), expected_json);
+   verify_plan_json(abis, type, bytes, expected_json);
    auto var3 = abis.binary_to_variant(type, b, max_serialization_time );
    BOOST_REQUIRE_EQUAL(fc::json::to_string(var3, get_deadline()), expected_json);
    auto bytes2 = abis.variant_to_binary(type, var2, abi_serializer::create_yield_function( max_serialization_time ));
@@ -2682,6 +2694,70 @@ BOOST_AUTO_TEST_CASE(extend)
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE(abi_plan_compile)
+{
+   using eosio::testing::fc_exception_message_starts_with;
+
+   auto abi = R"({
+      "version": "eosio::abi/1.1",
+      "types": [{"new_type_name": "account", "type": "name"}],
+      "structs": [
+         {"name": "base", "base": "", "fields": [{"name": "id", "type": "uint64"}]},
+         {"name": "derived", "base": "base", "fields": [
+            {"name": "owner", "type": "account"},
+            {"name": "children", "type": "derived[]"},
+            {"name": "value", "type": "v?"}
+         ]},
+         {"name": "repeated", "base": "base", "fields": [{"name": "id", "type": "uint64"}]},
+         {"name": "s2", "base": "", "fields": [
+            {"name": "i0", "type": "int8"},
+            {"name": "i1", "type": "int8$"},
+            {"name": "i2", "type": "int8"}
+         ]}
+      ],
+      "variants": [{"name": "v", "types": ["int64", "string", "account"]}],
+      "actions": [{"name": "act", "type": "derived", "ricardian_contract": ""}]
+   })";
+
+   try {
+      auto abis = std::make_shared<const abi_serializer>(fc::json::from_string(abi).as<abi_def>(), abi_serializer::create_yield_function( max_serialization_time ));
+      abi_plan plan(abis);
+      BOOST_TEST( plan.find_type("derived").has_value() );
+      BOOST_TEST( plan.find_type("derived[]").has_value() );
+      BOOST_TEST( !plan.find_type("unknown").has_value() );
+
+      auto yield = abi_serializer::create_yield_function( max_serialization_time );
+      auto json  = R"({"id":"5000000000","owner":"alice","children":[{"id":1,"owner":"bob","children":[],"value":["string","x\"y"]}],"value":["int64",-7]})";
+      auto bin   = abis->variant_to_binary("derived", fc::json::from_string(json), yield);
+      BOOST_REQUIRE_EQUAL( plan.binary_to_json("derived", bin, yield), json );
+      BOOST_REQUIRE_EQUAL( plan.binary_to_json("derived", bin, yield), fc::json::to_string(abis->binary_to_variant("derived", bin, yield), get_deadline()) );
+
+      // a field repeated from the base struct is converted by the abi_serializer
+      bin = abis->variant_to_binary("repeated", fc::json::from_string(R"({"id":1})"), yield);
+      BOOST_REQUIRE_EQUAL( plan.binary_to_json("repeated", bin, yield), fc::json::to_string(abis->binary_to_variant("repeated", bin, yield), get_deadline()) );
+
+      // types not in the plan are converted by the abi_serializer
+      bin = abis->variant_to_binary("base[]", fc::json::from_string(R"([{"id":1},{"id":2}])"), yield);
+      BOOST_REQUIRE_EQUAL( plan.binary_to_json("base[]", bin, yield), R"([{"id":1},{"id":2}])" );
+
+      bytes truncated = abis->variant_to_binary("derived", fc::json::from_string(json), yield);
+      truncated.resize(truncated.size() - 1);
+      BOOST_CHECK_THROW( plan.binary_to_json("derived", truncated, yield), unpack_exception );
+
+      BOOST_CHECK_EXCEPTION( plan.binary_to_json("s2", bytes{1}, yield),
+                             abi_exception, fc_exception_message_starts_with("Encountered field 'i2' without binary extension designation while processing struct") );
+      BOOST_CHECK_EXCEPTION( plan.binary_to_variant("s2", bytes{1}, yield),
+                             abi_exception, fc_exception_message_starts_with("Encountered field 'i2' without binary extension designation while processing struct") );
+
+      // the plan keeps the serializer it was compiled from, as when it is evicted from the abi_cache
+      bin = abis->variant_to_binary("derived", fc::json::from_string(json), yield);
+      auto base_bin = abis->variant_to_binary("base[]", fc::json::from_string(R"([{"id":1},{"id":2}])"), yield);
+      abis.reset();
+      BOOST_REQUIRE_EQUAL( fc::json::to_string(plan.binary_to_variant("derived", bin, yield), get_deadline()), json );
+      BOOST_REQUIRE_EQUAL( fc::json::to_string(plan.binary_to_variant("base[]", base_bin, yield), get_deadline()), R"([{"id":1},{"id":2}])" );
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE(version)
 {
    try {
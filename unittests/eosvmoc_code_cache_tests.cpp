@@ -0,0 +1,311 @@
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+
+#include <eosio/chain/webassembly/eos-vm-oc/code_cache.hpp>
+#include <eosio/testing/tester.hpp>
+#include <test_contracts.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+
+using namespace eosio;
+using namespace eosio::chain;
+using namespace eosio::chain::eosvmoc;
+using namespace eosio::testing;
+using mvo = fc::mutable_variant_object;
+
+namespace {
+
+code_tuple code(int n) {
+   return code_tuple{ digest_type::hash(n), 0 };
+}
+
+std::vector<code_tuple> drain(compile_queue& queue) {
+   std::vector<code_tuple> order;
+   while(!queue.empty()) {
+      order.push_back(queue.front());
+      queue.pop_front();
+   }
+   return order;
+}
+
+// a node tiering up all contracts to EOS VM OC, or nullptr when the tests run with EOS VM OC as the base runtime
+std::unique_ptr<tester> make_oc_tierup_tester(const fc::temp_directory& tempdir, uint32_t preload_count = 0) {
+   if(tester::default_config(tempdir).first.wasm_runtime == wasm_interface::vm_type::eos_vm_oc)
+      return {};
+   auto chain = std::make_unique<tester>(tempdir, [&](controller::config& cfg) {
+      cfg.eosvmoc_tierup = wasm_interface::vm_oc_enable::oc_all;
+      cfg.eosvmoc_config.preload_count = preload_count;
+   }, true);
+   chain->create_accounts({"payloadless"_n, "noop"_n});
+   chain->set_code("payloadless"_n, test_contracts::payloadless_wasm());
+   chain->set_abi("payloadless"_n, test_contracts::payloadless_abi());
+   chain->set_code("noop"_n, test_contracts::noop_wasm());
+   chain->set_abi("noop"_n, test_contracts::noop_abi());
+   chain->produce_block();
+   return chain;
+}
+
+compile_stats oc_stats(tester& chain) {
+   return chain.control->get_wasm_interface().get_eos_vm_oc_compile_stats();
+}
+
+void doit(tester& chain) {
+   auto trace = chain.push_action("payloadless"_n, "doit"_n, "payloadless"_n, mvo());
+   BOOST_CHECK_EQUAL(trace->action_traces.front().console, "Im a payloadless action");
+   chain.produce_block();
+}
+
+void anyaction(tester& chain) {
+   chain.push_action("noop"_n, "anyaction"_n, "noop"_n, mvo()("from", "noop")("type", "some type")("data", "some data"));
+   chain.produce_block();
+}
+
+// compiles run in the background, keep running the contract until as many compiles completed
+template <typename F>
+void run_until_compiled(tester& chain, uint64_t compiled, F&& run) {
+   for(int i = 0; i < 1000 && oc_stats(chain).compiled < compiled; ++i) {
+      run(chain);
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+   }
+   BOOST_REQUIRE_EQUAL(oc_stats(chain).compiled, compiled);
+}
+
+// the code cache files of a running node are what it leaves behind when killed at that point
+void save_code_cache(const tester& chain, const std::filesystem::path& dir) {
+   for(const char* file : {"code_cache.bin", "code_cache.journal"})
+      std::filesystem::copy_file(chain.get_config().state_dir / file, dir / file, std::filesystem::copy_options::overwrite_existing);
+}
+
+// replaces the code cache files of a closed node
+void restore_code_cache(const tester& chain, const std::filesystem::path& cache_dir, const std::filesystem::path& journal_dir) {
+   const std::filesystem::path& state_dir = chain.get_config().state_dir;
+   std::filesystem::copy_file(cache_dir / "code_cache.bin", state_dir / "code_cache.bin", std::filesystem::copy_options::overwrite_existing);
+   std::filesystem::copy_file(journal_dir / "code_cache.journal", state_dir / "code_cache.journal", std::filesystem::copy_options::overwrite_existing);
+}
+
+// allocates bytes no journal entry refers to, as code compiled right before the node was killed
+void leak_code_cache(const tester& chain, size_t bytes) {
+   bip::file_mapping mapping((chain.get_config().state_dir / "code_cache.bin").generic_string().c_str(), bip::read_write);
+   bip::mapped_region region(mapping, bip::read_write);
+   BOOST_REQUIRE(reinterpret_cast<allocator_t*>(region.get_address())->allocate(bytes) != nullptr);
+}
+
+void check_no_compiles(tester& chain) {
+   const compile_stats stats = oc_stats(chain);
+   BOOST_CHECK_EQUAL(stats.compiled, 0u);
+   BOOST_CHECK_EQUAL(stats.in_progress, 0u);
+   BOOST_CHECK_EQUAL(stats.queued, 0u);
+}
+
+void check_compiling(tester& chain) {
+   const compile_stats stats = oc_stats(chain);
+   BOOST_CHECK_EQUAL(stats.in_progress + stats.queued, 1u);
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(eosvmoc_code_cache_tests)
+
+BOOST_AUTO_TEST_CASE(compile_queue_order) {
+   compile_queue queue;
+   queue.push(code(1), false);
+   queue.push(code(2), false);
+   queue.push(code(3), false);
+   queue.push(code(4), true);
+   // executed again while queued
+   queue.push(code(3), false);
+   // preloaded, not executed yet
+   queue.push(code(5), false, 0);
+   BOOST_CHECK_EQUAL(queue.size(), 5u);
+
+   // eosio.* first, then hottest, then first come first served, then preloaded
+   BOOST_CHECK(drain(queue) == (std::vector<code_tuple>{code(4), code(3), code(1), code(2), code(5)}));
+}
+
+BOOST_AUTO_TEST_CASE(compile_queue_requests_accumulate) {
+   compile_queue queue;
+   queue.push(code(1), false);
+   queue.push(code(2), false);
+   for(int i = 0; i < 3; ++i)
+      queue.push(code(2), false);
+   queue.push(code(1), false);
+   queue.push(code(1), false);
+   BOOST_CHECK_EQUAL(queue.size(), 2u);
+   BOOST_CHECK(drain(queue) == (std::vector<code_tuple>{code(2), code(1)}));
+}
+
+BOOST_AUTO_TEST_CASE(compile_queue_high_priority_promotes) {
+   compile_queue queue;
+   queue.push(code(1), false);
+   for(int i = 0; i < 10; ++i)
+      queue.push(code(1), false);
+   queue.push(code(2), false);
+   // code already queued by another account is requested by an eosio.* account
+   queue.push(code(2), true);
+   BOOST_CHECK(queue.front() == code(2));
+
+   // a later non priority request does not demote it
+   queue.push(code(2), false);
+   BOOST_CHECK(drain(queue) == (std::vector<code_tuple>{code(2), code(1)}));
+}
+
+BOOST_AUTO_TEST_CASE(compile_queue_erase) {
+   compile_queue queue;
+   queue.push(code(1), false);
+   queue.push(code(2), false);
+   BOOST_CHECK(queue.contains(code(1)));
+   BOOST_CHECK(!queue.contains(code_tuple{ digest_type::hash(1), 1 }));
+
+   BOOST_CHECK(queue.erase(code(1)));
+   BOOST_CHECK(!queue.erase(code(1)));
+   BOOST_CHECK(!queue.contains(code(1)));
+
+   // queued again after erase, behind code that was already queued
+   queue.push(code(1), false);
+   BOOST_CHECK(drain(queue) == (std::vector<code_tuple>{code(2), code(1)}));
+}
+
+BOOST_AUTO_TEST_CASE(compile_stats_latency) {
+   compile_stats_tracker tracker;
+   const fc::time_point start = fc::time_point::now();
+
+   tracker.requested(code(1), start);
+   // latency counts from the first request
+   tracker.requested(code(1), start + fc::milliseconds(5));
+   tracker.completed(code(1), true, start + fc::milliseconds(20));
+   BOOST_CHECK_EQUAL(tracker.stats().compiled, 1u);
+   BOOST_CHECK_EQUAL(tracker.stats().latency_us, 20000u);
+
+   // failures add no latency
+   tracker.requested(code(2), start);
+   tracker.completed(code(2), false, start + fc::milliseconds(50));
+   BOOST_CHECK_EQUAL(tracker.stats().failed, 1u);
+   BOOST_CHECK_EQUAL(tracker.stats().latency_us, 20000u);
+
+   // forgotten, e.g. the code was removed while queued
+   tracker.requested(code(3), start);
+   tracker.forget(code(3));
+   tracker.completed(code(3), true, start + fc::milliseconds(50));
+   BOOST_CHECK_EQUAL(tracker.stats().compiled, 2u);
+   BOOST_CHECK_EQUAL(tracker.stats().latency_us, 20000u);
+
+   // requested again after completing, measured from the new request
+   tracker.requested(code(1), start + fc::milliseconds(100));
+   tracker.completed(code(1), true, start + fc::milliseconds(101));
+   BOOST_CHECK_EQUAL(tracker.stats().compiled, 3u);
+   BOOST_CHECK_EQUAL(tracker.stats().latency_us, 21000u);
+
+   BOOST_CHECK_EQUAL(tracker.stats().queued, 0u);
+   BOOST_CHECK_EQUAL(tracker.stats().in_progress, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(recover_after_kill) {
+   fc::temp_directory tempdir, killed;
+   auto chain = make_oc_tierup_tester(tempdir);
+   if(!chain)
+      return;
+   run_until_compiled(*chain, 1, doit);
+   save_code_cache(*chain, killed.path());
+   chain->close();
+
+   restore_code_cache(*chain, killed.path(), killed.path());
+   chain->open();
+   // executed with the recovered code
+   doit(*chain);
+   check_no_compiles(*chain);
+}
+
+BOOST_AUTO_TEST_CASE(recover_torn_journal) {
+   fc::temp_directory tempdir, first, killed;
+   auto chain = make_oc_tierup_tester(tempdir);
+   if(!chain)
+      return;
+   run_until_compiled(*chain, 1, doit);
+   save_code_cache(*chain, first.path());
+   run_until_compiled(*chain, 2, anyaction);
+   save_code_cache(*chain, killed.path());
+   chain->close();
+
+   // killed while appending the record of the second compile
+   restore_code_cache(*chain, killed.path(), killed.path());
+   const std::filesystem::path journal = chain->get_config().state_dir / "code_cache.journal";
+   BOOST_REQUIRE_GT(std::filesystem::file_size(journal), std::filesystem::file_size(first.path() / "code_cache.journal") + 16);
+   std::filesystem::resize_file(journal, std::filesystem::file_size(first.path() / "code_cache.journal") + 16);
+   chain->open();
+
+   doit(*chain);
+   check_no_compiles(*chain);
+   anyaction(*chain);
+   check_compiling(*chain);
+   run_until_compiled(*chain, 1, anyaction);
+}
+
+BOOST_AUTO_TEST_CASE(drop_code_not_on_disk) {
+   fc::temp_directory tempdir, before, killed;
+   auto chain = make_oc_tierup_tester(tempdir);
+   if(!chain)
+      return;
+   save_code_cache(*chain, before.path());
+   run_until_compiled(*chain, 1, doit);
+   save_code_cache(*chain, killed.path());
+   chain->close();
+
+   // power lost: the journal reached the disk, the compiled code did not
+   restore_code_cache(*chain, before.path(), killed.path());
+   chain->open();
+   check_no_compiles(*chain);
+
+   doit(*chain);
+   check_compiling(*chain);
+   run_until_compiled(*chain, 1, doit);
+}
+
+BOOST_AUTO_TEST_CASE(recovery_leak_limit) {
+   fc::temp_directory tempdir, killed;
+   auto chain = make_oc_tierup_tester(tempdir);
+   if(!chain)
+      return;
+   const size_t cache_size = chain->get_config().eosvmoc_config.cache_size;
+   run_until_compiled(*chain, 1, doit);
+   save_code_cache(*chain, killed.path());
+   chain->close();
+
+   // up to 10% of the cache allocated but not in the journal is left leaked
+   restore_code_cache(*chain, killed.path(), killed.path());
+   leak_code_cache(*chain, cache_size / 20);
+   chain->open();
+   doit(*chain);
+   check_no_compiles(*chain);
+   chain->close();
+
+   // more starts over with an empty cache
+   restore_code_cache(*chain, killed.path(), killed.path());
+   leak_code_cache(*chain, cache_size / 5);
+   chain->open();
+   doit(*chain);
+   check_compiling(*chain);
+}
+
+BOOST_AUTO_TEST_CASE(preload) {
+   fc::temp_directory tempdir, before, killed;
+   auto chain = make_oc_tierup_tester(tempdir, 10);
+   if(!chain)
+      return;
+   save_code_cache(*chain, before.path());
+   run_until_compiled(*chain, 1, doit);
+   save_code_cache(*chain, killed.path());
+   chain->close();
+
+   // compiled again on startup, before it is executed
+   restore_code_cache(*chain, before.path(), killed.path());
+   chain->open();
+   check_compiling(*chain);
+   run_until_compiled(*chain, 1, doit);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
@@ -0,0 +1,152 @@
+#include <eosio/chain/instantiated_module_cache.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace eosio;
+using namespace eosio::chain;
+
+namespace {
+
+using test_cache = instantiated_module_cache<std::unique_ptr<int>>;
+
+digest_type hash_of(int n) {
+   return digest_type::hash(n);
+}
+
+const test_cache::entry& insert(test_cache& cache, int n, uint64_t bytes, int64_t instantiation_us, bool evict = true) {
+   return cache.insert(hash_of(n), 0, 0, std::make_unique<int>(n), bytes, fc::microseconds(instantiation_us), evict);
+}
+
+bool cached(const test_cache& cache, int n) {
+   return cache.contains(hash_of(n), 0, 0);
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(instantiated_module_cache_tests)
+
+BOOST_AUTO_TEST_CASE(hit_and_miss) {
+   test_cache cache(0);
+   BOOST_CHECK(cache.find(hash_of(1), 0, 0) == nullptr);
+   insert(cache, 1, 100, 10);
+
+   const test_cache::entry* e = cache.find(hash_of(1), 0, 0);
+   BOOST_REQUIRE(e != nullptr);
+   BOOST_CHECK_EQUAL(*e->module, 1);
+   BOOST_CHECK_EQUAL(e->uses, 2u);
+
+   // a different vm version is different code
+   BOOST_CHECK(cache.find(hash_of(1), 0, 1) == nullptr);
+   BOOST_CHECK(cached(cache, 1));
+
+   auto stats = cache.get_stats();
+   BOOST_CHECK_EQUAL(stats.hits, 1u);
+   BOOST_CHECK_EQUAL(stats.misses, 2u);
+   BOOST_CHECK_EQUAL(stats.evictions, 0u);
+   BOOST_CHECK_EQUAL(stats.entries, 1u);
+   BOOST_CHECK_EQUAL(stats.bytes, 100u);
+}
+
+BOOST_AUTO_TEST_CASE(no_limit) {
+   test_cache cache(0);
+   for (int i = 0; i < 100; ++i)
+      insert(cache, i, 1024 * 1024, 1);
+   auto stats = cache.get_stats();
+   BOOST_CHECK_EQUAL(stats.entries, 100u);
+   BOOST_CHECK_EQUAL(stats.evictions, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(evicts_cheapest_per_byte) {
+   test_cache cache(300);
+   insert(cache, 1, 100, 1000);
+   insert(cache, 2, 100, 10);
+   insert(cache, 3, 50, 500);
+   insert(cache, 4, 100, 100);
+
+   // 2 takes the least time per byte to instantiate again
+   BOOST_CHECK(cached(cache, 1));
+   BOOST_CHECK(!cached(cache, 2));
+   BOOST_CHECK(cached(cache, 3));
+   BOOST_CHECK(cached(cache, 4));
+
+   // 4 now takes the least time per byte
+   insert(cache, 5, 100, 1000);
+   BOOST_CHECK(cached(cache, 1));
+   BOOST_CHECK(cached(cache, 3));
+   BOOST_CHECK(!cached(cache, 4));
+   BOOST_CHECK(cached(cache, 5));
+
+   auto stats = cache.get_stats();
+   BOOST_CHECK_EQUAL(stats.evictions, 2u);
+   BOOST_CHECK_EQUAL(stats.entries, 3u);
+   BOOST_CHECK_EQUAL(stats.bytes, 250u);
+}
+
+BOOST_AUTO_TEST_CASE(frequency_and_aging) {
+   test_cache cache(200);
+   insert(cache, 1, 100, 1000);
+   insert(cache, 2, 100, 600);
+   cache.find(hash_of(2), 0, 0);
+
+   // used twice, 2 is worth more than 1
+   insert(cache, 3, 100, 600);
+   BOOST_CHECK(!cached(cache, 1));
+   BOOST_CHECK(cached(cache, 2));
+   BOOST_CHECK(cached(cache, 3));
+
+   // evicting 1 raised the priority of entries used since then above 2
+   cache.find(hash_of(3), 0, 0);
+   insert(cache, 4, 100, 600);
+   BOOST_CHECK(!cached(cache, 2));
+   BOOST_CHECK(cached(cache, 3));
+   BOOST_CHECK(cached(cache, 4));
+}
+
+BOOST_AUTO_TEST_CASE(inserted_entry_is_kept) {
+   test_cache cache(100);
+   insert(cache, 1, 50, 10);
+   const test_cache::entry& e = insert(cache, 2, 200, 1);
+   BOOST_CHECK_EQUAL(*e.module, 2);
+   BOOST_CHECK(!cached(cache, 1));
+   BOOST_CHECK(cached(cache, 2));
+   BOOST_CHECK_EQUAL(cache.get_stats().bytes, 200u);
+}
+
+BOOST_AUTO_TEST_CASE(deferred_eviction) {
+   test_cache cache(100);
+   insert(cache, 1, 60, 10, false);
+   insert(cache, 2, 60, 20, false);
+   BOOST_CHECK_EQUAL(cache.get_stats().entries, 2u);
+   BOOST_CHECK_EQUAL(cache.get_stats().bytes, 120u);
+
+   cache.evict_to_budget();
+   BOOST_CHECK(!cached(cache, 1));
+   BOOST_CHECK(cached(cache, 2));
+   BOOST_CHECK_EQUAL(cache.get_stats().evictions, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(erase_replaced_code) {
+   test_cache cache(0);
+   insert(cache, 1, 100, 10);
+   insert(cache, 2, 100, 10);
+   cache.code_block_num_last_used(hash_of(1), 0, 0, 5);
+
+   std::vector<digest_type> erased;
+   auto on_erase = [&](const test_cache::entry& e) { erased.push_back(e.code_hash); };
+   cache.erase_last_used_before(4, on_erase);
+   BOOST_CHECK(erased.empty());
+   BOOST_CHECK(cached(cache, 1));
+
+   cache.erase_last_used_before(5, on_erase);
+   BOOST_REQUIRE_EQUAL(erased.size(), 1u);
+   BOOST_CHECK(erased[0] == hash_of(1));
+   BOOST_CHECK(!cached(cache, 1));
+   BOOST_CHECK(cached(cache, 2));
+
+   auto stats = cache.get_stats();
+   BOOST_CHECK_EQUAL(stats.entries, 1u);
+   BOOST_CHECK_EQUAL(stats.bytes, 100u);
+   BOOST_CHECK_EQUAL(stats.evictions, 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -124,6 +124,14 @@ BOOST_AUTO_TEST_CASE(test_split_log) {
    BOOST_CHECK(chain.control->fetch_block_by_number(145)->block_num() == 145u);
 
    BOOST_CHECK(!chain.control->fetch_block_by_number(160));
+
+   // blocks read without unpacking, including the first and last block of retained files and the head of blocks.log
+   for (uint32_t block_num : {41u, 60u, 61u, 100u, 140u, 141u, 145u, 150u}) {
+      BOOST_CHECK(chain.control->fetch_serialized_block_by_number(block_num) ==
+                  fc::raw::pack(*chain.control->fetch_block_by_number(block_num)));
+   }
+   BOOST_CHECK(chain.control->fetch_serialized_block_by_number(40).empty());
+   BOOST_CHECK(chain.control->fetch_serialized_block_by_number(160).empty());
 }
 
 BOOST_AUTO_TEST_CASE(test_split_log_zero_retained_file) {
@@ -0,0 +1,188 @@
+#include <eosio/chain/signature_recovery_cache.hpp>
+#include <eosio/chain/transaction.hpp>
+#include <eosio/chain/transaction_metadata.hpp>
+#include <eosio/chain/genesis_state.hpp>
+#include <eosio/testing/tester.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace eosio;
+using namespace eosio::chain;
+using namespace eosio::testing;
+
+namespace {
+
+std::pair<signature_type, digest_type> make_signature(const private_key_type& key, uint64_t n) {
+   digest_type digest = digest_type::hash(n);
+   return { key.sign(digest), digest };
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(signature_recovery_cache_tests)
+
+BOOST_AUTO_TEST_CASE(hit_and_miss) try {
+   signature_recovery_cache cache;
+   auto key = private_key_type::generate();
+   auto [sig, digest] = make_signature(key, 1);
+
+   BOOST_CHECK(cache.recover(sig, digest) == key.get_public_key());
+   BOOST_CHECK(cache.recover(sig, digest) == key.get_public_key());
+
+   auto stats = cache.get_stats();
+   auto start = stats;
+   BOOST_TEST(stats.entries == 1u);
+
+   // same signature against another digest recovers another key and must not be served from the cache
+   digest_type other = digest_type::hash(uint64_t(2));
+   BOOST_CHECK(cache.recover(sig, other) == public_key_type(sig, other));
+   BOOST_CHECK(cache.recover(sig, other) != key.get_public_key());
+
+   stats = cache.get_stats();
+   BOOST_TEST(stats.entries == 2u);
+   BOOST_TEST(stats.misses - start.misses == 1u);
+   BOOST_TEST(stats.hits - start.hits == 1u);
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE(eviction) try {
+   constexpr size_t capacity = 64;
+   signature_recovery_cache cache(capacity);
+   auto key   = private_key_type::generate();
+   auto start = cache.get_stats();
+
+   for (uint64_t n = 0; n < 10 * capacity; ++n) {
+      auto [sig, digest] = make_signature(key, n);
+      BOOST_CHECK(cache.recover(sig, digest) == key.get_public_key());
+   }
+
+   auto stats = cache.get_stats();
+   BOOST_TEST(stats.entries <= capacity);
+   BOOST_TEST(stats.misses - start.misses == 10 * capacity);
+   BOOST_TEST(stats.evictions - start.evictions == 10 * capacity - stats.entries);
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE(disabled) try {
+   signature_recovery_cache cache(0);
+   auto key   = private_key_type::generate();
+   auto [sig, digest] = make_signature(key, 1);
+   auto start = cache.get_stats();
+
+   BOOST_CHECK(cache.recover(sig, digest) == key.get_public_key());
+   BOOST_CHECK(cache.recover(sig, digest) == key.get_public_key());
+
+   auto stats = cache.get_stats();
+   BOOST_TEST(stats.entries == 0u);
+   BOOST_TEST(stats.hits == start.hits);
+   BOOST_TEST(stats.misses == start.misses);
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_CASE(signature_keys) try {
+   signature_recovery_cache cache;
+   const chain_id_type chain_id = genesis_state{}.compute_chain_id();
+   auto key1 = private_key_type::generate();
+   auto key2 = private_key_type::generate_r1();
+
+   signed_transaction trx;
+   trx.expiration = fc::time_point_sec{fc::time_point::now() + fc::seconds(60)};
+   trx.actions.emplace_back(vector<permission_level>{{"alice"_n, config::active_name}}, "eosio"_n, "noop"_n, bytes{});
+   trx.sign(key1, chain_id);
+   trx.sign(key2, chain_id);
+
+   flat_set<public_key_type> expected{key1.get_public_key(), key2.get_public_key()};
+   flat_set<public_key_type> keys;
+   trx.get_signature_keys(chain_id, fc::time_point::maximum(), keys, false, &cache);
+   BOOST_CHECK(keys == expected);
+
+   auto start = cache.get_stats();
+   keys.clear();
+   trx.get_signature_keys(chain_id, fc::time_point::maximum(), keys, false, &cache);
+   BOOST_CHECK(keys == expected);
+
+   auto stats = cache.get_stats();
+   BOOST_TEST(stats.hits - start.hits == 2u);
+   BOOST_TEST(stats.misses == start.misses);
+
+   // a different chain id changes the signed digest
+   genesis_state other_genesis;
+   other_genesis.initial_key = key1.get_public_key();
+   keys.clear();
+   trx.get_signature_keys(other_genesis.compute_chain_id(), fc::time_point::maximum(), keys, false, &cache);
+   BOOST_CHECK(keys != expected);
+} FC_LOG_AND_RETHROW()
+
+// a hit is billed the recovery time of the miss that cached the key, so warming the cache does not lower billing
+BOOST_AUTO_TEST_CASE(hit_billing) try {
+   signature_recovery_cache cache;
+   const chain_id_type chain_id = genesis_state{}.compute_chain_id();
+   auto key1 = private_key_type::generate();
+   auto key2 = private_key_type::generate_r1();
+
+   signed_transaction trx;
+   trx.expiration = fc::time_point_sec{fc::time_point::now() + fc::seconds(60)};
+   trx.actions.emplace_back(vector<permission_level>{{"alice"_n, config::active_name}}, "eosio"_n, "noop"_n, bytes{});
+   trx.sign(key1, chain_id);
+   trx.sign(key2, chain_id);
+
+   flat_set<public_key_type> keys;
+   const fc::microseconds miss_time = trx.get_signature_keys(chain_id, fc::time_point::maximum(), keys, false, &cache);
+
+   // recovery time of each key as cached by the miss, the same on every hit
+   const digest_type digest = trx.sig_digest(chain_id, trx.context_free_data);
+   fc::microseconds cached_time;
+   for (const auto& sig : trx.signatures) {
+      fc::microseconds t, again;
+      cache.recover(sig, digest, &t);
+      cache.recover(sig, digest, &again);
+      BOOST_TEST(t.count() > 0);
+      BOOST_TEST(t.count() == again.count());
+      cached_time += t;
+   }
+   BOOST_TEST(miss_time.count() >= cached_time.count());
+
+   auto start = cache.get_stats();
+   keys.clear();
+   const fc::microseconds hit_time = trx.get_signature_keys(chain_id, fc::time_point::maximum(), keys, false, &cache);
+   BOOST_TEST(cache.get_stats().hits - start.hits == 2u);
+   BOOST_TEST(hit_time.count() >= cached_time.count());
+
+   // a key recovered by the call itself reports no cached time, it is measured by the caller
+   auto [sig, sig_digest] = make_signature(key1, 3);
+   fc::microseconds t = fc::microseconds::maximum();
+   cache.recover(sig, sig_digest, &t);
+   BOOST_TEST(t.count() == 0);
+} FC_LOG_AND_RETHROW()
+
+// key recovery of incoming transactions and of block validation share the cache of their controller
+BOOST_AUTO_TEST_CASE(controller_cache) try {
+   tester chain;
+   auto& cache = chain.control->get_signature_recovery_cache();
+   signed_transaction trx;
+   chain.set_transaction_headers(trx);
+   trx.actions.emplace_back(vector<permission_level>{{config::system_account_name, config::active_name}}, "eosio"_n, "noop"_n, bytes{});
+   trx.sign(chain.get_private_key(config::system_account_name, "active"), chain.control->get_chain_id());
+   auto ptrx = std::make_shared<packed_transaction>(trx);
+
+   auto start = cache.get_stats();
+   auto recover = [&]() {
+      return transaction_metadata::recover_keys(ptrx, chain.control->get_chain_id(), fc::microseconds::maximum(),
+                                                transaction_metadata::trx_type::input, UINT32_MAX, &cache);
+   };
+   auto first = recover();
+   auto second = recover();
+   BOOST_CHECK(first->recovered_keys() == second->recovered_keys());
+
+   auto stats = cache.get_stats();
+   BOOST_TEST(stats.misses - start.misses == 1u);
+   BOOST_TEST(stats.hits - start.hits == 1u);
+
+   // another controller has its own cache
+   tester other;
+   auto& other_cache = other.control->get_signature_recovery_cache();
+   auto other_start = other_cache.get_stats();
+   transaction_metadata::recover_keys(ptrx, chain.control->get_chain_id(), fc::microseconds::maximum(),
+                                      transaction_metadata::trx_type::input, UINT32_MAX, &other_cache);
+   BOOST_TEST(other_cache.get_stats().misses - other_start.misses == 1u);
+   BOOST_TEST(cache.get_stats().misses - start.misses == 1u);
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -169,4 +169,68 @@ struct json_snapshot_suite {
    }
 };
 
-using snapshot_suites = boost::mpl::list<variant_snapshot_suite, buffered_snapshot_suite, json_snapshot_suite>;
+struct threaded_snapshot_suite {
+   using writer_t = ostream_snapshot_writer;
+   using reader_t = threaded_snapshot_reader;
+   using write_storage_t = std::ostringstream;
+   using snapshot_t = std::string;
+
+   struct writer : public writer_t {
+      writer( const std::shared_ptr<write_storage_t>& storage )
+      :writer_t(*storage)
+      ,storage(storage)
+      {
+
+      }
+
+      std::shared_ptr<write_storage_t> storage;
+   };
+
+   // every reader maps its own file, a file can not be rewritten while it is mapped
+   static std::filesystem::path temp_file() {
+      static fc::temp_directory temp_dir;
+      static uint32_t count = 0;
+      return temp_dir.path() / ("temp" + std::to_string(count++) + ".bin");
+   }
+
+   struct reader : public reader_t {
+      explicit reader(const std::filesystem::path& p)
+      :reader_t(p)
+      ,path(p)
+      {}
+      ~reader() {
+         remove(path);
+      }
+
+      std::filesystem::path path;
+   };
+
+   static auto get_writer() {
+      return std::make_shared<writer>(std::make_shared<write_storage_t>());
+   }
+
+   static auto finalize(const std::shared_ptr<writer>& w) {
+      w->finalize();
+      return w->storage->str();
+   }
+
+   static auto get_reader( const snapshot_t& buffer) {
+      auto p = temp_file();
+      std::ofstream fs(p, std::ios::out | std::ios::binary);
+      fs << buffer;
+      fs.close();
+      return std::make_shared<reader>(p);
+   }
+
+   static snapshot_t load_from_file(const std::string& filename) {
+      snapshot_input_file<snapshot::binary> file(filename);
+      return file.read_as_string();
+   }
+
+   static void write_to_file( const std::string& basename, const snapshot_t& snapshot ) {
+      snapshot_output_file<snapshot::binary> file(basename);
+      file.write<snapshot_t>(snapshot);
+   }
+};
+
+using snapshot_suites = boost::mpl::list<variant_snapshot_suite, buffered_snapshot_suite, json_snapshot_suite, threaded_snapshot_suite>;
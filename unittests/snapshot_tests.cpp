@@ -1,8 +1,11 @@
+#include <fstream>
 #include <sstream>
+#include <thread>
 
 #include <eosio/chain/block_log.hpp>
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/snapshot.hpp>
+#include <eosio/chain/snapshot_scheduler.hpp>
 #include <eosio/testing/tester.hpp>
 #include "snapshot_suites.hpp"
 
@@ -178,6 +181,7 @@ namespace {
          SNAPSHOT_SUITE::write_to_file("snapshot_debug_verify_integrity_hash_rhs", rhs_latest);
       }
       BOOST_REQUIRE_EQUAL(lhs_integrity_hash.str(), rhs_integrity_hash.str());
+      BOOST_REQUIRE_EQUAL(lhs.calculate_integrity_hash(2).str(), rhs.calculate_integrity_hash(2).str());
    }
 }
 
@@ -687,4 +691,83 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(jumbo_row, SNAPSHOT_SUITE, snapshot_suites)
    snapshotted_tester sst(chain.get_config(), SNAPSHOT_SUITE::get_reader(snapshot), 0);
 }
 
+BOOST_AUTO_TEST_CASE(background_snapshot)
+{
+   fc::temp_directory tempdir;
+   auto config = tester::default_config(tempdir);
+   // the forked process needs a private copy-on-write view of the state
+   config.first.db_map_mode = chainbase::pinnable_mapped_file::map_mode::heap;
+   tester chain(config.first, config.second);
+   chain.execute_setup_policy(setup_policy::full);
+
+   chain.create_account("snapshot"_n);
+   chain.produce_blocks(10);
+   chain.control->abort_block();
+
+   auto writer = buffered_snapshot_suite::get_writer();
+   chain.control->write_snapshot(writer);
+   auto expected = buffered_snapshot_suite::finalize(writer);
+   const auto head_id = chain.control->head_block_id();
+
+   fc::temp_directory snapshots_dir;
+   snapshot_scheduler scheduler;
+   scheduler.set_snapshots_path(snapshots_dir.path());
+   scheduler.set_background(true);
+
+   std::vector<snapshot_scheduler::snapshot_information> results;
+   auto next = [&results](const next_function_variant<snapshot_scheduler::snapshot_information>& r) {
+      BOOST_REQUIRE(std::holds_alternative<snapshot_scheduler::snapshot_information>(r));
+      results.push_back(std::get<snapshot_scheduler::snapshot_information>(r));
+   };
+   scheduler.create_snapshot(next, *chain.control, {});
+   // a second request for the same block is attached to the one in progress
+   scheduler.create_snapshot(next, *chain.control, {});
+   BOOST_TEST(scheduler.get_background_snapshot_stats().in_progress == 1u);
+
+   // the state keeps changing while the snapshot is written
+   chain.create_account("after"_n);
+   chain.produce_blocks(5);
+
+   for (int i = 0; i < 3000 && scheduler.get_background_snapshot_stats().in_progress; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      scheduler.poll_background_snapshots(*chain.control);
+   }
+   auto stats = scheduler.get_background_snapshot_stats();
+   BOOST_TEST(stats.in_progress == 0u);
+   BOOST_TEST(stats.completed == 1u);
+   BOOST_TEST(stats.failed == 0u);
+   BOOST_TEST(results.empty());
+
+   // pending until the snapshotted block is irreversible
+   BOOST_REQUIRE(chain.control->last_irreversible_block_num() >= block_header::num_from_id(head_id));
+   scheduler.on_irreversible_block(chain.control->fetch_block_by_number(chain.control->last_irreversible_block_num()), *chain.control);
+   BOOST_REQUIRE_EQUAL(results.size(), 2u);
+   BOOST_TEST(results[0].head_block_id == head_id);
+   BOOST_TEST(results[1].snapshot_name == results[0].snapshot_name);
+
+   std::ifstream in(results[0].snapshot_name, std::ios::in | std::ios::binary);
+   std::string written((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+   BOOST_TEST((written == expected));
+}
+
+BOOST_AUTO_TEST_CASE(integrity_hash_versions)
+{
+   tester chain;
+   chain.create_account("hashes"_n);
+   chain.produce_blocks(2);
+   chain.control->abort_block();
+
+   const auto v1 = chain.control->calculate_integrity_hash(1);
+   const auto v2 = chain.control->calculate_integrity_hash(2);
+   BOOST_CHECK(v1 != v2);
+   BOOST_CHECK(chain.control->calculate_integrity_hash() == v1);
+   BOOST_CHECK(chain.control->calculate_integrity_hash(2) == v2);
+   BOOST_CHECK_THROW(chain.control->calculate_integrity_hash(3), misc_exception);
+
+   chain.create_account("changed"_n);
+   chain.produce_block();
+   chain.control->abort_block();
+   BOOST_CHECK(chain.control->calculate_integrity_hash(2) != v2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -653,7 +653,7 @@ struct state_history_tester : state_history_tester_logs, tester {
 };
 
 static std::vector<char> get_decompressed_entry(eosio::state_history_log& log, block_num_type block_num) {
-   auto result = log.create_locked_decompress_stream();
+   eosio::decompress_stream result;
    log.get_unpacked_entry(block_num, result);
    namespace bio = boost::iostreams;
    return std::visit(eosio::chain::overloaded{ [](std::vector<char>& bytes) {